@@ -0,0 +1,106 @@
+#include "allocation_counter.h"
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<uint64_t> allocationCount{0};
+std::atomic<uint64_t> allocationBytes{0};
+
+void record(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void* countedAlloc(size_t size) {
+    record(size);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+/**
+ * Delegates to OpenCV's standard allocator, counting each Mat buffer.
+ * Buffers keep the standard allocator as their owner, so they are freed
+ * the usual way even after this one is uninstalled.
+ */
+class CountingMatAllocator : public cv::MatAllocator {
+public:
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override {
+        cv::UMatData* u = cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step,
+                                                               flags, usageFlags);
+        if (u != nullptr && data == nullptr) {
+            record(u->size);
+        }
+        return u;
+    }
+
+    bool allocate(cv::UMatData* u, cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override {
+        return cv::Mat::getStdAllocator()->allocate(u, flags, usageFlags);
+    }
+
+    void deallocate(cv::UMatData* u) const override {
+        cv::Mat::getStdAllocator()->deallocate(u);
+    }
+};
+
+const bool matAllocatorInstalled = [] {
+    static CountingMatAllocator allocator;
+    cv::Mat::setDefaultAllocator(&allocator);
+    return true;
+}();
+
+} // namespace
+
+AllocationStats allocationStats() {
+    AllocationStats stats;
+    stats.count = allocationCount.load(std::memory_order_relaxed);
+    stats.bytes = allocationBytes.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void* operator new(size_t size) {
+    return countedAlloc(size);
+}
+
+void* operator new[](size_t size) {
+    return countedAlloc(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    record(size);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    record(size);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
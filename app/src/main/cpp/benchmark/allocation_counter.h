@@ -0,0 +1,20 @@
+#ifndef BODYSCAN_BENCHMARK_ALLOCATION_COUNTER_H
+#define BODYSCAN_BENCHMARK_ALLOCATION_COUNTER_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Process-wide allocation counts since startup: every operator new (the
+ * global operators are replaced in allocation_counter.cpp) plus every
+ * cv::Mat buffer (counted by a default MatAllocator installed before main).
+ * OpenCV's internal scratch (cv::AutoBuffer, fastMalloc) is not included.
+ */
+struct AllocationStats {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+};
+
+AllocationStats allocationStats();
+
+#endif // BODYSCAN_BENCHMARK_ALLOCATION_COUNTER_H
@@ -0,0 +1,331 @@
+/**
+ * Per-stage benchmarks of the JNI-free pipeline on the fixture from
+ * fixtures.h. Besides time, every benchmark reports heap allocations and
+ * bytes per iteration ("allocs", "alloc_bytes"), so allocation regressions
+ * show up next to latency ones.
+ *
+ *   ./bodyscan_benchmark --benchmark_filter=Mesh
+ *   BODYSCAN_FIXTURE=scan.yml.gz ./bodyscan_benchmark
+ */
+#include "allocation_counter.h"
+#include "batch_engine.h"
+#include "fixtures.h"
+#include "image_preprocessor.h"
+#include "keypoint_schema.h"
+#include "mask_scanline.h"
+#include "measurements.h"
+#include "mesh_cache.h"
+#include "mesh_generator.h"
+#include "multi_view_3d.h"
+#include <benchmark/benchmark.h>
+#include <opencv2/opencv.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+/**
+ * Reports allocations made while the timed loop ran, averaged per iteration.
+ * Construct right before the loop; the counters are set on destruction.
+ */
+class AllocationReport {
+public:
+    explicit AllocationReport(benchmark::State& state) : state(state), start(allocationStats()) {}
+
+    ~AllocationReport() {
+        const AllocationStats end = allocationStats();
+        state.counters["allocs"] = benchmark::Counter(
+            static_cast<double>(end.count - start.count), benchmark::Counter::kAvgIterations);
+        state.counters["alloc_bytes"] = benchmark::Counter(
+            static_cast<double>(end.bytes - start.bytes), benchmark::Counter::kAvgIterations);
+    }
+
+private:
+    benchmark::State& state;
+    AllocationStats start;
+};
+
+std::vector<cv::Point3f> body25Keypoints() {
+    const std::vector<cv::Point3f>& kpts3d = scanFixture().keypoints3d;
+    return mapToBody25(KeypointSet<PipelineLayout>::fromPoints(kpts3d.data(), kpts3d.size())).toVector();
+}
+
+// ---- Preprocessing ----
+
+void BM_ImagePreprocessor(benchmark::State& state) {
+    const ScanFixture& fixture = scanFixture();
+    ImagePreprocessor::Context context;
+    cv::Mat output;
+    context.run(fixture.image, output);  // Size the scratch buffers
+
+    AllocationReport report(state);
+    for (auto _ : state) {
+        context.run(fixture.image, output);
+        benchmark::DoNotOptimize(output.data);
+    }
+}
+BENCHMARK(BM_ImagePreprocessor)->Unit(benchmark::kMillisecond);
+
+// The in-place entry point the scan path uses, including its input copy
+void BM_ImagePreprocessorInPlace(benchmark::State& state) {
+    const ScanFixture& fixture = scanFixture();
+    cv::Mat image;
+
+    AllocationReport report(state);
+    for (auto _ : state) {
+        fixture.image.copyTo(image);
+        ImagePreprocessor::run(image);
+        benchmark::DoNotOptimize(image.data);
+    }
+}
+BENCHMARK(BM_ImagePreprocessorInPlace)->Unit(benchmark::kMillisecond);
+
+// ---- Triangulation ----
+
+void BM_Triangulate(benchmark::State& state) {
+    const ScanFixture& fixture = scanFixture();
+    std::vector<cv::Point3f> kpts3d;
+    MultiView3D::triangulate(fixture.views, fixture.userHeight, kpts3d);
+
+    AllocationReport report(state);
+    for (auto _ : state) {
+        MultiView3D::triangulate(fixture.views, fixture.userHeight, kpts3d);
+        benchmark::DoNotOptimize(kpts3d.data());
+    }
+}
+BENCHMARK(BM_Triangulate)->Unit(benchmark::kMicrosecond);
+
+// ---- Meshing ----
+
+// Args: MeshLod, MeshFormat
+void BM_MeshGenerator(benchmark::State& state) {
+    const std::vector<cv::Point3f> body25 = body25Keypoints();
+    const MeshLod lod = static_cast<MeshLod>(state.range(0));
+    const MeshFormat format = static_cast<MeshFormat>(state.range(1));
+
+    size_t glbSize = 0;
+    AllocationReport report(state);
+    for (auto _ : state) {
+        const std::vector<uint8_t> glb = MeshGenerator::createFromKeypoints(body25, lod, format);
+        glbSize = glb.size();
+        benchmark::DoNotOptimize(glb.data());
+    }
+    state.counters["glb_bytes"] = static_cast<double>(glbSize);
+}
+BENCHMARK(BM_MeshGenerator)
+    ->ArgsProduct({{0, 1, 2}, {0, 1}})
+    ->ArgNames({"lod", "format"})
+    ->Unit(benchmark::kMicrosecond);
+
+// Writing into a reused buffer, as the direct ByteBuffer path does
+void BM_MeshGeneratorIntoBuffer(benchmark::State& state) {
+    const std::vector<cv::Point3f> body25 = body25Keypoints();
+    const MeshLod lod = static_cast<MeshLod>(state.range(0));
+    const MeshFormat format = static_cast<MeshFormat>(state.range(1));
+
+    std::vector<uint8_t> buffer(MeshGenerator::createFromKeypoints(body25, lod, format, nullptr, 0));
+
+    AllocationReport report(state);
+    for (auto _ : state) {
+        const size_t written = MeshGenerator::createFromKeypoints(
+            body25, lod, format, buffer.data(), buffer.size());
+        benchmark::DoNotOptimize(written);
+    }
+    state.counters["glb_bytes"] = static_cast<double>(buffer.size());
+}
+BENCHMARK(BM_MeshGeneratorIntoBuffer)
+    ->ArgsProduct({{0, 1, 2}, {0, 1}})
+    ->ArgNames({"lod", "format"})
+    ->Unit(benchmark::kMicrosecond);
+
+// Reopening a stored scan: hash the keypoints and find the GLB in the memory LRU
+void BM_MeshCacheHit(benchmark::State& state) {
+    const std::vector<cv::Point3f> body25 = body25Keypoints();
+    const MeshLod lod = static_cast<MeshLod>(state.range(0));
+
+    MeshCache cache;
+    cache.get(body25, lod);
+
+    AllocationReport report(state);
+    for (auto _ : state) {
+        const std::shared_ptr<const MeshBlob> glb = cache.get(body25, lod);
+        benchmark::DoNotOptimize(glb->data());
+    }
+}
+BENCHMARK(BM_MeshCacheHit)->Arg(0)->Arg(1)->Arg(2)->ArgName("lod")->Unit(benchmark::kMicrosecond);
+
+// ---- Measurements ----
+
+void BM_Circumferences(benchmark::State& state) {
+    const std::vector<cv::Point3f>& kpts3d = scanFixture().keypoints3d;
+
+    AllocationReport report(state);
+    for (auto _ : state) {
+        const std::vector<float> circumferences = computeCircumferences(kpts3d);
+        benchmark::DoNotOptimize(circumferences.data());
+    }
+}
+BENCHMARK(BM_Circumferences)->Unit(benchmark::kMicrosecond);
+
+// Arg: number of stored scans re-measured in one call
+void BM_CircumferencesBatch(benchmark::State& state) {
+    const std::vector<cv::Point3f>& kpts3d = scanFixture().keypoints3d;
+    const size_t scanCount = static_cast<size_t>(state.range(0));
+
+    std::vector<cv::Point3f> scans;
+    scans.reserve(kpts3d.size() * scanCount);
+    for (size_t i = 0; i < scanCount; ++i) {
+        scans.insert(scans.end(), kpts3d.begin(), kpts3d.end());
+    }
+    std::vector<float> out(scanCount * kCircumferenceCount);
+
+    AllocationReport report(state);
+    for (auto _ : state) {
+        computeCircumferences(scans.data(), kpts3d.size(), scanCount, CircumferenceRegions(), out.data());
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(scanCount));
+}
+BENCHMARK(BM_CircumferencesBatch)->Arg(1)->Arg(64)->Arg(1024)->Unit(benchmark::kMicrosecond);
+
+// Arg: 1 to measure thigh width on the segmentation mask
+void BM_Measurements2D(benchmark::State& state) {
+    const ScanFixture& fixture = scanFixture();
+    const cv::Size imageSize = ImagePreprocessor::outputSize(fixture.image.size());
+    const cv::Mat processed(imageSize, CV_8UC3, cv::Scalar::all(0));
+    const cv::Mat mask = state.range(0) ? fixture.mask : cv::Mat();
+
+    AllocationReport report(state);
+    for (auto _ : state) {
+        const std::vector<float> measurements = computeMeasurementsFrom2D(
+            fixture.views[0], fixture.userHeight, imageSize.width, imageSize.height, processed, mask);
+        benchmark::DoNotOptimize(measurements.data());
+    }
+}
+BENCHMARK(BM_Measurements2D)->Arg(0)->Arg(1)->ArgName("mask")->Unit(benchmark::kMicrosecond);
+
+// Every row of the mask; Arg: vote radius
+void BM_MaskScanline(benchmark::State& state) {
+    const cv::Mat& mask = scanFixture().mask;
+    const int radius = static_cast<int>(state.range(0));
+    MaskRun runs[32];
+
+    AllocationReport report(state);
+    for (auto _ : state) {
+        int total = 0;
+        for (int y = 0; y < mask.rows; ++y) {
+            total += MaskScanline::findRuns(mask, y, radius, runs, 32);
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * mask.rows);
+}
+BENCHMARK(BM_MaskScanline)->Arg(0)->Arg(2)->ArgName("radius")->Unit(benchmark::kMicrosecond);
+
+// ---- End to end (everything after pose detection) ----
+
+void BM_ScanPipeline(benchmark::State& state) {
+    const ScanFixture& fixture = scanFixture();
+    ImagePreprocessor::Context context;
+    cv::Mat processed;
+    std::vector<cv::Point3f> kpts3d;
+    const std::vector<cv::Point3f> body25 = body25Keypoints();
+
+    AllocationReport report(state);
+    for (auto _ : state) {
+        context.run(fixture.image, processed);
+        MultiView3D::triangulate(fixture.views, fixture.userHeight, kpts3d);
+        const std::vector<uint8_t> glb = MeshGenerator::createFromKeypoints(body25);
+        const std::vector<float> circumferences = computeCircumferences(fixture.keypoints3d);
+        const std::vector<float> measurements = computeMeasurementsFrom2D(
+            fixture.views[0], fixture.userHeight, processed.cols, processed.rows, processed, fixture.mask);
+        benchmark::DoNotOptimize(glb.data());
+        benchmark::DoNotOptimize(circumferences.data());
+        benchmark::DoNotOptimize(measurements.data());
+    }
+}
+BENCHMARK(BM_ScanPipeline)->Unit(benchmark::kMillisecond);
+
+// ---- Batch reprocessing ----
+
+// Archive of copies of the fixture in the temporary directory; removed on destruction
+class FixtureArchive {
+public:
+    explicit FixtureArchive(size_t records) : path(temporaryPath("input")) {
+        const ScanFixture& fixture = scanFixture();
+        std::vector<cv::Point2f> landmarks;
+        for (int view = 0; view < ScanArchiveLayout::kViewCount; ++view) {
+            const std::vector<cv::Point2f>& points = fixture.views[view % fixture.views.size()];
+            for (size_t i = 0; i < ScanArchiveLayout::kLandmarkCount; ++i) {
+                landmarks.push_back(i < points.size() ? points[i] : cv::Point2f());
+            }
+        }
+        std::vector<uint8_t> mask;
+        MaskCodec::encode(fixture.mask, mask);
+
+        ScanRecordView record;
+        record.userHeightCm = fixture.userHeight;
+        record.frontWidth = fixture.image.cols;
+        record.frontHeight = fixture.image.rows;
+        record.landmarks = landmarks.data();
+        record.maskWidth = fixture.mask.cols;
+        record.maskHeight = fixture.mask.rows;
+        record.mask = mask.data();
+        record.maskBytes = mask.size();
+
+        ScanArchiveWriter writer;
+        writer.open(path);
+        for (size_t i = 0; i < records; ++i) {
+            record.scanId = i;
+            writer.append(record);
+        }
+        writer.close();
+    }
+
+    ~FixtureArchive() { std::remove(path.c_str()); }
+
+    static std::string temporaryPath(const char* name) {
+        const char* directory = std::getenv("TMPDIR");
+        return std::string(directory != nullptr ? directory : "/tmp") + "/bodyscan_benchmark_" +
+               std::to_string(::getpid()) + "_" + name + ".bsa";
+    }
+
+    const std::string path;
+};
+
+// Whole archive through BatchEngine; Arg: worker threads
+void BM_BatchEngine(benchmark::State& state) {
+    constexpr size_t kRecords = 64;
+    const FixtureArchive archive(kRecords);
+    const std::string outputPath = FixtureArchive::temporaryPath("output");
+    ScanArchiveReader input;
+    if (!input.open(archive.path)) {
+        state.SkipWithError("Could not write the fixture archive");
+        return;
+    }
+
+    BatchEngine::Options options;
+    options.threads = static_cast<int>(state.range(0));
+
+    for (auto _ : state) {
+        ScanArchiveWriter output;
+        output.open(outputPath);
+        const BatchEngine::Summary summary = BatchEngine::run(input, output, options);
+        output.close();
+        benchmark::DoNotOptimize(summary.written);
+    }
+    std::remove(outputPath.c_str());
+    state.SetItemsProcessed(state.iterations() * kRecords);
+}
+BENCHMARK(BM_BatchEngine)
+    ->Arg(1)->Arg(2)->Arg(4)->Arg(8)
+    ->ArgName("threads")
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,258 @@
+#include "fixtures.h"
+#include "keypoint_schema.h"
+#include "multi_view_3d.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace {
+
+constexpr int kViewCount = 3;
+constexpr int kFrameWidth = 1080;
+constexpr int kFrameHeight = 1920;
+constexpr int kMaskDownscale = 4;
+
+// Camera model of MultiView3D (640x480 normalization, 200 cm, ~60 degree FOV)
+constexpr float kRigWidth = 640.0f;
+constexpr float kRigHeight = 480.0f;
+constexpr float kRigPrincipal = 320.0f;
+constexpr float kCameraDistance = 200.0f;
+
+/**
+ * Standing pose, facing the camera: x to the subject's left, y down, z away
+ * from the camera. Units are arbitrary (toCentimeters() rescales) and chosen
+ * so every view keeps the body in frame.
+ */
+const cv::Point3f kLandmarks[MediaPipeLayout::kCount] = {
+    {0.0f, -72.0f, -8.0f},                                           // 0 nose
+    {1.5f, -75.0f, -6.0f}, {3.0f, -75.0f, -6.0f}, {4.5f, -75.0f, -5.0f},    // 1-3 left eye
+    {-1.5f, -75.0f, -6.0f}, {-3.0f, -75.0f, -6.0f}, {-4.5f, -75.0f, -5.0f}, // 4-6 right eye
+    {6.5f, -73.0f, 0.0f}, {-6.5f, -73.0f, 0.0f},                     // 7-8 ears
+    {2.0f, -69.0f, -6.0f}, {-2.0f, -69.0f, -6.0f},                   // 9-10 mouth
+    {15.0f, -55.0f, 0.0f}, {-15.0f, -55.0f, 0.0f},                   // 11-12 shoulders
+    {19.0f, -33.0f, 1.0f}, {-19.0f, -33.0f, 1.0f},                   // 13-14 elbows
+    {21.0f, -12.0f, -1.0f}, {-21.0f, -12.0f, -1.0f},                 // 15-16 wrists
+    {22.0f, -8.0f, -1.0f}, {-22.0f, -8.0f, -1.0f},                   // 17-18 pinkies
+    {21.0f, -7.0f, -2.0f}, {-21.0f, -7.0f, -2.0f},                   // 19-20 index fingers
+    {20.0f, -9.0f, -3.0f}, {-20.0f, -9.0f, -3.0f},                   // 21-22 thumbs
+    {9.0f, 0.0f, 0.0f}, {-9.0f, 0.0f, 0.0f},                         // 23-24 hips
+    {9.5f, 25.0f, -1.0f}, {-9.5f, 25.0f, -1.0f},                     // 25-26 knees
+    {9.0f, 48.0f, 1.0f}, {-9.0f, 48.0f, 1.0f},                       // 27-28 ankles
+    {9.0f, 50.0f, 3.0f}, {-9.0f, 50.0f, 3.0f},                       // 29-30 heels
+    {10.0f, 52.0f, -7.0f}, {-10.0f, 52.0f, -7.0f},                   // 31-32 foot index
+};
+
+// Vertical shift that centers the body in the rig's image
+constexpr float kBodyOffsetY = -20.0f;
+
+// Bones the points past the 33 landmarks are spread along
+const int kBones[][2] = {
+    {11, 13}, {12, 14}, {13, 15}, {14, 16}, {23, 25}, {24, 26},
+    {25, 27}, {26, 28}, {11, 23}, {12, 24}, {11, 12}, {23, 24},
+};
+constexpr size_t kBoneCount = sizeof(kBones) / sizeof(kBones[0]);
+
+std::vector<cv::Point3f> skeleton() {
+    std::vector<cv::Point3f> points(PipelineLayout::kCount);
+    for (size_t i = 0; i < MediaPipeLayout::kCount; ++i) {
+        points[i] = kLandmarks[i] + cv::Point3f(0.0f, kBodyOffsetY, 0.0f);
+    }
+    for (size_t i = MediaPipeLayout::kCount; i < PipelineLayout::kCount; ++i) {
+        const size_t k = i - MediaPipeLayout::kCount;
+        const int* bone = kBones[k % kBoneCount];
+        const float t = static_cast<float>(k / kBoneCount + 1) / 10.0f;
+        points[i] = points[bone[0]] + (points[bone[1]] - points[bone[0]]) * t;
+    }
+    return points;
+}
+
+// The user turns in front of a fixed camera between views, so view N sees the
+// body rotated by N steps around its vertical axis
+std::vector<cv::Point2f> project(const std::vector<cv::Point3f>& points, int view) {
+    const float angle = 2.0f * static_cast<float>(M_PI) * view / kViewCount;
+    const float c = std::cos(angle);
+    const float s = std::sin(angle);
+    const float focalLength = kRigWidth / (2.0f * std::tan(30.0f * static_cast<float>(M_PI) / 180.0f));
+
+    std::vector<cv::Point2f> projected;
+    projected.reserve(points.size());
+    for (const cv::Point3f& p : points) {
+        const float x = c * p.x + s * p.z;
+        const float y = p.y;
+        const float z = -s * p.x + c * p.z + kCameraDistance;
+        projected.emplace_back((focalLength * x / z + kRigPrincipal) / kRigWidth,
+                               (focalLength * y / z + kRigPrincipal) / kRigHeight);
+    }
+    return projected;
+}
+
+// Skeleton in centimeters, y up, nose to ankles spanning 88% of the height
+// (the proportion MultiView3D::heightScale assumes)
+std::vector<cv::Point3f> toCentimeters(const std::vector<cv::Point3f>& points, float userHeight) {
+    const float span = points[MediaPipeLayout::kLeftAnkle].y - points[MediaPipeLayout::kNose].y;
+    const float scale = 0.88f * userHeight / span;
+
+    std::vector<cv::Point3f> scaled;
+    scaled.reserve(points.size());
+    for (const cv::Point3f& p : points) {
+        scaled.emplace_back(p.x * scale, -p.y * scale, p.z * scale);
+    }
+    return scaled;
+}
+
+// Filled body outline from the front-view landmarks, in canvas pixels
+void drawSilhouette(cv::Mat& canvas, const std::vector<cv::Point2f>& keypoints, const cv::Scalar& color) {
+    const auto at = [&](int index) {
+        return cv::Point(cvRound(keypoints[index].x * canvas.cols),
+                         cvRound(keypoints[index].y * canvas.rows));
+    };
+    const int limb = std::max(1, cvRound(canvas.cols * 0.035));
+
+    const cv::Point torso[] = {at(11), at(12), at(24), at(23)};
+    cv::fillConvexPoly(canvas, torso, 4, color, cv::LINE_AA);
+
+    const int limbs[][2] = {
+        {11, 13}, {13, 15}, {12, 14}, {14, 16},
+        {23, 25}, {25, 27}, {24, 26}, {26, 28}, {11, 12}, {23, 24},
+    };
+    for (const auto& bone : limbs) {
+        cv::line(canvas, at(bone[0]), at(bone[1]), color, limb, cv::LINE_AA);
+    }
+
+    const cv::Point neck = (at(11) + at(12)) / 2;
+    cv::line(canvas, neck, at(0), color, limb, cv::LINE_AA);
+    const int headRadius = std::max(1, cvRound(cv::norm(at(7) - at(8)) * 0.6));
+    cv::circle(canvas, at(0), headRadius, color, cv::FILLED, cv::LINE_AA);
+}
+
+} // namespace
+
+ScanFixture syntheticScanFixture() {
+    ScanFixture fixture;
+
+    const std::vector<cv::Point3f> points = skeleton();
+    for (int view = 0; view < kViewCount; ++view) {
+        fixture.views.push_back(project(points, view));
+    }
+    fixture.keypoints3d = toCentimeters(points, fixture.userHeight);
+    const std::vector<cv::Point2f>& front = fixture.views[0];
+
+    // Vertical gradient background, person, then sensor-like noise
+    fixture.image.create(kFrameHeight, kFrameWidth, CV_8UC4);
+    for (int y = 0; y < kFrameHeight; ++y) {
+        const double shade = 90.0 + 80.0 * y / kFrameHeight;
+        fixture.image.row(y).setTo(cv::Scalar(shade, shade * 0.95, shade * 0.9, 255));
+    }
+    drawSilhouette(fixture.image, front, cv::Scalar(170, 120, 95, 255));
+    cv::Mat noise(fixture.image.size(), CV_8UC4);
+    cv::RNG rng(0x5ca11);
+    rng.fill(noise, cv::RNG::UNIFORM, cv::Scalar(0, 0, 0, 0), cv::Scalar(24, 24, 24, 1));
+    fixture.image += noise;
+
+    // The landmarker's mask comes at a fraction of the frame size, with soft edges
+    cv::Mat mask8(kFrameHeight / kMaskDownscale, kFrameWidth / kMaskDownscale, CV_8UC1, cv::Scalar(0));
+    drawSilhouette(mask8, front, cv::Scalar(255));
+    cv::GaussianBlur(mask8, mask8, cv::Size(5, 5), 0);
+    mask8.convertTo(fixture.mask, CV_32F, 1.0 / 255.0);
+
+    return fixture;
+}
+
+bool loadScanFixture(const std::string& path, ScanFixture& fixture) {
+    cv::FileStorage fs(path, cv::FileStorage::READ);
+    if (!fs.isOpened()) {
+        return false;
+    }
+
+    const cv::FileNode views = fs["views"];
+    if (!views.isSeq() || views.size() == 0) {
+        return false;
+    }
+
+    ScanFixture loaded;
+    for (cv::FileNodeIterator it = views.begin(); it != views.end(); ++it) {
+        cv::Mat view;
+        *it >> view;
+        view.convertTo(view, CV_32F);
+        view = view.reshape(1, static_cast<int>(view.total() * view.channels() / 2));
+
+        std::vector<cv::Point2f> keypoints(PipelineLayout::kCount, cv::Point2f(0.0f, 0.0f));
+        for (int i = 0; i < view.rows && i < static_cast<int>(PipelineLayout::kCount); ++i) {
+            keypoints[i] = cv::Point2f(view.at<float>(i, 0), view.at<float>(i, 1));
+        }
+        loaded.views.push_back(std::move(keypoints));
+    }
+
+    fs["image"] >> loaded.image;
+    fs["mask"] >> loaded.mask;
+    if (!loaded.mask.empty() && loaded.mask.type() != CV_32FC1) {
+        loaded.mask.convertTo(loaded.mask, CV_32F, loaded.mask.depth() == CV_8U ? 1.0 / 255.0 : 1.0);
+    }
+    if (!fs["userHeight"].empty()) {
+        fs["userHeight"] >> loaded.userHeight;
+    }
+
+    cv::Mat keypoints3d;
+    fs["keypoints3d"] >> keypoints3d;
+    if (!keypoints3d.empty()) {
+        keypoints3d.convertTo(keypoints3d, CV_32F);
+        keypoints3d = keypoints3d.reshape(1, static_cast<int>(keypoints3d.total() * keypoints3d.channels() / 3));
+        loaded.keypoints3d.assign(PipelineLayout::kCount, cv::Point3f(0.0f, 0.0f, 0.0f));
+        for (int i = 0; i < keypoints3d.rows && i < static_cast<int>(PipelineLayout::kCount); ++i) {
+            loaded.keypoints3d[i] = cv::Point3f(keypoints3d.at<float>(i, 0), keypoints3d.at<float>(i, 1),
+                                                keypoints3d.at<float>(i, 2));
+        }
+    } else {
+        MultiView3D::triangulate(loaded.views, loaded.userHeight, loaded.keypoints3d);
+    }
+
+    fixture = std::move(loaded);
+    return true;
+}
+
+bool saveScanFixture(const std::string& path, const ScanFixture& fixture) {
+    cv::FileStorage fs(path, cv::FileStorage::WRITE);
+    if (!fs.isOpened()) {
+        return false;
+    }
+
+    fs << "views" << "[";
+    for (const std::vector<cv::Point2f>& view : fixture.views) {
+        fs << cv::Mat(view).reshape(1);
+    }
+    fs << "]";
+    fs << "image" << fixture.image;
+    fs << "mask" << fixture.mask;
+    fs << "userHeight" << fixture.userHeight;
+    fs << "keypoints3d" << cv::Mat(fixture.keypoints3d).reshape(1);
+    return true;
+}
+
+const ScanFixture& scanFixture() {
+    static const ScanFixture fixture = [] {
+        ScanFixture built;
+        const char* path = std::getenv("BODYSCAN_FIXTURE");
+        if (path != nullptr && *path != '\0') {
+            if (loadScanFixture(path, built)) {
+                std::fprintf(stderr, "Loaded fixture %s (%zu views)\n", path, built.views.size());
+            } else {
+                std::fprintf(stderr, "Could not load fixture %s - using the synthetic scan\n", path);
+                built = syntheticScanFixture();
+            }
+        } else {
+            built = syntheticScanFixture();
+        }
+
+        const char* outPath = std::getenv("BODYSCAN_FIXTURE_OUT");
+        if (outPath != nullptr && *outPath != '\0' && !saveScanFixture(outPath, built)) {
+            std::fprintf(stderr, "Could not write fixture to %s\n", outPath);
+        }
+        return built;
+    }();
+    return fixture;
+}
@@ -0,0 +1,61 @@
+#ifndef BODYSCAN_BENCHMARK_FIXTURES_H
+#define BODYSCAN_BENCHMARK_FIXTURES_H
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+/**
+ * Input of one scan as the core library sees it after pose detection:
+ * per-view pipeline keypoints plus the front camera frame and its
+ * segmentation mask.
+ */
+struct ScanFixture {
+    std::vector<std::vector<cv::Point2f>> views;  // PipelineLayout::kCount points each, normalized 0-1
+    cv::Mat image;                                // Front camera frame (CV_8UC4 RGBA)
+    cv::Mat mask;                                 // Front segmentation mask (CV_32FC1)
+    std::vector<cv::Point3f> keypoints3d;         // PipelineLayout::kCount points, cm, y up
+    float userHeight = 175.0f;                    // cm
+};
+
+/**
+ * Fixture used by every benchmark, built once.
+ *
+ * If BODYSCAN_FIXTURE names an OpenCV FileStorage file (.yml/.json/.xml),
+ * the recorded scan is loaded from it:
+ *   views:      sequence of Nx2 CV_32F matrices (normalized keypoints)
+ *   image:      CV_8UC4 front frame
+ *   mask:       CV_32FC1 front mask
+ *   userHeight: float, cm
+ *   keypoints3d: optional Nx3 CV_32F matrix, cm (triangulated from the views
+ *                when missing)
+ * Keypoint lists are padded with zeros or truncated to PipelineLayout::kCount.
+ * Otherwise a deterministic synthetic scan is used: a standing skeleton
+ * turned in front of the MultiView3D camera for three views, with a
+ * rendered silhouette mask and a noisy 1080x1920 frame. Its 3D keypoints
+ * are the skeleton itself, so meshing and circumferences see a plausible
+ * body whatever the triangulation makes of the views.
+ *
+ * Setting BODYSCAN_FIXTURE_OUT writes the fixture in use to that path, as a
+ * template for recordings.
+ */
+const ScanFixture& scanFixture();
+
+/**
+ * @param path FileStorage file
+ * @param fixture Output
+ * @return false if the file could not be opened or lacks the views
+ */
+bool loadScanFixture(const std::string& path, ScanFixture& fixture);
+
+/**
+ * @return false if the file could not be written
+ */
+bool saveScanFixture(const std::string& path, const ScanFixture& fixture);
+
+/**
+ * @return Deterministic synthetic scan (see scanFixture())
+ */
+ScanFixture syntheticScanFixture();
+
+#endif // BODYSCAN_BENCHMARK_FIXTURES_H
@@ -0,0 +1,81 @@
+#ifndef BATCH_ENGINE_H
+#define BATCH_ENGINE_H
+
+#include "mesh_generator.h"
+#include "scan_archive.h"
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Re-runs triangulation, meshing and measurements over archived scans, for
+ * server and offline tools that reprocess stored scan sets after a pipeline
+ * change. Pure core library: no JNI, no MediaPipe and no camera frames, so
+ * it builds on a host.
+ *
+ * Records are processed on a worker pool and written to the output archive
+ * in input order. At most a window of finished records waits for an earlier,
+ * slower one, so memory stays bounded however large the archive is.
+ */
+class BatchEngine {
+public:
+    struct Options {
+        int threads = 0;         // Workers; 0 = one per hardware thread
+        size_t window = 0;       // Records in flight; 0 = 4 per worker
+        MeshLod lod = MeshLod::Standard;
+        MeshFormat format = MeshFormat::Float32;
+        bool rebuildMesh = true;  // false: keep each record's GLB, re-measure only
+    };
+
+    struct Summary {
+        size_t written = 0;  // Records in the output archive
+        size_t failed = 0;   // Reprocessing threw; written with their original results
+        size_t skipped = 0;  // Corrupt in the input; not written
+        bool ok = false;     // false if the output could not be written
+    };
+
+    /**
+     * Results of reprocessing one record, in ScanRecordView's layout.
+     */
+    struct Result {
+        std::vector<cv::Point3f> keypoints3d;  // ScanArchiveLayout::kLandmarkCount points (cm)
+        std::vector<float> measurements;       // kMeasurementCount values (cm)
+        std::vector<uint8_t> glb;              // Empty if no mesh could be built
+        bool meshRebuilt = false;              // false: glb is unused, the record keeps its own
+
+        /**
+         * @param source Record the results were computed from
+         * @return source with its results replaced (points into this Result and
+         *         source's memory)
+         */
+        ScanRecordView apply(const ScanRecordView& source) const;
+    };
+
+    /**
+     * Reprocess one record on the calling thread. Depends only on its
+     * arguments, so records can be processed concurrently.
+     *
+     * @param record Archived scan
+     * @param options Mesh settings
+     * @param result Output; buffers are reused across calls
+     */
+    static void process(const ScanRecordView& record, const Options& options, Result& result);
+
+    /**
+     * Reprocess every record of input into output, in order. output must be
+     * open; it is left open.
+     *
+     * @return Record counts; ok is false if writing stopped at an error
+     */
+    static Summary run(const ScanArchiveReader& input, ScanArchiveWriter& output, const Options& options);
+
+    /**
+     * run() with default Options: every hardware thread, full rebuild.
+     */
+    static Summary run(const ScanArchiveReader& input, ScanArchiveWriter& output) {
+        return run(input, output, Options());
+    }
+};
+
+#endif // BATCH_ENGINE_H
@@ -0,0 +1,100 @@
+#ifndef FRAME_INPUT_H
+#define FRAME_INPUT_H
+
+#include <opencv2/opencv.hpp>
+#include <jni.h>
+
+struct AHardwareBuffer;
+
+/**
+ * Frame ingestion for the NativeBridge entry points.
+ *
+ * Turns caller-owned RGBA pixels into a cv::Mat the pipeline can consume:
+ * - Java byte[]: converted to RGB in a single pass while the array is pinned,
+ *   or kept pinned as an RGBA view so the conversion can run off the JNI thread
+ * - direct ByteBuffer: wrapped in place (no copy), honouring the row stride
+ * - HardwareBuffer (API 26+): locked for CPU reads and wrapped in place
+ *
+ * Wrapped frames stay 4-channel RGBA; ImagePreprocessor and
+ * MediaPipePoseDetector accept RGBA input and do the one conversion they need.
+ * The wrapped memory is only valid while this object is alive, so keep it in
+ * scope for the duration of the JNI call.
+ */
+class FrameInput {
+public:
+    FrameInput() = default;
+    ~FrameInput();
+
+    FrameInput(const FrameInput&) = delete;
+    FrameInput& operator=(const FrameInput&) = delete;
+
+    /**
+     * Copy an RGBA byte[] into an owned RGB Mat (one conversion pass, no clone).
+     *
+     * @param env JNI environment
+     * @param image RGBA pixels, tightly packed (width * 4 bytes per row)
+     * @param width Image width in pixels
+     * @param height Image height in pixels
+     * @param minFill Fraction of width*height*4 the array must hold (1.0 = exact).
+     *                Rows missing from a short array are cropped, never over-read.
+     * @return true if the frame was loaded
+     */
+    bool loadByteArray(JNIEnv* env, jbyteArray image, int width, int height, float minFill = 1.0f);
+
+    /**
+     * Pin an RGBA byte[] and wrap it as an RGBA view without converting it.
+     * Unlike loadByteArray(), the pixels stay in Java memory, so the RGB
+     * conversion can run later on a worker thread (no JNI calls needed there).
+     * The array is unpinned when this object is destroyed; the caller must
+     * keep the jbyteArray local reference alive until then.
+     *
+     * @param env JNI environment (must outlive this object)
+     * @param image RGBA pixels, tightly packed (width * 4 bytes per row)
+     * @param width Image width in pixels
+     * @param height Image height in pixels
+     * @return true if the array is large enough and was pinned
+     */
+    bool pinByteArray(JNIEnv* env, jbyteArray image, int width, int height);
+
+    /**
+     * Wrap a direct ByteBuffer holding RGBA pixels without copying.
+     *
+     * @param env JNI environment
+     * @param buffer Direct java.nio.ByteBuffer (e.g. a CameraX RGBA_8888 plane)
+     * @param width Image width in pixels
+     * @param height Image height in pixels
+     * @param rowStride Bytes per row, or 0 for tightly packed (width * 4)
+     * @return true if the buffer is direct and large enough
+     */
+    bool wrapDirectBuffer(JNIEnv* env, jobject buffer, int width, int height, int rowStride);
+
+    /**
+     * Lock an android.hardware.HardwareBuffer (R8G8B8A8/R8G8B8X8) for CPU reads
+     * and wrap it without copying. Unlocked when this object is destroyed.
+     *
+     * @param env JNI environment
+     * @param hardwareBuffer android.hardware.HardwareBuffer object
+     * @return true if the buffer was locked; false on API < 26 or unsupported format
+     */
+    bool wrapHardwareBuffer(JNIEnv* env, jobject hardwareBuffer);
+
+    /**
+     * @return The loaded frame (RGB from byte[], RGBA view otherwise)
+     */
+    cv::Mat& image() { return img; }
+
+    bool empty() const { return img.empty(); }
+
+private:
+    void release();
+
+    cv::Mat img;
+    AHardwareBuffer* lockedBuffer = nullptr;
+
+    // Set while a byte[] is pinned by pinByteArray()
+    JNIEnv* pinnedEnv = nullptr;
+    jbyteArray pinnedArray = nullptr;
+    jbyte* pinnedData = nullptr;
+};
+
+#endif // FRAME_INPUT_H
@@ -10,10 +10,52 @@ public:
      * Applies CLAHE, optional background removal, and resizing
      * Modifies the input image in-place
      * 
+     * Uses a per-thread Context, so concurrent calls from different
+     * threads never share scratch buffers.
+     * 
      * @param img Input/output image (will be modified)
      */
     static void run(cv::Mat& img);
+    
+    /**
+     * Size of the preprocessed image for a given input size
+     * (inputs wider than the target width are scaled down).
+     * 
+     * @param input Input image size
+     * @return Output image size
+     */
+    static cv::Size outputSize(const cv::Size& input);
+    
+    /**
+     * Reusable preprocessing state: one CLAHE instance plus scratch Mats
+     * that keep their allocations between calls of the same frame size.
+     * Not thread-safe - use one Context per thread.
+     */
+    class Context {
+    public:
+        Context();
+        
+        /**
+         * Resize, apply CLAHE on the L channel and write RGB output.
+         * The image is resized first and converted straight between RGB(A)
+         * and Lab, so every full-image pass runs at the output resolution.
+         * 
+         * @param src Input image (RGB, RGBA or grayscale, CV_8U)
+         * @param dst Output image (CV_8UC3 RGB). If already allocated at
+         *            outputSize(src.size()) it is written in place, so a
+         *            caller-owned buffer can be reused. Must not be a
+         *            sub-view of src.
+         */
+        void run(const cv::Mat& src, cv::Mat& dst);
+        
+    private:
+        cv::Ptr<cv::CLAHE> clahe;
+        cv::Mat resized;    // Source-format scratch (only when downscaling)
+        cv::Mat rgb;        // Grayscale input expanded to RGB
+        cv::Mat lab;
+        cv::Mat lightness;
+        cv::Mat equalized;
+    };
 };
 
 #endif
-
@@ -0,0 +1,57 @@
+#ifndef JNI_REGISTRY_H
+#define JNI_REGISTRY_H
+
+#include <jni.h>
+
+/**
+ * Kotlin classes, constructors and callbacks the JNI entry points use,
+ * resolved once in JNI_OnLoad and held as global refs, so no scan, preview
+ * or validation call pays for FindClass/GetMethodID. Resolving at load time
+ * also runs on the thread calling System.loadLibrary, whose class loader
+ * sees the app classes (FindClass on worker threads only sees the system
+ * loader).
+ */
+struct JniRegistry {
+    static constexpr const char* kNativeBridgeClass = "com/example/bodyscanapp/utils/NativeBridge";
+
+    jclass nativeBridgeClass = nullptr;
+
+    // ScanResult(FloatArray, ByteArray, FloatArray, FloatArray?, ScanTimings?)
+    jclass scanResultClass = nullptr;
+    jmethodID scanResultInit = nullptr;
+
+    // ScanTimings(FloatArray, Int, Int)
+    jclass scanTimingsClass = nullptr;
+    jmethodID scanTimingsInit = nullptr;
+
+    // ImageValidationResult(Boolean, Boolean, Boolean, Float, String)
+    jclass validationResultClass = nullptr;
+    jmethodID validationResultInit = nullptr;
+
+    // ScanCallback.onProgress(Long, Int), onComplete(Long, ScanResult?), onCancelled(Long)
+    jclass scanCallbackClass = nullptr;
+    jmethodID scanCallbackProgress = nullptr;
+    jmethodID scanCallbackComplete = nullptr;
+    jmethodID scanCallbackCancelled = nullptr;
+
+    /**
+     * Resolve every entry (called from JNI_OnLoad).
+     *
+     * @param env JNI environment of the loading thread
+     * @return false if any class, constructor or method is missing; the pending
+     *         exception is cleared and the registry left empty
+     */
+    static bool load(JNIEnv* env);
+
+    /**
+     * Drop the global refs (JNI_OnUnload).
+     */
+    static void unload(JNIEnv* env);
+
+    /**
+     * @return The registry; all entries are null unless load() succeeded
+     */
+    static const JniRegistry& get();
+};
+
+#endif // JNI_REGISTRY_H
@@ -0,0 +1,201 @@
+#ifndef KEYPOINT_SCHEMA_H
+#define KEYPOINT_SCHEMA_H
+
+#include <opencv2/opencv.hpp>
+#include <array>
+#include <bitset>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Compile-time description of the keypoint layouts used by the pipeline.
+ *
+ * - MediaPipeLayout: the 33 Pose Landmarker landmarks
+ * - Body135Layout: the 33 landmarks followed by 102 interpolated points
+ * - Body25Layout: the BODY_25 subset MeshGenerator consumes
+ *
+ * PipelineLayout is what PoseEstimator and MultiView3D produce. Building with
+ * BODYSCAN_MEDIAPIPE_KEYPOINTS_ONLY makes it MediaPipeLayout, skipping the
+ * interpolated points none of the measurements or the mesh use. The JNI
+ * arrays always keep the 135-keypoint wire layout (WireLayout); slots the
+ * pipeline does not produce are left zero.
+ */
+struct MediaPipeLayout {
+    static constexpr size_t kCount = 33;
+
+    // Landmark indices (subject's left/right)
+    static constexpr int kNose = 0;
+    static constexpr int kLeftEye = 2;
+    static constexpr int kRightEye = 5;
+    static constexpr int kLeftShoulder = 11;
+    static constexpr int kRightShoulder = 12;
+    static constexpr int kLeftElbow = 13;
+    static constexpr int kRightElbow = 14;
+    static constexpr int kLeftWrist = 15;
+    static constexpr int kRightWrist = 16;
+    static constexpr int kLeftHip = 23;
+    static constexpr int kRightHip = 24;
+    static constexpr int kLeftKnee = 25;
+    static constexpr int kRightKnee = 26;
+    static constexpr int kLeftAnkle = 27;
+    static constexpr int kRightAnkle = 28;
+};
+
+struct Body135Layout {
+    static constexpr size_t kCount = 135;
+
+    // Keypoints [0, kMediaPipeCount) are the MediaPipe landmarks, unchanged
+    static constexpr size_t kMediaPipeCount = MediaPipeLayout::kCount;
+};
+
+struct Body25Layout {
+    static constexpr size_t kCount = 25;
+
+    /**
+     * Where a BODY_25 keypoint comes from: a single MediaPipe landmark
+     * (first == second), the midpoint of two landmarks (falling back to
+     * whichever one is valid), or nothing (first < 0).
+     */
+    struct Source {
+        int8_t first;
+        int8_t second;
+    };
+
+    // 0 nose, 1 neck, 2-4 right arm, 5-7 left arm, 8 mid hip,
+    // 9-11 right leg, 12-14 left leg; 15-24 (eyes, ears, feet) are unused
+    static constexpr std::array<Source, kCount> kFromMediaPipe = {{
+        {MediaPipeLayout::kNose, MediaPipeLayout::kNose},
+        {MediaPipeLayout::kLeftShoulder, MediaPipeLayout::kRightShoulder},
+        {MediaPipeLayout::kRightShoulder, MediaPipeLayout::kRightShoulder},
+        {MediaPipeLayout::kRightElbow, MediaPipeLayout::kRightElbow},
+        {MediaPipeLayout::kRightWrist, MediaPipeLayout::kRightWrist},
+        {MediaPipeLayout::kLeftShoulder, MediaPipeLayout::kLeftShoulder},
+        {MediaPipeLayout::kLeftElbow, MediaPipeLayout::kLeftElbow},
+        {MediaPipeLayout::kLeftWrist, MediaPipeLayout::kLeftWrist},
+        {MediaPipeLayout::kLeftHip, MediaPipeLayout::kRightHip},
+        {MediaPipeLayout::kRightHip, MediaPipeLayout::kRightHip},
+        {MediaPipeLayout::kRightKnee, MediaPipeLayout::kRightKnee},
+        {MediaPipeLayout::kRightAnkle, MediaPipeLayout::kRightAnkle},
+        {MediaPipeLayout::kLeftHip, MediaPipeLayout::kLeftHip},
+        {MediaPipeLayout::kLeftKnee, MediaPipeLayout::kLeftKnee},
+        {MediaPipeLayout::kLeftAnkle, MediaPipeLayout::kLeftAnkle},
+        {-1, -1}, {-1, -1}, {-1, -1}, {-1, -1}, {-1, -1},
+        {-1, -1}, {-1, -1}, {-1, -1}, {-1, -1}, {-1, -1},
+    }};
+};
+
+namespace keypoint_schema_detail {
+constexpr bool body25SourcesInRange() {
+    for (const Body25Layout::Source& source : Body25Layout::kFromMediaPipe) {
+        if (source.first >= static_cast<int>(MediaPipeLayout::kCount) ||
+            source.second >= static_cast<int>(MediaPipeLayout::kCount) ||
+            (source.first < 0) != (source.second < 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace keypoint_schema_detail
+
+static_assert(keypoint_schema_detail::body25SourcesInRange(),
+              "Body25Layout::kFromMediaPipe must reference MediaPipe landmarks");
+
+// Layout of the ScanResult keypoint arrays crossing JNI
+using WireLayout = Body135Layout;
+
+#ifdef BODYSCAN_MEDIAPIPE_KEYPOINTS_ONLY
+using PipelineLayout = MediaPipeLayout;
+#else
+using PipelineLayout = Body135Layout;
+#endif
+
+/**
+ * Fixed-size keypoint set for a layout, with a validity bit per keypoint.
+ * Validity is decided once, when points are added, so later stages test a
+ * bit instead of re-checking coordinates. Lives on the stack.
+ */
+template <typename Layout, typename Point = cv::Point3f>
+class KeypointSet {
+public:
+    static constexpr size_t kCount = Layout::kCount;
+
+    /**
+     * A keypoint is valid when all coordinates are finite and it is not
+     * exactly the origin (the "not detected" placeholder).
+     */
+    static bool isValidPoint(const cv::Point3f& pt) {
+        return std::isfinite(pt.x) && std::isfinite(pt.y) && std::isfinite(pt.z) &&
+               !(pt.x == 0.0f && pt.y == 0.0f && pt.z == 0.0f);
+    }
+
+    static bool isValidPoint(const cv::Point2f& pt) {
+        return std::isfinite(pt.x) && std::isfinite(pt.y) && !(pt.x == 0.0f && pt.y == 0.0f);
+    }
+
+    /**
+     * @param points At least kCount points; only the first kCount are read
+     * @param count Number of points available
+     * @return The set; invalid or missing points stay zero and unflagged
+     */
+    static KeypointSet fromPoints(const Point* points, size_t count) {
+        KeypointSet set;
+        const size_t n = count < kCount ? count : kCount;
+        for (size_t i = 0; i < n; ++i) {
+            if (isValidPoint(points[i])) {
+                set.set(i, points[i]);
+            }
+        }
+        return set;
+    }
+
+    const Point& operator[](size_t index) const { return points[index]; }
+    bool valid(size_t index) const { return mask.test(index); }
+    size_t validCount() const { return mask.count(); }
+
+    void set(size_t index, const Point& point) {
+        points[index] = point;
+        mask.set(index);
+    }
+
+    const std::array<Point, kCount>& data() const { return points; }
+
+    std::vector<Point> toVector() const {
+        return std::vector<Point>(points.begin(), points.end());
+    }
+
+private:
+    std::array<Point, kCount> points{};
+    std::bitset<kCount> mask;
+};
+
+/**
+ * Map a keypoint set whose first 33 entries are the MediaPipe landmarks
+ * (MediaPipeLayout or Body135Layout) to BODY_25 using Body25Layout::kFromMediaPipe.
+ */
+template <typename Layout, typename Point>
+KeypointSet<Body25Layout, Point> mapToBody25(const KeypointSet<Layout, Point>& src) {
+    static_assert(Layout::kCount >= MediaPipeLayout::kCount,
+                  "source layout must start with the MediaPipe landmarks");
+
+    KeypointSet<Body25Layout, Point> body25;
+    for (size_t i = 0; i < Body25Layout::kCount; ++i) {
+        const Body25Layout::Source source = Body25Layout::kFromMediaPipe[i];
+        if (source.first < 0) {
+            continue;
+        }
+        const bool firstValid = src.valid(source.first);
+        const bool secondValid = src.valid(source.second);
+        if (firstValid && secondValid) {
+            body25.set(i, (src[source.first] + src[source.second]) * 0.5f);
+        } else if (firstValid) {
+            body25.set(i, src[source.first]);
+        } else if (secondValid) {
+            body25.set(i, src[source.second]);
+        }
+    }
+    return body25;
+}
+
+#endif // KEYPOINT_SCHEMA_H
@@ -0,0 +1,80 @@
+#ifndef MASK_SCANLINE_H
+#define MASK_SCANLINE_H
+
+#include <opencv2/opencv.hpp>
+
+/**
+ * Horizontal foreground run, columns [begin, end)
+ */
+struct MaskRun {
+    int begin;
+    int end;
+};
+
+/**
+ * Scanline analysis of a person segmentation mask (CV_32FC1, 0-1 confidence).
+ *
+ * One sweep of a row returns every foreground run, so several measurements
+ * (left/right thigh edges, later waist and hips) can share it instead of each
+ * walking the row pixel by pixel. Rows are read through their row pointers,
+ * four columns per step with NEON where available.
+ */
+class MaskScanline {
+public:
+    // A pixel is foreground above this confidence
+    static constexpr float kForegroundThreshold = 0.5f;
+
+    // Largest supported radius for the multi-row form (9 rows)
+    static constexpr int kMaxRadius = 4;
+
+    /**
+     * Find the foreground runs along row y, voting over rows
+     * [y - radius, y + radius]: a column is foreground when more than half of
+     * those rows are (rows past the mask border are not counted). A radius of
+     * 1-2 smooths single-row mask noise at the same per-column cost.
+     *
+     * @param mask Segmentation mask (CV_32FC1)
+     * @param y Center row
+     * @param radius Rows on each side of y to combine (clamped to 0..kMaxRadius)
+     * @param runs Output runs, left to right
+     * @param maxRuns Capacity of runs; scanning stops once it is full
+     * @return Number of runs written; 0 if y is outside the mask or the mask
+     *         is not CV_32FC1
+     */
+    static int findRuns(const cv::Mat& mask, int y, int radius, MaskRun* runs, int maxRuns);
+
+    /**
+     * Same as above for a mask at its native resolution when the caller works
+     * in image coordinates: the image row is mapped to its mask row, and the
+     * runs come back in image columns. The result matches findRuns on the mask
+     * resized (nearest neighbour) to imageSize, without resizing it.
+     *
+     * @param imageSize Size of the image the row and runs refer to
+     * @param imageY Image row
+     * @param radius Mask rows on each side to combine
+     */
+    static int findRuns(const cv::Mat& mask, const cv::Size& imageSize, int imageY, int radius,
+                        MaskRun* runs, int maxRuns);
+
+    /**
+     * Same as above for a mask covering only part of the image (a mask
+     * from inference on a crop): rows outside maskRegion have no runs, and
+     * runs come back in image columns, offset by the region.
+     *
+     * @param maskRegion Image area the mask covers; empty for the whole image
+     */
+    static int findRuns(const cv::Mat& mask, const cv::Size& imageSize, const cv::Rect& maskRegion,
+                        int imageY, int radius, MaskRun* runs, int maxRuns);
+
+    /**
+     * @return Leftmost foreground column within [from, to], or -1 if none
+     */
+    static int firstForeground(const MaskRun* runs, int count, int from, int to);
+
+    /**
+     * @return Rightmost foreground column within [from, to], or -1 if none
+     */
+    static int lastForeground(const MaskRun* runs, int count, int from, int to);
+};
+
+#endif // MASK_SCANLINE_H
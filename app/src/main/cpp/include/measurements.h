@@ -0,0 +1,47 @@
+#ifndef MEASUREMENTS_H
+#define MEASUREMENTS_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// Number of values computeMeasurementsFrom2D produces
+constexpr int kMeasurementCount = 8;
+
+/**
+ * Computes body measurements from the 2D keypoints of one view, using the
+ * user's known height as the scale. If processedImg and segmentationMask are
+ * provided, thigh width comes from pixel-level edge detection on the mask
+ * (sampled at its own resolution, so it need not match the image size).
+ *
+ * MediaPipe landmark indices (33 total):
+ * 0: nose, 1-6: eyes, 7-8: ears, 9-10: mouth
+ * 11-12: shoulders, 13-14: elbows, 15-16: wrists (left, right)
+ * 17-22: hands (pinky, index, thumb for left/right)
+ * 23-24: hips, 25-26: knees, 27-28: ankles (left, right)
+ * 29-30: heels, 31-32: foot_index (left, right)
+ *
+ * Pure OpenCV (no JNI), part of the host-buildable core library.
+ *
+ * @param kpts2d Pipeline keypoints (MediaPipe landmarks first), normalized 0-1
+ * @param userHeight User height in centimeters
+ * @param imgWidth Width of the image the keypoints refer to
+ * @param imgHeight Height of the image the keypoints refer to
+ * @param processedImg Preprocessed image (only checked for presence)
+ * @param segmentationMask Person mask (CV_32FC1), any resolution
+ * @param maskRegion Image area the mask covers (PoseDetection::maskRegion);
+ *                   empty for the whole image
+ * @return kMeasurementCount values in cm, 0 where unavailable:
+ *         [0] shoulder width, [1] arm length, [2] leg length, [3] hip width,
+ *         [4] upper body length, [5] lower body length, [6] neck width
+ *         (eye to eye), [7] thigh width (left/right averaged where paired)
+ */
+std::vector<float> computeMeasurementsFrom2D(
+    const std::vector<cv::Point2f>& kpts2d,
+    float userHeight,
+    int imgWidth,
+    int imgHeight,
+    const cv::Mat& processedImg = cv::Mat(),
+    const cv::Mat& segmentationMask = cv::Mat(),
+    const cv::Rect& maskRegion = cv::Rect());
+
+#endif // MEASUREMENTS_H
@@ -4,6 +4,10 @@
 #include <opencv2/opencv.hpp>
 #include <vector>
 #include <jni.h>
+#include <mutex>
+#include <cstdint>
+
+class PoseSession;
 
 /**
  * MediaPipe Pose Detector wrapper class.
@@ -26,6 +30,41 @@ public:
      */
     static bool initialize(JNIEnv* env, jobject context);
     
+    /**
+     * Store the JavaVM and resolve the helper classes and method IDs while the
+     * library loads (JNI_OnLoad), where FindClass sees the app's class loader.
+     * If resolution fails here, initialize() retries it.
+     * 
+     * @param vm Java VM
+     * @param env JNI environment of the loading thread
+     * @return true if the method IDs were resolved
+     */
+    static bool onLoad(JavaVM* vm, JNIEnv* env);
+    
+    /**
+     * Everything one MediaPipe inference produces.
+     */
+    struct PoseDetection {
+        std::vector<cv::Point3f> landmarks;  // 33 normalized (x, y, z), empty if no person
+        std::vector<float> visibility;       // 33 visibility scores (0-1), empty if unavailable
+        int poseCount = 0;                   // Number of people detected
+        cv::Mat segmentationMask;            // CV_32FC1 at mask resolution, empty unless requested
+        cv::Rect maskRegion;                 // Image area the mask covers (the crop); empty = whole image
+    };
+    
+    /**
+     * Run a single pose inference and extract landmarks, pose count,
+     * visibility and (optionally) the segmentation mask from that one result.
+     * Uses the shared default session; callers with frames in flight
+     * concurrently should use their own PoseSession instead.
+     * 
+     * @param env JNI environment
+     * @param img Input image (RGB format, OpenCV Mat)
+     * @param withMask Also copy the segmentation mask out of the result
+     * @return Detection result; landmarks empty if detection failed
+     */
+    static PoseDetection detectFull(JNIEnv* env, const cv::Mat& img, bool withMask = false);
+    
     /**
      * Detect pose landmarks from an OpenCV Mat image.
      * 
@@ -37,8 +76,39 @@ public:
     static std::vector<cv::Point3f> detect(JNIEnv* env, const cv::Mat& img);
     
     /**
-     * Get segmentation mask from the last detection.
-     * Must be called after detect() with the same image.
+     * Start the VIDEO-mode landmarker behind detectTracked(). It follows the
+     * pose from the previous frame's landmarks instead of searching every
+     * frame for a person, which is what a stream of preview frames wants.
+     * 
+     * @param env JNI environment
+     * @return true if tracking is available (initialize() must have succeeded)
+     */
+    static bool startTracking(JNIEnv* env);
+    
+    /**
+     * Run one tracked inference on the next frame of a stream. Landmarks,
+     * visibility and pose count only; no result is retained and no mask is
+     * produced. Frames must be passed in order, one stream at a time.
+     * 
+     * @param env JNI environment (attached from g_jvm if null)
+     * @param img Input frame (RGB or RGBA, OpenCV Mat)
+     * @param timestampMs Frame time, strictly increasing across calls
+     * @return Detection result; landmarks empty if detection failed
+     */
+    static PoseDetection detectTracked(JNIEnv* env, const cv::Mat& img, int64_t timestampMs);
+    
+    /**
+     * Close the VIDEO-mode landmarker started by startTracking().
+     * 
+     * @param env JNI environment (attached from g_jvm if null)
+     */
+    static void stopTracking(JNIEnv* env);
+    
+    /**
+     * Get segmentation mask from the last detection on the default session.
+     * Must be called after detect() with the same image. Prefer
+     * detectFull(env, img, true) or PoseSession::segmentationMask(), which
+     * cannot pick up another caller's result.
      * 
      * @param env JNI environment
      * @param img Input image (RGB format, OpenCV Mat) - used to get mask dimensions
@@ -49,6 +119,7 @@ public:
     
     /**
      * Count the number of detected poses (people) in an image.
+     * Runs a full inference - prefer detectFull() when landmarks are needed too.
      * 
      * @param env JNI environment
      * @param img Input image (RGB format, OpenCV Mat)
@@ -72,24 +143,108 @@ public:
     static void release(JNIEnv* env);
 
 private:
+    friend class PoseSession;
+    
+    /**
+     * Session behind the static detect()/detectFull()/getSegmentationMask() API.
+     */
+    static PoseSession& defaultSession();
+    
     /**
      * Convert OpenCV Mat to Android Bitmap and call MediaPipe detection.
+     * Inference itself is serialized (one shared PoseLandmarker); the bitmap
+     * conversion before it runs concurrently.
      * 
      * @param env JNI environment
      * @param img Input OpenCV Mat (RGB)
-     * @return FloatArray of 33*3 = 99 floats [x1, y1, z1, x2, y2, z2, ...], or null
+     * @param videoTimestampMs Frame time for the VIDEO-mode landmarker, or -1
+     *                         for the IMAGE-mode one
+     * @return PoseLandmarkerResult local ref, or null
      */
-    static jfloatArray detectInternal(JNIEnv* env, const cv::Mat& img);
+    static jobject runInference(JNIEnv* env, const cv::Mat& img, int64_t videoTimestampMs = -1);
+    
+    /**
+     * Read the 33 landmarks of the first pose from a PoseLandmarkerResult.
+     */
+    static std::vector<cv::Point3f> extractLandmarks(JNIEnv* env, jobject result);
+    
+    /**
+     * Read the 33 visibility scores of the first pose from a PoseLandmarkerResult.
+     */
+    static std::vector<float> extractVisibility(JNIEnv* env, jobject result);
+    
+    /**
+     * Count the poses in a PoseLandmarkerResult.
+     */
+    static int extractPoseCount(JNIEnv* env, jobject result);
+    
+    /**
+     * Get the first segmentation mask of a PoseLandmarkerResult.
+     * When MediaPipe's mask ByteBuffer is direct, the Mat wraps it without a
+     * copy and holds a global ref to the buffer until the last Mat sharing
+     * that memory is released. Otherwise the mask is copied out of a float[].
+     * 
+     * @return CV_32FC1 mask, or empty Mat if none
+     */
+    static cv::Mat extractMask(JNIEnv* env, jobject result);
     
     /**
      * Convert OpenCV Mat to Android Bitmap.
+     * The bitmap comes from the pool and must be handed back with releaseBitmap().
      * 
      * @param env JNI environment
      * @param img Input OpenCV Mat (RGB)
-     * @return Bitmap object, or null on failure
+     * @return Pooled Bitmap (global ref), or null on failure
      */
     static jobject matToBitmap(JNIEnv* env, const cv::Mat& img);
     
+    /**
+     * Write an image into a locked RGBA_8888 bitmap, respecting its row stride.
+     * 
+     * @param env JNI environment
+     * @param img Source image (same size as the bitmap)
+     * @param conversion cv::cvtColor code to RGBA, or -1 to copy 4-channel data as-is
+     * @param bitmap Target bitmap
+     * @return true if the pixels were written
+     */
+    static bool copyToBitmap(JNIEnv* env, const cv::Mat& img, int conversion, jobject bitmap);
+    
+    /**
+     * Take an idle ARGB_8888 bitmap of the given size from the pool,
+     * creating one if none is free.
+     * 
+     * @return Bitmap global ref owned by the pool, or null on failure
+     */
+    static jobject acquireBitmap(JNIEnv* env, int width, int height);
+    
+    /**
+     * Return a bitmap obtained from acquireBitmap()/matToBitmap() to the pool.
+     */
+    static void releaseBitmap(JNIEnv* env, jobject bitmap);
+    
+    /**
+     * Delete every pooled bitmap (called from release()).
+     */
+    static void clearBitmapPool(JNIEnv* env);
+    
+    /**
+     * Pooled bitmap, reused across detections of the same frame size so a
+     * steady preview stream performs no Java heap allocations.
+     */
+    struct BitmapPoolEntry {
+        int width;
+        int height;
+        jobject bitmap;     // Global ref
+        bool inUse;
+        uint64_t lastUsed;  // Pool clock value, for LRU eviction
+    };
+    
+    // Enough for the three capture views plus a preview size
+    static constexpr size_t kBitmapPoolSize = 4;
+    static std::vector<BitmapPoolEntry> bitmapPool;
+    static std::mutex bitmapPoolMutex;
+    static uint64_t bitmapPoolClock;
+    
     // Cached JNI class and method IDs
     static jclass helperClass;
     static jclass bitmapClass;
@@ -98,17 +253,25 @@ private:
     static jmethodID detectMethod;
     static jmethodID extractMethod;
     static jmethodID extractMaskMethod;
+    static jmethodID extractMaskBufferMethod;
+    static jmethodID maskWidthMethod;
+    static jmethodID maskHeightMethod;
     static jmethodID countPosesMethod;
+    static jmethodID extractVisibilityMethod;
     static jmethodID isReadyMethod;
     static jmethodID releaseMethod;
+    static jmethodID startVideoMethod;
+    static jmethodID detectVideoMethod;
+    static jmethodID stopVideoMethod;
     static jmethodID createBitmapMethod;
+    static jobject argb8888Config;  // Global ref to Bitmap.Config.ARGB_8888
     static bool jniInitialized;
+    static std::mutex jniInitMutex;
     
-    /**
-     * Get the last detection result for mask extraction.
-     * This is a workaround - we need to store the result to extract mask.
-     */
-    static jobject lastDetectionResult;
+    // The Kotlin helper owns a single PoseLandmarker running in IMAGE mode,
+    // so calls into detectPose are made one at a time. The VIDEO-mode one
+    // shares the lock: both compete for the same cores
+    static std::mutex inferenceMutex;
     
     /**
      * Initialize JNI method IDs (called once).
@@ -119,5 +282,102 @@ private:
     static bool initializeJNI(JNIEnv* env);
 };
 
+/**
+ * Independent MediaPipe detection state.
+ * 
+ * Each session keeps its own handle to the last PoseLandmarkerResult behind
+ * its own lock, so several views or preview frames can be in flight at once
+ * (one session each) without one overwriting another's segmentation mask.
+ * A session itself processes one detection at a time.
+ */
+class PoseSession {
+public:
+    PoseSession() = default;
+    ~PoseSession();
+    
+    PoseSession(const PoseSession&) = delete;
+    PoseSession& operator=(const PoseSession&) = delete;
+    
+    /**
+     * Run one inference and keep its result for segmentationMask().
+     * 
+     * @param env JNI environment (attached from g_jvm if null)
+     * @param img Input image (RGB or RGBA, OpenCV Mat)
+     * @param withMask Also copy the segmentation mask out of the result
+     * @return Detection result; landmarks empty if detection failed
+     */
+    MediaPipePoseDetector::PoseDetection detect(JNIEnv* env, const cv::Mat& img, bool withMask = false);
+    
+    /**
+     * Like detect(), but runs inference on a crop: the box around this
+     * session's previous landmarks, padded by kRoiPadding on each side. Fewer
+     * pixels go through bitmap conversion and the model, and the person
+     * fills more of the model input. Landmarks come back in full-frame
+     * coordinates; the mask stays at the crop's resolution, with maskRegion
+     * set to the crop (MaskScanline maps through it).
+     * 
+     * Runs on the full frame when there is no previous pose or the crop would
+     * cover most of the frame anyway. Every call is one inference: when the
+     * crop finds no person or the pose reaches the crop border (the person
+     * moved out of it), the ROI is dropped and the next call searches the full
+     * frame. Meant for consecutive frames of one stream; poseCount only counts
+     * people inside the crop, so person-count validation should use detect().
+     * 
+     * @param env JNI environment (attached from g_jvm if null)
+     * @param img Input image (RGB or RGBA, OpenCV Mat)
+     * @param withMask Also copy the segmentation mask out of the result
+     * @return Detection result; landmarks empty if detection failed
+     */
+    MediaPipePoseDetector::PoseDetection detectWithRoi(JNIEnv* env, const cv::Mat& img, bool withMask = false);
+    
+    /**
+     * Segmentation mask of this session's last detection.
+     * 
+     * @param env JNI environment (attached from g_jvm if null)
+     * @param maskRegion Output: image area the mask covers; empty = whole image
+     * @return CV_32FC1 mask, or empty Mat if no detection or no mask
+     */
+    cv::Mat segmentationMask(JNIEnv* env, cv::Rect& maskRegion);
+    
+    /**
+     * Drop the retained result and the ROI (also done on destruction).
+     * 
+     * @param env JNI environment (attached from g_jvm if null)
+     */
+    void clear(JNIEnv* env);
+    
+    // ROI padding on each side, as a fraction of the landmark box size
+    static constexpr float kRoiPadding = 0.25f;
+    
+    // A crop covering more of the frame than this runs on the full frame instead
+    static constexpr float kMaxRoiArea = 0.7f;
+    
+    // Crop sizes are rounded up to this many pixels, so a steady stream
+    // reuses the same pooled bitmap size from frame to frame
+    static constexpr int kRoiGranularity = 64;
+
+private:
+    /**
+     * One inference on img(crop) (the whole image if crop is empty) with
+     * results mapped to full-frame coordinates. Caller holds mutex.
+     */
+    MediaPipePoseDetector::PoseDetection detectLocked(JNIEnv* env, const cv::Mat& img,
+                                                      bool withMask, const cv::Rect& crop);
+    
+    /**
+     * Padded pixel crop around the last landmarks for an image of this size,
+     * or an empty Rect if the full frame should be used. Caller holds mutex.
+     */
+    cv::Rect roiFor(const cv::Size& imageSize) const;
+    
+    std::mutex mutex;
+    jobject lastResult = nullptr;  // Global ref to the latest PoseLandmarkerResult
+    cv::Rect lastCrop;             // Crop lastResult ran on (empty = full frame)
+    
+    // Normalized full-frame box of the last detected landmarks
+    bool hasRoi = false;
+    cv::Rect2f roi;
+};
+
 #endif // MEDIAPIPE_POSE_DETECTOR_H
 
@@ -0,0 +1,167 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include "mesh_generator.h"
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Immutable GLB bytes held by MeshCache: either an owned buffer or a
+ * read-only mapping of a cache file (unmapped when the last reference goes).
+ */
+class MeshBlob {
+public:
+    explicit MeshBlob(std::vector<uint8_t> bytes) : owned(std::move(bytes)) {}
+    ~MeshBlob();
+
+    MeshBlob(const MeshBlob&) = delete;
+    MeshBlob& operator=(const MeshBlob&) = delete;
+
+    /**
+     * Map a file read-only.
+     *
+     * @param path GLB file
+     * @return Blob over the mapping, or null if the file is missing, empty or cannot be mapped
+     */
+    static std::shared_ptr<const MeshBlob> map(const std::string& path);
+
+    const uint8_t* data() const { return mapping != nullptr ? static_cast<const uint8_t*>(mapping) : owned.data(); }
+    size_t size() const { return mapping != nullptr ? mappedSize : owned.size(); }
+
+    /**
+     * @return true if the bytes are a file mapping (read-only memory)
+     */
+    bool mapped() const { return mapping != nullptr; }
+
+private:
+    MeshBlob() = default;
+
+    std::vector<uint8_t> owned;
+    void* mapping = nullptr;
+    size_t mappedSize = 0;
+};
+
+/**
+ * Content-addressed GLB cache: meshes are keyed by a hash of the BODY_25
+ * keypoints together with the LOD (segment count) and format, so a stored
+ * scan reopened with unchanged keypoints gets its existing GLB instead of a
+ * rebuild and re-serialization.
+ *
+ * Lookups go through an in-memory LRU bounded in bytes, then, when a
+ * directory is configured, an on-disk LRU of one file per mesh, mapped
+ * rather than read. Misses are built with MeshGenerator and written to both.
+ * Thread-safe; meshes are built outside the lock, so concurrent misses on
+ * the same key may both build it.
+ */
+class MeshCache {
+public:
+    // Bump when MeshGenerator output changes, so older disk entries are never served
+    static constexpr int kVersion = 1;
+
+    static constexpr size_t kDefaultMemoryBytes = 8u << 20;
+    static constexpr size_t kDefaultDiskBytes = 64u << 20;
+
+    struct Key {
+        uint64_t keypointHash = 0;
+        MeshLod lod = MeshLod::Standard;
+        MeshFormat format = MeshFormat::Float32;
+
+        bool operator==(const Key& other) const {
+            return keypointHash == other.keypointHash && lod == other.lod && format == other.format;
+        }
+    };
+
+    struct Stats {
+        uint64_t memoryHits = 0;
+        uint64_t diskHits = 0;
+        uint64_t misses = 0;       // Built by MeshGenerator
+        size_t memoryBytes = 0;    // GLB bytes resident in the memory LRU
+    };
+
+    explicit MeshCache(size_t memoryBytes = kDefaultMemoryBytes) : memoryBudget(memoryBytes) {}
+
+    /**
+     * @param body25 BODY_25 keypoints (cm), as passed to MeshGenerator
+     * @return Key of the mesh MeshGenerator would build for them
+     */
+    static Key keyFor(const std::vector<cv::Point3f>& body25, MeshLod lod, MeshFormat format);
+
+    /**
+     * Cached GLB for the keypoints, built (and cached) on a miss.
+     *
+     * @return GLB bytes, or null if no mesh can be built from the keypoints
+     */
+    std::shared_ptr<const MeshBlob> get(const std::vector<cv::Point3f>& body25,
+                                        MeshLod lod = MeshLod::Standard,
+                                        MeshFormat format = MeshFormat::Float32);
+
+    /**
+     * Lookup without building.
+     *
+     * @return GLB bytes, or null if the mesh is in neither cache
+     */
+    std::shared_ptr<const MeshBlob> find(const Key& key);
+
+    /**
+     * Enable the on-disk LRU, or disable it with an empty directory. The
+     * directory is created if missing, scanned once for its current size and
+     * trimmed to maxBytes right away. Afterwards the size is tracked in memory
+     * and the directory is only scanned again when a store goes over budget.
+     *
+     * @return false if the directory cannot be created
+     */
+    bool setDiskCache(const std::string& directory, size_t maxBytes = kDefaultDiskBytes);
+
+    /**
+     * Resize the memory LRU, evicting least recently used meshes to fit.
+     */
+    void setMemoryBudget(size_t bytes);
+
+    /**
+     * Drop every in-memory mesh (blobs still referenced elsewhere stay valid).
+     */
+    void clear();
+
+    Stats stats() const;
+
+private:
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return static_cast<size_t>(key.keypointHash ^ (static_cast<uint64_t>(key.lod) << 56) ^
+                                       (static_cast<uint64_t>(key.format) << 60));
+        }
+    };
+
+    using LruList = std::list<std::pair<Key, std::shared_ptr<const MeshBlob>>>;
+
+    std::string diskPath(const Key& key) const;
+    void insertLocked(const Key& key, std::shared_ptr<const MeshBlob> blob);
+    void evictLocked();
+    void store(const Key& key, const MeshBlob& blob);
+
+    /**
+     * Unlink least recently used files until at most maxBytes remain.
+     *
+     * @return Bytes of cache files left in the directory
+     */
+    static size_t trimDirectory(const std::string& directory, size_t maxBytes);
+
+    mutable std::mutex mutex;
+    LruList lru;  // Most recently used first
+    std::unordered_map<Key, LruList::iterator, KeyHash> entries;
+    size_t memoryBudget;
+    size_t memoryUsed = 0;
+    std::string diskDirectory;  // Empty: no disk cache
+    size_t diskBudget = kDefaultDiskBytes;
+    size_t diskUsed = 0;  // Bytes in diskDirectory, as of the last scan plus later stores
+    Stats counters;
+};
+
+#endif // MESH_CACHE_H
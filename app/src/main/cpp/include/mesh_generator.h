@@ -5,6 +5,27 @@
 #include <vector>
 #include <cstdint>
 
+/**
+ * Mesh level of detail - the tessellation used for every body part.
+ * Values match NativeBridge.MeshLod ordinals on the Kotlin side.
+ */
+enum class MeshLod : int {
+    Thumbnail = 0,  // 8 segments: a few hundred triangles, for list previews
+    Standard = 1,   // 16 segments: default
+    Detailed = 2    // 32 segments: high-resolution viewer and export
+};
+
+/**
+ * GLB vertex/index encoding.
+ * Values match NativeBridge.MeshFormat ordinals on the Kotlin side.
+ */
+enum class MeshFormat : int {
+    Float32 = 0,  // float32 positions and normals, uint32 indices
+    Compact = 1   // KHR_mesh_quantization: int16 positions (dequantized by the
+                  // node transform), normalized int8 normals, uint16 indices
+                  // when the vertex count allows - about half the size
+};
+
 class MeshGenerator {
 public:
     /**
@@ -12,11 +33,60 @@ public:
      * Generates ellipsoids/cylinders for each body segment and serializes to GLB format
      * 
      * @param kpts3d Vector of 135 3D keypoints (in centimeters)
+     * @param lod Level of detail (segments per ellipsoid/cylinder)
+     * @param format Vertex/index encoding of the GLB
      * @return GLB binary data as vector of bytes
      */
     static std::vector<uint8_t> createFromKeypoints(
-        const std::vector<cv::Point3f>& kpts3d
+        const std::vector<cv::Point3f>& kpts3d,
+        MeshLod lod = MeshLod::Standard,
+        MeshFormat format = MeshFormat::Float32
+    );
+    
+    /**
+     * Same as createFromKeypoints(kpts3d, lod, format), writing the GLB straight into
+     * a caller-provided buffer (e.g. a direct ByteBuffer) without an
+     * intermediate vector.
+     * 
+     * @param kpts3d Vector of BODY_25 3D keypoints (in centimeters)
+     * @param lod Level of detail
+     * @param format Vertex/index encoding of the GLB
+     * @param out Destination buffer
+     * @param capacity Size of out in bytes
+     * @return GLB size in bytes, or 0 if no mesh could be built. If the
+     *         result is larger than capacity nothing was written - retry
+     *         with a buffer of that size.
+     */
+    static size_t createFromKeypoints(
+        const std::vector<cv::Point3f>& kpts3d,
+        MeshLod lod,
+        MeshFormat format,
+        uint8_t* out,
+        size_t capacity
     );
+    
+    /**
+     * @param lod Level of detail
+     * @return Number of segments (sectors) per primitive for that level
+     */
+    static int segmentsFor(MeshLod lod);
+};
+
+// Number of values computeCircumferences produces per scan
+constexpr int kCircumferenceCount = 7;
+
+/**
+ * Horizontal body slices used by computeCircumferences, as fractions of the
+ * keypoints' vertical span measured from the top. The defaults follow
+ * typical human proportions.
+ */
+struct CircumferenceRegions {
+    float chest = 0.25f;
+    float waist = 0.50f;
+    float hip = 0.60f;
+    float thigh = 0.70f;
+    float arm = 0.30f;
+    float tolerance = 0.05f;  // Half-thickness of each slice
 };
 
 /**
@@ -24,9 +94,25 @@ public:
  * Calculates waist, chest, hips, thighs, and arms circumferences
  * 
  * @param kpts3d Vector of 135 3D keypoints (in centimeters)
+ * @param regions Slice positions
  * @return Vector of measurements in cm: [waist, chest, hips, left_thigh, right_thigh, left_arm, right_arm]
  */
-std::vector<float> computeCircumferences(const std::vector<cv::Point3f>& kpts3d);
+std::vector<float> computeCircumferences(const std::vector<cv::Point3f>& kpts3d,
+                                         const CircumferenceRegions& regions = CircumferenceRegions());
+
+/**
+ * Batch form for re-measuring stored scans: the slice buffers are allocated
+ * once and reused for every scan.
+ * 
+ * @param kpts3d scanCount scans stored back to back, keypointsPerScan points each
+ * @param keypointsPerScan Keypoints per scan (e.g. 135)
+ * @param scanCount Number of scans
+ * @param regions Slice positions, shared by all scans
+ * @param out scanCount * kCircumferenceCount values, one row per scan in the
+ *            order of computeCircumferences(); zeros for unusable scans
+ */
+void computeCircumferences(const cv::Point3f* kpts3d, size_t keypointsPerScan, size_t scanCount,
+                           const CircumferenceRegions& regions, float* out);
 
 #endif
 
@@ -6,18 +6,52 @@
 
 class MultiView3D {
 public:
+    // Supported number of views (cameras evenly spaced around the person)
+    static constexpr int kMinViews = 2;
+    static constexpr int kMaxViews = 8;
+    
     /**
      * Triangulates 3D keypoints from multiple 2D views
-     * Uses multi-view stereo triangulation and scales using user height
+     * Uses N-view linear (DLT/SVD) triangulation over every view in which a
+     * keypoint was detected, and scales using user height (see heightScale())
      * 
-     * @param kpts2d Vector of 3 views, each containing 135 2D keypoints (normalized 0-1)
+     * View 0 is the front; the others follow at equal angles around the
+     * person (3 views = front, left at 120 degrees, right at -120 degrees).
+     * 
+     * @param kpts2d kMinViews..kMaxViews views, each containing 135 2D keypoints (normalized 0-1)
      * @param userHeight User height in centimeters (for scaling)
-     * @return Vector of 135 3D keypoints in real-world coordinates (centimeters)
+     * @return Vector of 135 3D keypoints in real-world coordinates (centimeters);
+     *         zeros for keypoints seen in fewer than two views
      */
     static std::vector<cv::Point3f> triangulate(
         const std::vector<std::vector<cv::Point2f>>& kpts2d,
         float userHeight
     );
+    
+    /**
+     * Same as triangulate(kpts2d, userHeight), writing into a caller-owned
+     * buffer so repeated scans reuse its allocation.
+     * 
+     * @param kpts2d kMinViews..kMaxViews views, each containing 135 2D keypoints (normalized 0-1)
+     * @param userHeight User height in centimeters (for scaling)
+     * @param kpts3d Output, resized to 135 3D keypoints (zeros where triangulation failed)
+     */
+    static void triangulate(
+        const std::vector<std::vector<cv::Point2f>>& kpts2d,
+        float userHeight,
+        std::vector<cv::Point3f>& kpts3d
+    );
+    
+    /**
+     * Height scaling stage: scale factor that maps triangulated points to
+     * centimeters, from the nose-to-ankle span of the points themselves.
+     * Depends only on its arguments, so concurrent scans never share state.
+     * 
+     * @param kpts3d Unscaled triangulated keypoints (MediaPipe landmarks first)
+     * @param userHeight User height in centimeters
+     * @return Scale factor, or 1.0 if the height or landmarks are unavailable
+     */
+    static float heightScale(const std::vector<cv::Point3f>& kpts3d, float userHeight);
 };
 
 #endif
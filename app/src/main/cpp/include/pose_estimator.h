@@ -18,7 +18,9 @@ public:
      * Returns 135 keypoints in normalized coordinates (0-1 range).
      * 
      * MediaPipe provides 33 landmarks which are mapped to 135 keypoints
-     * through interpolation and direct mapping.
+     * through interpolation and direct mapping. The count is
+     * PipelineLayout::kCount (keypoint_schema.h): 33 in a
+     * BODYSCAN_MEDIAPIPE_KEYPOINTS_ONLY build.
      * 
      * @param img Input image (RGB, OpenCV Mat)
      * @return Vector of 135 2D keypoints (normalized x, y coordinates)
@@ -26,6 +28,26 @@ public:
      */
     static std::vector<cv::Point2f> detect(const cv::Mat& img);
     
+    /**
+     * Detects 2D keypoints and returns the segmentation mask from the same
+     * MediaPipe inference (no second detection, no reliance on the last call).
+     * 
+     * @param img Input image (RGB, OpenCV Mat)
+     * @param segmentationMask Output mask (CV_32FC1 at MediaPipe's mask resolution),
+     *                         empty if unavailable
+     * @return Vector of 135 2D keypoints (normalized x, y coordinates)
+     */
+    static std::vector<cv::Point2f> detect(const cv::Mat& img, cv::Mat& segmentationMask);
+    
+    /**
+     * Map 33 MediaPipe landmarks to the pipeline keypoints the way detect()
+     * does, for callers that run inference themselves (e.g. PreviewSession).
+     * 
+     * @param landmarks 33 normalized MediaPipe landmarks
+     * @return PipelineLayout::kCount 2D keypoints; zeros if landmarks is not 33 long
+     */
+    static std::vector<cv::Point2f> mapLandmarks(const std::vector<cv::Point3f>& landmarks);
+    
     /**
      * Validation result structure
      */
@@ -50,6 +72,9 @@ public:
      * @return ValidationResult with validation status, confidence, and message
      */
     static ValidationResult validateImage(const cv::Mat& img);
+
+private:
+    static std::vector<cv::Point2f> detect(const cv::Mat& img, cv::Mat& segmentationMask, bool withMask);
 };
 
 #endif
@@ -0,0 +1,57 @@
+#ifndef PREPROCESS_POOL_H
+#define PREPROCESS_POOL_H
+
+#include "scan_trace.h"
+#include <opencv2/opencv.hpp>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Long-lived threads running ImagePreprocessor::run() for views that are
+ * preprocessed while another view is in inference. The threads outlive
+ * scans, so their thread-local ImagePreprocessor contexts (CLAHE and
+ * scratch Mats) are built once and reused by every scan, unlike threads
+ * started per scan. Pure OpenCV: the workers make no JNI calls.
+ */
+class PreprocessPool {
+public:
+    // Views 1-2 of a three-view scan in parallel
+    static constexpr int kWorkerCount = 2;
+
+    /**
+     * @return Process-wide pool (never destroyed; workers start on first use)
+     */
+    static PreprocessPool& shared();
+
+    PreprocessPool() = default;
+    ~PreprocessPool();
+
+    PreprocessPool(const PreprocessPool&) = delete;
+    PreprocessPool& operator=(const PreprocessPool&) = delete;
+
+    /**
+     * Queue ImagePreprocessor::run(img). Runs on the calling thread if no
+     * worker could be started.
+     *
+     * @param img Image preprocessed in place; must stay alive until the
+     *            future is ready (the future does not wait on destruction)
+     * @param timings Timings the Preprocess stage records into, or null
+     * @return Ready once img is preprocessed; get() rethrows a failure
+     */
+    std::future<void> submit(cv::Mat& img, ScanTimings* timings);
+
+private:
+    void run();
+
+    std::mutex mutex;
+    std::condition_variable taskReady;
+    std::deque<std::packaged_task<void()>> tasks;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+};
+
+#endif // PREPROCESS_POOL_H
@@ -0,0 +1,156 @@
+#ifndef PREVIEW_SESSION_H
+#define PREVIEW_SESSION_H
+
+#include "keypoint_schema.h"
+#include "mediapipe_pose_detector.h"
+#include <opencv2/opencv.hpp>
+#include <jni.h>
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * One Euro filter for a single coordinate: a low-pass filter whose cutoff
+ * rises with the signal's speed, so a still pose stops jittering while fast
+ * motion is followed with little lag. Costs a few multiplies per sample.
+ */
+class OneEuroFilter {
+public:
+    struct Params {
+        float minCutoff = 1.5f;        // Hz, cutoff when still (lower = smoother)
+        float beta = 5.0f;             // Cutoff increase per unit/s of speed (higher = less lag)
+        float derivativeCutoff = 1.0f; // Hz, cutoff of the speed estimate
+    };
+
+    /**
+     * @param value New sample
+     * @param dt Seconds since the previous sample (> 0)
+     * @return Filtered value; the first sample after reset() passes through
+     */
+    float filter(float value, float dt, const Params& params);
+
+    void reset() { initialized = false; }
+
+private:
+    bool initialized = false;
+    float lastValue = 0.0f;
+    float lastDerivative = 0.0f;
+};
+
+/**
+ * Streaming keypoint detection for the camera preview overlay.
+ *
+ * pushFrame() copies the frame (downscaled to kMaxFrameSide) into a reused
+ * buffer and returns at once; a worker thread runs tracked inference
+ * (MediaPipePoseDetector::detectTracked, seeded by the previous frame's
+ * landmarks) on the newest frame. A frame pushed while the worker is busy
+ * replaces the one waiting, so slow inference drops frames instead of
+ * building a backlog. Landmarks are smoothed with a One Euro filter per
+ * coordinate, and the last pose is held for kHoldFrames frames when
+ * detection drops out briefly.
+ *
+ * Frame buffers, filters and the result array live as long as the session,
+ * so a steady stream allocates nothing per frame on the Java heap.
+ */
+class PreviewSession {
+public:
+    // Result floats: normalized x, y per keypoint of the wire layout
+    static constexpr size_t kKeypointFloats = WireLayout::kCount * 2;
+
+    // Frames without a pose before the held result is cleared and smoothing restarts
+    static constexpr int kHoldFrames = 3;
+
+    // Longer frame side kept for inference; the model runs at a fraction of it
+    static constexpr int kMaxFrameSide = 640;
+
+    PreviewSession() = default;
+    ~PreviewSession();
+
+    PreviewSession(const PreviewSession&) = delete;
+    PreviewSession& operator=(const PreviewSession&) = delete;
+
+    /**
+     * Start the worker thread (no-op if already running). Returns once the
+     * worker has attached to the JVM.
+     *
+     * @param env JNI environment
+     * @return true if the session is running; false if MediaPipe is not ready
+     *         or the worker could not start or attach
+     */
+    bool start(JNIEnv* env);
+
+    /**
+     * Hand the next frame to the worker. The pixels are copied, so the
+     * caller's buffer can be reused as soon as this returns.
+     *
+     * @param frame RGB or RGBA frame
+     * @return false if the session is not running or the frame is empty
+     */
+    bool pushFrame(const cv::Mat& frame);
+
+    /**
+     * Copy the latest smoothed keypoints.
+     *
+     * @param out kKeypointFloats floats (normalized x, y; zeros when no pose)
+     * @return Sequence number (1-based) of the frame the keypoints come from,
+     *         or 0 if no frame has been processed yet
+     */
+    uint64_t latest(float* out) const;
+
+    /**
+     * Stop and join the worker, dropping any waiting frame and the filter state.
+     *
+     * @param env JNI environment (attached from g_jvm if null)
+     */
+    void stop(JNIEnv* env);
+
+    struct Stats {
+        uint64_t pushed = 0;     // Frames handed to pushFrame()
+        uint64_t processed = 0;  // Frames inference ran on
+        uint64_t dropped = 0;    // Frames replaced before the worker took them
+    };
+
+    Stats stats() const;
+
+private:
+    void run(std::promise<bool> attached);
+    void process(JNIEnv* env, const cv::Mat& frame, uint64_t sequence, int64_t timestampMs);
+
+    std::mutex lifecycleMutex;  // Serializes start() and stop()
+    mutable std::mutex mutex;
+    std::condition_variable frameReady;
+    std::thread worker;
+    bool running = false;
+    bool tracking = false;  // VIDEO-mode landmarker started; only changes while no worker runs
+
+    // Frames rotate incoming -> pending -> working by swapping, so each
+    // buffer is reallocated only when the frame size changes
+    std::mutex pushMutex;    // Serializes producers around incoming
+    cv::Mat incoming;
+    cv::Mat pending;
+    bool hasPending = false;
+    uint64_t pendingSequence = 0;
+    int64_t pendingTimestampMs = 0;
+    uint64_t nextSequence = 0;
+
+    // Published result (guarded by mutex)
+    std::array<float, kKeypointFloats> output{};
+    uint64_t outputSequence = 0;
+    Stats counters;
+
+    // Worker-only state
+    cv::Mat working;
+    PoseSession fallbackSession;  // IMAGE-mode ROI detection when tracking is unavailable
+    OneEuroFilter::Params filterParams;
+    std::array<OneEuroFilter, MediaPipeLayout::kCount * 2> filters;
+    std::vector<cv::Point3f> smoothed;
+    int64_t lastTimestampMs = -1;
+    int64_t lastFilteredMs = -1;
+    int missedFrames = 0;
+};
+
+#endif // PREVIEW_SESSION_H
@@ -0,0 +1,215 @@
+#ifndef SCAN_ARCHIVE_H
+#define SCAN_ARCHIVE_H
+
+#include "keypoint_schema.h"
+#include "measurements.h"
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Byte layout of a scan archive: stored scans reduced to what triangulation,
+ * meshing and measurements need, so they can be reprocessed without the
+ * camera frames. Little endian, every section 16-byte aligned, so a mapped
+ * file is read in place.
+ *
+ * File:
+ *
+ *   offset  size    field
+ *   0       4       magic "BSA1"
+ *   4       4       uint32 version (kVersion)
+ *   8       4       uint32 recordCount
+ *   12      4       reserved, zero
+ *   16      8       uint64 indexOffset
+ *   24      8       uint64 fileBytes
+ *   32      ...     records
+ *   indexOffset     uint64[recordCount] record offsets, in record order
+ *
+ * Record (at a 16-byte aligned offset):
+ *
+ *   0       4       uint32 recordBytes (to the next record, padding included)
+ *   4       4       uint32 flags (kHasResults)
+ *   8       8       uint64 scanId (caller-defined, e.g. a database key)
+ *   16      4       float userHeightCm
+ *   20      8       uint32 frontWidth, frontHeight (image the 2D landmarks were measured on)
+ *   28      8       uint32 maskWidth, maskHeight (0 when there is no mask)
+ *   36      4       uint32 maskBytes (compressed, see MaskCodec)
+ *   40      4       uint32 glbBytes
+ *   44      4       reserved, zero
+ *   48      792     float[3 * 33 * 2] landmarks, per view, normalized 0-1
+ *   840     396     float[33 * 3] keypoints3d (cm), valid with kHasResults
+ *   1236    32      float[8] measurements (cm), valid with kHasResults
+ *   1280    ...     mask bytes, then the GLB at the next 16-byte boundary
+ *
+ * A file that was not closed has no index (indexOffset 0) and is rejected.
+ */
+struct ScanArchiveLayout {
+    static constexpr uint32_t kMagic = 0x31415342;  // "BSA1" in little endian
+    static constexpr uint32_t kVersion = 1;
+
+    static constexpr int kViewCount = 3;
+    static constexpr size_t kLandmarkCount = MediaPipeLayout::kCount;
+
+    static constexpr size_t kFileHeaderBytes = 32;
+    static constexpr size_t kRecordHeaderBytes = 48;
+
+    // Record flags
+    static constexpr uint32_t kHasResults = 1u << 0;
+
+    static constexpr size_t kLandmarksOffset = kRecordHeaderBytes;
+    static constexpr size_t kKeypoints3dOffset =
+        kLandmarksOffset + kViewCount * kLandmarkCount * 2 * sizeof(float);
+    static constexpr size_t kMeasurementsOffset = kKeypoints3dOffset + kLandmarkCount * 3 * sizeof(float);
+    // Mask start rounded up to 16 bytes
+    static constexpr size_t kMaskOffset =
+        (kMeasurementsOffset + kMeasurementCount * sizeof(float) + 15) / 16 * 16;
+};
+
+static_assert(ScanArchiveLayout::kKeypoints3dOffset == 840, "ScanArchive layout changed");
+static_assert(ScanArchiveLayout::kMeasurementsOffset == 1236, "ScanArchive layout changed");
+static_assert(ScanArchiveLayout::kMaskOffset == 1280, "ScanArchive layout changed");
+
+/**
+ * One archived scan. Filled by ScanArchiveReader with pointers into the
+ * mapped file, or by the caller with its own memory for ScanArchiveWriter.
+ */
+struct ScanRecordView {
+    uint64_t scanId = 0;
+    float userHeightCm = 0.0f;
+    int frontWidth = 0;
+    int frontHeight = 0;
+
+    // kViewCount * kLandmarkCount points, view 0 (front) first
+    const cv::Point2f* landmarks = nullptr;
+
+    // Results of the last processing; null when the record has none
+    const cv::Point3f* keypoints3d = nullptr;  // kLandmarkCount points
+    const float* measurements = nullptr;       // kMeasurementCount values
+
+    int maskWidth = 0;
+    int maskHeight = 0;
+    const uint8_t* mask = nullptr;  // MaskCodec::encode output
+    size_t maskBytes = 0;
+
+    const uint8_t* glb = nullptr;
+    size_t glbBytes = 0;
+
+    /**
+     * @return Landmarks of one view as the pipeline takes them
+     */
+    std::vector<cv::Point2f> view(int index) const;
+
+    /**
+     * @return Front segmentation mask (CV_32FC1, 0-1), empty if the record
+     *         has none or it does not decode to maskWidth x maskHeight
+     */
+    cv::Mat decodeMask() const;
+};
+
+/**
+ * Segmentation mask compression for the archive: confidence quantized to
+ * uint8, then PackBits run-length coded (person masks are long runs of 0
+ * and 255 with short soft edges).
+ */
+class MaskCodec {
+public:
+    /**
+     * @param mask CV_32FC1 (0-1 confidence) or CV_8UC1 (0-255) mask
+     * @param out Output, replaced; empty if the mask is empty or of another type
+     */
+    static void encode(const cv::Mat& mask, std::vector<uint8_t>& out);
+
+    /**
+     * @return CV_8UC1 mask, or empty if data does not decode to exactly width x height
+     */
+    static cv::Mat decode(const uint8_t* data, size_t size, int width, int height);
+};
+
+/**
+ * Appends records to a new archive file. close() writes the index and the
+ * header; until then the file is incomplete. Not thread-safe.
+ */
+class ScanArchiveWriter {
+public:
+    ScanArchiveWriter() = default;
+    ~ScanArchiveWriter();
+
+    ScanArchiveWriter(const ScanArchiveWriter&) = delete;
+    ScanArchiveWriter& operator=(const ScanArchiveWriter&) = delete;
+
+    /**
+     * @param path File to create (replaced if it exists)
+     * @return false if the file cannot be created
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @param record Scan to append; landmarks are required
+     * @return false if not open, the record lacks landmarks or the write failed
+     */
+    bool append(const ScanRecordView& record);
+
+    /**
+     * Write the index and header and close the file.
+     *
+     * @return false if not open or the write failed
+     */
+    bool close();
+
+    /**
+     * @return Records appended since open()
+     */
+    size_t size() const { return offsets.size(); }
+
+private:
+    bool write(const void* data, size_t size);
+
+    int fd = -1;
+    uint64_t position = 0;
+    std::vector<uint64_t> offsets;
+    std::vector<uint8_t> staging;  // One record, reused
+};
+
+/**
+ * Read-only mapping of an archive. Records are validated on access and
+ * point into the mapping, which lives as long as the reader. Reading is
+ * thread-safe.
+ */
+class ScanArchiveReader {
+public:
+    ScanArchiveReader() = default;
+    ~ScanArchiveReader();
+
+    ScanArchiveReader(const ScanArchiveReader&) = delete;
+    ScanArchiveReader& operator=(const ScanArchiveReader&) = delete;
+
+    /**
+     * @param path Archive file
+     * @return false if the file cannot be mapped, is not a kVersion archive or was not closed
+     */
+    bool open(const std::string& path);
+
+    void close();
+
+    /**
+     * @return Number of records
+     */
+    size_t size() const { return count; }
+
+    /**
+     * @param index Record index, 0 to size() - 1
+     * @param record Output, pointing into the mapping
+     * @return false if the index is out of range or the record is corrupt
+     */
+    bool record(size_t index, ScanRecordView& record) const;
+
+private:
+    const uint8_t* data = nullptr;
+    size_t bytes = 0;
+    size_t count = 0;
+    uint64_t indexOffset = 0;
+};
+
+#endif // SCAN_ARCHIVE_H
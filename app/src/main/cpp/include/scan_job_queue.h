@@ -0,0 +1,131 @@
+#ifndef SCAN_JOB_QUEUE_H
+#define SCAN_JOB_QUEUE_H
+
+#include "scan_trace.h"
+#include <jni.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Thrown by ScanJob::checkpoint() once the job is cancelled, to unwind the
+ * pipeline between stages. Caught by the queue, never by the pipeline.
+ */
+struct ScanCancelled {};
+
+/**
+ * One queued scan. The pipeline calls checkpoint() before each stage, which
+ * reports progress to the listener and is where cancellation takes effect:
+ * a stage that already started runs to completion.
+ */
+class ScanJob {
+public:
+    ScanJob(uint64_t handle, jobject listener) : jobHandle(handle), callback(listener) {}
+
+    uint64_t handle() const { return jobHandle; }
+
+    bool isCancelled() const { return cancelled.load(std::memory_order_relaxed); }
+
+    void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+
+    /**
+     * Report that stage is about to run (NativeBridge.ScanCallback.onProgress).
+     * Only call from the thread running the job.
+     *
+     * @throws ScanCancelled if the job was cancelled
+     */
+    void checkpoint(ScanStage stage);
+
+private:
+    friend class ScanJobQueue;
+
+    const uint64_t jobHandle;
+    const jobject callback;  // Global ref to a NativeBridge.ScanCallback, owned by the queue
+    JNIEnv* env = nullptr;   // Worker running the job, set while it runs
+    std::atomic<bool> cancelled{false};
+};
+
+/**
+ * Fixed pool of JVM-attached worker threads running scan jobs in FIFO order.
+ *
+ * submit() returns a handle at once; the job later completes on a worker
+ * through its listener with either onComplete(handle, result) or, if it was
+ * cancelled before or between stages, onCancelled(handle). Exactly one of
+ * the two is called per job, including a job that could not run (it
+ * completes with a null result). MediaPipe serializes inference, so with two
+ * workers one job's preprocessing overlaps another's inference, and a stale
+ * job being cancelled does not hold up the one replacing it.
+ */
+class ScanJobQueue {
+public:
+    /**
+     * Builds the job's ScanResult on the worker thread.
+     *
+     * @return ScanResult local ref (may be null)
+     * @throws ScanCancelled from ScanJob::checkpoint()
+     */
+    using Work = std::function<jobject(JNIEnv* env, ScanJob& job)>;
+
+    static constexpr int kWorkerCount = 2;
+
+    ScanJobQueue() = default;
+    ~ScanJobQueue();
+
+    ScanJobQueue(const ScanJobQueue&) = delete;
+    ScanJobQueue& operator=(const ScanJobQueue&) = delete;
+
+    /**
+     * Queue a job, starting the workers on first use.
+     *
+     * @param env JNI environment of the caller
+     * @param listener NativeBridge.ScanCallback; a global ref is kept until the job completes
+     * @param work Pipeline to run; must own copies of its inputs
+     * @return Job handle (> 0), or 0 if the listener is null or no worker could
+     *         start and attach to the JVM
+     */
+    uint64_t submit(JNIEnv* env, jobject listener, Work work);
+
+    /**
+     * Request cancellation. A queued job completes with onCancelled without
+     * running; a running one at its next checkpoint.
+     *
+     * @return false if the job is unknown or already completed
+     */
+    bool cancel(uint64_t handle);
+
+    /**
+     * @return Jobs queued or running
+     */
+    size_t pending() const;
+
+private:
+    void run();
+    void execute(JNIEnv* env, const std::shared_ptr<ScanJob>& job, Work& work);
+    static void finish(JNIEnv* env, const ScanJob& job, jobject result, bool cancelled);
+    void stop();
+
+    struct Entry {
+        std::shared_ptr<ScanJob> job;
+        Work work;
+    };
+
+    mutable std::mutex mutex;
+    std::condition_variable jobReady;
+    std::condition_variable workerReported;
+    std::deque<Entry> queued;
+    std::unordered_map<uint64_t, std::shared_ptr<ScanJob>> jobs;  // Queued or running
+    std::vector<std::thread> workers;
+    size_t reportedWorkers = 0;  // Workers that tried to attach
+    size_t attachedWorkers = 0;  // Of those, the ones that did (and run jobs)
+    uint64_t nextHandle = 0;
+    bool stopping = false;
+};
+
+#endif // SCAN_JOB_QUEUE_H
@@ -0,0 +1,136 @@
+#ifndef SCAN_OUTPUT_H
+#define SCAN_OUTPUT_H
+
+#include "keypoint_schema.h"
+#include "measurements.h"
+#include "scan_trace.h"
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Outcome of a scan written into a ScanOutput buffer. Values are stored in
+ * the buffer header and must match NativeBridge.ScanOutput.
+ */
+enum class ScanOutputStatus : int32_t {
+    Ok = 0,
+    InvalidInput = 1,   // Frames missing or of the wrong size; all sections zero
+    Failed = 2,         // Processing threw; all sections zero
+    MeshTooLarge = 3    // Everything but the mesh was written; meshBytes is the size needed
+};
+
+/**
+ * Byte layout of one scan result in a single caller-owned buffer (a direct
+ * ByteBuffer reused across scans), in native byte order:
+ *
+ *   offset  size    field
+ *   0       4       magic "BSO1"
+ *   4       4       uint32 version (kVersion)
+ *   8       4       int32 status (ScanOutputStatus)
+ *   12      4       uint32 meshBytes (GLB size; 0 for single image)
+ *   16      4       uint32 maskBytes (segmentation mask read back from MediaPipe)
+ *   20      12      reserved, zero
+ *   32      32      float[8] stage times in ms, in ScanStage order
+ *   64      1620    float[135 * 3] keypoints3d (cm, zero for single image)
+ *   1684    1080    float[135 * 2] keypoints2d (normalized, zero for three views)
+ *   2764    32      float[8] measurements (cm)
+ *   2800    ...     GLB bytes, up to the end of the buffer
+ *
+ * The sections mirror the ScanResult arrays, in the 135-keypoint wire layout.
+ */
+struct ScanOutputLayout {
+    static constexpr uint32_t kMagic = 0x314F5342;  // "BSO1" in little endian
+    static constexpr uint32_t kVersion = 1;
+
+    static constexpr size_t kMagicOffset = 0;
+    static constexpr size_t kVersionOffset = 4;
+    static constexpr size_t kStatusOffset = 8;
+    static constexpr size_t kMeshBytesOffset = 12;
+    static constexpr size_t kMaskBytesOffset = 16;
+    static constexpr size_t kHeaderBytes = 32;
+
+    static constexpr size_t kKeypoints3dFloats = WireLayout::kCount * 3;
+    static constexpr size_t kKeypoints2dFloats = WireLayout::kCount * 2;
+
+    static constexpr size_t kStageMsOffset = kHeaderBytes;
+    static constexpr size_t kKeypoints3dOffset = kStageMsOffset + kScanStageCount * sizeof(float);
+    static constexpr size_t kKeypoints2dOffset = kKeypoints3dOffset + kKeypoints3dFloats * sizeof(float);
+    static constexpr size_t kMeasurementsOffset = kKeypoints2dOffset + kKeypoints2dFloats * sizeof(float);
+    // Mesh start rounded up to 16 bytes
+    static constexpr size_t kMeshOffset =
+        (kMeasurementsOffset + kMeasurementCount * sizeof(float) + 15) / 16 * 16;
+
+    // Smallest buffer that holds everything but the mesh
+    static constexpr size_t kMinCapacity = kMeshOffset;
+};
+
+static_assert(ScanOutputLayout::kKeypoints3dOffset == 64, "ScanOutput layout changed");
+static_assert(ScanOutputLayout::kKeypoints2dOffset == 1684, "ScanOutput layout changed");
+static_assert(ScanOutputLayout::kMeasurementsOffset == 2764, "ScanOutput layout changed");
+static_assert(ScanOutputLayout::kMeshOffset == 2800, "ScanOutput layout changed");
+
+/**
+ * Fills a ScanOutputLayout buffer in place. Nothing is allocated; sections
+ * are written with memcpy, so the buffer needs no particular alignment.
+ */
+class ScanOutputWriter {
+public:
+    /**
+     * @param data Buffer start
+     * @param capacity Buffer size in bytes
+     */
+    ScanOutputWriter(uint8_t* data, size_t capacity);
+
+    /**
+     * @return true if the buffer is at least ScanOutputLayout::kMinCapacity
+     */
+    bool valid() const { return data != nullptr && capacity >= ScanOutputLayout::kMinCapacity; }
+
+    /**
+     * Zero the header and fixed sections, then write magic and version
+     * (status Ok). Call before filling a reused buffer.
+     */
+    void reset();
+
+    ScanOutputStatus status() const;
+    void setStatus(ScanOutputStatus status);
+    void setMaskBytes(size_t bytes);
+
+    /**
+     * Write the GLB size after the mesh was written to meshData(); sets
+     * MeshTooLarge if it did not fit.
+     */
+    void setMeshBytes(size_t bytes);
+
+    /**
+     * @param points Pipeline keypoints; slots past count stay zero
+     * @param count Number of points, at most WireLayout::kCount are written
+     */
+    void setKeypoints3d(const cv::Point3f* points, size_t count);
+    void setKeypoints2d(const cv::Point2f* points, size_t count);
+
+    /**
+     * @param values Measurements; at most kMeasurementCount are written
+     */
+    void setMeasurements(const float* values, size_t count);
+
+    void setTimings(const ScanTimings& timings);
+
+    /**
+     * @return Start of the GLB section
+     */
+    uint8_t* meshData() const { return data + ScanOutputLayout::kMeshOffset; }
+
+    /**
+     * @return Bytes available for the GLB
+     */
+    size_t meshCapacity() const { return capacity - ScanOutputLayout::kMeshOffset; }
+
+private:
+    void writeU32(size_t offset, uint32_t value);
+
+    uint8_t* data;
+    size_t capacity;
+};
+
+#endif // SCAN_OUTPUT_H
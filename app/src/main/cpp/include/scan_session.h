@@ -0,0 +1,106 @@
+#ifndef SCAN_SESSION_H
+#define SCAN_SESSION_H
+
+#include "scan_trace.h"
+#include <opencv2/opencv.hpp>
+#include <jni.h>
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Three-view scan fed one view at a time, so each view's preprocessing and
+ * MediaPipe detection run while the user turns for the next shot.
+ *
+ * begin() opens a scan, addView() hands a captured view to a worker thread
+ * and returns at once, and finish() waits for whatever detection is still
+ * running and hands the detected views over; only triangulation, meshing
+ * and measurements are left to the caller. Adding a view again (a retake)
+ * replaces it, and the earlier take's result is discarded even if its
+ * detection is still in flight.
+ */
+class ScanSession {
+public:
+    static constexpr int kViewCount = 3;
+
+    // A view after preprocessing and detection
+    struct View {
+        cv::Mat image;                       // Preprocessed RGB frame
+        std::vector<cv::Point2f> keypoints;  // PipelineLayout::kCount normalized points
+        cv::Mat mask;                        // Segmentation mask (front view only)
+    };
+
+    ScanSession() = default;
+    ~ScanSession();
+
+    ScanSession(const ScanSession&) = delete;
+    ScanSession& operator=(const ScanSession&) = delete;
+
+    /**
+     * Open a new scan, dropping the views of an unfinished one, and start
+     * the worker thread if it is not running.
+     *
+     * @param env JNI environment
+     * @return false if MediaPipe is not ready
+     */
+    bool begin(JNIEnv* env);
+
+    /**
+     * Queue a view for preprocessing and detection.
+     *
+     * @param index View index, 0 (front, used for measurements) to kViewCount - 1
+     * @param frame RGB or RGBA frame owned by the session from now on (not a
+     *              view of caller memory)
+     * @return false if no scan is open, the index is out of range or the frame is empty
+     */
+    bool addView(int index, cv::Mat frame);
+
+    /**
+     * Wait for the views still being detected and close the scan.
+     *
+     * @param views Output, by index
+     * @param timings Output: Preprocess and Inference time of every take; the
+     *                caller adds the remaining stages
+     * @return false if no scan is open, a view was never added or the worker stopped
+     */
+    bool finish(std::array<View, kViewCount>& views, std::shared_ptr<ScanTimings>& timings);
+
+    /**
+     * Close any open scan and join the worker.
+     */
+    void stop();
+
+    /**
+     * @return true if a scan is open
+     */
+    bool isOpen() const;
+
+private:
+    void run();
+
+    struct Slot {
+        bool added = false;    // A take was handed to addView()
+        bool queued = false;   // The latest take waits for the worker
+        bool ready = false;    // The latest take is detected
+        uint64_t take = 0;     // Bumped by every addView(), so stale results are dropped
+        cv::Mat frame;         // Latest take until the worker picks it up
+        View view;
+    };
+
+    std::mutex lifecycleMutex;  // Serializes begin() and stop() around the worker
+    mutable std::mutex mutex;
+    std::condition_variable viewQueued;
+    std::condition_variable viewDone;
+    std::thread worker;
+    bool running = false;
+    bool open = false;
+    uint64_t generation = 0;  // Bumped by begin(), so results of an older scan are dropped
+    std::array<Slot, kViewCount> slots;
+    std::shared_ptr<ScanTimings> timings;
+};
+
+#endif // SCAN_SESSION_H
@@ -0,0 +1,99 @@
+#ifndef SCAN_TRACE_H
+#define SCAN_TRACE_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * Pipeline stages timed by ScopedTimer.
+ * Values match NativeBridge.ScanStage ordinals on the Kotlin side.
+ */
+enum class ScanStage : int {
+    Decode = 0,         // Frame ingestion: byte[] copy or pin, buffer wrap, HardwareBuffer lock
+    Preprocess = 1,     // Resize, color conversion and CLAHE
+    Inference = 2,      // MediaPipe: bitmap upload, detection, landmark and mask readback
+    Triangulation = 3,
+    MeshBuild = 4,      // Body primitives and vertex/index buffers
+    GlbSerialize = 5,   // glTF JSON and binary chunk
+    Measurement = 6,    // 2D measurements and circumferences
+    Pack = 7,           // Copying results into Java arrays
+    Count
+};
+
+constexpr int kScanStageCount = static_cast<int>(ScanStage::Count);
+
+/**
+ * Per-stage wall time of one scan. Each stage sums every timer that ran for
+ * it, so a stage run once per view reports the total over the views, and
+ * stages on worker threads can add up to more than the scan took.
+ * Recording is lock-free and safe from several threads.
+ */
+class ScanTimings {
+public:
+    void add(ScanStage stage, int64_t nanos) {
+        stageNanos[static_cast<int>(stage)].fetch_add(nanos, std::memory_order_relaxed);
+    }
+
+    int64_t nanos(ScanStage stage) const {
+        return stageNanos[static_cast<int>(stage)].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @param out kScanStageCount values in milliseconds, in ScanStage order
+     */
+    void toMillis(float* out) const;
+
+    /**
+     * Makes a ScanTimings the one ScopedTimers on this thread record into,
+     * restoring the previous one when the scope ends. Worker threads of a
+     * scan open their own Scope on the scan's timings.
+     */
+    class Scope {
+    public:
+        explicit Scope(ScanTimings* timings);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        ScanTimings* previous;
+    };
+
+    /**
+     * @return Timings of the innermost Scope on this thread, or null
+     */
+    static ScanTimings* current();
+
+private:
+    std::array<std::atomic<int64_t>, kScanStageCount> stageNanos{};
+};
+
+/**
+ * Times the enclosing block as one stage: an ATrace section named after the
+ * stage (visible in systrace/Perfetto whenever tracing is on) plus, inside a
+ * ScanTimings::Scope, the elapsed time. Outside a Scope the clock is not read,
+ * so stage code can keep its timers on every path.
+ */
+class ScopedTimer {
+public:
+    explicit ScopedTimer(ScanStage stage);
+    ~ScopedTimer();
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    ScanStage stage;
+    ScanTimings* timings;
+    std::chrono::steady_clock::time_point start;
+};
+
+/**
+ * @return Trace section name of a stage, e.g. "bodyscan:Preprocess"
+ */
+const char* scanStageName(ScanStage stage);
+
+#endif // SCAN_TRACE_H
@@ -0,0 +1,189 @@
+#include "batch_engine.h"
+#include "keypoint_schema.h"
+#include "measurements.h"
+#include "multi_view_3d.h"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+namespace {
+
+// Records a worker may finish ahead of the one being written, per worker
+constexpr size_t kWindowPerWorker = 4;
+
+enum class SlotState {
+    Pending,    // Not processed yet (or already written)
+    Processed,
+    Failed,     // Reprocessing threw
+    Skipped     // Corrupt in the input
+};
+
+struct Slot {
+    SlotState state = SlotState::Pending;
+    ScanRecordView source;
+    BatchEngine::Result result;  // Buffers reused by every record of the slot
+};
+
+SlotState processRecord(const ScanArchiveReader& input, size_t index, const BatchEngine::Options& options,
+                        Slot& slot) {
+    if (!input.record(index, slot.source)) {
+        return SlotState::Skipped;
+    }
+    try {
+        BatchEngine::process(slot.source, options, slot.result);
+        return SlotState::Processed;
+    } catch (...) {
+        return SlotState::Failed;
+    }
+}
+
+// Append a finished slot; false if the output failed
+bool writeSlot(const Slot& slot, ScanArchiveWriter& output, BatchEngine::Summary& summary) {
+    switch (slot.state) {
+        case SlotState::Processed:
+            if (!output.append(slot.result.apply(slot.source))) {
+                return false;
+            }
+            summary.written++;
+            return true;
+        case SlotState::Failed:
+            if (!output.append(slot.source)) {
+                return false;
+            }
+            summary.written++;
+            summary.failed++;
+            return true;
+        case SlotState::Skipped:
+        case SlotState::Pending:
+            summary.skipped++;
+            return true;
+    }
+    return true;
+}
+
+} // namespace
+
+ScanRecordView BatchEngine::Result::apply(const ScanRecordView& source) const {
+    ScanRecordView record = source;
+    record.keypoints3d = keypoints3d.data();
+    record.measurements = measurements.data();
+    if (meshRebuilt) {
+        record.glb = glb.empty() ? nullptr : glb.data();
+        record.glbBytes = glb.size();
+    }
+    return record;
+}
+
+void BatchEngine::process(const ScanRecordView& record, const Options& options, Result& result) {
+    std::vector<std::vector<cv::Point2f>> views(ScanArchiveLayout::kViewCount);
+    for (int i = 0; i < ScanArchiveLayout::kViewCount; ++i) {
+        views[i] = record.view(i);
+    }
+
+    // Only the MediaPipe landmarks are archived: the interpolated pipeline
+    // keypoints triangulate to zeros and are dropped
+    MultiView3D::triangulate(views, record.userHeightCm, result.keypoints3d);
+    result.keypoints3d.resize(ScanArchiveLayout::kLandmarkCount);
+
+    result.meshRebuilt = options.rebuildMesh;
+    if (options.rebuildMesh) {
+        const std::vector<cv::Point3f> body25 = mapToBody25(
+            KeypointSet<MediaPipeLayout>::fromPoints(result.keypoints3d.data(), result.keypoints3d.size()))
+            .toVector();
+        result.glb = MeshGenerator::createFromKeypoints(body25, options.lod, options.format);
+    } else {
+        result.glb.clear();
+    }
+
+    // The measurement only checks that a preprocessed frame exists; the
+    // archive keeps the frame's size instead of the frame
+    static const cv::Mat kFramePresent(1, 1, CV_8UC1, cv::Scalar(0));
+    const cv::Mat mask = record.decodeMask();
+    result.measurements = computeMeasurementsFrom2D(views[0], record.userHeightCm, record.frontWidth,
+                                                    record.frontHeight, kFramePresent, mask);
+}
+
+BatchEngine::Summary BatchEngine::run(const ScanArchiveReader& input, ScanArchiveWriter& output,
+                                      const Options& options) {
+    Summary summary;
+    const size_t total = input.size();
+    const size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t threads = std::min(options.threads > 0 ? static_cast<size_t>(options.threads) : hardwareThreads,
+                                    std::max<size_t>(total, 1));
+    const size_t window = options.window > 0 ? options.window : threads * kWindowPerWorker;
+
+    std::vector<Slot> slots(window);
+    std::mutex mutex;
+    std::condition_variable slotFree;
+    std::condition_variable slotDone;
+    size_t next = 0;      // Next record to hand to a worker
+    size_t consumed = 0;  // Records written (or skipped) so far
+    bool stopping = false;
+
+    // Record i goes to slot i % window once record i - window has been written
+    auto work = [&] {
+        for (;;) {
+            size_t index;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                slotFree.wait(lock, [&] { return stopping || next >= total || next < consumed + window; });
+                if (stopping || next >= total) {
+                    return;
+                }
+                index = next++;
+            }
+
+            Slot& slot = slots[index % window];
+            const SlotState state = processRecord(input, index, options, slot);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                slot.state = state;
+            }
+            slotDone.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    try {
+        for (size_t i = 0; i < threads; ++i) {
+            workers.emplace_back(work);
+        }
+    } catch (const std::system_error&) {
+        // Run with the workers that started
+    }
+
+    bool ok = true;
+    for (size_t index = 0; index < total && ok; ++index) {
+        Slot& slot = slots[index % window];
+        if (workers.empty()) {
+            slot.state = processRecord(input, index, options, slot);
+        } else {
+            std::unique_lock<std::mutex> lock(mutex);
+            slotDone.wait(lock, [&slot] { return slot.state != SlotState::Pending; });
+        }
+
+        // Workers never touch a finished slot until it is freed below
+        ok = writeSlot(slot, output, summary);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            slot.state = SlotState::Pending;
+            consumed = index + 1;
+            stopping = !ok;
+        }
+        slotFree.notify_all();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    slotFree.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    summary.ok = ok;
+    return summary;
+}
@@ -0,0 +1,197 @@
+#include "frame_input.h"
+#include <opencv2/opencv.hpp>
+#include <opencv2/imgproc.hpp>
+#include <android/hardware_buffer.h>
+#include <android/log.h>
+#include <dlfcn.h>
+#include <cstdint>
+#include <algorithm>
+
+#define LOG_TAG "FrameInput"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+// AHardwareBuffer entry points live in libnativewindow and only exist on API 26+.
+// minSdk is 24, so resolve them at runtime instead of linking against them.
+struct HardwareBufferApi {
+    AHardwareBuffer* (*fromHardwareBuffer)(JNIEnv*, jobject) = nullptr;
+    void (*describe)(const AHardwareBuffer*, AHardwareBuffer_Desc*) = nullptr;
+    int (*lock)(AHardwareBuffer*, uint64_t, int32_t, const ARect*, void**) = nullptr;
+    int (*unlock)(AHardwareBuffer*, int32_t*) = nullptr;
+
+    bool available() const {
+        return fromHardwareBuffer != nullptr && describe != nullptr &&
+               lock != nullptr && unlock != nullptr;
+    }
+};
+
+const HardwareBufferApi& hardwareBufferApi() {
+    static const HardwareBufferApi api = [] {
+        HardwareBufferApi loaded;
+        void* lib = dlopen("libnativewindow.so", RTLD_NOW | RTLD_LOCAL);
+        if (lib == nullptr) {
+            return loaded;
+        }
+        loaded.fromHardwareBuffer = reinterpret_cast<decltype(loaded.fromHardwareBuffer)>(
+            dlsym(lib, "AHardwareBuffer_fromHardwareBuffer"));
+        loaded.describe = reinterpret_cast<decltype(loaded.describe)>(
+            dlsym(lib, "AHardwareBuffer_describe"));
+        loaded.lock = reinterpret_cast<decltype(loaded.lock)>(
+            dlsym(lib, "AHardwareBuffer_lock"));
+        loaded.unlock = reinterpret_cast<decltype(loaded.unlock)>(
+            dlsym(lib, "AHardwareBuffer_unlock"));
+        return loaded;
+    }();
+    return api;
+}
+
+} // namespace
+
+FrameInput::~FrameInput() {
+    release();
+}
+
+void FrameInput::release() {
+    img.release();
+    if (lockedBuffer != nullptr) {
+        hardwareBufferApi().unlock(lockedBuffer, nullptr);
+        lockedBuffer = nullptr;
+    }
+    if (pinnedData != nullptr) {
+        pinnedEnv->ReleaseByteArrayElements(pinnedArray, pinnedData, JNI_ABORT);
+        pinnedEnv = nullptr;
+        pinnedArray = nullptr;
+        pinnedData = nullptr;
+    }
+}
+
+bool FrameInput::loadByteArray(JNIEnv* env, jbyteArray image, int width, int height, float minFill) {
+    release();
+
+    if (env == nullptr || image == nullptr || width <= 0 || height <= 0) {
+        return false;
+    }
+
+    const size_t rowBytes = static_cast<size_t>(width) * 4;
+    const size_t expectedSize = rowBytes * height;
+    const size_t len = static_cast<size_t>(env->GetArrayLength(image));
+    if (len < expectedSize * minFill) {
+        return false;
+    }
+
+    // Never read past the end of a short array - drop the incomplete rows instead
+    int rows = std::min(height, static_cast<int>(len / rowBytes));
+    if (rows <= 0) {
+        return false;
+    }
+
+    // Critical access avoids the defensive copy GetByteArrayElements may make.
+    // No JNI calls are allowed until the array is released.
+    void* buf = env->GetPrimitiveArrayCritical(image, nullptr);
+    if (buf == nullptr) {
+        return false;
+    }
+
+    // cvtColor allocates a continuous, owned RGB Mat - no clone() needed
+    cv::Mat rgba(rows, width, CV_8UC4, buf);
+    cv::cvtColor(rgba, img, cv::COLOR_RGBA2RGB);
+
+    env->ReleasePrimitiveArrayCritical(image, buf, JNI_ABORT);
+    return !img.empty();
+}
+
+bool FrameInput::pinByteArray(JNIEnv* env, jbyteArray image, int width, int height) {
+    release();
+
+    if (env == nullptr || image == nullptr || width <= 0 || height <= 0) {
+        return false;
+    }
+
+    const size_t expectedSize = static_cast<size_t>(width) * height * 4;
+    if (static_cast<size_t>(env->GetArrayLength(image)) < expectedSize) {
+        return false;
+    }
+
+    // Large arrays live in ART's non-moving space, so this normally pins
+    // rather than copies. Unlike a critical region it permits JNI calls
+    // (MediaPipe) while held.
+    jbyte* data = env->GetByteArrayElements(image, nullptr);
+    if (data == nullptr) {
+        return false;
+    }
+    pinnedEnv = env;
+    pinnedArray = image;
+    pinnedData = data;
+
+    img = cv::Mat(height, width, CV_8UC4, data);
+    return true;
+}
+
+bool FrameInput::wrapDirectBuffer(JNIEnv* env, jobject buffer, int width, int height, int rowStride) {
+    release();
+
+    if (env == nullptr || buffer == nullptr || width <= 0 || height <= 0) {
+        return false;
+    }
+
+    const size_t rowBytes = static_cast<size_t>(width) * 4;
+    const size_t stride = rowStride > 0 ? static_cast<size_t>(rowStride) : rowBytes;
+    if (stride < rowBytes) {
+        LOGE("Row stride %d smaller than row size %zu", rowStride, rowBytes);
+        return false;
+    }
+
+    void* data = env->GetDirectBufferAddress(buffer);
+    jlong capacity = env->GetDirectBufferCapacity(buffer);
+    if (data == nullptr || capacity < 0) {
+        LOGE("ByteBuffer is not direct");
+        return false;
+    }
+
+    // The last row only needs width*4 bytes - CameraX planes omit trailing padding
+    const size_t required = stride * (height - 1) + rowBytes;
+    if (static_cast<size_t>(capacity) < required) {
+        LOGE("Direct buffer too small: %lld < %zu", static_cast<long long>(capacity), required);
+        return false;
+    }
+
+    img = cv::Mat(height, width, CV_8UC4, data, stride);
+    return true;
+}
+
+bool FrameInput::wrapHardwareBuffer(JNIEnv* env, jobject hardwareBuffer) {
+    release();
+
+    const HardwareBufferApi& api = hardwareBufferApi();
+    if (env == nullptr || hardwareBuffer == nullptr || !api.available()) {
+        return false;
+    }
+
+    // Borrowed reference - valid while the Java HardwareBuffer is alive
+    AHardwareBuffer* buffer = api.fromHardwareBuffer(env, hardwareBuffer);
+    if (buffer == nullptr) {
+        return false;
+    }
+
+    AHardwareBuffer_Desc desc = {};
+    api.describe(buffer, &desc);
+    if (desc.format != AHARDWAREBUFFER_FORMAT_R8G8B8A8_UNORM &&
+        desc.format != AHARDWAREBUFFER_FORMAT_R8G8B8X8_UNORM) {
+        LOGE("Unsupported HardwareBuffer format: %u", desc.format);
+        return false;
+    }
+
+    void* data = nullptr;
+    if (api.lock(buffer, AHARDWAREBUFFER_USAGE_CPU_READ_OFTEN, -1, nullptr, &data) != 0 ||
+        data == nullptr) {
+        LOGE("Failed to lock HardwareBuffer for CPU read");
+        return false;
+    }
+    lockedBuffer = buffer;
+
+    // desc.stride is in pixels, not bytes
+    img = cv::Mat(static_cast<int>(desc.height), static_cast<int>(desc.width), CV_8UC4,
+                  data, static_cast<size_t>(desc.stride) * 4);
+    return true;
+}
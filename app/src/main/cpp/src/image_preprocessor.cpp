@@ -1,60 +1,76 @@
 #include "image_preprocessor.h"
+#include "scan_trace.h"
 #include <opencv2/opencv.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/imgcodecs.hpp>
 
-void ImagePreprocessor::run(cv::Mat& img) {
-    if (img.empty()) {
+// Target ~640px width for performance
+static const int kTargetWidth = 640;
+
+cv::Size ImagePreprocessor::outputSize(const cv::Size& input) {
+    if (input.width <= kTargetWidth) {
+        return input;
+    }
+    double scale = static_cast<double>(kTargetWidth) / input.width;
+    return cv::Size(kTargetWidth, static_cast<int>(input.height * scale));
+}
+
+ImagePreprocessor::Context::Context()
+    : clahe(cv::createCLAHE(2.0, cv::Size(8, 8))) {
+}
+
+void ImagePreprocessor::Context::run(const cv::Mat& src, cv::Mat& dst) {
+    ScopedTimer timer(ScanStage::Preprocess);
+    if (src.empty()) {
+        dst.release();
         return;
     }
 
-    // Convert to appropriate color space if needed
-    cv::Mat processed;
-    if (img.channels() == 4) {
-        cv::cvtColor(img, processed, cv::COLOR_RGBA2RGB);
-    } else if (img.channels() == 1) {
-        cv::cvtColor(img, processed, cv::COLOR_GRAY2RGB);
-    } else {
-        processed = img.clone();
+    // Hold a reference to the source in case dst is the same Mat
+    cv::Mat source = src;
+    if (dst.data == source.data) {
+        dst.release();
     }
 
-    // Resize if image is too large (target ~640px width for performance)
-    const int targetWidth = 640;
-    if (processed.cols > targetWidth) {
-        double scale = static_cast<double>(targetWidth) / processed.cols;
-        int newHeight = static_cast<int>(processed.rows * scale);
-        cv::resize(processed, processed, cv::Size(targetWidth, newHeight), 0, 0, cv::INTER_LINEAR);
+    // Resize first (in the source format) so the color passes touch fewer pixels
+    cv::Size size = outputSize(source.size());
+    if (size != source.size()) {
+        cv::resize(source, resized, size, 0, 0, cv::INTER_LINEAR);
+        source = resized;
     }
 
     // Apply CLAHE (Contrast Limited Adaptive Histogram Equalization)
-    // Convert to LAB color space for better contrast enhancement
-    // Note: OpenCV uses BGR by default, but we have RGB, so convert RGB->BGR first
-    cv::Mat bgr;
-    cv::cvtColor(processed, bgr, cv::COLOR_RGB2BGR);
-    
-    cv::Mat lab;
-    cv::cvtColor(bgr, lab, cv::COLOR_BGR2Lab);
-    
-    std::vector<cv::Mat> labChannels;
-    cv::split(lab, labChannels);
-    
-    // Apply CLAHE to L channel only
-    cv::Ptr<cv::CLAHE> clahe = cv::createCLAHE(2.0, cv::Size(8, 8));
-    clahe->apply(labChannels[0], labChannels[0]);
-    
-    // Merge channels back
-    cv::merge(labChannels, lab);
-    cv::cvtColor(lab, bgr, cv::COLOR_Lab2BGR);
-    
-    // Convert back to RGB
-    cv::cvtColor(bgr, processed, cv::COLOR_BGR2RGB);
+    // on the L channel of Lab. RGB2Lab accepts 3- and 4-channel input, so
+    // RGBA frames go straight to Lab without an RGB copy.
+    if (source.channels() == 1) {
+        cv::cvtColor(source, rgb, cv::COLOR_GRAY2RGB);
+        source = rgb;
+    }
+    cv::cvtColor(source, lab, cv::COLOR_RGB2Lab);
+
+    cv::extractChannel(lab, lightness, 0);
+    clahe->apply(lightness, equalized);
+    cv::insertChannel(equalized, lab, 0);
+
+    cv::cvtColor(lab, dst, cv::COLOR_Lab2RGB);
 
     // Optional: Simple background removal using thresholding
     // This is a basic implementation - can be enhanced with GrabCut or more sophisticated methods
     // For now, we'll skip background removal as it requires more complex setup
     // and can be added later if needed
+}
+
+void ImagePreprocessor::run(cv::Mat& img) {
+    if (img.empty()) {
+        return;
+    }
+
+    // The context's scratch buffers are reused; the output is a fresh Mat
+    // because img keeps it beyond this call
+    static thread_local Context context;
+    cv::Mat processed;
+    context.run(img, processed);
 
     // Update the input image
     img = processed;
 }
-
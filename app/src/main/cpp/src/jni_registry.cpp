@@ -0,0 +1,99 @@
+#include "jni_registry.h"
+#include <android/log.h>
+#include <initializer_list>
+
+#define LOG_TAG "JniRegistry"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+JniRegistry registry;
+
+// Global ref to a class, or null (exception cleared) if it cannot be found
+jclass globalClass(JNIEnv* env, const char* name) {
+    jclass local = env->FindClass(name);
+    if (local == nullptr) {
+        env->ExceptionClear();
+        LOGE("Failed to find class %s", name);
+        return nullptr;
+    }
+    jclass global = static_cast<jclass>(env->NewGlobalRef(local));
+    env->DeleteLocalRef(local);
+    return global;
+}
+
+void deleteClassRefs(JNIEnv* env, const JniRegistry& entries) {
+    for (jclass clazz : {entries.nativeBridgeClass, entries.scanResultClass,
+                         entries.scanTimingsClass, entries.validationResultClass,
+                         entries.scanCallbackClass}) {
+        if (clazz != nullptr) {
+            env->DeleteGlobalRef(clazz);
+        }
+    }
+}
+
+jmethodID method(JNIEnv* env, jclass clazz, const char* name, const char* signature) {
+    if (clazz == nullptr) {
+        return nullptr;
+    }
+    jmethodID id = env->GetMethodID(clazz, name, signature);
+    if (id == nullptr) {
+        env->ExceptionClear();
+        LOGE("Failed to find method %s%s", name, signature);
+    }
+    return id;
+}
+
+jmethodID constructor(JNIEnv* env, jclass clazz, const char* signature) {
+    return method(env, clazz, "<init>", signature);
+}
+
+} // namespace
+
+bool JniRegistry::load(JNIEnv* env) {
+    JniRegistry loaded;
+    loaded.nativeBridgeClass = globalClass(env, kNativeBridgeClass);
+
+    loaded.scanResultClass = globalClass(env, "com/example/bodyscanapp/utils/NativeBridge$ScanResult");
+    loaded.scanResultInit = constructor(env, loaded.scanResultClass,
+        "([F[B[F[FLcom/example/bodyscanapp/utils/NativeBridge$ScanTimings;)V");
+
+    loaded.scanTimingsClass = globalClass(env, "com/example/bodyscanapp/utils/NativeBridge$ScanTimings");
+    loaded.scanTimingsInit = constructor(env, loaded.scanTimingsClass, "([FII)V");
+
+    loaded.validationResultClass = globalClass(
+        env, "com/example/bodyscanapp/utils/NativeBridge$ImageValidationResult");
+    loaded.validationResultInit = constructor(env, loaded.validationResultClass,
+                                              "(ZZZFLjava/lang/String;)V");
+
+    loaded.scanCallbackClass = globalClass(env, "com/example/bodyscanapp/utils/NativeBridge$ScanCallback");
+    loaded.scanCallbackProgress = method(env, loaded.scanCallbackClass, "onProgress", "(JI)V");
+    loaded.scanCallbackComplete = method(env, loaded.scanCallbackClass, "onComplete",
+        "(JLcom/example/bodyscanapp/utils/NativeBridge$ScanResult;)V");
+    loaded.scanCallbackCancelled = method(env, loaded.scanCallbackClass, "onCancelled", "(J)V");
+
+    const bool complete = loaded.nativeBridgeClass != nullptr &&
+                          loaded.scanResultInit != nullptr &&
+                          loaded.scanTimingsInit != nullptr &&
+                          loaded.validationResultInit != nullptr &&
+                          loaded.scanCallbackProgress != nullptr &&
+                          loaded.scanCallbackComplete != nullptr &&
+                          loaded.scanCallbackCancelled != nullptr;
+    if (!complete) {
+        deleteClassRefs(env, loaded);
+        return false;
+    }
+
+    deleteClassRefs(env, registry);
+    registry = loaded;
+    return true;
+}
+
+void JniRegistry::unload(JNIEnv* env) {
+    deleteClassRefs(env, registry);
+    registry = JniRegistry();
+}
+
+const JniRegistry& JniRegistry::get() {
+    return registry;
+}
@@ -0,0 +1,168 @@
+#include "mask_scanline.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MASK_SCANLINE_NEON 1
+#endif
+
+namespace {
+
+// Turns per-column foreground flags into runs
+struct RunBuilder {
+    MaskRun* runs;
+    int capacity;
+    int count = 0;
+    int start = 0;
+    bool inRun = false;
+
+    bool full() const { return count >= capacity; }
+
+    void push(int x, bool foreground) {
+        if (foreground == inRun) {
+            return;
+        }
+        if (foreground) {
+            start = x;
+        } else {
+            runs[count++] = {start, x};
+        }
+        inRun = foreground;
+    }
+
+    int finish(int width) {
+        if (inRun && !full()) {
+            runs[count++] = {start, width};
+        }
+        return count;
+    }
+};
+
+} // namespace
+
+int MaskScanline::findRuns(const cv::Mat& mask, int y, int radius, MaskRun* runs, int maxRuns) {
+    if (mask.empty() || mask.type() != CV_32FC1 || runs == nullptr || maxRuns <= 0 ||
+        y < 0 || y >= mask.rows) {
+        return 0;
+    }
+
+    radius = std::max(0, std::min(radius, kMaxRadius));
+    const int firstRow = std::max(0, y - radius);
+    const int lastRow = std::min(mask.rows - 1, y + radius);
+    const int rowCount = lastRow - firstRow + 1;
+
+    const float* rows[2 * kMaxRadius + 1];
+    for (int r = 0; r < rowCount; ++r) {
+        rows[r] = mask.ptr<float>(firstRow + r);
+    }
+
+    const int width = mask.cols;
+    RunBuilder builder{runs, maxRuns};
+    int x = 0;
+
+#ifdef MASK_SCANLINE_NEON
+    // Four columns per step: each row's comparison adds 1 (all-ones lanes
+    // subtracted) to the column's vote. Blocks without a transition are skipped.
+    const float32x4_t threshold = vdupq_n_f32(kForegroundThreshold);
+    const uint32x4_t rowsVector = vdupq_n_u32(static_cast<uint32_t>(rowCount));
+    for (; x + 4 <= width && !builder.full(); x += 4) {
+        uint32x4_t votes = vdupq_n_u32(0);
+        for (int r = 0; r < rowCount; ++r) {
+            votes = vsubq_u32(votes, vcgtq_f32(vld1q_f32(rows[r] + x), threshold));
+        }
+        const uint32x4_t foreground = vcgtq_u32(vshlq_n_u32(votes, 1), rowsVector);
+        const uint64_t lanes = vget_lane_u64(vreinterpret_u64_u16(vmovn_u32(foreground)), 0);
+        if (lanes == (builder.inRun ? ~0ull : 0ull)) {
+            continue;
+        }
+        for (int lane = 0; lane < 4 && !builder.full(); ++lane) {
+            builder.push(x + lane, ((lanes >> (16 * lane)) & 1) != 0);
+        }
+    }
+#endif
+
+    for (; x < width && !builder.full(); ++x) {
+        int votes = 0;
+        for (int r = 0; r < rowCount; ++r) {
+            votes += rows[r][x] > kForegroundThreshold ? 1 : 0;
+        }
+        builder.push(x, votes * 2 > rowCount);
+    }
+
+    return builder.finish(width);
+}
+
+int MaskScanline::findRuns(const cv::Mat& mask, const cv::Size& imageSize, int imageY, int radius,
+                           MaskRun* runs, int maxRuns) {
+    return findRuns(mask, imageSize, cv::Rect(), imageY, radius, runs, maxRuns);
+}
+
+int MaskScanline::findRuns(const cv::Mat& mask, const cv::Size& imageSize, const cv::Rect& maskRegion,
+                           int imageY, int radius, MaskRun* runs, int maxRuns) {
+    if (mask.empty() || imageSize.width <= 0 || imageSize.height <= 0 ||
+        imageY < 0 || imageY >= imageSize.height) {
+        return 0;
+    }
+    const cv::Rect region = maskRegion.area() > 0 ? maskRegion : cv::Rect(0, 0, imageSize.width, imageSize.height);
+    if (imageY < region.y || imageY >= region.y + region.height) {
+        return 0;  // Outside the mask: background
+    }
+    const int regionY = imageY - region.y;
+
+    if (region.width == mask.cols && region.height == mask.rows) {
+        const int count = findRuns(mask, regionY, radius, runs, maxRuns);
+        for (int i = 0; i < count; ++i) {
+            runs[i].begin += region.x;
+            runs[i].end += region.x;
+        }
+        return count;
+    }
+
+    // Nearest-neighbour sampling: region pixel i maps to mask pixel floor((i + 0.5) * mask / region)
+    const long long maskRows = mask.rows;
+    const long long maskCols = mask.cols;
+    const long long width = region.width;
+    const int maskY = static_cast<int>((2 * regionY + 1) * maskRows / (2LL * region.height));
+
+    const int count = findRuns(mask, maskY, radius, runs, maxRuns);
+
+    // Mask column c covers region columns from ceil(c * region / mask - 0.5)
+    int mapped = 0;
+    for (int i = 0; i < count; ++i) {
+        const int begin = region.x + static_cast<int>((2 * runs[i].begin * width + maskCols - 1) / (2 * maskCols));
+        const int end = region.x + static_cast<int>((2 * runs[i].end * width + maskCols - 1) / (2 * maskCols));
+        if (begin >= end) {
+            continue; // Narrower than one image pixel when downsampling
+        }
+        if (mapped > 0 && begin <= runs[mapped - 1].end) {
+            runs[mapped - 1].end = end; // The gap collapsed
+        } else {
+            runs[mapped++] = {begin, end};
+        }
+    }
+    return mapped;
+}
+
+int MaskScanline::firstForeground(const MaskRun* runs, int count, int from, int to) {
+    from = std::max(from, 0);
+    for (int i = 0; i < count; ++i) {
+        const int begin = std::max(runs[i].begin, from);
+        if (begin < runs[i].end) {
+            return begin <= to ? begin : -1;
+        }
+    }
+    return -1;
+}
+
+int MaskScanline::lastForeground(const MaskRun* runs, int count, int from, int to) {
+    from = std::max(from, 0);
+    for (int i = count - 1; i >= 0; --i) {
+        const int last = std::min(runs[i].end - 1, to);
+        if (last >= runs[i].begin) {
+            return last >= from ? last : -1;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,329 @@
+#include "measurements.h"
+#include "keypoint_schema.h"
+#include "mask_scanline.h"
+#include "scan_trace.h"
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+// Helper function to check if a keypoint is valid (detected and within bounds)
+static inline bool isValidKeypoint(const cv::Point2f& pt) {
+    return pt.x >= 0.0f && pt.x <= 1.0f && pt.y >= 0.0f && pt.y <= 1.0f;
+}
+
+// Helper function to calculate distance between two keypoints in normalized coordinates
+static inline float keypointDistance(const cv::Point2f& p1, const cv::Point2f& p2) {
+    float dx = p2.x - p1.x;
+    float dy = p2.y - p1.y;
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+// Helper function to validate measurement value (sanity check)
+static inline float validateMeasurement(float value, float minVal, float maxVal) {
+    if (value < minVal || value > maxVal || std::isnan(value) || std::isinf(value)) {
+        return 0.0f; // Invalid measurement
+    }
+    return value;
+}
+
+// Thigh edge detection: foreground runs tracked per mask row (a person row has a
+// handful), with a 5-row majority vote so single-row mask noise cannot move an edge
+static const int kMaxMaskRuns = 32;
+static const int kMaskRowRadius = 2;
+
+std::vector<float> computeMeasurementsFrom2D(
+    const std::vector<cv::Point2f>& kpts2d, 
+    float userHeight, 
+    int imgWidth, 
+    int imgHeight,
+    const cv::Mat& processedImg,
+    const cv::Mat& segmentationMask,
+    const cv::Rect& maskRegion) {
+    ScopedTimer timer(ScanStage::Measurement);
+    std::vector<float> measurements(kMeasurementCount, 0.0f);
+    
+    // Validation: Check input parameters
+    if (kpts2d.empty() || kpts2d.size() < MediaPipeLayout::kCount || userHeight <= 0.0f || 
+        userHeight > 300.0f || imgWidth <= 0 || imgHeight <= 0) {
+        return measurements; // Return zeros for invalid input
+    }
+    
+    // Find head keypoint (nose - index 0)
+    float headY = 1.0f; // Start with max (top of image)
+    bool hasHead = false;
+    if (isValidKeypoint(kpts2d[0])) {
+        headY = kpts2d[0].y;
+        hasHead = true;
+    }
+    
+    // Find feet keypoints (ankles, heels, foot_index - indices 27-32)
+    float feetY = 0.0f; // Start with min (bottom of image)
+    bool hasFeet = false;
+    for (int i = 27; i <= 32 && i < static_cast<int>(kpts2d.size()); ++i) {
+        if (isValidKeypoint(kpts2d[i])) {
+            feetY = std::max(feetY, kpts2d[i].y);
+            hasFeet = true;
+        }
+    }
+    
+    // If feet not found, use bottommost valid keypoint as fallback
+    if (!hasFeet) {
+        for (size_t i = 0; i < kpts2d.size(); ++i) {
+            if (isValidKeypoint(kpts2d[i])) {
+                feetY = std::max(feetY, kpts2d[i].y);
+            }
+        }
+    }
+    
+    // Calculate body height in normalized coordinates
+    float bodyHeightNormalized = feetY - headY;
+    if (bodyHeightNormalized <= 0.0f || !hasHead) {
+        return measurements; // Invalid body height
+    }
+    
+    // Convert normalized height to pixels using processed image height
+    float bodyHeightPixels = bodyHeightNormalized * imgHeight;
+    
+    if (bodyHeightPixels <= 0.0f) {
+        return measurements;
+    }
+    
+    // Calculate scale factor: user's known height / body height in pixels
+    // This gives us cm per pixel for this specific image
+    float cmPerPixel = userHeight / bodyHeightPixels;
+    
+    // [0] Shoulder Width: Distance between landmarks 11 and 12 (left and right shoulders)
+    if (kpts2d.size() > 12 && isValidKeypoint(kpts2d[11]) && isValidKeypoint(kpts2d[12])) {
+        float shoulderWidthNormalized = keypointDistance(kpts2d[11], kpts2d[12]);
+        float shoulderWidthCm = shoulderWidthNormalized * imgWidth * cmPerPixel;
+        measurements[0] = validateMeasurement(shoulderWidthCm, 30.0f, 60.0f);
+    }
+    
+    // [1] Arm Length: Average of left and right arm lengths
+    // Left arm: shoulder (11) → elbow (13) → wrist (15)
+    // Right arm: shoulder (12) → elbow (14) → wrist (16)
+    if (kpts2d.size() > 16 && 
+        isValidKeypoint(kpts2d[11]) && isValidKeypoint(kpts2d[13]) && isValidKeypoint(kpts2d[15]) &&
+        isValidKeypoint(kpts2d[12]) && isValidKeypoint(kpts2d[14]) && isValidKeypoint(kpts2d[16])) {
+        // Calculate left arm length (sum of segments)
+        float leftArmSegment1 = keypointDistance(kpts2d[11], kpts2d[13]);
+        float leftArmSegment2 = keypointDistance(kpts2d[13], kpts2d[15]);
+        float leftArmLengthNormalized = leftArmSegment1 + leftArmSegment2;
+        
+        // Calculate right arm length (sum of segments)
+        float rightArmSegment1 = keypointDistance(kpts2d[12], kpts2d[14]);
+        float rightArmSegment2 = keypointDistance(kpts2d[14], kpts2d[16]);
+        float rightArmLengthNormalized = rightArmSegment1 + rightArmSegment2;
+        
+        // Average the two arms
+        float avgArmLengthNormalized = (leftArmLengthNormalized + rightArmLengthNormalized) / 2.0f;
+        
+        // Convert to centimeters using max dimension for diagonal distances
+        float avgArmLengthCm = avgArmLengthNormalized * std::max(imgWidth, imgHeight) * cmPerPixel;
+        measurements[1] = validateMeasurement(avgArmLengthCm, 50.0f, 80.0f);
+    }
+    
+    // [2] Leg Length: Average of left and right leg lengths
+    // Left leg: hip (23) → knee (25) → ankle (27)
+    // Right leg: hip (24) → knee (26) → ankle (28)
+    if (kpts2d.size() > 28 && 
+        isValidKeypoint(kpts2d[23]) && isValidKeypoint(kpts2d[25]) && isValidKeypoint(kpts2d[27]) &&
+        isValidKeypoint(kpts2d[24]) && isValidKeypoint(kpts2d[26]) && isValidKeypoint(kpts2d[28])) {
+        // Calculate left leg length (sum of segments)
+        float leftLegSegment1 = keypointDistance(kpts2d[23], kpts2d[25]);
+        float leftLegSegment2 = keypointDistance(kpts2d[25], kpts2d[27]);
+        float leftLegLengthNormalized = leftLegSegment1 + leftLegSegment2;
+        
+        // Calculate right leg length (sum of segments)
+        float rightLegSegment1 = keypointDistance(kpts2d[24], kpts2d[26]);
+        float rightLegSegment2 = keypointDistance(kpts2d[26], kpts2d[28]);
+        float rightLegLengthNormalized = rightLegSegment1 + rightLegSegment2;
+        
+        // Average the two legs
+        float avgLegLengthNormalized = (leftLegLengthNormalized + rightLegLengthNormalized) / 2.0f;
+        
+        // Convert to centimeters using max dimension for diagonal distances
+        float avgLegLengthCm = avgLegLengthNormalized * std::max(imgWidth, imgHeight) * cmPerPixel;
+        measurements[2] = validateMeasurement(avgLegLengthCm, 70.0f, 120.0f);
+    }
+    
+    // [3] Hip Width: Distance between landmarks 23 and 24 (left and right hips)
+    if (kpts2d.size() > 24 && isValidKeypoint(kpts2d[23]) && isValidKeypoint(kpts2d[24])) {
+        float hipWidthNormalized = keypointDistance(kpts2d[23], kpts2d[24]);
+        float hipWidthCm = hipWidthNormalized * imgWidth * cmPerPixel;
+        measurements[3] = validateMeasurement(hipWidthCm, 25.0f, 50.0f);
+    }
+    
+    // [4] Upper Body Length: Distance from hip midpoint to highest keypoint
+    if (kpts2d.size() > 24 && isValidKeypoint(kpts2d[23]) && isValidKeypoint(kpts2d[24])) {
+        // Calculate hip midpoint manually (do NOT assume landmark 35 exists)
+        cv::Point2f hipMidpoint;
+        hipMidpoint.x = (kpts2d[23].x + kpts2d[24].x) / 2.0f;
+        hipMidpoint.y = (kpts2d[23].y + kpts2d[24].y) / 2.0f;
+        
+        // Find highest keypoint (minimum Y value) from keypoints 0-32
+        float highestY = 1.0f;
+        cv::Point2f highestKeypoint;
+        bool foundHighest = false;
+        for (int i = 0; i <= 32 && i < static_cast<int>(kpts2d.size()); ++i) {
+            if (isValidKeypoint(kpts2d[i])) {
+                if (kpts2d[i].y < highestY) {
+                    highestY = kpts2d[i].y;
+                    highestKeypoint = kpts2d[i];
+                    foundHighest = true;
+                }
+            }
+        }
+        
+        if (foundHighest) {
+            // Calculate vertical distance (Y increases downward, so subtract to get positive length)
+            float upperBodyLengthNormalized = hipMidpoint.y - highestKeypoint.y;
+            float upperBodyLengthCm = upperBodyLengthNormalized * imgHeight * cmPerPixel;
+            measurements[4] = validateMeasurement(upperBodyLengthCm, 40.0f, 80.0f);
+        }
+    }
+    
+    // [5] Lower Body Length: Distance from hip midpoint to ankle midpoint
+    if (kpts2d.size() > 28 && 
+        isValidKeypoint(kpts2d[23]) && isValidKeypoint(kpts2d[24]) &&
+        isValidKeypoint(kpts2d[27]) && isValidKeypoint(kpts2d[28])) {
+        // Calculate hip midpoint manually (do NOT assume landmark 35 exists)
+        cv::Point2f hipMidpoint;
+        hipMidpoint.x = (kpts2d[23].x + kpts2d[24].x) / 2.0f;
+        hipMidpoint.y = (kpts2d[23].y + kpts2d[24].y) / 2.0f;
+        
+        // Calculate ankle midpoint manually (do NOT assume landmark 134 exists)
+        cv::Point2f ankleMidpoint;
+        ankleMidpoint.x = (kpts2d[27].x + kpts2d[28].x) / 2.0f;
+        ankleMidpoint.y = (kpts2d[27].y + kpts2d[28].y) / 2.0f;
+        
+        // Calculate distance (primarily vertical, so use imgHeight)
+        float lowerBodyLengthNormalized = keypointDistance(hipMidpoint, ankleMidpoint);
+        float lowerBodyLengthCm = lowerBodyLengthNormalized * imgHeight * cmPerPixel;
+        measurements[5] = validateMeasurement(lowerBodyLengthCm, 60.0f, 100.0f);
+    }
+    
+    // [6] Neck Width: Distance from left eye (2) to right eye (5)
+    if (kpts2d.size() > 5 && isValidKeypoint(kpts2d[2]) && isValidKeypoint(kpts2d[5])) {
+        float neckWidthNormalized = keypointDistance(kpts2d[2], kpts2d[5]);
+        float neckWidthCm = neckWidthNormalized * imgWidth * cmPerPixel;
+        measurements[6] = validateMeasurement(neckWidthCm, 8.0f, 15.0f);
+    }
+    
+    // [7] Thigh Width: Average of left and right thigh widths
+    // Use pixel-level edge detection if segmentation mask is available
+    float leftThighWidthPixels = 0.0f;
+    float rightThighWidthPixels = 0.0f;
+    bool leftThighValid = false;
+    bool rightThighValid = false;
+    
+    // The mask may be at any resolution: scanlines are sampled from it in image coordinates
+    bool usePixelDetection = !segmentationMask.empty() && !processedImg.empty();
+    const cv::Size imageSize(imgWidth, imgHeight);
+    
+    // Left thigh: Calculate midpoint between left hip (23) and left knee (25)
+    if (kpts2d.size() > 25 && isValidKeypoint(kpts2d[23]) && isValidKeypoint(kpts2d[25])) {
+        float midpointYNormalized = (kpts2d[23].y + kpts2d[25].y) / 2.0f;
+        int midpointY = static_cast<int>(midpointYNormalized * imgHeight);
+        
+        if (usePixelDetection && midpointY >= 0 && midpointY < imgHeight) {
+            // Pixel-level edge detection: foreground runs along the midpoint row
+            MaskRun runs[kMaxMaskRuns];
+            const int runCount = MaskScanline::findRuns(segmentationMask, imageSize, maskRegion, midpointY,
+                                                         kMaskRowRadius, runs, kMaxMaskRuns);
+            float leftHipXNormalized = kpts2d[23].x;
+            int leftHipX = static_cast<int>(leftHipXNormalized * imgWidth);
+            
+            // Leftmost edge: first foreground pixel from the left edge of the image
+            int leftEdge = MaskScanline::firstForeground(runs, runCount, 0, imgWidth - 1);
+            
+            // Rightmost edge of left thigh: last foreground pixel between the left hip
+            // and its mirror across the body centerline
+            int bodyCenterX = 0;
+            if (kpts2d.size() > 24 && isValidKeypoint(kpts2d[23]) && isValidKeypoint(kpts2d[24])) {
+                bodyCenterX = static_cast<int>((kpts2d[23].x + kpts2d[24].x) / 2.0f * imgWidth);
+            }
+            int searchEnd = std::min(leftHipX + (bodyCenterX - leftHipX) * 2, imgWidth - 1);
+            int rightEdge = MaskScanline::lastForeground(runs, runCount, leftHipX, searchEnd);
+            
+            if (leftEdge >= 0 && rightEdge >= 0 && rightEdge > leftEdge) {
+                leftThighWidthPixels = static_cast<float>(rightEdge - leftEdge);
+                leftThighValid = true;
+            }
+        }
+        
+        // Fallback to estimation if pixel detection failed
+        if (!leftThighValid) {
+            float bodyCenterX = 0.5f;
+            if (kpts2d.size() > 24 && isValidKeypoint(kpts2d[23]) && isValidKeypoint(kpts2d[24])) {
+                bodyCenterX = (kpts2d[23].x + kpts2d[24].x) / 2.0f;
+            }
+            float hipHalfWidth = std::abs(kpts2d[23].x - bodyCenterX);
+            float thighExpansionFactor = 1.5f;
+            float leftThighHalfWidth = hipHalfWidth * thighExpansionFactor;
+            float leftThighWidthNormalized = leftThighHalfWidth * 2.0f;
+            leftThighWidthPixels = leftThighWidthNormalized * imgWidth;
+            leftThighValid = true;
+        }
+    }
+    
+    // Right thigh: Calculate midpoint between right hip (24) and right knee (26)
+    if (kpts2d.size() > 26 && isValidKeypoint(kpts2d[24]) && isValidKeypoint(kpts2d[26])) {
+        float midpointYNormalized = (kpts2d[24].y + kpts2d[26].y) / 2.0f;
+        int midpointY = static_cast<int>(midpointYNormalized * imgHeight);
+        
+        if (usePixelDetection && midpointY >= 0 && midpointY < imgHeight) {
+            // Pixel-level edge detection: foreground runs along the midpoint row
+            MaskRun runs[kMaxMaskRuns];
+            const int runCount = MaskScanline::findRuns(segmentationMask, imageSize, maskRegion, midpointY,
+                                                         kMaskRowRadius, runs, kMaxMaskRuns);
+            float rightHipXNormalized = kpts2d[24].x;
+            int rightHipX = static_cast<int>(rightHipXNormalized * imgWidth);
+            
+            // Leftmost edge of right thigh: first foreground pixel right of the body centerline
+            int bodyCenterX = 0;
+            if (kpts2d.size() > 24 && isValidKeypoint(kpts2d[23]) && isValidKeypoint(kpts2d[24])) {
+                bodyCenterX = static_cast<int>((kpts2d[23].x + kpts2d[24].x) / 2.0f * imgWidth);
+            }
+            int leftEdge = MaskScanline::firstForeground(runs, runCount, bodyCenterX, imgWidth - 1);
+            
+            // Rightmost edge: last foreground pixel, as long as it is right of the hip
+            int rightEdge = MaskScanline::lastForeground(runs, runCount, rightHipX, imgWidth - 1);
+            
+            if (leftEdge >= 0 && rightEdge >= 0 && rightEdge > leftEdge) {
+                rightThighWidthPixels = static_cast<float>(rightEdge - leftEdge);
+                rightThighValid = true;
+            }
+        }
+        
+        // Fallback to estimation if pixel detection failed
+        if (!rightThighValid) {
+            float bodyCenterX = 0.5f;
+            if (kpts2d.size() > 24 && isValidKeypoint(kpts2d[23]) && isValidKeypoint(kpts2d[24])) {
+                bodyCenterX = (kpts2d[23].x + kpts2d[24].x) / 2.0f;
+            }
+            float hipHalfWidth = std::abs(kpts2d[24].x - bodyCenterX);
+            float thighExpansionFactor = 1.5f;
+            float rightThighHalfWidth = hipHalfWidth * thighExpansionFactor;
+            float rightThighWidthNormalized = rightThighHalfWidth * 2.0f;
+            rightThighWidthPixels = rightThighWidthNormalized * imgWidth;
+            rightThighValid = true;
+        }
+    }
+    
+    // Calculate average thigh width in centimeters
+    if (leftThighValid && rightThighValid) {
+        float avgThighWidthPixels = (leftThighWidthPixels + rightThighWidthPixels) / 2.0f;
+        float avgThighWidthCm = avgThighWidthPixels * cmPerPixel;
+        measurements[7] = validateMeasurement(avgThighWidthCm, 15.0f, 40.0f);
+    } else if (leftThighValid) {
+        float leftThighWidthCm = leftThighWidthPixels * cmPerPixel;
+        measurements[7] = validateMeasurement(leftThighWidthCm, 15.0f, 40.0f);
+    } else if (rightThighValid) {
+        float rightThighWidthCm = rightThighWidthPixels * cmPerPixel;
+        measurements[7] = validateMeasurement(rightThighWidthCm, 15.0f, 40.0f);
+    }
+    
+    return measurements;
+}
@@ -1,8 +1,13 @@
 #include "mediapipe_pose_detector.h"
+#include "keypoint_schema.h"
+#include "scan_trace.h"
 #include <opencv2/opencv.hpp>
 #include <opencv2/imgproc.hpp>
 #include <android/bitmap.h>
 #include <android/log.h>
+#include <algorithm>
+#include <cmath>
+#include <mutex>
 
 #define LOG_TAG "MediaPipePoseDetector"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
@@ -16,14 +21,27 @@ jmethodID MediaPipePoseDetector::initMethod = nullptr;
 jmethodID MediaPipePoseDetector::detectMethod = nullptr;
 jmethodID MediaPipePoseDetector::extractMethod = nullptr;
 jmethodID MediaPipePoseDetector::extractMaskMethod = nullptr;
+jmethodID MediaPipePoseDetector::extractMaskBufferMethod = nullptr;
+jmethodID MediaPipePoseDetector::maskWidthMethod = nullptr;
+jmethodID MediaPipePoseDetector::maskHeightMethod = nullptr;
 jmethodID MediaPipePoseDetector::countPosesMethod = nullptr;
+jmethodID MediaPipePoseDetector::extractVisibilityMethod = nullptr;
 jmethodID MediaPipePoseDetector::isReadyMethod = nullptr;
 jmethodID MediaPipePoseDetector::releaseMethod = nullptr;
+jmethodID MediaPipePoseDetector::startVideoMethod = nullptr;
+jmethodID MediaPipePoseDetector::detectVideoMethod = nullptr;
+jmethodID MediaPipePoseDetector::stopVideoMethod = nullptr;
 jmethodID MediaPipePoseDetector::createBitmapMethod = nullptr;
+jobject MediaPipePoseDetector::argb8888Config = nullptr;
 bool MediaPipePoseDetector::jniInitialized = false;
-jobject MediaPipePoseDetector::lastDetectionResult = nullptr;
+std::mutex MediaPipePoseDetector::jniInitMutex;
+std::mutex MediaPipePoseDetector::inferenceMutex;
+std::vector<MediaPipePoseDetector::BitmapPoolEntry> MediaPipePoseDetector::bitmapPool;
+std::mutex MediaPipePoseDetector::bitmapPoolMutex;
+uint64_t MediaPipePoseDetector::bitmapPoolClock = 0;
 
 bool MediaPipePoseDetector::initializeJNI(JNIEnv* env) {
+    std::lock_guard<std::mutex> lock(jniInitMutex);
     if (jniInitialized) {
         return true;
     }
@@ -86,12 +104,32 @@ bool MediaPipePoseDetector::initializeJNI(JNIEnv* env) {
         return false;
     }
     
-    // Get mask width/height methods
-    jmethodID getMaskWidthMethod = env->GetStaticMethodID(helperClass, "getSegmentationMaskWidth", 
-                                                         "(Lcom/google/mediapipe/tasks/vision/poselandmarker/PoseLandmarkerResult;)I");
-    jmethodID getMaskHeightMethod = env->GetStaticMethodID(helperClass, "getSegmentationMaskHeight", 
-                                                          "(Lcom/google/mediapipe/tasks/vision/poselandmarker/PoseLandmarkerResult;)I");
-    // Store these if needed, or call directly
+    extractVisibilityMethod = env->GetStaticMethodID(helperClass, "extractLandmarkVisibility", 
+                                                    "(Lcom/google/mediapipe/tasks/vision/poselandmarker/PoseLandmarkerResult;)[F");
+    if (extractVisibilityMethod == nullptr) {
+        LOGE("Failed to find extractLandmarkVisibility method");
+        env->ExceptionClear();
+        // Not critical - visibility is optional in PoseDetection
+    }
+    
+    // Mask dimensions and the zero-copy mask buffer (optional, like the mask itself)
+    maskWidthMethod = env->GetStaticMethodID(helperClass, "getSegmentationMaskWidth", 
+                                             "(Lcom/google/mediapipe/tasks/vision/poselandmarker/PoseLandmarkerResult;)I");
+    maskHeightMethod = env->GetStaticMethodID(helperClass, "getSegmentationMaskHeight", 
+                                              "(Lcom/google/mediapipe/tasks/vision/poselandmarker/PoseLandmarkerResult;)I");
+    if (maskWidthMethod == nullptr || maskHeightMethod == nullptr) {
+        LOGE("Failed to find mask dimension methods");
+        env->ExceptionClear();
+        maskWidthMethod = maskHeightMethod = nullptr;
+    }
+    
+    extractMaskBufferMethod = env->GetStaticMethodID(helperClass, "extractSegmentationMaskBuffer", 
+                                                     "(Lcom/google/mediapipe/tasks/vision/poselandmarker/PoseLandmarkerResult;)Ljava/nio/ByteBuffer;");
+    if (extractMaskBufferMethod == nullptr) {
+        LOGE("Failed to find extractSegmentationMaskBuffer method");
+        env->ExceptionClear();
+        // Not critical - falls back to extractSegmentationMaskData
+    }
     
     isReadyMethod = env->GetStaticMethodID(helperClass, "isReady", "()Z");
     if (isReadyMethod == nullptr) {
@@ -105,6 +143,18 @@ bool MediaPipePoseDetector::initializeJNI(JNIEnv* env) {
         return false;
     }
     
+    // VIDEO-mode tracking for the streaming preview (optional - the preview
+    // falls back to IMAGE-mode detection)
+    startVideoMethod = env->GetStaticMethodID(helperClass, "startVideoTracking", "()Z");
+    detectVideoMethod = env->GetStaticMethodID(helperClass, "detectPoseForVideo", 
+                                               "(Landroid/graphics/Bitmap;J)Lcom/google/mediapipe/tasks/vision/poselandmarker/PoseLandmarkerResult;");
+    stopVideoMethod = env->GetStaticMethodID(helperClass, "stopVideoTracking", "()V");
+    if (startVideoMethod == nullptr || detectVideoMethod == nullptr || stopVideoMethod == nullptr) {
+        LOGE("Failed to find video tracking methods");
+        env->ExceptionClear();
+        startVideoMethod = detectVideoMethod = stopVideoMethod = nullptr;
+    }
+    
     // Get Bitmap.createBitmap method
     createBitmapMethod = env->GetStaticMethodID(bitmapClass, "createBitmap", 
                                                 "(IILandroid/graphics/Bitmap$Config;)Landroid/graphics/Bitmap;");
@@ -113,6 +163,21 @@ bool MediaPipePoseDetector::initializeJNI(JNIEnv* env) {
         return false;
     }
     
+    // Cache Bitmap.Config.ARGB_8888 so bitmap creation needs no field lookups
+    jfieldID argb8888Field = env->GetStaticFieldID(configClass, "ARGB_8888", 
+                                                    "Landroid/graphics/Bitmap$Config;");
+    if (argb8888Field == nullptr) {
+        LOGE("Failed to find ARGB_8888 field");
+        return false;
+    }
+    jobject config = env->GetStaticObjectField(configClass, argb8888Field);
+    if (config == nullptr) {
+        LOGE("Failed to get ARGB_8888 config");
+        return false;
+    }
+    argb8888Config = env->NewGlobalRef(config);
+    env->DeleteLocalRef(config);
+    
     jniInitialized = true;
     LOGI("JNI initialization successful");
     return true;
@@ -122,6 +187,29 @@ bool MediaPipePoseDetector::initializeJNI(JNIEnv* env) {
 static jobject g_context = nullptr;
 JavaVM* g_jvm = nullptr; // Exported for use in pose_estimator.cpp
 
+// Attach the calling thread when no JNI environment was passed in
+static JNIEnv* resolveEnv(JNIEnv* env) {
+    if (env == nullptr && g_jvm != nullptr) {
+        g_jvm->AttachCurrentThread(&env, nullptr);
+    }
+    return env;
+}
+
+PoseSession& MediaPipePoseDetector::defaultSession() {
+    // Never destroyed - its global ref is dropped in release(), not at exit
+    static PoseSession* session = new PoseSession();
+    return *session;
+}
+
+bool MediaPipePoseDetector::onLoad(JavaVM* vm, JNIEnv* env) {
+    g_jvm = vm;
+    if (!initializeJNI(env)) {
+        env->ExceptionClear();
+        return false;
+    }
+    return true;
+}
+
 bool MediaPipePoseDetector::initialize(JNIEnv* env, jobject context) {
     if (!initializeJNI(env)) {
         return false;
@@ -174,6 +262,9 @@ void MediaPipePoseDetector::release(JNIEnv* env) {
     if (env->ExceptionCheck()) {
         env->ExceptionClear();
     }
+    
+    defaultSession().clear(env);
+    clearBitmapPool(env);
 }
 
 jobject MediaPipePoseDetector::matToBitmap(JNIEnv* env, const cv::Mat& img) {
@@ -182,88 +273,172 @@ jobject MediaPipePoseDetector::matToBitmap(JNIEnv* env, const cv::Mat& img) {
         return nullptr;
     }
     
-    // Ensure image is RGB (3 channels)
-    cv::Mat rgbImg;
+    // Pick the conversion that writes RGBA_8888 straight from the source Mat
+    int conversion = -1;
     if (img.channels() == 1) {
-        cv::cvtColor(img, rgbImg, cv::COLOR_GRAY2RGB);
+        conversion = cv::COLOR_GRAY2RGBA;
     } else if (img.channels() == 3) {
-        rgbImg = img.clone();
-    } else if (img.channels() == 4) {
-        cv::cvtColor(img, rgbImg, cv::COLOR_RGBA2RGB);
-    } else {
+        conversion = cv::COLOR_RGB2RGBA;
+    } else if (img.channels() != 4) {
         LOGE("Unsupported image format: %d channels", img.channels());
         return nullptr;
     }
     
-    // Get ARGB_8888 config
-    jfieldID argb8888Field = env->GetStaticFieldID(configClass, "ARGB_8888", 
-                                                    "Landroid/graphics/Bitmap$Config;");
-    if (argb8888Field == nullptr) {
-        LOGE("Failed to find ARGB_8888 field");
+    jobject bitmap = acquireBitmap(env, img.cols, img.rows);
+    if (bitmap == nullptr) {
         return nullptr;
     }
     
-    jobject config = env->GetStaticObjectField(configClass, argb8888Field);
-    if (config == nullptr) {
-        LOGE("Failed to get ARGB_8888 config");
+    if (!copyToBitmap(env, img, conversion, bitmap)) {
+        releaseBitmap(env, bitmap);
+        return nullptr;
+    }
+    
+    return bitmap;
+}
+
+jobject MediaPipePoseDetector::acquireBitmap(JNIEnv* env, int width, int height) {
+    {
+        std::lock_guard<std::mutex> lock(bitmapPoolMutex);
+        for (auto& entry : bitmapPool) {
+            if (!entry.inUse && entry.width == width && entry.height == height) {
+                entry.inUse = true;
+                entry.lastUsed = ++bitmapPoolClock;
+                return entry.bitmap;
+            }
+        }
+    }
+    
+    if (argb8888Config == nullptr) {
+        LOGE("ARGB_8888 config not initialized");
         return nullptr;
     }
     
-    // Create bitmap
-    jobject bitmap = env->CallStaticObjectMethod(bitmapClass, createBitmapMethod, 
-                                                 rgbImg.cols, rgbImg.rows, config);
-    if (bitmap == nullptr || env->ExceptionCheck()) {
+    // No free bitmap of this size - create one outside the lock
+    jobject local = env->CallStaticObjectMethod(bitmapClass, createBitmapMethod, 
+                                                width, height, argb8888Config);
+    if (local == nullptr || env->ExceptionCheck()) {
         if (env->ExceptionCheck()) {
             env->ExceptionDescribe();
             env->ExceptionClear();
         }
         LOGE("Failed to create bitmap");
-        env->DeleteLocalRef(config);
         return nullptr;
     }
+    jobject bitmap = env->NewGlobalRef(local);
+    env->DeleteLocalRef(local);
+    
+    std::vector<jobject> evicted;
+    {
+        std::lock_guard<std::mutex> lock(bitmapPoolMutex);
+        
+        // Evict least recently used idle bitmaps to make room; if every slot is
+        // busy the pool temporarily grows and shrinks again on release
+        while (bitmapPool.size() >= kBitmapPoolSize) {
+            auto lru = bitmapPool.end();
+            for (auto it = bitmapPool.begin(); it != bitmapPool.end(); ++it) {
+                if (!it->inUse && (lru == bitmapPool.end() || it->lastUsed < lru->lastUsed)) {
+                    lru = it;
+                }
+            }
+            if (lru == bitmapPool.end()) {
+                break;
+            }
+            evicted.push_back(lru->bitmap);
+            bitmapPool.erase(lru);
+        }
+        
+        bitmapPool.push_back({width, height, bitmap, true, ++bitmapPoolClock});
+    }
+    
+    for (jobject old : evicted) {
+        env->DeleteGlobalRef(old);
+    }
     
-    // Copy pixel data to bitmap
+    return bitmap;
+}
+
+void MediaPipePoseDetector::releaseBitmap(JNIEnv* env, jobject bitmap) {
+    if (bitmap == nullptr) {
+        return;
+    }
+    
+    jobject evicted = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(bitmapPoolMutex);
+        for (auto it = bitmapPool.begin(); it != bitmapPool.end(); ++it) {
+            if (it->bitmap == bitmap) {
+                it->inUse = false;
+                // Drop entries that overflowed the pool while all slots were busy
+                if (bitmapPool.size() > kBitmapPoolSize) {
+                    evicted = it->bitmap;
+                    bitmapPool.erase(it);
+                }
+                break;
+            }
+        }
+    }
+    
+    if (evicted != nullptr) {
+        env->DeleteGlobalRef(evicted);
+    }
+}
+
+void MediaPipePoseDetector::clearBitmapPool(JNIEnv* env) {
+    std::vector<BitmapPoolEntry> entries;
+    {
+        std::lock_guard<std::mutex> lock(bitmapPoolMutex);
+        entries.swap(bitmapPool);
+    }
+    for (const auto& entry : entries) {
+        env->DeleteGlobalRef(entry.bitmap);
+    }
+}
+
+bool MediaPipePoseDetector::copyToBitmap(JNIEnv* env, const cv::Mat& img, int conversion, jobject bitmap) {
     void* pixels;
     AndroidBitmapInfo info;
     if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS) {
         LOGE("Failed to get bitmap info");
-        env->DeleteLocalRef(config);
-        env->DeleteLocalRef(bitmap);
-        return nullptr;
+        return false;
+    }
+    
+    if (info.format != ANDROID_BITMAP_FORMAT_RGBA_8888 ||
+        static_cast<int>(info.width) != img.cols || static_cast<int>(info.height) != img.rows) {
+        LOGE("Bitmap %ux%u (format %d) does not match %dx%d image",
+             info.width, info.height, info.format, img.cols, img.rows);
+        return false;
     }
     
     if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS) {
         LOGE("Failed to lock bitmap pixels");
-        env->DeleteLocalRef(config);
-        env->DeleteLocalRef(bitmap);
-        return nullptr;
+        return false;
     }
     
-    // Convert RGB to ARGB
-    uint8_t* src = rgbImg.data;
-    uint32_t* dst = (uint32_t*)pixels;
-    for (int y = 0; y < rgbImg.rows; ++y) {
-        for (int x = 0; x < rgbImg.cols; ++x) {
-            int idx = y * rgbImg.cols + x;
-            uint8_t r = src[idx * 3 + 0];
-            uint8_t g = src[idx * 3 + 1];
-            uint8_t b = src[idx * 3 + 2];
-            // ARGB format: 0xAARRGGBB
-            dst[idx] = (0xFF << 24) | (r << 16) | (g << 8) | b;
-        }
+    // ARGB_8888 is stored as R, G, B, A bytes in memory. Wrap the locked pixels
+    // (honouring the row stride) and let OpenCV's vectorized kernels write into
+    // them directly - no intermediate RGB clone, no per-pixel index math.
+    cv::Mat dst(img.rows, img.cols, CV_8UC4, pixels, info.stride);
+    if (conversion >= 0) {
+        cv::cvtColor(img, dst, conversion);
+    } else {
+        img.copyTo(dst);
     }
     
     AndroidBitmap_unlockPixels(env, bitmap);
-    env->DeleteLocalRef(config);
     
-    return bitmap;
+    // cvtColor/copyTo reallocate only on a size/type mismatch, which was ruled out above
+    return dst.data == pixels;
 }
 
-jfloatArray MediaPipePoseDetector::detectInternal(JNIEnv* env, const cv::Mat& img) {
+jobject MediaPipePoseDetector::runInference(JNIEnv* env, const cv::Mat& img, int64_t videoTimestampMs) {
     if (!isReady(env)) {
         LOGE("MediaPipe not ready");
         return nullptr;
     }
+    if (videoTimestampMs >= 0 && detectVideoMethod == nullptr) {
+        return nullptr;
+    }
     
     // Convert Mat to Bitmap
     jobject bitmap = matToBitmap(env, img);
@@ -273,131 +448,221 @@ jfloatArray MediaPipePoseDetector::detectInternal(JNIEnv* env, const cv::Mat& im
     }
     
     // Call MediaPipe detection
-    jobject result = env->CallStaticObjectMethod(helperClass, detectMethod, bitmap);
+    jobject result;
+    {
+        std::lock_guard<std::mutex> lock(inferenceMutex);
+        if (videoTimestampMs >= 0) {
+            result = env->CallStaticObjectMethod(helperClass, detectVideoMethod, bitmap,
+                                                 static_cast<jlong>(videoTimestampMs));
+        } else {
+            result = env->CallStaticObjectMethod(helperClass, detectMethod, bitmap);
+        }
+    }
+    
+    // Detection is synchronous, so the bitmap can go back to the pool right away
+    releaseBitmap(env, bitmap);
+    
     if (env->ExceptionCheck()) {
         env->ExceptionDescribe();
         env->ExceptionClear();
-        env->DeleteLocalRef(bitmap);
         return nullptr;
     }
     
     if (result == nullptr) {
         LOGE("MediaPipe detection returned null");
-        env->DeleteLocalRef(bitmap);
         return nullptr;
     }
     
-    // Store result for mask extraction (create global ref)
-    if (lastDetectionResult != nullptr) {
-        env->DeleteGlobalRef(lastDetectionResult);
-    }
-    lastDetectionResult = env->NewGlobalRef(result);
+    return result;
+}
+
+std::vector<cv::Point3f> MediaPipePoseDetector::extractLandmarks(JNIEnv* env, jobject result) {
+    std::vector<cv::Point3f> landmarks;
     
-    // Extract landmarks
-    jfloatArray landmarks = (jfloatArray)env->CallStaticObjectMethod(
+    jfloatArray jLandmarks = (jfloatArray)env->CallStaticObjectMethod(
         helperClass, extractMethod, result);
-    
     if (env->ExceptionCheck()) {
         env->ExceptionDescribe();
         env->ExceptionClear();
-    }
-    
-    env->DeleteLocalRef(bitmap);
-    env->DeleteLocalRef(result);
-    
-    return landmarks;
-}
-
-std::vector<cv::Point3f> MediaPipePoseDetector::detect(JNIEnv* env, const cv::Mat& img) {
-    std::vector<cv::Point3f> landmarks;
-    
-    if (img.empty() || img.cols <= 0 || img.rows <= 0) {
         return landmarks;
     }
-    
-    // Ensure we have a valid JNI environment
-    if (env == nullptr && g_jvm != nullptr) {
-        g_jvm->AttachCurrentThread(&env, nullptr);
-    }
-    if (env == nullptr) {
-        LOGE("Failed to get JNI environment");
-        return landmarks;
-    }
-    
-    jfloatArray jLandmarks = detectInternal(env, img);
     if (jLandmarks == nullptr) {
         return landmarks;
     }
     
+    const jsize expected = static_cast<jsize>(MediaPipeLayout::kCount * 3);
     jsize len = env->GetArrayLength(jLandmarks);
-    if (len != 33 * 3) {
-        LOGE("Unexpected landmark array length: %d (expected %d)", len, 33 * 3);
+    if (len != expected) {
+        LOGE("Unexpected landmark array length: %d (expected %d)", len, expected);
         env->DeleteLocalRef(jLandmarks);
         return landmarks;
     }
     
-    // Extract landmarks
-    jfloat* data = env->GetFloatArrayElements(jLandmarks, nullptr);
-    if (data == nullptr) {
-        env->DeleteLocalRef(jLandmarks);
-        return landmarks;
-    }
-    
-    landmarks.reserve(33);
-    for (int i = 0; i < 33; ++i) {
-        float x = data[i * 3 + 0];
-        float y = data[i * 3 + 1];
-        float z = data[i * 3 + 2];
-        landmarks.push_back(cv::Point3f(x, y, z));
-    }
-    
-    env->ReleaseFloatArrayElements(jLandmarks, data, JNI_ABORT);
+    // Extract landmarks straight into the (x, y, z) points
+    landmarks.resize(MediaPipeLayout::kCount);
+    env->GetFloatArrayRegion(jLandmarks, 0, expected, reinterpret_cast<jfloat*>(landmarks.data()));
     env->DeleteLocalRef(jLandmarks);
     
     return landmarks;
 }
 
-cv::Mat MediaPipePoseDetector::getSegmentationMask(JNIEnv* env, const cv::Mat& img) {
-    cv::Mat mask;
+std::vector<float> MediaPipePoseDetector::extractVisibility(JNIEnv* env, jobject result) {
+    std::vector<float> visibility;
+    if (extractVisibilityMethod == nullptr) {
+        return visibility;
+    }
     
-    if (lastDetectionResult == nullptr || extractMaskMethod == nullptr) {
-        return mask; // Return empty Mat
+    jfloatArray jVisibility = (jfloatArray)env->CallStaticObjectMethod(
+        helperClass, extractVisibilityMethod, result);
+    if (env->ExceptionCheck()) {
+        env->ExceptionClear();
+        return visibility;
+    }
+    if (jVisibility == nullptr) {
+        return visibility;
     }
     
-    if (img.empty() || img.cols <= 0 || img.rows <= 0) {
-        return mask;
+    const jsize expected = static_cast<jsize>(MediaPipeLayout::kCount);
+    if (env->GetArrayLength(jVisibility) == expected) {
+        visibility.resize(MediaPipeLayout::kCount);
+        env->GetFloatArrayRegion(jVisibility, 0, expected, visibility.data());
     }
+    env->DeleteLocalRef(jVisibility);
     
-    // Ensure we have a valid JNI environment
-    if (env == nullptr && g_jvm != nullptr) {
-        g_jvm->AttachCurrentThread(&env, nullptr);
+    return visibility;
+}
+
+int MediaPipePoseDetector::extractPoseCount(JNIEnv* env, jobject result) {
+    jint count = env->CallStaticIntMethod(helperClass, countPosesMethod, result);
+    if (env->ExceptionCheck()) {
+        env->ExceptionDescribe();
+        env->ExceptionClear();
+        return 0;
     }
-    if (env == nullptr) {
-        LOGE("Failed to get JNI environment for mask extraction");
-        return mask;
+    return count;
+}
+
+namespace {
+
+/**
+ * Allocator for Mats that wrap a Java direct ByteBuffer: the UMatData holds a
+ * global ref to the buffer and drops it when the last Mat referencing the
+ * memory goes away. Allocation requests (create() on such a Mat) go to the
+ * standard allocator.
+ */
+class DirectBufferAllocator : public cv::MatAllocator {
+public:
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override {
+        return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+    }
+    
+    bool allocate(cv::UMatData* data, cv::AccessFlag accessFlags,
+                  cv::UMatUsageFlags usageFlags) const override {
+        return cv::Mat::getStdAllocator()->allocate(data, accessFlags, usageFlags);
+    }
+    
+    void deallocate(cv::UMatData* u) const override {
+        if (u == nullptr || u->refcount != 0 || u->urefcount != 0) {
+            return;
+        }
+        if (u->userdata != nullptr && g_jvm != nullptr) {
+            // The last Mat may die on any thread (e.g. a preprocessing worker):
+            // attach only for the delete and leave the thread as it was found
+            JNIEnv* env = nullptr;
+            const jint status = g_jvm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6);
+            if (status == JNI_OK) {
+                env->DeleteGlobalRef(static_cast<jobject>(u->userdata));
+            } else if (status == JNI_EDETACHED && g_jvm->AttachCurrentThread(&env, nullptr) == JNI_OK) {
+                env->DeleteGlobalRef(static_cast<jobject>(u->userdata));
+                g_jvm->DetachCurrentThread();
+            }
+        }
+        delete u;
+    }
+};
+
+const DirectBufferAllocator* directBufferAllocator() {
+    // Never destroyed - Mats may outlive static destruction order
+    static const DirectBufferAllocator* allocator = new DirectBufferAllocator();
+    return allocator;
+}
+
+/**
+ * Wrap a direct ByteBuffer of width * height floats as a CV_32FC1 Mat that
+ * keeps the buffer alive.
+ * 
+ * @return The wrapped mask, or empty Mat if the buffer is not direct or too small
+ */
+cv::Mat wrapDirectMask(JNIEnv* env, jobject buffer, int width, int height) {
+    void* data = env->GetDirectBufferAddress(buffer);
+    const jlong capacity = env->GetDirectBufferCapacity(buffer);
+    const size_t required = static_cast<size_t>(width) * height * sizeof(float);
+    if (data == nullptr || capacity < 0 || static_cast<size_t>(capacity) < required) {
+        return cv::Mat();
+    }
+    
+    jobject ref = env->NewGlobalRef(buffer);
+    if (ref == nullptr) {
+        return cv::Mat();
+    }
+    
+    const DirectBufferAllocator* allocator = directBufferAllocator();
+    cv::Mat mask(height, width, CV_32FC1, data);
+    cv::UMatData* u = new cv::UMatData(allocator);
+    u->data = u->origdata = static_cast<cv::uchar*>(data);
+    u->size = required;
+    u->userdata = ref;
+    mask.u = u;
+    mask.allocator = const_cast<DirectBufferAllocator*>(allocator);
+    mask.addref();
+    return mask;
+}
+
+} // namespace
+
+cv::Mat MediaPipePoseDetector::extractMask(JNIEnv* env, jobject result) {
+    cv::Mat mask;
+    
+    if (result == nullptr || maskWidthMethod == nullptr || maskHeightMethod == nullptr) {
+        return mask; // Return empty Mat
     }
     
     // Get mask width and height
-    jmethodID getMaskWidthMethod = env->GetStaticMethodID(helperClass, "getSegmentationMaskWidth", 
-                                                         "(Lcom/google/mediapipe/tasks/vision/poselandmarker/PoseLandmarkerResult;)I");
-    jmethodID getMaskHeightMethod = env->GetStaticMethodID(helperClass, "getSegmentationMaskHeight", 
-                                                          "(Lcom/google/mediapipe/tasks/vision/poselandmarker/PoseLandmarkerResult;)I");
-    
-    if (getMaskWidthMethod == nullptr || getMaskHeightMethod == nullptr) {
-        LOGE("Failed to find mask dimension methods");
+    jint maskWidth = env->CallStaticIntMethod(helperClass, maskWidthMethod, result);
+    jint maskHeight = env->CallStaticIntMethod(helperClass, maskHeightMethod, result);
+    if (env->ExceptionCheck()) {
+        env->ExceptionClear();
         return mask;
     }
     
-    jint maskWidth = env->CallStaticIntMethod(helperClass, getMaskWidthMethod, lastDetectionResult);
-    jint maskHeight = env->CallStaticIntMethod(helperClass, getMaskHeightMethod, lastDetectionResult);
-    
     if (maskWidth <= 0 || maskHeight <= 0) {
         return mask; // No mask available
     }
     
+    // Zero-copy path: wrap MediaPipe's own mask buffer
+    if (extractMaskBufferMethod != nullptr) {
+        jobject buffer = env->CallStaticObjectMethod(helperClass, extractMaskBufferMethod, result);
+        if (env->ExceptionCheck()) {
+            env->ExceptionClear();
+            buffer = nullptr;
+        }
+        if (buffer != nullptr) {
+            mask = wrapDirectMask(env, buffer, maskWidth, maskHeight);
+            env->DeleteLocalRef(buffer);
+            if (!mask.empty()) {
+                return mask;
+            }
+        }
+    }
+    
+    if (extractMaskMethod == nullptr) {
+        return mask;
+    }
+    
     // Extract mask data
     jfloatArray jMaskData = (jfloatArray)env->CallStaticObjectMethod(
-        helperClass, extractMaskMethod, lastDetectionResult);
+        helperClass, extractMaskMethod, result);
     
     if (jMaskData == nullptr || env->ExceptionCheck()) {
         if (env->ExceptionCheck()) {
@@ -413,63 +678,318 @@ cv::Mat MediaPipePoseDetector::getSegmentationMask(JNIEnv* env, const cv::Mat& i
         return mask;
     }
     
-    // Get mask data
-    jfloat* maskData = env->GetFloatArrayElements(jMaskData, nullptr);
-    if (maskData == nullptr) {
-        env->DeleteLocalRef(jMaskData);
-        return mask;
-    }
-    
-    // Create OpenCV Mat from mask data
-    mask = cv::Mat(maskHeight, maskWidth, CV_32FC1, maskData).clone();
-    
-    env->ReleaseFloatArrayElements(jMaskData, maskData, JNI_ABORT);
+    // Copy mask data straight into the OpenCV Mat
+    mask.create(maskHeight, maskWidth, CV_32FC1);
+    env->GetFloatArrayRegion(jMaskData, 0, maskSize, mask.ptr<float>());
     env->DeleteLocalRef(jMaskData);
     
     return mask;
 }
 
-int MediaPipePoseDetector::countDetectedPoses(JNIEnv* env, const cv::Mat& img) {
-    if (!isReady(env)) {
-        LOGE("MediaPipe not ready");
-        return 0;
-    }
-    
-    // Convert Mat to Bitmap
-    jobject bitmap = matToBitmap(env, img);
-    if (bitmap == nullptr) {
-        LOGE("Failed to convert Mat to Bitmap");
-        return 0;
+MediaPipePoseDetector::PoseDetection MediaPipePoseDetector::detectFull(
+    JNIEnv* env, const cv::Mat& img, bool withMask) {
+    return defaultSession().detect(env, img, withMask);
+}
+
+std::vector<cv::Point3f> MediaPipePoseDetector::detect(JNIEnv* env, const cv::Mat& img) {
+    return detectFull(env, img, false).landmarks;
+}
+
+bool MediaPipePoseDetector::startTracking(JNIEnv* env) {
+    if (!jniInitialized || startVideoMethod == nullptr) {
+        return false;
     }
     
-    // Call MediaPipe detection
-    jobject result = env->CallStaticObjectMethod(helperClass, detectMethod, bitmap);
+    jboolean started = env->CallStaticBooleanMethod(helperClass, startVideoMethod);
     if (env->ExceptionCheck()) {
         env->ExceptionDescribe();
         env->ExceptionClear();
-        env->DeleteLocalRef(bitmap);
-        return 0;
+        return false;
+    }
+    return started == JNI_TRUE;
+}
+
+MediaPipePoseDetector::PoseDetection MediaPipePoseDetector::detectTracked(
+    JNIEnv* env, const cv::Mat& img, int64_t timestampMs) {
+    ScopedTimer timer(ScanStage::Inference);
+    PoseDetection detection;
+    
+    if (img.empty() || img.cols <= 0 || img.rows <= 0 || timestampMs < 0) {
+        return detection;
     }
     
+    env = resolveEnv(env);
+    if (env == nullptr) {
+        LOGE("Failed to get JNI environment");
+        return detection;
+    }
+    
+    jobject result = runInference(env, img, timestampMs);
     if (result == nullptr) {
-        LOGE("MediaPipe detection returned null");
-        env->DeleteLocalRef(bitmap);
-        return 0;
+        return detection;
     }
     
-    // Count detected poses
-    jint count = env->CallStaticIntMethod(helperClass, countPosesMethod, result);
+    detection.poseCount = extractPoseCount(env, result);
+    detection.landmarks = extractLandmarks(env, result);
+    if (!detection.landmarks.empty()) {
+        detection.visibility = extractVisibility(env, result);
+    }
+    env->DeleteLocalRef(result);
+    
+    return detection;
+}
+
+void MediaPipePoseDetector::stopTracking(JNIEnv* env) {
+    if (!jniInitialized || stopVideoMethod == nullptr) {
+        return;
+    }
+    
+    env = resolveEnv(env);
+    if (env == nullptr) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(inferenceMutex);
+    env->CallStaticVoidMethod(helperClass, stopVideoMethod);
     if (env->ExceptionCheck()) {
-        env->ExceptionDescribe();
         env->ExceptionClear();
-        env->DeleteLocalRef(bitmap);
-        env->DeleteLocalRef(result);
-        return 0;
+    }
+}
+
+cv::Mat MediaPipePoseDetector::getSegmentationMask(JNIEnv* env, const cv::Mat& img) {
+    if (img.empty() || img.cols <= 0 || img.rows <= 0) {
+        return cv::Mat();
     }
     
-    env->DeleteLocalRef(bitmap);
+    // The default session never crops, so the mask covers the whole image
+    cv::Rect maskRegion;
+    return defaultSession().segmentationMask(env, maskRegion);
+}
+
+int MediaPipePoseDetector::countDetectedPoses(JNIEnv* env, const cv::Mat& img) {
+    return detectFull(env, img, false).poseCount;
+}
+
+namespace {
+
+// Landmarks below this visibility are left out of the ROI box
+constexpr float kRoiMinVisibility = 0.5f;
+
+// A pose this close to a crop edge (fraction of the crop size) may extend past it
+constexpr float kRoiBorderMargin = 0.02f;
+
+/**
+ * Normalized box around the visible landmarks (all of them when there are no
+ * visibility scores).
+ * 
+ * @return false if no landmark is visible
+ */
+bool landmarkBounds(const MediaPipePoseDetector::PoseDetection& detection, cv::Rect2f& box) {
+    const bool useVisibility = detection.visibility.size() == detection.landmarks.size();
+    float minX = 1.0f, minY = 1.0f, maxX = 0.0f, maxY = 0.0f;
+    bool any = false;
+    for (size_t i = 0; i < detection.landmarks.size(); ++i) {
+        if (useVisibility && detection.visibility[i] < kRoiMinVisibility) {
+            continue;
+        }
+        // Off-frame estimates are clamped to the frame
+        const float x = std::min(std::max(detection.landmarks[i].x, 0.0f), 1.0f);
+        const float y = std::min(std::max(detection.landmarks[i].y, 0.0f), 1.0f);
+        minX = std::min(minX, x);
+        minY = std::min(minY, y);
+        maxX = std::max(maxX, x);
+        maxY = std::max(maxY, y);
+        any = true;
+    }
+    if (!any) {
+        return false;
+    }
+    box = cv::Rect2f(minX, minY, maxX - minX, maxY - minY);
+    return true;
+}
+
+/**
+ * Whether a pose found in a crop stays clear of the crop edges. Edges lying
+ * on the frame border do not count: the full frame would see no more there.
+ */
+bool poseInsideCrop(const cv::Rect2f& box, const cv::Rect& crop, const cv::Size& imageSize) {
+    const float marginX = kRoiBorderMargin * crop.width;
+    const float marginY = kRoiBorderMargin * crop.height;
+    const float left = box.x * imageSize.width;
+    const float right = (box.x + box.width) * imageSize.width;
+    const float top = box.y * imageSize.height;
+    const float bottom = (box.y + box.height) * imageSize.height;
+    
+    if (crop.x > 0 && left < crop.x + marginX) {
+        return false;
+    }
+    if (crop.x + crop.width < imageSize.width && right > crop.x + crop.width - marginX) {
+        return false;
+    }
+    if (crop.y > 0 && top < crop.y + marginY) {
+        return false;
+    }
+    if (crop.y + crop.height < imageSize.height && bottom > crop.y + crop.height - marginY) {
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+PoseSession::~PoseSession() {
+    clear(nullptr);
+}
+
+MediaPipePoseDetector::PoseDetection PoseSession::detect(JNIEnv* env, const cv::Mat& img, bool withMask) {
+    if (img.empty() || img.cols <= 0 || img.rows <= 0) {
+        return MediaPipePoseDetector::PoseDetection();
+    }
+    
+    // Ensure we have a valid JNI environment
+    env = resolveEnv(env);
+    if (env == nullptr) {
+        LOGE("Failed to get JNI environment");
+        return MediaPipePoseDetector::PoseDetection();
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    return detectLocked(env, img, withMask, cv::Rect());
+}
+
+MediaPipePoseDetector::PoseDetection PoseSession::detectWithRoi(JNIEnv* env, const cv::Mat& img, bool withMask) {
+    if (img.empty() || img.cols <= 0 || img.rows <= 0) {
+        return MediaPipePoseDetector::PoseDetection();
+    }
+    
+    env = resolveEnv(env);
+    if (env == nullptr) {
+        LOGE("Failed to get JNI environment");
+        return MediaPipePoseDetector::PoseDetection();
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    // Empty (full frame) without a previous pose or when the crop would be most of the frame
+    const cv::Rect crop = roiFor(img.size());
+    MediaPipePoseDetector::PoseDetection detection = detectLocked(env, img, withMask, crop);
+    
+    // detectLocked() refreshed roi from this detection's landmarks. Tracking
+    // lost costs no second inference here: the next frame searches the full frame.
+    if (crop.area() > 0 && hasRoi && !poseInsideCrop(roi, crop, img.size())) {
+        hasRoi = false;
+    }
+    return detection;
+}
+
+cv::Rect PoseSession::roiFor(const cv::Size& imageSize) const {
+    if (!hasRoi) {
+        return cv::Rect();
+    }
+    
+    const float padX = roi.width * kRoiPadding;
+    const float padY = roi.height * kRoiPadding;
+    const float left = std::max(roi.x - padX, 0.0f) * imageSize.width;
+    const float right = std::min(roi.x + roi.width + padX, 1.0f) * imageSize.width;
+    const float top = std::max(roi.y - padY, 0.0f) * imageSize.height;
+    const float bottom = std::min(roi.y + roi.height + padY, 1.0f) * imageSize.height;
+    
+    // Round the size up to the granularity, keep it centered on the padded
+    // box and shift it back inside the frame where it overhangs
+    auto roundUp = [](float extent, int limit) {
+        const int size = (static_cast<int>(std::ceil(extent)) + kRoiGranularity - 1) /
+                         kRoiGranularity * kRoiGranularity;
+        return std::min(std::max(size, kRoiGranularity), limit);
+    };
+    const int width = roundUp(right - left, imageSize.width);
+    const int height = roundUp(bottom - top, imageSize.height);
+    if (static_cast<float>(width) * height > kMaxRoiArea * imageSize.width * imageSize.height) {
+        return cv::Rect();
+    }
+    
+    const int x = std::min(std::max(static_cast<int>(std::lround((left + right - width) * 0.5f)), 0),
+                           imageSize.width - width);
+    const int y = std::min(std::max(static_cast<int>(std::lround((top + bottom - height) * 0.5f)), 0),
+                           imageSize.height - height);
+    return cv::Rect(x, y, width, height);
+}
+
+MediaPipePoseDetector::PoseDetection PoseSession::detectLocked(JNIEnv* env, const cv::Mat& img,
+                                                               bool withMask, const cv::Rect& crop) {
+    ScopedTimer timer(ScanStage::Inference);
+    MediaPipePoseDetector::PoseDetection detection;
+    const bool cropped = crop.area() > 0;
+    
+    // Single inference - everything below reads from this one result
+    // (a crop is a view into img; the bitmap conversion reads it in place)
+    jobject result = MediaPipePoseDetector::runInference(env, cropped ? img(crop) : img);
+    if (result == nullptr) {
+        hasRoi = false;
+        return detection;
+    }
+    
+    detection.poseCount = MediaPipePoseDetector::extractPoseCount(env, result);
+    detection.landmarks = MediaPipePoseDetector::extractLandmarks(env, result);
+    if (!detection.landmarks.empty()) {
+        detection.visibility = MediaPipePoseDetector::extractVisibility(env, result);
+    }
+    if (withMask) {
+        // At the crop's resolution; maskRegion places it in the frame
+        detection.segmentationMask = MediaPipePoseDetector::extractMask(env, result);
+        detection.maskRegion = crop;
+    }
+    
+    if (cropped) {
+        // Crop-normalized to full-frame normalized; z shares the x scale
+        const float scaleX = static_cast<float>(crop.width) / img.cols;
+        const float scaleY = static_cast<float>(crop.height) / img.rows;
+        const float offsetX = static_cast<float>(crop.x) / img.cols;
+        const float offsetY = static_cast<float>(crop.y) / img.rows;
+        for (cv::Point3f& landmark : detection.landmarks) {
+            landmark.x = offsetX + landmark.x * scaleX;
+            landmark.y = offsetY + landmark.y * scaleY;
+            landmark.z *= scaleX;
+        }
+    }
+    
+    // The next detectWithRoi() crops around this pose
+    hasRoi = !detection.landmarks.empty() && landmarkBounds(detection, roi);
+    
+    // Keep this session's result for segmentationMask()
+    if (lastResult != nullptr) {
+        env->DeleteGlobalRef(lastResult);
+    }
+    lastResult = env->NewGlobalRef(result);
+    lastCrop = crop;
     env->DeleteLocalRef(result);
     
-    return count;
+    return detection;
 }
 
+cv::Mat PoseSession::segmentationMask(JNIEnv* env, cv::Rect& maskRegion) {
+    maskRegion = cv::Rect();
+    env = resolveEnv(env);
+    if (env == nullptr) {
+        LOGE("Failed to get JNI environment for mask extraction");
+        return cv::Mat();
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    maskRegion = lastCrop;
+    return MediaPipePoseDetector::extractMask(env, lastResult);
+}
+
+void PoseSession::clear(JNIEnv* env) {
+    std::lock_guard<std::mutex> lock(mutex);
+    hasRoi = false;
+    lastCrop = cv::Rect();
+    if (lastResult == nullptr) {
+        return;
+    }
+    
+    env = resolveEnv(env);
+    if (env != nullptr) {
+        env->DeleteGlobalRef(lastResult);
+    }
+    lastResult = nullptr;
+}
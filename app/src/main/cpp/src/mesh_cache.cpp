@@ -0,0 +1,343 @@
+#include "mesh_cache.h"
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr const char* kFileSuffix = ".glb";
+
+// GLB header: magic "glTF", version, total length (little-endian uint32s)
+constexpr uint32_t kGlbMagic = 0x46546C67;
+constexpr size_t kGlbHeaderBytes = 12;
+
+// A store over budget trims to this fraction of it, so the directory is
+// rescanned once per quarter budget written rather than on every miss
+constexpr size_t kTrimHeadroomDivisor = 4;
+
+// 64-bit FNV-1a
+constexpr uint64_t kFnvOffset = 1469598103934665603ull;
+constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+uint64_t fnv1a(uint64_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= kFnvPrime;
+    }
+    return hash;
+}
+
+bool endsWith(const char* name, const char* suffix) {
+    const size_t nameLength = std::strlen(name);
+    const size_t suffixLength = std::strlen(suffix);
+    return nameLength >= suffixLength && std::strcmp(name + nameLength - suffixLength, suffix) == 0;
+}
+
+// A disk entry is served only if it is a whole GLB: a truncated or foreign
+// file would otherwise reach the viewer as a mesh
+bool isCompleteGlb(const MeshBlob& blob) {
+    if (blob.size() < kGlbHeaderBytes) {
+        return false;
+    }
+    uint32_t magic;
+    uint32_t length;
+    std::memcpy(&magic, blob.data(), sizeof(magic));
+    std::memcpy(&length, blob.data() + 8, sizeof(length));
+    return magic == kGlbMagic && length == blob.size();
+}
+
+// Write all of data to path through a temporary file, so readers never map a
+// partial GLB. Each writer gets its own temporary file: concurrent misses on
+// one key each rename a complete file into place, never a shared one another
+// writer is still filling.
+bool writeFileAtomically(const std::string& path, const uint8_t* data, size_t size) {
+    std::string temporary = path + ".XXXXXX";
+    const int fd = ::mkstemp(&temporary[0]);
+    if (fd < 0) {
+        return false;
+    }
+    size_t written = 0;
+    while (written < size) {
+        const ssize_t n = ::write(fd, data + written, size - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        written += static_cast<size_t>(n);
+    }
+    const bool ok = ::close(fd) == 0 && written == size;
+    if (!ok || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        ::unlink(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+// ---- MeshBlob ----
+
+MeshBlob::~MeshBlob() {
+    if (mapping != nullptr) {
+        ::munmap(mapping, mappedSize);
+    }
+}
+
+std::shared_ptr<const MeshBlob> MeshBlob::map(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+        ::close(fd);
+        return nullptr;
+    }
+    const size_t size = static_cast<size_t>(info.st_size);
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // The mapping keeps the file contents
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+
+    std::shared_ptr<MeshBlob> blob(new MeshBlob());
+    blob->mapping = mapping;
+    blob->mappedSize = size;
+    return blob;
+}
+
+// ---- MeshCache ----
+
+MeshCache::Key MeshCache::keyFor(const std::vector<cv::Point3f>& body25, MeshLod lod, MeshFormat format) {
+    // Hash the exact float bits: identical keypoints are what make a GLB reusable.
+    // The segment count and version are folded in, so a tessellation change
+    // never matches an older entry.
+    const int32_t params[] = {kVersion, MeshGenerator::segmentsFor(lod), static_cast<int32_t>(lod),
+                              static_cast<int32_t>(format), static_cast<int32_t>(body25.size())};
+    uint64_t hash = fnv1a(kFnvOffset, params, sizeof(params));
+    hash = fnv1a(hash, body25.data(), body25.size() * sizeof(cv::Point3f));
+
+    Key key;
+    key.keypointHash = hash;
+    key.lod = lod;
+    key.format = format;
+    return key;
+}
+
+std::shared_ptr<const MeshBlob> MeshCache::get(const std::vector<cv::Point3f>& body25,
+                                               MeshLod lod, MeshFormat format) {
+    const Key key = keyFor(body25, lod, format);
+    if (std::shared_ptr<const MeshBlob> cached = find(key)) {
+        return cached;
+    }
+
+    std::vector<uint8_t> glb = MeshGenerator::createFromKeypoints(body25, lod, format);
+    if (glb.empty()) {
+        return nullptr;  // Not cached: keypoints that cannot mesh are cheap to reject again
+    }
+    auto blob = std::make_shared<const MeshBlob>(std::move(glb));
+    store(key, *blob);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    counters.misses++;
+    insertLocked(key, blob);
+    return blob;
+}
+
+std::shared_ptr<const MeshBlob> MeshCache::find(const Key& key) {
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(key);
+        if (it != entries.end()) {
+            lru.splice(lru.begin(), lru, it->second);  // Most recently used
+            counters.memoryHits++;
+            return it->second->second;
+        }
+        if (diskDirectory.empty()) {
+            return nullptr;
+        }
+        path = diskPath(key);
+    }
+
+    std::shared_ptr<const MeshBlob> blob = MeshBlob::map(path);
+    if (blob == nullptr) {
+        return nullptr;
+    }
+    if (!isCompleteGlb(*blob)) {
+        // Drop it, so the rebuilt mesh replaces it
+        if (::unlink(path.c_str()) == 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            diskUsed -= std::min(diskUsed, blob->size());
+        }
+        return nullptr;
+    }
+    // Refresh the file's place in the disk LRU (ordered by modification time)
+    ::utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    counters.diskHits++;
+    insertLocked(key, blob);
+    return blob;
+}
+
+bool MeshCache::setDiskCache(const std::string& directory, size_t maxBytes) {
+    if (!directory.empty() && ::mkdir(directory.c_str(), 0700) != 0 && errno != EEXIST) {
+        return false;
+    }
+    const size_t used = directory.empty() ? 0 : trimDirectory(directory, maxBytes);
+    std::lock_guard<std::mutex> lock(mutex);
+    diskDirectory = directory;
+    diskBudget = maxBytes;
+    diskUsed = used;
+    return true;
+}
+
+void MeshCache::setMemoryBudget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    memoryBudget = bytes;
+    evictLocked();
+}
+
+void MeshCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    lru.clear();
+    entries.clear();
+    memoryUsed = 0;
+}
+
+MeshCache::Stats MeshCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats result = counters;
+    result.memoryBytes = memoryUsed;
+    return result;
+}
+
+std::string MeshCache::diskPath(const Key& key) const {
+    char name[64];
+    std::snprintf(name, sizeof(name), "/v%d-%016" PRIx64 "-%d-%d%s", kVersion, key.keypointHash,
+                  static_cast<int>(key.lod), static_cast<int>(key.format), kFileSuffix);
+    return diskDirectory + name;
+}
+
+void MeshCache::insertLocked(const Key& key, std::shared_ptr<const MeshBlob> blob) {
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        // A concurrent miss got here first; keep its blob
+        lru.splice(lru.begin(), lru, it->second);
+        return;
+    }
+    memoryUsed += blob->size();
+    lru.emplace_front(key, std::move(blob));
+    entries.emplace(key, lru.begin());
+    evictLocked();
+}
+
+void MeshCache::evictLocked() {
+    // The newest entry stays even if it alone exceeds the budget
+    while (memoryUsed > memoryBudget && lru.size() > 1) {
+        memoryUsed -= lru.back().second->size();
+        entries.erase(lru.back().first);
+        lru.pop_back();
+    }
+}
+
+void MeshCache::store(const Key& key, const MeshBlob& blob) {
+    std::string directory;
+    std::string path;
+    size_t budget;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (diskDirectory.empty()) {
+            return;
+        }
+        directory = diskDirectory;
+        path = diskPath(key);
+        budget = diskBudget;
+    }
+    if (!writeFileAtomically(path, blob.data(), blob.size())) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (diskDirectory != directory) {
+            return;  // Reconfigured meanwhile; setDiskCache counted the directory itself
+        }
+        // Replacing an existing file of the same key overcounts, which only
+        // brings the next rescan forward
+        diskUsed += blob.size();
+        if (diskUsed <= budget) {
+            return;
+        }
+    }
+    const size_t used = trimDirectory(directory, budget - budget / kTrimHeadroomDivisor);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (diskDirectory == directory) {
+        diskUsed = used;
+    }
+}
+
+size_t MeshCache::trimDirectory(const std::string& directory, size_t maxBytes) {
+    DIR* dir = ::opendir(directory.c_str());
+    if (dir == nullptr) {
+        return 0;
+    }
+
+    struct CacheFile {
+        std::string path;
+        size_t size;
+        struct timespec modified;
+    };
+    std::vector<CacheFile> files;
+    size_t total = 0;
+    while (struct dirent* entry = ::readdir(dir)) {
+        if (!endsWith(entry->d_name, kFileSuffix)) {
+            continue;
+        }
+        CacheFile file;
+        file.path = directory + "/" + entry->d_name;
+        struct stat info;
+        if (::stat(file.path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) {
+            continue;
+        }
+        file.size = static_cast<size_t>(info.st_size);
+#if defined(__APPLE__)
+        file.modified = info.st_mtimespec;
+#else
+        file.modified = info.st_mtim;
+#endif
+        total += file.size;
+        files.push_back(std::move(file));
+    }
+    ::closedir(dir);
+
+    if (total <= maxBytes) {
+        return total;
+    }
+    // Oldest first. Mapped files stay readable after unlink until they are unmapped.
+    std::sort(files.begin(), files.end(), [](const CacheFile& a, const CacheFile& b) {
+        return a.modified.tv_sec != b.modified.tv_sec ? a.modified.tv_sec < b.modified.tv_sec
+                                                      : a.modified.tv_nsec < b.modified.tv_nsec;
+    });
+    for (const CacheFile& file : files) {
+        if (total <= maxBytes) {
+            break;
+        }
+        if (::unlink(file.path.c_str()) == 0) {
+            total -= file.size;
+        }
+    }
+    return total;
+}
@@ -1,15 +1,20 @@
 #include "mesh_generator.h"
+#include "keypoint_schema.h"
+#include "scan_trace.h"
 #include <opencv2/opencv.hpp>
 #include <opencv2/imgproc.hpp>
 #include <vector>
+#include <cstddef>
 #include <cstdint>
 #include <cmath>
 #include <algorithm>
 #include <limits>
 #include <string>
-#include <sstream>
 #include <cstring>
-#include <iomanip>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
 #ifdef __ANDROID__
 #include <android/log.h>
 #endif
@@ -21,149 +26,112 @@ float calculateEllipseCircumference(float a, float b) {
     return M_PI * (a + b) * (1.0f + (3.0f * h) / (10.0f + std::sqrt(4.0f - 3.0f * h)));
 }
 
-// Helper function to fit ellipse to 3D points at a given Y level
-float fitEllipseAtY(const std::vector<cv::Point3f>& kpts3d, float targetY, float tolerance) {
-    std::vector<cv::Point2f> points2d;
-    
-    for (const auto& pt : kpts3d) {
-        if (std::abs(pt.y - targetY) < tolerance) {
-            // Project to XZ plane (width and depth)
-            points2d.push_back(cv::Point2f(pt.x, pt.z));
-        }
-    }
-    
+// Circumference of the ellipse fitted to a slice, or 0 if there are too few points
+static float circumferenceOf(const std::vector<cv::Point2f>& points2d) {
     if (points2d.size() < 5) {
         return 0.0f; // Not enough points
     }
     
-    // Fit ellipse
     cv::RotatedRect ellipse = cv::fitEllipse(points2d);
     float a = ellipse.size.width / 2.0f;
     float b = ellipse.size.height / 2.0f;
-    
-    return calculateEllipseCircumference(a, b);
+    float circumference = calculateEllipseCircumference(a, b);
+    return circumference > 0.0f ? circumference : 0.0f;
 }
 
-std::vector<float> computeCircumferences(const std::vector<cv::Point3f>& kpts3d) {
-    std::vector<float> measurements;
-    
-    if (kpts3d.empty() || kpts3d.size() < 10) {
-        // Return zeros if insufficient data
-        return std::vector<float>(7, 0.0f); // 7 measurements
+/**
+ * One XZ-projected point bucket per circumference, in output order. The
+ * buckets keep their capacity between scans, so only the first scan allocates.
+ */
+struct CircumferenceBins {
+    std::vector<cv::Point2f> points[kCircumferenceCount];
+};
+
+/**
+ * Measure one scan: a bounds sweep, then a single binning sweep that drops
+ * every keypoint into each slice it falls in, then one ellipse fit per slice.
+ * 
+ * @param out kCircumferenceCount values, zeros if the scan is unusable
+ */
+static void measureCircumferences(const cv::Point3f* kpts3d, size_t count,
+                                  const CircumferenceRegions& regions,
+                                  CircumferenceBins& bins, float* out) {
+    std::fill(out, out + kCircumferenceCount, 0.0f);
+    if (kpts3d == nullptr || count < 10) {
+        return; // Insufficient data
     }
     
     // Find bounding box to determine body regions
     float minY = std::numeric_limits<float>::max();
     float maxY = std::numeric_limits<float>::lowest();
-    
-    for (const auto& pt : kpts3d) {
-        minY = std::min(minY, pt.y);
-        maxY = std::max(maxY, pt.y);
+    for (size_t i = 0; i < count; ++i) {
+        minY = std::min(minY, kpts3d[i].y);
+        maxY = std::max(maxY, kpts3d[i].y);
     }
     
     float height = maxY - minY;
     if (height <= 0.0f) {
-        return std::vector<float>(7, 0.0f);
-    }
-    
-    // Define body regions as fractions of height (from top to bottom)
-    // These are approximate positions based on typical human proportions
-    float headBottomY = minY + height * 0.10f;      // 10% from top
-    float chestY = minY + height * 0.25f;             // 25% from top (chest level)
-    float waistY = minY + height * 0.50f;             // 50% from top (waist level)
-    float hipY = minY + height * 0.60f;               // 60% from top (hip level)
-    float thighY = minY + height * 0.70f;            // 70% from top (thigh level)
-    float armY = minY + height * 0.30f;                // 30% from top (arm level)
-    
-    float tolerance = height * 0.05f; // 5% of height tolerance
-    
-    // 1. Waist circumference
-    float waist = fitEllipseAtY(kpts3d, waistY, tolerance);
-    measurements.push_back(waist > 0.0f ? waist : 0.0f);
-    
-    // 2. Chest circumference
-    float chest = fitEllipseAtY(kpts3d, chestY, tolerance);
-    measurements.push_back(chest > 0.0f ? chest : 0.0f);
-    
-    // 3. Hip circumference
-    float hips = fitEllipseAtY(kpts3d, hipY, tolerance);
-    measurements.push_back(hips > 0.0f ? hips : 0.0f);
-    
-    // 4. Left thigh circumference
-    // For thighs, we need to find points on the left side
-    std::vector<cv::Point2f> leftThighPoints;
-    float leftThighCenterX = 0.0f;
-    int leftCount = 0;
-    for (const auto& pt : kpts3d) {
-        if (std::abs(pt.y - thighY) < tolerance && pt.x < 0.0f) { // Left side
-            leftThighPoints.push_back(cv::Point2f(pt.x, pt.z));
-            leftThighCenterX += pt.x;
-            leftCount++;
-        }
-    }
-    float leftThigh = 0.0f;
-    if (leftThighPoints.size() >= 5) {
-        cv::RotatedRect ellipse = cv::fitEllipse(leftThighPoints);
-        float a = ellipse.size.width / 2.0f;
-        float b = ellipse.size.height / 2.0f;
-        leftThigh = calculateEllipseCircumference(a, b);
+        return;
     }
-    measurements.push_back(leftThigh);
     
-    // 5. Right thigh circumference
-    std::vector<cv::Point2f> rightThighPoints;
-    for (const auto& pt : kpts3d) {
-        if (std::abs(pt.y - thighY) < tolerance && pt.x > 0.0f) { // Right side
-            rightThighPoints.push_back(cv::Point2f(pt.x, pt.z));
-        }
-    }
-    float rightThigh = 0.0f;
-    if (rightThighPoints.size() >= 5) {
-        cv::RotatedRect ellipse = cv::fitEllipse(rightThighPoints);
-        float a = ellipse.size.width / 2.0f;
-        float b = ellipse.size.height / 2.0f;
-        rightThigh = calculateEllipseCircumference(a, b);
+    // Slice levels measured from the top, in output order:
+    // waist, chest, hips, left/right thigh, left/right arm
+    const float sliceY[kCircumferenceCount] = {
+        minY + height * regions.waist,
+        minY + height * regions.chest,
+        minY + height * regions.hip,
+        minY + height * regions.thigh,
+        minY + height * regions.thigh,
+        minY + height * regions.arm,
+        minY + height * regions.arm,
+    };
+    // Side of the body each slice keeps: 0 = all, -1 = left (x < 0), 1 = right (x > 0)
+    static const int sliceSide[kCircumferenceCount] = {0, 0, 0, -1, 1, -1, 1};
+    const float tolerance = height * regions.tolerance;
+    
+    for (auto& bin : bins.points) {
+        bin.clear();
+        bin.reserve(count);
     }
-    measurements.push_back(rightThigh);
     
-    // 6. Left arm circumference
-    std::vector<cv::Point2f> leftArmPoints;
-    for (const auto& pt : kpts3d) {
-        if (std::abs(pt.y - armY) < tolerance && pt.x < 0.0f) { // Left side
-            leftArmPoints.push_back(cv::Point2f(pt.x, pt.z));
+    for (size_t i = 0; i < count; ++i) {
+        const cv::Point3f& pt = kpts3d[i];
+        const int side = pt.x < 0.0f ? -1 : (pt.x > 0.0f ? 1 : 0);
+        for (int slice = 0; slice < kCircumferenceCount; ++slice) {
+            if (std::abs(pt.y - sliceY[slice]) < tolerance &&
+                (sliceSide[slice] == 0 || sliceSide[slice] == side)) {
+                // Project to XZ plane (width and depth)
+                bins.points[slice].push_back(cv::Point2f(pt.x, pt.z));
+            }
         }
     }
-    float leftArm = 0.0f;
-    if (leftArmPoints.size() >= 5) {
-        cv::RotatedRect ellipse = cv::fitEllipse(leftArmPoints);
-        float a = ellipse.size.width / 2.0f;
-        float b = ellipse.size.height / 2.0f;
-        leftArm = calculateEllipseCircumference(a, b);
-    }
-    measurements.push_back(leftArm);
     
-    // 7. Right arm circumference
-    std::vector<cv::Point2f> rightArmPoints;
-    for (const auto& pt : kpts3d) {
-        if (std::abs(pt.y - armY) < tolerance && pt.x > 0.0f) { // Right side
-            rightArmPoints.push_back(cv::Point2f(pt.x, pt.z));
-        }
+    for (int slice = 0; slice < kCircumferenceCount; ++slice) {
+        out[slice] = circumferenceOf(bins.points[slice]);
     }
-    float rightArm = 0.0f;
-    if (rightArmPoints.size() >= 5) {
-        cv::RotatedRect ellipse = cv::fitEllipse(rightArmPoints);
-        float a = ellipse.size.width / 2.0f;
-        float b = ellipse.size.height / 2.0f;
-        rightArm = calculateEllipseCircumference(a, b);
+}
+
+std::vector<float> computeCircumferences(const std::vector<cv::Point3f>& kpts3d,
+                                         const CircumferenceRegions& regions) {
+    ScopedTimer timer(ScanStage::Measurement);
+    static thread_local CircumferenceBins bins;
+    std::vector<float> measurements(kCircumferenceCount, 0.0f);
+    measureCircumferences(kpts3d.data(), kpts3d.size(), regions, bins, measurements.data());
+    return measurements;
+}
+
+void computeCircumferences(const cv::Point3f* kpts3d, size_t keypointsPerScan, size_t scanCount,
+                           const CircumferenceRegions& regions, float* out) {
+    if (kpts3d == nullptr || out == nullptr) {
+        return;
     }
-    measurements.push_back(rightArm);
     
-    // Ensure we return exactly 7 measurements
-    while (measurements.size() < 7) {
-        measurements.push_back(0.0f);
+    ScopedTimer timer(ScanStage::Measurement);
+    CircumferenceBins bins;
+    for (size_t scan = 0; scan < scanCount; ++scan) {
+        measureCircumferences(kpts3d + scan * keypointsPerScan, keypointsPerScan, regions,
+                              bins, out + scan * kCircumferenceCount);
     }
-    
-    return measurements;
 }
 
 // Helper function to calculate distance between two 3D points
@@ -181,14 +149,36 @@ bool isValidKeypoint(const cv::Point3f& pt) {
              (pt.x == 0.0f && pt.y == 0.0f && pt.z == 0.0f));
 }
 
-// Helper function to generate ellipsoid vertices with normals
-void generateEllipsoid(const cv::Point3f& center, float radiusX, float radiusY, float radiusZ,
-                      int segments, std::vector<float>& vertices, std::vector<float>& normals,
-                      std::vector<uint32_t>& indices, uint32_t& indexOffset) {
+/**
+ * One vertex as it is laid out in the GLB vertex bufferView: position and
+ * normal interleaved, so the Float32 output is a straight copy (byteStride 24).
+ */
+struct MeshVertex {
+    float position[3];
+    float normal[3];
+};
+
+/**
+ * Unit primitive geometry, built once per segment count. Every instance in a
+ * mesh is a transform of one of these, so no trigonometry runs per mesh.
+ */
+struct UnitPrimitive {
+    std::vector<MeshVertex> vertices;
+    std::vector<uint32_t> indices;  // Relative to the primitive's first vertex
+    
+    size_t vertexCount() const { return vertices.size(); }
+};
+
+// Unit sphere: (sin(theta)cos(phi), cos(theta), sin(theta)sin(phi)) over
+// segments/2 rings and segments sectors; the normal equals the position
+static UnitPrimitive buildUnitSphere(int segments) {
     const int rings = segments / 2;
     const int sectors = segments;
     
-    // Generate vertices and normals
+    UnitPrimitive unit;
+    unit.vertices.reserve((rings + 1) * (sectors + 1));
+    unit.indices.reserve(rings * sectors * 6);
+    
     for (int i = 0; i <= rings; ++i) {
         float theta = M_PI * i / rings; // 0 to PI
         float sinTheta = std::sin(theta);
@@ -196,205 +186,490 @@ void generateEllipsoid(const cv::Point3f& center, float radiusX, float radiusY,
         
         for (int j = 0; j <= sectors; ++j) {
             float phi = 2.0f * M_PI * j / sectors; // 0 to 2*PI
-            float sinPhi = std::sin(phi);
-            float cosPhi = std::cos(phi);
-            
-            // Vertex position
-            float x = center.x + radiusX * sinTheta * cosPhi;
-            float y = center.y + radiusY * cosTheta;
-            float z = center.z + radiusZ * sinTheta * sinPhi;
-            
-            vertices.push_back(x);
-            vertices.push_back(y);
-            vertices.push_back(z);
+            MeshVertex vertex;
+            vertex.position[0] = sinTheta * std::cos(phi);
+            vertex.position[1] = cosTheta;
+            vertex.position[2] = sinTheta * std::sin(phi);
             
-            // Normal (normalized direction from center to vertex)
-            float nx = sinTheta * cosPhi;
-            float ny = cosTheta;
-            float nz = sinTheta * sinPhi;
-            float norm = std::sqrt(nx * nx + ny * ny + nz * nz);
-            if (norm > 0.0001f) {
-                nx /= norm;
-                ny /= norm;
-                nz /= norm;
+            const float* p = vertex.position;
+            float norm = std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+            float inv = norm > 0.0001f ? 1.0f / norm : 1.0f;
+            for (int axis = 0; axis < 3; ++axis) {
+                vertex.normal[axis] = p[axis] * inv;
             }
-            
-            normals.push_back(nx);
-            normals.push_back(ny);
-            normals.push_back(nz);
+            unit.vertices.push_back(vertex);
         }
     }
     
-    // Generate indices
     for (int i = 0; i < rings; ++i) {
         for (int j = 0; j < sectors; ++j) {
-            uint32_t first = indexOffset + i * (sectors + 1) + j;
-            uint32_t second = indexOffset + (i + 1) * (sectors + 1) + j;
-            
-            indices.push_back(first);
-            indices.push_back(second);
-            indices.push_back(first + 1);
+            uint32_t first = i * (sectors + 1) + j;
+            uint32_t second = (i + 1) * (sectors + 1) + j;
             
-            indices.push_back(first + 1);
-            indices.push_back(second);
-            indices.push_back(second + 1);
+            unit.indices.insert(unit.indices.end(), {first, second, first + 1,
+                                                     first + 1, second, second + 1});
+        }
+    }
+    
+    return unit;
+}
+
+// Unit cylinder: positions hold (cos(a), sin(a), ring) for the start (ring 0)
+// and end (ring 1) circles; normals hold the radial direction (cos(a), sin(a), 0)
+static UnitPrimitive buildUnitCylinder(int segments) {
+    UnitPrimitive unit;
+    unit.vertices.reserve((segments + 1) * 2);
+    unit.indices.reserve(segments * 6);
+    
+    for (int ring = 0; ring <= 1; ++ring) {
+        for (int i = 0; i <= segments; ++i) {
+            float angle = 2.0f * M_PI * i / segments;
+            MeshVertex vertex;
+            vertex.position[0] = vertex.normal[0] = std::cos(angle);
+            vertex.position[1] = vertex.normal[1] = std::sin(angle);
+            vertex.position[2] = static_cast<float>(ring);
+            vertex.normal[2] = 0.0f;
+            unit.vertices.push_back(vertex);
         }
     }
     
-    indexOffset += (rings + 1) * (sectors + 1);
+    for (int i = 0; i < segments; ++i) {
+        uint32_t base0 = i;
+        uint32_t base1 = segments + 1 + i;
+        
+        unit.indices.insert(unit.indices.end(), {base0, base1, base0 + 1,
+                                                 base0 + 1, base1, base1 + 1});
+    }
+    
+    return unit;
+}
+
+// Templates keyed by segment count; entries are never removed, so the
+// returned references stay valid
+static const UnitPrimitive& cachedUnitPrimitive(bool cylinder, int segments) {
+    static std::mutex cacheMutex;
+    static std::map<std::pair<bool, int>, std::unique_ptr<UnitPrimitive>> cache;
+    
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    std::unique_ptr<UnitPrimitive>& entry = cache[std::make_pair(cylinder, segments)];
+    if (!entry) {
+        entry.reset(new UnitPrimitive(cylinder ? buildUnitCylinder(segments)
+                                               : buildUnitSphere(segments)));
+    }
+    return *entry;
+}
+
+/**
+ * One ellipsoid or cylinder of the body mesh, recorded first so the
+ * output buffers can be sized exactly before any vertex is written.
+ */
+struct PrimitiveInstance {
+    bool cylinder;
+    cv::Point3f origin;   // Ellipsoid center / cylinder start
+    cv::Point3f axis;     // Ellipsoid radii / cylinder start-to-end vector
+    cv::Point3f perp1;    // Cylinder cross-section basis (radius included)
+    cv::Point3f perp2;
+};
+
+/**
+ * Mesh geometry filled from a PrimitiveInstance list. Positions are kept as
+ * emitted; the centering/scaling transform is applied when they are written
+ * to the GLB, so the vertices are only ever touched twice.
+ */
+struct MeshBuffers {
+    std::vector<MeshVertex> vertices;
+    std::vector<uint32_t> indices;
+    
+    // Bounds of the emitted positions, gathered while they are written
+    float boundsMin[3];
+    float boundsMax[3];
+    
+    // Output transform: (position - center) * scale
+    float center[3];
+    float scale;
+    
+    float transformed(int axis, float value) const {
+        return (value - center[axis]) * scale;
+    }
+};
+
+static const UnitPrimitive& unitFor(const PrimitiveInstance& instance, int segments) {
+    return cachedUnitPrimitive(instance.cylinder, segments);
+}
+
+// Helper function to record an ellipsoid
+static void addEllipsoid(std::vector<PrimitiveInstance>& primitives, const cv::Point3f& center,
+                         float radiusX, float radiusY, float radiusZ) {
+    PrimitiveInstance instance = {};
+    instance.cylinder = false;
+    instance.origin = center;
+    instance.axis = cv::Point3f(radiusX, radiusY, radiusZ);
+    primitives.push_back(instance);
+}
+
+/**
+ * Write all primitives into exactly-sized buffers: each vertex is the unit
+ * template transformed by its instance, each index the template index plus
+ * the instance's first vertex. The bounds are accumulated in the same pass
+ * and the output transform is reset to identity.
+ */
+static void emitPrimitives(const std::vector<PrimitiveInstance>& primitives, int segments,
+                           MeshBuffers& mesh) {
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+    for (const auto& instance : primitives) {
+        const UnitPrimitive& unit = unitFor(instance, segments);
+        vertexCount += unit.vertexCount();
+        indexCount += unit.indices.size();
+    }
+    
+    mesh.vertices.resize(vertexCount);
+    mesh.indices.resize(indexCount);
+    for (int axis = 0; axis < 3; ++axis) {
+        mesh.boundsMin[axis] = std::numeric_limits<float>::max();
+        mesh.boundsMax[axis] = std::numeric_limits<float>::lowest();
+        mesh.center[axis] = 0.0f;
+    }
+    mesh.scale = 1.0f;
+    
+    MeshVertex* vertex = mesh.vertices.data();
+    uint32_t* index = mesh.indices.data();
+    uint32_t indexOffset = 0;
+    
+    for (const auto& instance : primitives) {
+        const UnitPrimitive& unit = unitFor(instance, segments);
+        const size_t count = unit.vertexCount();
+        const MeshVertex* t = unit.vertices.data();
+        const cv::Point3f& o = instance.origin;
+        const cv::Point3f& a = instance.axis;
+        
+        if (!instance.cylinder) {
+            // Ellipsoid: scale the unit sphere by the radii; normals as-is
+            for (size_t v = 0; v < count; ++v, ++t, ++vertex) {
+                vertex->position[0] = o.x + a.x * t->position[0];
+                vertex->position[1] = o.y + a.y * t->position[1];
+                vertex->position[2] = o.z + a.z * t->position[2];
+                std::memcpy(vertex->normal, t->normal, sizeof(vertex->normal));
+            }
+        } else {
+            // Cylinder: ring point = origin + ring * axis + cos * perp1 + sin * perp2
+            const cv::Point3f& u = instance.perp1;
+            const cv::Point3f& w = instance.perp2;
+            const float radius = static_cast<float>(cv::norm(u));
+            const float inv = radius > 0.0f ? 1.0f / radius : 0.0f;
+            for (size_t v = 0; v < count; ++v, ++t, ++vertex) {
+                const float* p = t->position;
+                const float* n = t->normal;
+                cv::Point3f offset = u * p[0] + w * p[1];
+                vertex->position[0] = o.x + a.x * p[2] + offset.x;
+                vertex->position[1] = o.y + a.y * p[2] + offset.y;
+                vertex->position[2] = o.z + a.z * p[2] + offset.z;
+                
+                // Normal points outward from cylinder axis
+                vertex->normal[0] = (u.x * n[0] + w.x * n[1]) * inv;
+                vertex->normal[1] = (u.y * n[0] + w.y * n[1]) * inv;
+                vertex->normal[2] = (u.z * n[0] + w.z * n[1]) * inv;
+            }
+        }
+        
+        // Bounds of the vertices just written, while they are still in cache
+        for (const MeshVertex* written = vertex - count; written != vertex; ++written) {
+            for (int axis = 0; axis < 3; ++axis) {
+                mesh.boundsMin[axis] = std::min(mesh.boundsMin[axis], written->position[axis]);
+                mesh.boundsMax[axis] = std::max(mesh.boundsMax[axis], written->position[axis]);
+            }
+        }
+        
+        for (uint32_t i : unit.indices) {
+            *index++ = indexOffset + i;
+        }
+        indexOffset += static_cast<uint32_t>(count);
+    }
 }
 
 // Helper function to write uint32_t in little-endian
-void writeUint32LE(std::vector<uint8_t>& data, uint32_t value) {
-    data.push_back(static_cast<uint8_t>(value & 0xFF));
-    data.push_back(static_cast<uint8_t>((value >> 8) & 0xFF));
-    data.push_back(static_cast<uint8_t>((value >> 16) & 0xFF));
-    data.push_back(static_cast<uint8_t>((value >> 24) & 0xFF));
+static uint8_t* putUint32LE(uint8_t* out, uint32_t value) {
+    out[0] = static_cast<uint8_t>(value & 0xFF);
+    out[1] = static_cast<uint8_t>((value >> 8) & 0xFF);
+    out[2] = static_cast<uint8_t>((value >> 16) & 0xFF);
+    out[3] = static_cast<uint8_t>((value >> 24) & 0xFF);
+    return out + 4;
+}
+
+static size_t padTo4(size_t size) {
+    return (size + 3) & ~static_cast<size_t>(3);
+}
+
+// Large enough for the glTF JSON below with any vertex count and bounds
+static const size_t kMaxGltfJsonSize = 3072;
+
+// Quantized position range (KHR_mesh_quantization SHORT) and normal range (BYTE normalized)
+static const float kPositionQuantMax = 32767.0f;
+static const float kNormalQuantMax = 127.0f;
+
+/**
+ * Where everything goes in the BIN chunk and how it is described in JSON.
+ * Computed before anything is written, so the output size is exact.
+ * 
+ * Vertices occupy one interleaved bufferView (position, then normal, per
+ * vertex) followed by the index bufferView.
+ */
+struct GlbLayout {
+    MeshFormat format;
+    size_t vertexCount;
+    size_t indexCount;
+    size_t vertexStride;       // byteStride of the vertex view
+    size_t normalOffset;       // NORMAL byteOffset within a vertex
+    size_t indexSize;          // 2 (uint16) or 4 (uint32)
+    size_t indexOffset;        // Start of the index view (after the vertices)
+    size_t binaryLength;       // Unpadded
+    
+    // Compact format: stored = (position - translation) / scale
+    float translation[3];
+    float scale;
+    int quantMin[3];
+    int quantMax[3];
+};
+
+static int quantizePosition(float value, float translation, float scale) {
+    float q = std::round((value - translation) / scale);
+    return static_cast<int>(std::max(-kPositionQuantMax, std::min(kPositionQuantMax, q)));
 }
 
-// Helper function to write float in little-endian
-void writeFloatLE(std::vector<uint8_t>& data, float value) {
-    uint32_t bits;
-    std::memcpy(&bits, &value, sizeof(float));
-    writeUint32LE(data, bits);
+static int quantizeNormal(float value) {
+    float q = std::round(value * kNormalQuantMax);
+    return static_cast<int>(std::max(-kNormalQuantMax, std::min(kNormalQuantMax, q)));
 }
 
-// Helper function to create GLB manually (without tinygltf dependency)
-std::vector<uint8_t> createGLBManually(
-    const std::vector<float>& vertices,
-    const std::vector<float>& normals,
-    const std::vector<uint32_t>& indices) {
+/**
+ * @param boundsMin Bounds of the transformed positions (see MeshBuffers::transformed)
+ * @param boundsMax
+ */
+static GlbLayout computeGlbLayout(const MeshBuffers& mesh, const float boundsMin[3],
+                                  const float boundsMax[3], MeshFormat format) {
+    GlbLayout layout = {};
+    layout.format = format;
+    layout.vertexCount = mesh.vertices.size();
+    layout.indexCount = mesh.indices.size();
+    
+    if (format == MeshFormat::Compact) {
+        // Attributes within a stride must stay 4-byte aligned: int16 xyz is
+        // padded to 8 bytes, int8 xyz to 4. The largest uint16 value is
+        // reserved, so uint16 indices need fewer than 65535 vertices.
+        layout.vertexStride = 12;
+        layout.normalOffset = 8;
+        layout.indexSize = layout.vertexCount < 65535 ? 2 : 4;
+        
+        // A uniform scale keeps normals valid under the node transform
+        float halfExtent = 0.0f;
+        for (int axis = 0; axis < 3; ++axis) {
+            layout.translation[axis] = (boundsMin[axis] + boundsMax[axis]) * 0.5f;
+            halfExtent = std::max(halfExtent, (boundsMax[axis] - boundsMin[axis]) * 0.5f);
+        }
+        layout.scale = halfExtent > 0.0f ? halfExtent / kPositionQuantMax : 1.0f;
+        
+        // Quantization is monotonic, so the quantized bounds are exact
+        for (int axis = 0; axis < 3; ++axis) {
+            layout.quantMin[axis] = quantizePosition(boundsMin[axis], layout.translation[axis], layout.scale);
+            layout.quantMax[axis] = quantizePosition(boundsMax[axis], layout.translation[axis], layout.scale);
+        }
+    } else {
+        layout.vertexStride = sizeof(MeshVertex);
+        layout.normalOffset = offsetof(MeshVertex, normal);
+        layout.indexSize = sizeof(uint32_t);
+        layout.scale = 1.0f;
+    }
     
-    if (vertices.empty() || indices.empty()) {
-        return std::vector<uint8_t>();
+    // Both strides are multiples of 4, so the index view needs no padding
+    layout.indexOffset = layout.vertexCount * layout.vertexStride;
+    layout.binaryLength = layout.indexOffset + layout.indexCount * layout.indexSize;
+    return layout;
+}
+
+/**
+ * Format the glTF JSON chunk into a caller (stack) buffer.
+ * 
+ * @return JSON length in bytes (unpadded), or 0 if it did not fit
+ */
+static size_t formatGltfJson(char* json, size_t capacity, const GlbLayout& layout,
+                             const float boundsMin[3], const float boundsMax[3]) {
+    const bool compact = layout.format == MeshFormat::Compact;
+    
+    // Format-dependent fragments
+    char nodeTransform[160] = "";
+    char positionBounds[192];
+    if (compact) {
+        std::snprintf(nodeTransform, sizeof(nodeTransform),
+                      ", \"translation\": [%.6f,%.6f,%.6f], \"scale\": [%.9g,%.9g,%.9g]",
+                      layout.translation[0], layout.translation[1], layout.translation[2],
+                      layout.scale, layout.scale, layout.scale);
+        std::snprintf(positionBounds, sizeof(positionBounds), "\"min\": [%d,%d,%d], \"max\": [%d,%d,%d]",
+                      layout.quantMin[0], layout.quantMin[1], layout.quantMin[2],
+                      layout.quantMax[0], layout.quantMax[1], layout.quantMax[2]);
+    } else {
+        std::snprintf(positionBounds, sizeof(positionBounds), "\"min\": [%.6f,%.6f,%.6f], \"max\": [%.6f,%.6f,%.6f]",
+                      boundsMin[0], boundsMin[1], boundsMin[2], boundsMax[0], boundsMax[1], boundsMax[2]);
     }
     
-    size_t vertexCount = vertices.size() / 3;
-    size_t normalCount = normals.size() / 3;
-    size_t indexCount = indices.size();
-    
-    // Calculate bounding box
-    float minX = vertices[0], maxX = vertices[0];
-    float minY = vertices[1], maxY = vertices[1];
-    float minZ = vertices[2], maxZ = vertices[2];
-    
-    for (size_t i = 0; i < vertices.size(); i += 3) {
-        minX = std::min(minX, vertices[i]);
-        maxX = std::max(maxX, vertices[i]);
-        minY = std::min(minY, vertices[i + 1]);
-        maxY = std::max(maxY, vertices[i + 1]);
-        minZ = std::min(minZ, vertices[i + 2]);
-        maxZ = std::max(maxZ, vertices[i + 2]);
-    }
-    
-    // Build binary buffer: vertices + normals + indices
-    std::vector<uint8_t> binaryBuffer;
-    binaryBuffer.resize(vertices.size() * sizeof(float) + 
-                       normals.size() * sizeof(float) + 
-                       indices.size() * sizeof(uint32_t));
-    
-    size_t offset = 0;
-    std::memcpy(binaryBuffer.data() + offset, vertices.data(), vertices.size() * sizeof(float));
-    offset += vertices.size() * sizeof(float);
-    std::memcpy(binaryBuffer.data() + offset, normals.data(), normals.size() * sizeof(float));
-    offset += normals.size() * sizeof(float);
-    std::memcpy(binaryBuffer.data() + offset, indices.data(), indices.size() * sizeof(uint32_t));
-    
-    // Build JSON string manually
-    std::ostringstream jsonStream;
-    jsonStream << std::fixed << std::setprecision(6);
-    jsonStream << "{\n";
-    jsonStream << "  \"asset\": {\"version\": \"2.0\"},\n";
-    jsonStream << "  \"scene\": 0,\n";
-    jsonStream << "  \"scenes\": [{\"nodes\": [0]}],\n";
-    jsonStream << "  \"nodes\": [{\"mesh\": 0, \"name\": \"BodyMesh\"}],\n";
-    jsonStream << "  \"meshes\": [{\n";
-    jsonStream << "    \"primitives\": [{\n";
-    jsonStream << "      \"attributes\": {\"POSITION\": 0, \"NORMAL\": 1},\n";
-    jsonStream << "      \"indices\": 2,\n";
-    jsonStream << "      \"material\": 0\n";
-    jsonStream << "    }]\n";
-    jsonStream << "  }],\n";
-    jsonStream << "  \"materials\": [{\n";
-    jsonStream << "    \"pbrMetallicRoughness\": {\n";
-    jsonStream << "      \"baseColorFactor\": [0.8, 0.8, 0.8, 1.0],\n";
-    jsonStream << "      \"metallicFactor\": 0.0,\n";
-    jsonStream << "      \"roughnessFactor\": 0.5\n";
-    jsonStream << "    },\n";
-    jsonStream << "    \"doubleSided\": true\n";
-    jsonStream << "  }],\n";
-    jsonStream << "  \"buffers\": [{\"byteLength\": " << binaryBuffer.size() << "}],\n";
-    jsonStream << "  \"bufferViews\": [\n";
-    jsonStream << "    {\"buffer\": 0, \"byteOffset\": 0, \"byteLength\": " 
-               << (vertices.size() * sizeof(float)) << ", \"target\": 34962},\n";
-    jsonStream << "    {\"buffer\": 0, \"byteOffset\": " << (vertices.size() * sizeof(float))
-               << ", \"byteLength\": " << (normals.size() * sizeof(float)) << ", \"target\": 34962},\n";
-    jsonStream << "    {\"buffer\": 0, \"byteOffset\": " 
-               << (vertices.size() * sizeof(float) + normals.size() * sizeof(float))
-               << ", \"byteLength\": " << (indices.size() * sizeof(uint32_t)) << ", \"target\": 34963}\n";
-    jsonStream << "  ],\n";
-    jsonStream << "  \"accessors\": [\n";
-    jsonStream << "    {\"bufferView\": 0, \"byteOffset\": 0, \"componentType\": 5126, \"count\": " 
-               << vertexCount << ", \"type\": \"VEC3\", \"min\": [" 
-               << minX << "," << minY << "," << minZ << "], \"max\": [" 
-               << maxX << "," << maxY << "," << maxZ << "]},\n";
-    jsonStream << "    {\"bufferView\": 1, \"byteOffset\": 0, \"componentType\": 5126, \"count\": " 
-               << normalCount << ", \"type\": \"VEC3\"},\n";
-    jsonStream << "    {\"bufferView\": 2, \"byteOffset\": 0, \"componentType\": 5125, \"count\": " 
-               << indexCount << ", \"type\": \"SCALAR\"}\n";
-    jsonStream << "  ]\n";
-    jsonStream << "}\n";
-    
-    std::string jsonString = jsonStream.str();
-    
-    // Pad JSON to 4-byte boundary
-    size_t jsonPadding = (4 - (jsonString.size() % 4)) % 4;
-    jsonString.append(jsonPadding, ' ');
-    
-    // Pad binary to 4-byte boundary
-    size_t binaryPadding = (4 - (binaryBuffer.size() % 4)) % 4;
-    binaryBuffer.insert(binaryBuffer.end(), binaryPadding, 0);
-    
-    // Build GLB
-    std::vector<uint8_t> glb;
-    
-    // GLB Header (12 bytes)
-    // Magic: "glTF"
-    glb.push_back(0x67); glb.push_back(0x6C); glb.push_back(0x54); glb.push_back(0x46);
-    // Version: 2
-    writeUint32LE(glb, 2);
-    // Total length (will be updated later)
-    uint32_t totalLengthPos = glb.size();
-    writeUint32LE(glb, 0); // Placeholder
-    
-    // JSON Chunk (12 bytes header + JSON data)
-    uint32_t jsonChunkLength = 12 + jsonString.size();
-    writeUint32LE(glb, jsonString.size());
-    // Chunk type: JSON (must be "JSON" in ASCII: 0x4A='J', 0x53='S', 0x4F='O', 0x4E='N')
-    glb.push_back(0x4A); glb.push_back(0x53); glb.push_back(0x4F); glb.push_back(0x4E);
-    // JSON data
-    glb.insert(glb.end(), jsonString.begin(), jsonString.end());
-    
-    // BIN Chunk (12 bytes header + binary data)
-    uint32_t binChunkLength = 12 + binaryBuffer.size();
-    writeUint32LE(glb, binaryBuffer.size());
-    // Chunk type: BIN (0x004E4942 = "BIN\0")
-    glb.push_back(0x42); glb.push_back(0x49); glb.push_back(0x4E); glb.push_back(0x00);
-    // Binary data
-    glb.insert(glb.end(), binaryBuffer.begin(), binaryBuffer.end());
-    
-    // Update total length
-    uint32_t totalLength = glb.size();
-    std::memcpy(glb.data() + totalLengthPos, &totalLength, sizeof(uint32_t));
+    // glTF componentType: 5120 BYTE, 5122 SHORT, 5123 UNSIGNED_SHORT,
+    // 5125 UNSIGNED_INT, 5126 FLOAT
+    const int positionType = compact ? 5122 : 5126;
+    const int normalType = compact ? 5120 : 5126;
+    const int indexType = layout.indexSize == 2 ? 5123 : 5125;
+    
+    int written = std::snprintf(json, capacity,
+        "{\n"
+        "  \"asset\": {\"version\": \"2.0\"},\n"
+        "%s"
+        "  \"scene\": 0,\n"
+        "  \"scenes\": [{\"nodes\": [0]}],\n"
+        "  \"nodes\": [{\"mesh\": 0, \"name\": \"BodyMesh\"%s}],\n"
+        "  \"meshes\": [{\n"
+        "    \"primitives\": [{\n"
+        "      \"attributes\": {\"POSITION\": 0, \"NORMAL\": 1},\n"
+        "      \"indices\": 2,\n"
+        "      \"material\": 0\n"
+        "    }]\n"
+        "  }],\n"
+        "  \"materials\": [{\n"
+        "    \"pbrMetallicRoughness\": {\n"
+        "      \"baseColorFactor\": [0.8, 0.8, 0.8, 1.0],\n"
+        "      \"metallicFactor\": 0.0,\n"
+        "      \"roughnessFactor\": 0.5\n"
+        "    },\n"
+        "    \"doubleSided\": true\n"
+        "  }],\n"
+        "  \"buffers\": [{\"byteLength\": %zu}],\n"
+        "  \"bufferViews\": [\n"
+        "    {\"buffer\": 0, \"byteOffset\": 0, \"byteLength\": %zu, \"byteStride\": %zu, \"target\": 34962},\n"
+        "    {\"buffer\": 0, \"byteOffset\": %zu, \"byteLength\": %zu, \"target\": 34963}\n"
+        "  ],\n"
+        "  \"accessors\": [\n"
+        "    {\"bufferView\": 0, \"byteOffset\": 0, \"componentType\": %d, \"count\": %zu, "
+        "\"type\": \"VEC3\", %s},\n"
+        "    {\"bufferView\": 0, \"byteOffset\": %zu, \"componentType\": %d%s, \"count\": %zu, "
+        "\"type\": \"VEC3\"},\n"
+        "    {\"bufferView\": 1, \"byteOffset\": 0, \"componentType\": %d, \"count\": %zu, "
+        "\"type\": \"SCALAR\"}\n"
+        "  ]\n"
+        "}\n",
+        compact ? "  \"extensionsUsed\": [\"KHR_mesh_quantization\"],\n"
+                  "  \"extensionsRequired\": [\"KHR_mesh_quantization\"],\n" : "",
+        nodeTransform,
+        layout.binaryLength,
+        layout.indexOffset, layout.vertexStride,
+        layout.indexOffset, layout.binaryLength - layout.indexOffset,
+        positionType, layout.vertexCount, positionBounds,
+        layout.normalOffset, normalType, compact ? ", \"normalized\": true" : "", layout.vertexCount,
+        indexType, layout.indexCount);
+    
+    if (written <= 0 || static_cast<size_t>(written) >= capacity) {
+        return 0;
+    }
+    return static_cast<size_t>(written);
+}
+
+// Write the geometry into the BIN chunk in the layout's format, applying the
+// mesh's output transform on the way
+static void writeGeometry(const MeshBuffers& mesh, const GlbLayout& layout, uint8_t* bin) {
+    uint8_t* out = bin;
+    if (layout.format != MeshFormat::Compact) {
+        for (const MeshVertex& v : mesh.vertices) {
+            MeshVertex transformed;
+            for (int axis = 0; axis < 3; ++axis) {
+                transformed.position[axis] = mesh.transformed(axis, v.position[axis]);
+                transformed.normal[axis] = v.normal[axis];
+            }
+            std::memcpy(out, &transformed, sizeof(transformed));
+            out += sizeof(transformed);
+        }
+        std::memcpy(bin + layout.indexOffset, mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+        return;
+    }
     
-    return glb;
+    // Quantize straight into the chunk; the 4th component of each is padding
+    for (const MeshVertex& v : mesh.vertices) {
+        int16_t* position = reinterpret_cast<int16_t*>(out);
+        int8_t* normal = reinterpret_cast<int8_t*>(out + layout.normalOffset);
+        for (int axis = 0; axis < 3; ++axis) {
+            position[axis] = static_cast<int16_t>(quantizePosition(
+                mesh.transformed(axis, v.position[axis]), layout.translation[axis], layout.scale));
+            normal[axis] = static_cast<int8_t>(quantizeNormal(v.normal[axis]));
+        }
+        position[3] = 0;
+        normal[3] = 0;
+        out += layout.vertexStride;
+    }
+    
+    if (layout.indexSize == 2) {
+        uint16_t* index = reinterpret_cast<uint16_t*>(bin + layout.indexOffset);
+        for (uint32_t i : mesh.indices) {
+            *index++ = static_cast<uint16_t>(i);
+        }
+    } else {
+        std::memcpy(bin + layout.indexOffset, mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+    }
+}
+
+/**
+ * Write a GLB (without tinygltf dependency) in a single pass.
+ * The exact size is known up front, so nothing is copied twice and nothing
+ * grows: header, JSON chunk, then the geometry straight into the BIN chunk.
+ * 
+ * @param format Float32 attributes, or compact quantized attributes
+ * @param out Destination, or null to only compute the size
+ * @param capacity Size of out in bytes
+ * @return GLB size in bytes; nothing is written if capacity is too small.
+ *         0 if the mesh is empty.
+ */
+static size_t writeGLB(const MeshBuffers& mesh, const float boundsMin[3], const float boundsMax[3],
+                       MeshFormat format, uint8_t* out, size_t capacity) {
+    if (mesh.vertices.empty() || mesh.indices.empty()) {
+        return 0;
+    }
+    
+    const GlbLayout layout = computeGlbLayout(mesh, boundsMin, boundsMax, format);
+    
+    char json[kMaxGltfJsonSize];
+    const size_t jsonLength = formatGltfJson(json, sizeof(json), layout, boundsMin, boundsMax);
+    if (jsonLength == 0) {
+        return 0;
+    }
+    
+    // Chunks are padded to 4 bytes: JSON with spaces, BIN with zeros
+    const size_t jsonChunkLength = padTo4(jsonLength);
+    const size_t binChunkLength = padTo4(layout.binaryLength);
+    const size_t totalLength = 12 + 8 + jsonChunkLength + 8 + binChunkLength;
+    
+    if (out == nullptr || capacity < totalLength) {
+        return totalLength;
+    }
+    
+    // GLB Header (12 bytes): magic "glTF", version 2, total length
+    uint8_t* p = out;
+    *p++ = 0x67; *p++ = 0x6C; *p++ = 0x54; *p++ = 0x46;
+    p = putUint32LE(p, 2);
+    p = putUint32LE(p, static_cast<uint32_t>(totalLength));
+    
+    // JSON Chunk (chunk type "JSON")
+    p = putUint32LE(p, static_cast<uint32_t>(jsonChunkLength));
+    *p++ = 0x4A; *p++ = 0x53; *p++ = 0x4F; *p++ = 0x4E;
+    std::memcpy(p, json, jsonLength);
+    std::memset(p + jsonLength, ' ', jsonChunkLength - jsonLength);
+    p += jsonChunkLength;
+    
+    // BIN Chunk (chunk type "BIN\0")
+    p = putUint32LE(p, static_cast<uint32_t>(binChunkLength));
+    *p++ = 0x42; *p++ = 0x49; *p++ = 0x4E; *p++ = 0x00;
+    writeGeometry(mesh, layout, p);
+    std::memset(p + layout.binaryLength, 0, binChunkLength - layout.binaryLength);
+    
+    return totalLength;
 }
 
-// Helper function to generate a cylinder between two points
-void generateCylinderBetweenPoints(const cv::Point3f& start, const cv::Point3f& end,
-                                   float radius, int segments,
-                                   std::vector<float>& vertices, std::vector<float>& normals,
-                                   std::vector<uint32_t>& indices, uint32_t& indexOffset) {
+// Helper function to record a cylinder between two points
+static void addCylinder(std::vector<PrimitiveInstance>& primitives, const cv::Point3f& start,
+                        const cv::Point3f& end, float radius) {
     if (radius <= 0.0f) return;
     
     cv::Point3f direction = end - start;
@@ -439,58 +714,32 @@ void generateCylinderBetweenPoints(const cv::Point3f& start, const cv::Point3f&
         perp2.z /= perp2Len;
     }
     
-    // Generate cylinder vertices at start and end
-    for (int ring = 0; ring <= 1; ++ring) {
-        cv::Point3f base = (ring == 0) ? start : end;
-        
-        for (int i = 0; i <= segments; ++i) {
-            float angle = 2.0f * M_PI * i / segments;
-            float cosA = std::cos(angle);
-            float sinA = std::sin(angle);
-            
-            cv::Point3f offset;
-            offset.x = radius * (cosA * perp1.x + sinA * perp2.x);
-            offset.y = radius * (cosA * perp1.y + sinA * perp2.y);
-            offset.z = radius * (cosA * perp1.z + sinA * perp2.z);
-            
-            cv::Point3f vertex = base + offset;
-            vertices.push_back(vertex.x);
-            vertices.push_back(vertex.y);
-            vertices.push_back(vertex.z);
-            
-            // Normal points outward from cylinder axis
-            float normLen = std::sqrt(offset.x * offset.x + offset.y * offset.y + offset.z * offset.z);
-            if (normLen > 0.001f) {
-                normals.push_back(offset.x / normLen);
-                normals.push_back(offset.y / normLen);
-                normals.push_back(offset.z / normLen);
-            } else {
-                normals.push_back(perp1.x);
-                normals.push_back(perp1.y);
-                normals.push_back(perp1.z);
-            }
-        }
-    }
-    
-    // Generate indices for cylinder sides
-    for (int i = 0; i < segments; ++i) {
-        uint32_t base0 = indexOffset + i;
-        uint32_t base1 = indexOffset + segments + 1 + i;
-        
-        indices.push_back(base0);
-        indices.push_back(base1);
-        indices.push_back(base0 + 1);
-        
-        indices.push_back(base0 + 1);
-        indices.push_back(base1);
-        indices.push_back(base1 + 1);
+    PrimitiveInstance instance = {};
+    instance.cylinder = true;
+    instance.origin = start;
+    instance.axis = end - start;
+    instance.perp1 = perp1 * radius;
+    instance.perp2 = perp2 * radius;
+    primitives.push_back(instance);
+}
+
+int MeshGenerator::segmentsFor(MeshLod lod) {
+    switch (lod) {
+        case MeshLod::Thumbnail: return 8;
+        case MeshLod::Detailed: return 32;
+        case MeshLod::Standard:
+        default: return 16;
     }
-    
-    indexOffset += (segments + 1) * 2;
 }
 
-std::vector<uint8_t> MeshGenerator::createFromKeypoints(
-    const std::vector<cv::Point3f>& kpts3d) {
+/**
+ * Build the body mesh geometry and the transform that centers and scales
+ * it, plus its transformed bounds (the GLB POSITION accessor min/max).
+ * 
+ * @return false if the keypoints cannot produce a mesh
+ */
+static bool buildBodyMesh(const std::vector<cv::Point3f>& kpts3d, MeshLod lod, MeshBuffers& mesh,
+                          float boundsMin[3], float boundsMax[3]) {
     
     // BODY_25 keypoint indices (assuming kpts3d has at least 25 keypoints)
     // 0: nose, 1: neck, 2: right_shoulder, 3: right_elbow, 4: right_wrist,
@@ -499,7 +748,7 @@ std::vector<uint8_t> MeshGenerator::createFromKeypoints(
     // 12: left_hip, 13: left_knee, 14: left_ankle
     
     if (kpts3d.empty() || kpts3d.size() < 15) {
-        return std::vector<uint8_t>(); // Return empty if insufficient keypoints
+        return false; // Return empty if insufficient keypoints
     }
     
     // Validate keypoints
@@ -511,12 +760,11 @@ std::vector<uint8_t> MeshGenerator::createFromKeypoints(
     }
     
     if (validKeypoints < 10) {
-        return std::vector<uint8_t>(); // Not enough valid keypoints
+        return false; // Not enough valid keypoints
     }
     
     // Extract key BODY_25 keypoints
-    const size_t BODY_25_COUNT = 25;
-    size_t keypointCount = std::min(kpts3d.size(), BODY_25_COUNT);
+    size_t keypointCount = std::min(kpts3d.size(), Body25Layout::kCount);
     
     cv::Point3f nose = (keypointCount > 0 && isValidKeypoint(kpts3d[0])) ? kpts3d[0] : cv::Point3f(0, 0, 0);
     cv::Point3f neck = (keypointCount > 1 && isValidKeypoint(kpts3d[1])) ? kpts3d[1] : cv::Point3f(0, 0, 0);
@@ -556,11 +804,10 @@ std::vector<uint8_t> MeshGenerator::createFromKeypoints(
     #endif
     
     // Generate mesh segments using actual keypoint positions
-    std::vector<float> allVertices;
-    std::vector<float> allNormals;
-    std::vector<uint32_t> allIndices;
-    uint32_t indexOffset = 0;
-    const int segments = 16; // Resolution of cylinders
+    // (recorded as instances first, then emitted into exactly-sized buffers)
+    std::vector<PrimitiveInstance> primitives;
+    primitives.reserve(12);
+    const int segments = MeshGenerator::segmentsFor(lod); // Resolution of ellipsoids/cylinders
     
     // Calculate segment radii based on actual body proportions
     // Use distances between keypoints to estimate body part sizes
@@ -590,8 +837,7 @@ std::vector<uint8_t> MeshGenerator::createFromKeypoints(
         } else {
             headTop.y = nose.y - headRadius * 1.5f;
         }
-        generateEllipsoid(nose, headRadius, headRadius * 1.5f, headRadius,
-                         segments, allVertices, allNormals, allIndices, indexOffset);
+        addEllipsoid(primitives, nose, headRadius, headRadius * 1.5f, headRadius);
     }
     
     // 2. Neck: cylinder from head base to shoulders
@@ -599,8 +845,7 @@ std::vector<uint8_t> MeshGenerator::createFromKeypoints(
         cv::Point3f headBase = neck;
         headBase.y = neck.y + headRadius * 0.3f; // Slightly above neck
         float neckRadius = headRadius * 0.6f;
-        generateCylinderBetweenPoints(headBase, neck, neckRadius, segments,
-                                     allVertices, allNormals, allIndices, indexOffset);
+        addCylinder(primitives, headBase, neck, neckRadius);
     }
     
     // 3. Torso: from neck to mid-hip, using actual keypoint positions
@@ -614,8 +859,7 @@ std::vector<uint8_t> MeshGenerator::createFromKeypoints(
         }
         
         // Torso as ellipsoid positioned between neck and hip
-        generateEllipsoid(torsoCenter, torsoWidth * 0.5f, torsoHeight * 0.5f, torsoDepth * 0.5f,
-                         segments, allVertices, allNormals, allIndices, indexOffset);
+        addEllipsoid(primitives, torsoCenter, torsoWidth * 0.5f, torsoHeight * 0.5f, torsoDepth * 0.5f);
     }
     
     // 4. Pelvis: at hip level, connecting to legs
@@ -628,93 +872,77 @@ std::vector<uint8_t> MeshGenerator::createFromKeypoints(
         }
         
         cv::Point3f pelvisCenter = midHip;
-        generateEllipsoid(pelvisCenter, hipWidth * 0.5f, pelvisHeight * 0.5f, hipWidth * 0.4f,
-                         segments, allVertices, allNormals, allIndices, indexOffset);
+        addEllipsoid(primitives, pelvisCenter, hipWidth * 0.5f, pelvisHeight * 0.5f, hipWidth * 0.4f);
     }
     
     // 5. Right thigh: cylinder from right hip to right knee
     if (isValidKeypoint(rightHip) && isValidKeypoint(rightKnee)) {
         float thighLength = distance3D(rightHip, rightKnee);
         float thighRadius = thighLength * 0.12f; // Thigh radius ~12% of length
-        generateCylinderBetweenPoints(rightHip, rightKnee, thighRadius, segments,
-                                     allVertices, allNormals, allIndices, indexOffset);
+        addCylinder(primitives, rightHip, rightKnee, thighRadius);
     }
     
     // 6. Left thigh: cylinder from left hip to left knee
     if (isValidKeypoint(leftHip) && isValidKeypoint(leftKnee)) {
         float thighLength = distance3D(leftHip, leftKnee);
         float thighRadius = thighLength * 0.12f;
-        generateCylinderBetweenPoints(leftHip, leftKnee, thighRadius, segments,
-                                     allVertices, allNormals, allIndices, indexOffset);
+        addCylinder(primitives, leftHip, leftKnee, thighRadius);
     }
     
     // 7. Right lower leg: cylinder from right knee to right ankle
     if (isValidKeypoint(rightKnee) && isValidKeypoint(rightAnkle)) {
         float legLength = distance3D(rightKnee, rightAnkle);
         float legRadius = legLength * 0.10f; // Lower leg radius ~10% of length
-        generateCylinderBetweenPoints(rightKnee, rightAnkle, legRadius, segments,
-                                     allVertices, allNormals, allIndices, indexOffset);
+        addCylinder(primitives, rightKnee, rightAnkle, legRadius);
     }
     
     // 8. Left lower leg: cylinder from left knee to left ankle
     if (isValidKeypoint(leftKnee) && isValidKeypoint(leftAnkle)) {
         float legLength = distance3D(leftKnee, leftAnkle);
         float legRadius = legLength * 0.10f;
-        generateCylinderBetweenPoints(leftKnee, leftAnkle, legRadius, segments,
-                                     allVertices, allNormals, allIndices, indexOffset);
+        addCylinder(primitives, leftKnee, leftAnkle, legRadius);
     }
     
     // 9. Right upper arm: cylinder from right shoulder to right elbow
     if (isValidKeypoint(rightShoulder) && isValidKeypoint(rightElbow)) {
         float armLength = distance3D(rightShoulder, rightElbow);
         float armRadius = armLength * 0.10f; // Upper arm radius ~10% of length
-        generateCylinderBetweenPoints(rightShoulder, rightElbow, armRadius, segments,
-                                     allVertices, allNormals, allIndices, indexOffset);
+        addCylinder(primitives, rightShoulder, rightElbow, armRadius);
     }
     
     // 10. Left upper arm: cylinder from left shoulder to left elbow
     if (isValidKeypoint(leftShoulder) && isValidKeypoint(leftElbow)) {
         float armLength = distance3D(leftShoulder, leftElbow);
         float armRadius = armLength * 0.10f;
-        generateCylinderBetweenPoints(leftShoulder, leftElbow, armRadius, segments,
-                                     allVertices, allNormals, allIndices, indexOffset);
+        addCylinder(primitives, leftShoulder, leftElbow, armRadius);
     }
     
     // 11. Right forearm: cylinder from right elbow to right wrist
     if (isValidKeypoint(rightElbow) && isValidKeypoint(rightWrist)) {
         float forearmLength = distance3D(rightElbow, rightWrist);
         float forearmRadius = forearmLength * 0.08f; // Forearm radius ~8% of length
-        generateCylinderBetweenPoints(rightElbow, rightWrist, forearmRadius, segments,
-                                     allVertices, allNormals, allIndices, indexOffset);
+        addCylinder(primitives, rightElbow, rightWrist, forearmRadius);
     }
     
     // 12. Left forearm: cylinder from left elbow to left wrist
     if (isValidKeypoint(leftElbow) && isValidKeypoint(leftWrist)) {
         float forearmLength = distance3D(leftElbow, leftWrist);
         float forearmRadius = forearmLength * 0.08f;
-        generateCylinderBetweenPoints(leftElbow, leftWrist, forearmRadius, segments,
-                                     allVertices, allNormals, allIndices, indexOffset);
+        addCylinder(primitives, leftElbow, leftWrist, forearmRadius);
     }
     
+    emitPrimitives(primitives, segments, mesh);
+    
     // Create GLB from vertices, normals, and indices
-    if (allVertices.empty() || allIndices.empty()) {
-        return std::vector<uint8_t>();
+    if (mesh.vertices.empty() || mesh.indices.empty()) {
+        return false;
     }
     
-    // Center and scale the model to ensure it's visible
-    // Find bounding box of all vertices
-    float minX = allVertices[0], maxX = allVertices[0];
-    float minY = allVertices[1], maxY = allVertices[1];
-    float minZ = allVertices[2], maxZ = allVertices[2];
-    
-    for (size_t i = 0; i < allVertices.size(); i += 3) {
-        minX = std::min(minX, allVertices[i]);
-        maxX = std::max(maxX, allVertices[i]);
-        minY = std::min(minY, allVertices[i + 1]);
-        maxY = std::max(maxY, allVertices[i + 1]);
-        minZ = std::min(minZ, allVertices[i + 2]);
-        maxZ = std::max(maxZ, allVertices[i + 2]);
-    }
+    // Center and scale the model to ensure it's visible, using the bounds
+    // gathered while the vertices were emitted
+    const float minX = mesh.boundsMin[0], maxX = mesh.boundsMax[0];
+    const float minY = mesh.boundsMin[1], maxY = mesh.boundsMax[1];
+    const float minZ = mesh.boundsMin[2], maxZ = mesh.boundsMax[2];
     
     // Calculate center and size
     float centerX = (minX + maxX) * 0.5f;
@@ -732,7 +960,7 @@ std::vector<uint8_t> MeshGenerator::createFromKeypoints(
         "Model bounds before scaling: min(%.3f,%.3f,%.3f) max(%.3f,%.3f,%.3f) size(%.3f,%.3f,%.3f) maxSize=%.3f",
         minX, minY, minZ, maxX, maxY, maxZ, sizeX, sizeY, sizeZ, maxSize);
     __android_log_print(ANDROID_LOG_DEBUG, "MeshGenerator",
-        "Vertex count: %zu, Index count: %zu", allVertices.size() / 3, allIndices.size());
+        "Vertex count: %zu, Index count: %zu", mesh.vertices.size(), mesh.indices.size());
     
     // Log if using placeholder (all at origin)
     if (maxSize < 0.001f) {
@@ -756,25 +984,20 @@ std::vector<uint8_t> MeshGenerator::createFromKeypoints(
         // Generate a simple placeholder model at origin
         #ifdef __ANDROID__
         __android_log_print(ANDROID_LOG_WARN, "MeshGenerator",
-            "Model is at origin! Generating placeholder. Vertex count: %zu", allVertices.size() / 3);
+            "Model is at origin! Generating placeholder. Vertex count: %zu", mesh.vertices.size());
         #endif
         
-        // Clear existing vertices and generate a simple 1.5m tall humanoid placeholder
-        allVertices.clear();
-        allNormals.clear();
-        allIndices.clear();
-        indexOffset = 0;
+        // Replace the geometry with a simple 1.5m tall humanoid placeholder
+        primitives.clear();
         
         // Generate a simple humanoid shape: head + torso
         cv::Point3f headCenter(0.0f, 1.2f, 0.0f);  // Head at 1.2m height
         cv::Point3f torsoCenter(0.0f, 0.6f, 0.0f); // Torso at 0.6m height
-        generateEllipsoid(headCenter, 0.15f, 0.15f, 0.15f, segments, allVertices, allNormals, allIndices, indexOffset);
-        generateEllipsoid(torsoCenter, 0.25f, 0.6f, 0.2f, segments, allVertices, allNormals, allIndices, indexOffset);
+        addEllipsoid(primitives, headCenter, 0.15f, 0.15f, 0.15f);
+        addEllipsoid(primitives, torsoCenter, 0.25f, 0.6f, 0.2f);
         
-        // Recalculate bounds
-        minX = -0.25f; maxX = 0.25f;
-        minY = 0.0f; maxY = 1.5f;
-        minZ = -0.25f; maxZ = 0.25f;
+        // Re-emitting gathers the placeholder's bounds and leaves it untransformed
+        emitPrimitives(primitives, segments, mesh);
         centerX = centerY = centerZ = 0.0f;
         maxSize = 1.5f;
         scale = 1.0f;
@@ -789,31 +1012,60 @@ std::vector<uint8_t> MeshGenerator::createFromKeypoints(
         scale = 1.0f;
     }
     
-    // Center and scale all vertices
-    for (size_t i = 0; i < allVertices.size(); i += 3) {
-        allVertices[i] = (allVertices[i] - centerX) * scale;
-        allVertices[i + 1] = (allVertices[i + 1] - centerY) * scale;
-        allVertices[i + 2] = (allVertices[i + 2] - centerZ) * scale;
+    // Centering and scaling happen as the GLB is written
+    mesh.center[0] = centerX;
+    mesh.center[1] = centerY;
+    mesh.center[2] = centerZ;
+    mesh.scale = scale;
+    
+    // (x - center) * scale is monotonic, so the transformed bounds are the
+    // bounds of the transformed vertices - no second pass needed
+    for (int axis = 0; axis < 3; ++axis) {
+        boundsMin[axis] = mesh.transformed(axis, mesh.boundsMin[axis]);
+        boundsMax[axis] = mesh.transformed(axis, mesh.boundsMax[axis]);
     }
     
     #ifdef __ANDROID__
-    // Recalculate bounds after scaling
-    float newMinX = allVertices[0], newMaxX = allVertices[0];
-    float newMinY = allVertices[1], newMaxY = allVertices[1];
-    float newMinZ = allVertices[2], newMaxZ = allVertices[2];
-    for (size_t i = 0; i < allVertices.size(); i += 3) {
-        newMinX = std::min(newMinX, allVertices[i]);
-        newMaxX = std::max(newMaxX, allVertices[i]);
-        newMinY = std::min(newMinY, allVertices[i + 1]);
-        newMaxY = std::max(newMaxY, allVertices[i + 1]);
-        newMinZ = std::min(newMinZ, allVertices[i + 2]);
-        newMaxZ = std::max(newMaxZ, allVertices[i + 2]);
-    }
     __android_log_print(ANDROID_LOG_DEBUG, "MeshGenerator",
         "Model bounds after scaling: min(%.3f,%.3f,%.3f) max(%.3f,%.3f,%.3f) scale=%.3f",
-        newMinX, newMinY, newMinZ, newMaxX, newMaxY, newMaxZ, scale);
+        boundsMin[0], boundsMin[1], boundsMin[2], boundsMax[0], boundsMax[1], boundsMax[2], scale);
     #endif
     
-    return createGLBManually(allVertices, allNormals, allIndices);
+    return true;
+}
+
+// buildBodyMesh as the MeshBuild stage; serialization is timed separately
+static bool buildTimed(const std::vector<cv::Point3f>& kpts3d, MeshLod lod, MeshBuffers& mesh,
+                       float boundsMin[3], float boundsMax[3]) {
+    ScopedTimer timer(ScanStage::MeshBuild);
+    return buildBodyMesh(kpts3d, lod, mesh, boundsMin, boundsMax);
+}
+
+std::vector<uint8_t> MeshGenerator::createFromKeypoints(
+    const std::vector<cv::Point3f>& kpts3d, MeshLod lod, MeshFormat format) {
+    MeshBuffers mesh;
+    float boundsMin[3], boundsMax[3];
+    if (!buildTimed(kpts3d, lod, mesh, boundsMin, boundsMax)) {
+        return std::vector<uint8_t>();
+    }
+    
+    ScopedTimer timer(ScanStage::GlbSerialize);
+    // Size first, then a single exact allocation
+    std::vector<uint8_t> glb(writeGLB(mesh, boundsMin, boundsMax, format, nullptr, 0));
+    if (!glb.empty()) {
+        writeGLB(mesh, boundsMin, boundsMax, format, glb.data(), glb.size());
+    }
+    return glb;
 }
 
+size_t MeshGenerator::createFromKeypoints(
+    const std::vector<cv::Point3f>& kpts3d, MeshLod lod, MeshFormat format,
+    uint8_t* out, size_t capacity) {
+    MeshBuffers mesh;
+    float boundsMin[3], boundsMax[3];
+    if (!buildTimed(kpts3d, lod, mesh, boundsMin, boundsMax)) {
+        return 0;
+    }
+    ScopedTimer timer(ScanStage::GlbSerialize);
+    return writeGLB(mesh, boundsMin, boundsMax, format, out, capacity);
+}
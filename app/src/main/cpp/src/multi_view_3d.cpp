@@ -1,56 +1,34 @@
 #include "multi_view_3d.h"
+#include "keypoint_schema.h"
+#include "scan_trace.h"
 #include <opencv2/opencv.hpp>
-#include <opencv2/calib3d.hpp>
 #include <vector>
 #include <cmath>
 #include <algorithm>
 #include <limits>
 
-std::vector<cv::Point3f> MultiView3D::triangulate(
-    const std::vector<std::vector<cv::Point2f>>& kpts2d,
-    float userHeight) {
-    
-    const int numKeypoints = 135;
-    std::vector<cv::Point3f> kpts3d;
-    kpts3d.reserve(numKeypoints);
+namespace {
 
-    // Validate input
-    if (kpts2d.size() != 3) {
-        // Return zeros if invalid input
-        for (int i = 0; i < numKeypoints; ++i) {
-            kpts3d.push_back(cv::Point3f(0.0f, 0.0f, 0.0f));
-        }
-        return kpts3d;
-    }
+const int kNumKeypoints = static_cast<int>(PipelineLayout::kCount);
+
+// Keypoints are normalized; triangulation assumes a 640x480 image
+const float kImageWidth = 640.0f;
+const float kImageHeight = 480.0f;
 
-    // Define camera poses for 3 views (front, left, right)
-    // Assuming cameras are positioned around the person at equal angles
+/**
+ * Projection matrices (row-major 3x4) for a rig of N cameras spaced evenly
+ * around the person. They only depend on the rig geometry, so each view
+ * count is built once.
+ */
+struct CameraRig {
+    double P[MultiView3D::kMaxViews][12];
+};
+
+CameraRig buildCameraRig(int numViews) {
+    // Define camera poses for N views: view 0 is the front, the rest follow
+    // at equal angles (3 views = front, left at 120 degrees, right at -120)
     const float cameraDistance = 200.0f; // cm - distance from person
-    const float angleStep = 120.0f * M_PI / 180.0f; // 120 degrees between views
-    
-    // Camera 0: Front view (0 degrees)
-    cv::Mat R0 = cv::Mat::eye(3, 3, CV_32F);
-    cv::Mat t0 = (cv::Mat_<float>(3, 1) << 0.0f, 0.0f, cameraDistance);
-    
-    // Camera 1: Left view (120 degrees)
-    cv::Mat R1 = (cv::Mat_<float>(3, 3) << 
-        std::cos(angleStep), 0.0f, std::sin(angleStep),
-        0.0f, 1.0f, 0.0f,
-        -std::sin(angleStep), 0.0f, std::cos(angleStep));
-    cv::Mat t1 = (cv::Mat_<float>(3, 1) << 
-        cameraDistance * std::sin(angleStep), 
-        0.0f, 
-        cameraDistance * std::cos(angleStep));
-    
-    // Camera 2: Right view (-120 degrees)
-    cv::Mat R2 = (cv::Mat_<float>(3, 3) << 
-        std::cos(-angleStep), 0.0f, std::sin(-angleStep),
-        0.0f, 1.0f, 0.0f,
-        -std::sin(-angleStep), 0.0f, std::cos(-angleStep));
-    cv::Mat t2 = (cv::Mat_<float>(3, 1) << 
-        cameraDistance * std::sin(-angleStep), 
-        0.0f, 
-        cameraDistance * std::cos(-angleStep));
+    const float angleStep = 2.0f * M_PI / numViews;
 
     // Camera intrinsic matrix (simplified - assumes square pixels, centered principal point)
     // Using a typical phone camera FOV (~60 degrees) and 640px width
@@ -60,108 +38,175 @@ std::vector<cv::Point3f> MultiView3D::triangulate(
         0.0f, focalLength, 320.0f,
         0.0f, 0.0f, 1.0f);
 
-    // Projection matrices for each camera
-    cv::Mat P0, P1, P2;
-    cv::hconcat(R0, t0, P0);
-    P0 = K * P0;
-    cv::hconcat(R1, t1, P1);
-    P1 = K * P1;
-    cv::hconcat(R2, t2, P2);
-    P2 = K * P2;
-
-    // Process each keypoint
-    for (int i = 0; i < numKeypoints; ++i) {
-        // Get 2D keypoints from all 3 views (normalized 0-1, convert to pixel coordinates)
-        std::vector<cv::Point2f> points2d;
-        bool valid = true;
-        
-        for (int view = 0; view < 3; ++view) {
-            if (i >= static_cast<int>(kpts2d[view].size())) {
-                valid = false;
-                break;
+    CameraRig rig = {};
+    for (int view = 0; view < numViews; ++view) {
+        const float angle = angleStep * view;
+        cv::Mat R = (cv::Mat_<float>(3, 3) << 
+            std::cos(angle), 0.0f, std::sin(angle),
+            0.0f, 1.0f, 0.0f,
+            -std::sin(angle), 0.0f, std::cos(angle));
+        cv::Mat t = (cv::Mat_<float>(3, 1) << 
+            cameraDistance * std::sin(angle), 
+            0.0f, 
+            cameraDistance * std::cos(angle));
+
+        // Projection matrix P = K [R | t]
+        cv::Mat P;
+        cv::hconcat(R, t, P);
+        P = K * P;
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 4; ++c) {
+                rig.P[view][r * 4 + c] = P.at<float>(r, c);
             }
-            
-            // Convert normalized coordinates to pixel coordinates (assuming 640x480 image)
-            float px = kpts2d[view][i].x * 640.0f;
-            float py = kpts2d[view][i].y * 480.0f;
-            points2d.push_back(cv::Point2f(px, py));
         }
+    }
+    return rig;
+}
 
-        if (!valid) {
-            kpts3d.push_back(cv::Point3f(0.0f, 0.0f, 0.0f));
-            continue;
+const CameraRig& cameraRig(int numViews) {
+    // Built once (thread-safe) and read-only afterwards
+    static const std::vector<CameraRig> rigs = [] {
+        std::vector<CameraRig> built(MultiView3D::kMaxViews + 1);
+        for (int n = MultiView3D::kMinViews; n <= MultiView3D::kMaxViews; ++n) {
+            built[n] = buildCameraRig(n);
         }
+        return built;
+    }();
+    return rigs[numViews];
+}
 
-        // Triangulate using two views (front and left, or front and right)
-        cv::Mat point4d;
-        
-        // Use front and left views for triangulation
-        cv::triangulatePoints(P0, P1, 
-            cv::Mat(points2d[0]), 
-            cv::Mat(points2d[1]), 
-            point4d);
-        
-        // Convert from homogeneous to 3D coordinates
-        cv::Point3f point3d;
-        if (point4d.at<float>(3, 0) != 0.0f) {
-            point3d.x = point4d.at<float>(0, 0) / point4d.at<float>(3, 0);
-            point3d.y = point4d.at<float>(1, 0) / point4d.at<float>(3, 0);
-            point3d.z = point4d.at<float>(2, 0) / point4d.at<float>(3, 0);
-        } else {
-            point3d = cv::Point3f(0.0f, 0.0f, 0.0f);
-        }
+// Undetected keypoints are (0, 0) or outside the normalized image
+inline bool isValidObservation(const cv::Point2f& pt) {
+    return std::isfinite(pt.x) && std::isfinite(pt.y) &&
+           pt.x >= 0.0f && pt.x <= 1.0f && pt.y >= 0.0f && pt.y <= 1.0f &&
+           !(pt.x == 0.0f && pt.y == 0.0f);
+}
 
-        // Scale using user height as reference
-        // Estimate body height from keypoints (head to foot distance)
-        // For now, use a simple scaling factor based on typical body proportions
-        // A typical person's height in the coordinate system should match userHeight
-        
-        // Find approximate head and foot keypoints (simplified)
-        // Keypoint 0 is typically head, keypoint 134 might be foot
-        // We'll use a scaling approach based on the bounding box of all keypoints
-        
-        // For initial implementation, scale based on Y-axis range
-        // This is a simplified approach - can be improved with better keypoint mapping
-        static float scaleFactor = 1.0f;
-        static bool scaleComputed = false;
-        
-        if (!scaleComputed && userHeight > 0.0f) {
-            // Estimate scale from first few keypoints
-            // Assume keypoints span roughly the person's height
-            float minY = std::numeric_limits<float>::max();
-            float maxY = std::numeric_limits<float>::lowest();
-            
-            for (int j = 0; j < std::min(50, static_cast<int>(kpts2d[0].size())); ++j) {
-                float y = kpts2d[0][j].y;
-                if (y > 0.0f && y < 1.0f) {
-                    minY = std::min(minY, y);
-                    maxY = std::max(maxY, y);
-                }
+} // namespace
+
+std::vector<cv::Point3f> MultiView3D::triangulate(
+    const std::vector<std::vector<cv::Point2f>>& kpts2d,
+    float userHeight) {
+    std::vector<cv::Point3f> kpts3d;
+    triangulate(kpts2d, userHeight, kpts3d);
+    return kpts3d;
+}
+
+void MultiView3D::triangulate(
+    const std::vector<std::vector<cv::Point2f>>& kpts2d,
+    float userHeight,
+    std::vector<cv::Point3f>& kpts3d) {
+    ScopedTimer timer(ScanStage::Triangulation);
+    
+    // Invalid keypoints stay at zero
+    kpts3d.assign(kNumKeypoints, cv::Point3f(0.0f, 0.0f, 0.0f));
+
+    // Validate input
+    const int numViews = static_cast<int>(kpts2d.size());
+    if (numViews < kMinViews || numViews > kMaxViews) {
+        return;
+    }
+    const CameraRig& rig = cameraRig(numViews);
+
+    // Linear (DLT) triangulation: each view observing the keypoint at (x, y)
+    // contributes the rows x*P3 - P1 and y*P3 - P2 of A; the point is the
+    // right singular vector of A with the smallest singular value. A lives
+    // on the stack, sized for the maximum view count.
+    double rows[2 * kMaxViews * 4];
+    cv::Mat X;
+    for (int i = 0; i < kNumKeypoints; ++i) {
+        int used = 0;
+        for (int view = 0; view < numViews; ++view) {
+            if (i >= static_cast<int>(kpts2d[view].size()) ||
+                !isValidObservation(kpts2d[view][i])) {
+                continue;
             }
             
-            if (maxY > minY) {
-                // Estimate height in 3D space from triangulated points
-                // Use a reference: if normalized Y spans 0.8 (head to foot), 
-                // and userHeight is the real height, calculate scale
-                float estimatedHeight3D = std::abs(maxY - minY) * 200.0f; // rough estimate
-                if (estimatedHeight3D > 0.0f) {
-                    scaleFactor = userHeight / estimatedHeight3D;
-                }
+            // Convert normalized coordinates to pixel coordinates
+            const double x = kpts2d[view][i].x * kImageWidth;
+            const double y = kpts2d[view][i].y * kImageHeight;
+            const double* P = rig.P[view];
+            double* rx = rows + used * 8;
+            double* ry = rx + 4;
+            for (int c = 0; c < 4; ++c) {
+                rx[c] = x * P[8 + c] - P[c];
+                ry[c] = y * P[8 + c] - P[4 + c];
             }
-            scaleComputed = true;
+            ++used;
         }
-        
-        // Apply scaling
-        point3d.x *= scaleFactor;
-        point3d.y *= scaleFactor;
-        point3d.z *= scaleFactor;
+
+        // Needs at least two views to intersect rays
+        if (used < 2) {
+            continue;
+        }
+
+        cv::Mat A(used * 2, 4, CV_64F, rows);
+        cv::SVD::solveZ(A, X);
+        const double* h = X.ptr<double>();
+        if (h[3] == 0.0 || !std::isfinite(h[3])) {
+            continue;
+        }
+        const double inv = 1.0 / h[3];
         
         // Adjust coordinate system: Y should be height (positive up)
         // Z should be depth, X should be width
         // Our triangulation gives us camera-relative coordinates, so we adjust
-        kpts3d.push_back(cv::Point3f(point3d.x, -point3d.y, point3d.z));
+        kpts3d[i] = cv::Point3f(static_cast<float>(h[0] * inv),
+                                static_cast<float>(-h[1] * inv),
+                                static_cast<float>(h[2] * inv));
     }
 
-    return kpts3d;
+    // Scale using user height as reference - computed from this call's points only
+    float scale = heightScale(kpts3d, userHeight);
+    if (scale != 1.0f) {
+        for (auto& pt : kpts3d) {
+            pt *= scale;
+        }
+    }
 }
 
+float MultiView3D::heightScale(const std::vector<cv::Point3f>& kpts3d, float userHeight) {
+    if (userHeight <= 0.0f || kpts3d.size() < MediaPipeLayout::kCount) {
+        return 1.0f;
+    }
+
+    const KeypointSet<MediaPipeLayout> landmarks =
+        KeypointSet<MediaPipeLayout>::fromPoints(kpts3d.data(), kpts3d.size());
+
+    // Average of the valid points among the given MediaPipe indices
+    auto average = [&](std::initializer_list<int> indices, cv::Point3f& out) {
+        cv::Point3f sum(0.0f, 0.0f, 0.0f);
+        int count = 0;
+        for (int idx : indices) {
+            if (landmarks.valid(idx)) {
+                sum += landmarks[idx];
+                ++count;
+            }
+        }
+        if (count == 0) {
+            return false;
+        }
+        out = sum * (1.0f / count);
+        return true;
+    };
+
+    // Nose, falling back to the eyes, down to the ankles
+    cv::Point3f head, ankles;
+    if (!average({MediaPipeLayout::kNose}, head) &&
+        !average({MediaPipeLayout::kLeftEye, MediaPipeLayout::kRightEye}, head)) {
+        return 1.0f;
+    }
+    if (!average({MediaPipeLayout::kLeftAnkle, MediaPipeLayout::kRightAnkle}, ankles)) {
+        return 1.0f;
+    }
+
+    float span = static_cast<float>(cv::norm(head - ankles));
+    if (!(span > 0.0f) || !std::isfinite(span)) {
+        return 1.0f;
+    }
+
+    // Nose to ankle covers roughly 88% of standing height
+    // (nose ~92% of stature, ankle joint ~4% above the floor)
+    const float noseToAnkleFraction = 0.88f;
+    return userHeight * noseToAnkleFraction / span;
+}
@@ -1,5 +1,6 @@
 #include "pose_estimator.h"
 #include "mediapipe_pose_detector.h"
+#include "keypoint_schema.h"
 #include <opencv2/opencv.hpp>
 #include <opencv2/imgproc.hpp>
 #include <vector>
@@ -56,22 +57,25 @@ static JNIEnv* getJNIEnv() {
  * - Additional anatomical points
  * 
  * For now, we'll use direct mapping for the 33 landmarks and
- * interpolate/extrapolate the remaining 102 keypoints.
+ * interpolate/extrapolate the remaining 102 keypoints. A
+ * BODYSCAN_MEDIAPIPE_KEYPOINTS_ONLY build (PipelineLayout = MediaPipeLayout)
+ * stops after the direct mapping.
  */
-static std::vector<cv::Point2f> mapMediaPipeTo135(
+static std::vector<cv::Point2f> mapMediaPipeToPipeline(
     const std::vector<cv::Point3f>& mpLandmarks) {
     
-    std::vector<cv::Point2f> keypoints(135, cv::Point2f(0.0f, 0.0f));
+    std::vector<cv::Point2f> keypoints(PipelineLayout::kCount, cv::Point2f(0.0f, 0.0f));
     
-    if (mpLandmarks.size() != 33) {
+    if (mpLandmarks.size() != MediaPipeLayout::kCount) {
         return keypoints; // Return zeros if invalid input
     }
     
     // Direct mapping: Map first 33 MediaPipe landmarks to first 33 keypoints
-    for (int i = 0; i < 33; ++i) {
+    for (size_t i = 0; i < MediaPipeLayout::kCount; ++i) {
         keypoints[i] = cv::Point2f(mpLandmarks[i].x, mpLandmarks[i].y);
     }
     
+#ifndef BODYSCAN_MEDIAPIPE_KEYPOINTS_ONLY
     // Interpolate additional keypoints
     // Strategy: Create intermediate points between major landmarks
     
@@ -79,17 +83,18 @@ static std::vector<cv::Point2f> mapMediaPipeTo135(
     // Add interpolated points between facial landmarks
     int faceStart = 0;
     int faceEnd = 10;
-    int kpIdx = 33;
+    int kpIdx = static_cast<int>(Body135Layout::kMediaPipeCount);
+    const int kEnd = static_cast<int>(Body135Layout::kCount);
     
     // Upper body - left arm (indices 11-16)
     // 11: left shoulder, 12: left elbow, 13: left wrist
-    if (kpIdx < 135 && mpLandmarks[11].x > 0 && mpLandmarks[12].x > 0) {
+    if (kpIdx < kEnd && mpLandmarks[11].x > 0 && mpLandmarks[12].x > 0) {
         // Midpoint between shoulder and elbow
         keypoints[kpIdx++] = cv::Point2f(
             (mpLandmarks[11].x + mpLandmarks[12].x) / 2.0f,
             (mpLandmarks[11].y + mpLandmarks[12].y) / 2.0f);
     }
-    if (kpIdx < 135 && mpLandmarks[12].x > 0 && mpLandmarks[13].x > 0) {
+    if (kpIdx < kEnd && mpLandmarks[12].x > 0 && mpLandmarks[13].x > 0) {
         // Midpoint between elbow and wrist
         keypoints[kpIdx++] = cv::Point2f(
             (mpLandmarks[12].x + mpLandmarks[13].x) / 2.0f,
@@ -108,13 +113,13 @@ static std::vector<cv::Point2f> mapMediaPipeTo135(
     // 29-32: right leg (hip, knee, ankle)
     
     // Right arm interpolation
-    if (kpIdx < 135 && mpLandmarks.size() > 23 && 
+    if (kpIdx < kEnd && mpLandmarks.size() > 23 && 
         mpLandmarks[23].x > 0 && mpLandmarks[24].x > 0) {
         keypoints[kpIdx++] = cv::Point2f(
             (mpLandmarks[23].x + mpLandmarks[24].x) / 2.0f,
             (mpLandmarks[23].y + mpLandmarks[24].y) / 2.0f);
     }
-    if (kpIdx < 135 && mpLandmarks.size() > 24 && 
+    if (kpIdx < kEnd && mpLandmarks.size() > 24 && 
         mpLandmarks[24].x > 0 && mpLandmarks[25].x > 0) {
         keypoints[kpIdx++] = cv::Point2f(
             (mpLandmarks[24].x + mpLandmarks[25].x) / 2.0f,
@@ -122,13 +127,13 @@ static std::vector<cv::Point2f> mapMediaPipeTo135(
     }
     
     // Left leg interpolation (17-22)
-    if (kpIdx < 135 && mpLandmarks.size() > 17 && 
+    if (kpIdx < kEnd && mpLandmarks.size() > 17 && 
         mpLandmarks[17].x > 0 && mpLandmarks[18].x > 0) {
         keypoints[kpIdx++] = cv::Point2f(
             (mpLandmarks[17].x + mpLandmarks[18].x) / 2.0f,
             (mpLandmarks[17].y + mpLandmarks[18].y) / 2.0f);
     }
-    if (kpIdx < 135 && mpLandmarks.size() > 18 && 
+    if (kpIdx < kEnd && mpLandmarks.size() > 18 && 
         mpLandmarks[18].x > 0 && mpLandmarks[19].x > 0) {
         keypoints[kpIdx++] = cv::Point2f(
             (mpLandmarks[18].x + mpLandmarks[19].x) / 2.0f,
@@ -136,13 +141,13 @@ static std::vector<cv::Point2f> mapMediaPipeTo135(
     }
     
     // Right leg interpolation (29-32)
-    if (kpIdx < 135 && mpLandmarks.size() > 29 && 
+    if (kpIdx < kEnd && mpLandmarks.size() > 29 && 
         mpLandmarks[29].x > 0 && mpLandmarks[30].x > 0) {
         keypoints[kpIdx++] = cv::Point2f(
             (mpLandmarks[29].x + mpLandmarks[30].x) / 2.0f,
             (mpLandmarks[29].y + mpLandmarks[30].y) / 2.0f);
     }
-    if (kpIdx < 135 && mpLandmarks.size() > 30 && 
+    if (kpIdx < kEnd && mpLandmarks.size() > 30 && 
         mpLandmarks[30].x > 0 && mpLandmarks[31].x > 0) {
         keypoints[kpIdx++] = cv::Point2f(
             (mpLandmarks[30].x + mpLandmarks[31].x) / 2.0f,
@@ -151,7 +156,7 @@ static std::vector<cv::Point2f> mapMediaPipeTo135(
     
     // Fill remaining keypoints with interpolated/extrapolated values
     // For now, duplicate nearby valid keypoints or use body proportions
-    while (kpIdx < 135) {
+    while (kpIdx < kEnd) {
         // Use the last valid keypoint or a default position
         if (kpIdx > 0 && keypoints[kpIdx - 1].x > 0) {
             keypoints[kpIdx] = keypoints[kpIdx - 1];
@@ -161,14 +166,28 @@ static std::vector<cv::Point2f> mapMediaPipeTo135(
         }
         kpIdx++;
     }
+#endif
     
     return keypoints;
 }
 
+std::vector<cv::Point2f> PoseEstimator::mapLandmarks(const std::vector<cv::Point3f>& landmarks) {
+    return mapMediaPipeToPipeline(landmarks);
+}
+
 // Implementation using MediaPipe for pose detection
 std::vector<cv::Point2f> PoseEstimator::detect(const cv::Mat& img) {
-    const int numKeypoints = 135;
-    std::vector<cv::Point2f> keypoints(numKeypoints, cv::Point2f(0.0f, 0.0f));
+    cv::Mat unusedMask;
+    return detect(img, unusedMask, false);
+}
+
+std::vector<cv::Point2f> PoseEstimator::detect(const cv::Mat& img, cv::Mat& segmentationMask) {
+    return detect(img, segmentationMask, true);
+}
+
+std::vector<cv::Point2f> PoseEstimator::detect(const cv::Mat& img, cv::Mat& segmentationMask, bool withMask) {
+    std::vector<cv::Point2f> keypoints(PipelineLayout::kCount, cv::Point2f(0.0f, 0.0f));
+    segmentationMask.release();
     
     if (img.empty() || img.cols <= 0 || img.rows <= 0) {
         return keypoints;
@@ -187,16 +206,19 @@ std::vector<cv::Point2f> PoseEstimator::detect(const cv::Mat& img) {
         return keypoints;
     }
     
-    // Detect pose using MediaPipe
-    std::vector<cv::Point3f> mpLandmarks = MediaPipePoseDetector::detect(env, img);
+    // Detect pose using MediaPipe - landmarks and mask come from one inference.
+    // Always the full frame: unrelated calls never inherit each other's crop
+    // (ROI tracking is PreviewSession's, over consecutive frames)
+    MediaPipePoseDetector::PoseDetection detection = MediaPipePoseDetector::detectFull(env, img, withMask);
+    segmentationMask = detection.segmentationMask;
     
-    if (mpLandmarks.empty() || mpLandmarks.size() != 33) {
+    if (detection.landmarks.empty() || detection.landmarks.size() != MediaPipeLayout::kCount) {
         // No pose detected or invalid result
         return keypoints;
     }
     
-    // Map 33 MediaPipe landmarks to 135 keypoints
-    keypoints = mapMediaPipeTo135(mpLandmarks);
+    // Map 33 MediaPipe landmarks to the pipeline keypoints (135 by default)
+    keypoints = mapMediaPipeToPipeline(detection.landmarks);
     
     return keypoints;
 }
@@ -244,19 +266,20 @@ PoseEstimator::ValidationResult PoseEstimator::validateImage(const cv::Mat& img)
     }
     
     try {
-        // Count detected poses first to check for multiple people
-        int poseCount = MediaPipePoseDetector::countDetectedPoses(env, img);
-        if (poseCount > 1) {
+        // One inference provides both the pose count and the landmarks
+        MediaPipePoseDetector::PoseDetection detection = MediaPipePoseDetector::detectFull(env, img);
+        
+        // Check for multiple people first
+        if (detection.poseCount > 1) {
             result.hasMultiplePeople = true;
             result.message = "Multiple people detected. Please ensure only one person is in the image.";
             return result;
         }
         
-        // Detect pose using MediaPipe
-        std::vector<cv::Point3f> mpLandmarks = MediaPipePoseDetector::detect(env, img);
+        const std::vector<cv::Point3f>& mpLandmarks = detection.landmarks;
         
         // Check if any landmarks were detected
-        if (mpLandmarks.empty() || mpLandmarks.size() != 33) {
+        if (mpLandmarks.empty() || mpLandmarks.size() != MediaPipeLayout::kCount) {
             result.message = "No person detected";
             return result;
         }
@@ -295,7 +318,7 @@ PoseEstimator::ValidationResult PoseEstimator::validateImage(const cv::Mat& img)
         }
         
         result.hasPerson = true;
-        result.confidence = std::min(1.0f, validLandmarkCount / 33.0f);
+        result.confidence = std::min(1.0f, validLandmarkCount / static_cast<float>(MediaPipeLayout::kCount));
         
         // Define required landmarks for full body detection
         // Head landmarks (indices 0-10)
@@ -0,0 +1,69 @@
+#include "preprocess_pool.h"
+#include "image_preprocessor.h"
+#include <system_error>
+
+PreprocessPool& PreprocessPool::shared() {
+    static PreprocessPool* pool = new PreprocessPool();
+    return *pool;
+}
+
+PreprocessPool::~PreprocessPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskReady.notify_all();
+    for (std::thread& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+std::future<void> PreprocessPool::submit(cv::Mat& img, ScanTimings* timings) {
+    cv::Mat* view = &img;
+    std::packaged_task<void()> task([view, timings] {
+        ScanTimings::Scope scope(timings);
+        ImagePreprocessor::run(*view);
+    });
+    std::future<void> done = task.get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!stopping && workers.empty()) {
+            try {
+                for (int i = 0; i < kWorkerCount; ++i) {
+                    workers.emplace_back(&PreprocessPool::run, this);
+                }
+            } catch (const std::system_error&) {
+                // Run with the workers that started
+            }
+        }
+        if (!stopping && !workers.empty()) {
+            tasks.push_back(std::move(task));
+        }
+    }
+
+    if (task.valid()) {
+        task();  // No worker: preprocess here
+    } else {
+        taskReady.notify_one();
+    }
+    return done;
+}
+
+void PreprocessPool::run() {
+    for (;;) {
+        std::packaged_task<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            taskReady.wait(lock, [this] { return !tasks.empty() || stopping; });
+            if (tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();  // Exceptions are stored in the task's future
+    }
+}
@@ -0,0 +1,285 @@
+#include "preview_session.h"
+#include "pose_estimator.h"
+#include <opencv2/opencv.hpp>
+#include <android/log.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <system_error>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define LOG_TAG "PreviewSession"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+// Defined in mediapipe_pose_detector.cpp
+extern JavaVM* g_jvm;
+
+namespace {
+
+// Exponential smoothing factor of a first-order low-pass filter
+float smoothingFactor(float cutoffHz, float dt) {
+    const float tau = 1.0f / (2.0f * static_cast<float>(M_PI) * cutoffHz);
+    return 1.0f / (1.0f + tau / dt);
+}
+
+} // namespace
+
+float OneEuroFilter::filter(float value, float dt, const Params& params) {
+    if (!initialized || dt <= 0.0f) {
+        initialized = true;
+        lastValue = value;
+        lastDerivative = 0.0f;
+        return value;
+    }
+
+    const float derivative = (value - lastValue) / dt;
+    const float derivativeAlpha = smoothingFactor(params.derivativeCutoff, dt);
+    lastDerivative += derivativeAlpha * (derivative - lastDerivative);
+
+    const float cutoff = params.minCutoff + params.beta * std::fabs(lastDerivative);
+    lastValue += smoothingFactor(cutoff, dt) * (value - lastValue);
+    return lastValue;
+}
+
+PreviewSession::~PreviewSession() {
+    stop(nullptr);
+}
+
+bool PreviewSession::start(JNIEnv* env) {
+    std::lock_guard<std::mutex> lifecycle(lifecycleMutex);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (running) {
+            return true;
+        }
+    }
+    // A worker left over from a stopped or failed start has already exited
+    if (worker.joinable()) {
+        worker.join();
+    }
+
+    if (g_jvm == nullptr || !MediaPipePoseDetector::isReady(env)) {
+        LOGE("MediaPipe not ready - cannot start preview");
+        return false;
+    }
+
+    // Worker-only state can be reset here: no worker is running
+    tracking = MediaPipePoseDetector::startTracking(env);
+    for (OneEuroFilter& filter : filters) {
+        filter.reset();
+    }
+    lastFilteredMs = -1;
+    missedFrames = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        hasPending = false;
+        output.fill(0.0f);
+        outputSequence = 0;
+        nextSequence = 0;
+        counters = Stats();
+        running = true;
+    }
+    std::promise<bool> attached;
+    std::future<bool> workerReady = attached.get_future();
+    try {
+        worker = std::thread(&PreviewSession::run, this, std::move(attached));
+    } catch (const std::system_error&) {
+        LOGE("Failed to start preview worker thread");
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+
+    // Report failure here rather than accept frames nothing will process
+    if (!worker.joinable() || !workerReady.get()) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+        if (tracking) {
+            MediaPipePoseDetector::stopTracking(env);
+            tracking = false;
+        }
+        return false;
+    }
+
+    LOGI("Preview started (%s)", tracking ? "tracking" : "per-frame detection");
+    return true;
+}
+
+bool PreviewSession::pushFrame(const cv::Mat& frame) {
+    if (frame.empty()) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) {
+            return false;
+        }
+    }
+
+    std::lock_guard<std::mutex> pushLock(pushMutex);
+
+    // Copy (and downscale) outside the main lock so the worker never waits on it
+    const int longSide = std::max(frame.cols, frame.rows);
+    if (longSide > kMaxFrameSide) {
+        const double scale = static_cast<double>(kMaxFrameSide) / longSide;
+        const cv::Size size(std::max(1, static_cast<int>(std::lround(frame.cols * scale))),
+                            std::max(1, static_cast<int>(std::lround(frame.rows * scale))));
+        cv::resize(frame, incoming, size, 0, 0, cv::INTER_AREA);
+    } else {
+        frame.copyTo(incoming);
+    }
+
+    const int64_t timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) {
+            return false;
+        }
+        if (hasPending) {
+            counters.dropped++;  // Latest frame wins
+        }
+        std::swap(incoming, pending);
+        hasPending = true;
+        pendingSequence = ++nextSequence;
+        pendingTimestampMs = timestampMs;
+        counters.pushed++;
+    }
+    frameReady.notify_one();
+    return true;
+}
+
+uint64_t PreviewSession::latest(float* out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::copy(output.begin(), output.end(), out);
+    return outputSequence;
+}
+
+PreviewSession::Stats PreviewSession::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+void PreviewSession::stop(JNIEnv* env) {
+    std::lock_guard<std::mutex> lifecycle(lifecycleMutex);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running && !worker.joinable()) {
+            return;
+        }
+        running = false;
+        hasPending = false;
+    }
+    frameReady.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+
+    if (tracking) {
+        MediaPipePoseDetector::stopTracking(env);
+        tracking = false;
+    }
+
+    const Stats finalStats = stats();
+    LOGI("Preview stopped: %llu frames pushed, %llu processed, %llu dropped",
+         static_cast<unsigned long long>(finalStats.pushed),
+         static_cast<unsigned long long>(finalStats.processed),
+         static_cast<unsigned long long>(finalStats.dropped));
+}
+
+void PreviewSession::run(std::promise<bool> attached) {
+    JNIEnv* env = nullptr;
+    if (g_jvm->AttachCurrentThread(&env, nullptr) != JNI_OK || env == nullptr) {
+        LOGE("Failed to attach preview worker thread");
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+        }
+        attached.set_value(false);
+        return;
+    }
+    attached.set_value(true);
+
+    for (;;) {
+        uint64_t sequence;
+        int64_t timestampMs;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            frameReady.wait(lock, [this] { return hasPending || !running; });
+            if (!running) {
+                break;
+            }
+            std::swap(pending, working);
+            hasPending = false;
+            sequence = pendingSequence;
+            timestampMs = pendingTimestampMs;
+        }
+
+        try {
+            process(env, working, sequence, timestampMs);
+        } catch (...) {
+            LOGE("Preview frame %llu failed", static_cast<unsigned long long>(sequence));
+        }
+    }
+
+    fallbackSession.clear(env);
+    g_jvm->DetachCurrentThread();
+}
+
+void PreviewSession::process(JNIEnv* env, const cv::Mat& frame, uint64_t sequence, int64_t timestampMs) {
+    // The VIDEO-mode landmarker requires strictly increasing timestamps
+    if (timestampMs <= lastTimestampMs) {
+        timestampMs = lastTimestampMs + 1;
+    }
+    lastTimestampMs = timestampMs;
+
+    const MediaPipePoseDetector::PoseDetection detection = tracking
+        ? MediaPipePoseDetector::detectTracked(env, frame, timestampMs)
+        : fallbackSession.detectWithRoi(env, frame, false);
+
+    std::array<float, kKeypointFloats> result{};
+    bool publish = true;
+
+    if (detection.landmarks.size() == MediaPipeLayout::kCount) {
+        missedFrames = 0;
+        const float dt = lastFilteredMs >= 0
+            ? static_cast<float>(std::max<int64_t>(1, timestampMs - lastFilteredMs)) / 1000.0f
+            : 0.0f;
+        lastFilteredMs = timestampMs;
+
+        smoothed.resize(MediaPipeLayout::kCount);
+        for (size_t i = 0; i < MediaPipeLayout::kCount; ++i) {
+            const cv::Point3f& landmark = detection.landmarks[i];
+            smoothed[i].x = filters[i * 2 + 0].filter(landmark.x, dt, filterParams);
+            smoothed[i].y = filters[i * 2 + 1].filter(landmark.y, dt, filterParams);
+            smoothed[i].z = landmark.z;
+        }
+
+        const std::vector<cv::Point2f> keypoints = PoseEstimator::mapLandmarks(smoothed);
+        for (size_t i = 0; i < keypoints.size() && i < WireLayout::kCount; ++i) {
+            result[i * 2 + 0] = keypoints[i].x;
+            result[i * 2 + 1] = keypoints[i].y;
+        }
+    } else if (++missedFrames > kHoldFrames) {
+        // Tracking lost: clear the overlay and start smoothing afresh
+        for (OneEuroFilter& filter : filters) {
+            filter.reset();
+        }
+        lastFilteredMs = -1;
+    } else {
+        publish = false;  // Hold the last pose through a brief dropout
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    counters.processed++;
+    if (publish) {
+        output = result;
+        outputSequence = sequence;
+    }
+}
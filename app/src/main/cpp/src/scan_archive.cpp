@@ -0,0 +1,373 @@
+#include "scan_archive.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Records are written and mapped in native byte order
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "ScanArchiveLayout is little endian"
+#endif
+
+static_assert(sizeof(cv::Point3f) == 3 * sizeof(float), "Point3f must be three packed floats");
+static_assert(sizeof(cv::Point2f) == 2 * sizeof(float), "Point2f must be two packed floats");
+
+namespace {
+
+constexpr size_t kLandmarkPoints = ScanArchiveLayout::kViewCount * ScanArchiveLayout::kLandmarkCount;
+
+// File header fields
+constexpr size_t kMagicOffset = 0;
+constexpr size_t kVersionOffset = 4;
+constexpr size_t kRecordCountOffset = 8;
+constexpr size_t kIndexOffsetOffset = 16;
+constexpr size_t kFileBytesOffset = 24;
+
+// Record header fields
+constexpr size_t kRecordBytesOffset = 0;
+constexpr size_t kFlagsOffset = 4;
+constexpr size_t kScanIdOffset = 8;
+constexpr size_t kUserHeightOffset = 16;
+constexpr size_t kFrontSizeOffset = 20;
+constexpr size_t kMaskSizeOffset = 28;
+constexpr size_t kMaskBytesOffset = 36;
+constexpr size_t kGlbBytesOffset = 40;
+
+// PackBits: a header byte h of 0..127 is followed by h + 1 literal bytes,
+// h of 129..255 by one byte repeated 257 - h times (128 is unused)
+constexpr size_t kMaxPackBitsRun = 128;
+constexpr size_t kMinRepeat = 3;  // Shorter repeats cost as much as literals
+
+size_t align16(size_t offset) {
+    return (offset + 15) / 16 * 16;
+}
+
+template <typename T>
+void store(uint8_t* data, size_t offset, T value) {
+    std::memcpy(data + offset, &value, sizeof(value));
+}
+
+template <typename T>
+T load(const uint8_t* data, size_t offset) {
+    T value;
+    std::memcpy(&value, data + offset, sizeof(value));
+    return value;
+}
+
+size_t repeatLength(const uint8_t* data, size_t size, size_t start) {
+    size_t length = 1;
+    while (start + length < size && length < kMaxPackBitsRun && data[start + length] == data[start]) {
+        ++length;
+    }
+    return length;
+}
+
+} // namespace
+
+// ---- ScanRecordView ----
+
+std::vector<cv::Point2f> ScanRecordView::view(int index) const {
+    if (landmarks == nullptr || index < 0 || index >= ScanArchiveLayout::kViewCount) {
+        return std::vector<cv::Point2f>();
+    }
+    const cv::Point2f* first = landmarks + index * ScanArchiveLayout::kLandmarkCount;
+    return std::vector<cv::Point2f>(first, first + ScanArchiveLayout::kLandmarkCount);
+}
+
+cv::Mat ScanRecordView::decodeMask() const {
+    cv::Mat quantized = MaskCodec::decode(mask, maskBytes, maskWidth, maskHeight);
+    if (quantized.empty()) {
+        return cv::Mat();
+    }
+    cv::Mat confidence;
+    quantized.convertTo(confidence, CV_32FC1, 1.0 / 255.0);
+    return confidence;
+}
+
+// ---- MaskCodec ----
+
+void MaskCodec::encode(const cv::Mat& mask, std::vector<uint8_t>& out) {
+    out.clear();
+    cv::Mat quantized;
+    if (mask.type() == CV_32FC1) {
+        mask.convertTo(quantized, CV_8UC1, 255.0);
+    } else if (mask.type() == CV_8UC1) {
+        quantized = mask.isContinuous() ? mask : mask.clone();
+    }
+    if (quantized.empty()) {
+        return;
+    }
+
+    const uint8_t* data = quantized.ptr<uint8_t>();
+    const size_t size = quantized.total();
+    // Person masks are mostly long runs; noisy masks grow the vector (at most size + size / 128)
+    out.reserve(size / 64 + 16);
+
+    size_t i = 0;
+    while (i < size) {
+        const size_t repeat = repeatLength(data, size, i);
+        if (repeat >= kMinRepeat) {
+            out.push_back(static_cast<uint8_t>(257 - repeat));
+            out.push_back(data[i]);
+            i += repeat;
+            continue;
+        }
+
+        // Literals up to the next repeat worth coding
+        const size_t start = i;
+        while (i < size && i - start < kMaxPackBitsRun && repeatLength(data, size, i) < kMinRepeat) {
+            ++i;
+        }
+        out.push_back(static_cast<uint8_t>(i - start - 1));
+        out.insert(out.end(), data + start, data + i);
+    }
+}
+
+cv::Mat MaskCodec::decode(const uint8_t* data, size_t size, int width, int height) {
+    if (data == nullptr || size == 0 || width <= 0 || height <= 0) {
+        return cv::Mat();
+    }
+    // No input byte expands to more than kMaxPackBitsRun pixels; a bigger size is corrupt
+    if (static_cast<uint64_t>(width) * static_cast<uint64_t>(height) > size * kMaxPackBitsRun) {
+        return cv::Mat();
+    }
+    cv::Mat mask(height, width, CV_8UC1);
+    uint8_t* out = mask.ptr<uint8_t>();
+    const size_t total = mask.total();
+
+    size_t written = 0;
+    size_t i = 0;
+    while (i < size) {
+        const uint8_t header = data[i++];
+        if (header < 128) {
+            const size_t length = static_cast<size_t>(header) + 1;
+            if (i + length > size || written + length > total) {
+                return cv::Mat();
+            }
+            std::memcpy(out + written, data + i, length);
+            i += length;
+            written += length;
+        } else if (header > 128) {
+            const size_t length = 257 - static_cast<size_t>(header);
+            if (i >= size || written + length > total) {
+                return cv::Mat();
+            }
+            std::memset(out + written, data[i++], length);
+            written += length;
+        }
+    }
+    return written == total ? mask : cv::Mat();
+}
+
+// ---- ScanArchiveWriter ----
+
+ScanArchiveWriter::~ScanArchiveWriter() {
+    close();
+}
+
+bool ScanArchiveWriter::open(const std::string& path) {
+    close();
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    position = 0;
+    offsets.clear();
+
+    // Zero header (no index) until close()
+    uint8_t header[ScanArchiveLayout::kFileHeaderBytes] = {};
+    if (!write(header, sizeof(header))) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    return true;
+}
+
+bool ScanArchiveWriter::append(const ScanRecordView& record) {
+    if (fd < 0 || record.landmarks == nullptr) {
+        return false;
+    }
+    const size_t maskBytes = record.mask != nullptr ? record.maskBytes : 0;
+    const size_t glbBytes = record.glb != nullptr ? record.glbBytes : 0;
+    const size_t glbOffset = align16(ScanArchiveLayout::kMaskOffset + maskBytes);
+    const size_t recordBytes = align16(glbOffset + glbBytes);
+    if (recordBytes > UINT32_MAX) {
+        return false;
+    }
+
+    staging.assign(recordBytes, 0);
+    uint8_t* data = staging.data();
+    const bool hasResults = record.keypoints3d != nullptr && record.measurements != nullptr;
+    store<uint32_t>(data, kRecordBytesOffset, static_cast<uint32_t>(recordBytes));
+    store<uint32_t>(data, kFlagsOffset, hasResults ? ScanArchiveLayout::kHasResults : 0);
+    store<uint64_t>(data, kScanIdOffset, record.scanId);
+    store<float>(data, kUserHeightOffset, record.userHeightCm);
+    store<uint32_t>(data, kFrontSizeOffset, static_cast<uint32_t>(std::max(0, record.frontWidth)));
+    store<uint32_t>(data, kFrontSizeOffset + 4, static_cast<uint32_t>(std::max(0, record.frontHeight)));
+    store<uint32_t>(data, kMaskSizeOffset, maskBytes > 0 ? static_cast<uint32_t>(std::max(0, record.maskWidth)) : 0);
+    store<uint32_t>(data, kMaskSizeOffset + 4, maskBytes > 0 ? static_cast<uint32_t>(std::max(0, record.maskHeight)) : 0);
+    store<uint32_t>(data, kMaskBytesOffset, static_cast<uint32_t>(maskBytes));
+    store<uint32_t>(data, kGlbBytesOffset, static_cast<uint32_t>(glbBytes));
+
+    std::memcpy(data + ScanArchiveLayout::kLandmarksOffset, record.landmarks, kLandmarkPoints * sizeof(cv::Point2f));
+    if (hasResults) {
+        std::memcpy(data + ScanArchiveLayout::kKeypoints3dOffset, record.keypoints3d,
+                    ScanArchiveLayout::kLandmarkCount * sizeof(cv::Point3f));
+        std::memcpy(data + ScanArchiveLayout::kMeasurementsOffset, record.measurements,
+                    kMeasurementCount * sizeof(float));
+    }
+    if (maskBytes > 0) {
+        std::memcpy(data + ScanArchiveLayout::kMaskOffset, record.mask, maskBytes);
+    }
+    if (glbBytes > 0) {
+        std::memcpy(data + glbOffset, record.glb, glbBytes);
+    }
+
+    const uint64_t offset = position;
+    if (!write(data, recordBytes)) {
+        return false;
+    }
+    offsets.push_back(offset);
+    return true;
+}
+
+bool ScanArchiveWriter::close() {
+    if (fd < 0) {
+        return false;
+    }
+    const uint64_t indexOffset = position;
+    bool ok = offsets.size() <= UINT32_MAX &&
+              write(offsets.data(), offsets.size() * sizeof(uint64_t));
+
+    if (ok) {
+        uint8_t header[ScanArchiveLayout::kFileHeaderBytes] = {};
+        store<uint32_t>(header, kMagicOffset, ScanArchiveLayout::kMagic);
+        store<uint32_t>(header, kVersionOffset, ScanArchiveLayout::kVersion);
+        store<uint32_t>(header, kRecordCountOffset, static_cast<uint32_t>(offsets.size()));
+        store<uint64_t>(header, kIndexOffsetOffset, indexOffset);
+        store<uint64_t>(header, kFileBytesOffset, position);
+        ok = ::pwrite(fd, header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+    }
+    ok = ::close(fd) == 0 && ok;
+    fd = -1;
+    return ok;
+}
+
+bool ScanArchiveWriter::write(const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    size_t written = 0;
+    while (written < size) {
+        const ssize_t n = ::write(fd, bytes + written, size - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        written += static_cast<size_t>(n);
+    }
+    position += size;
+    return true;
+}
+
+// ---- ScanArchiveReader ----
+
+ScanArchiveReader::~ScanArchiveReader() {
+    close();
+}
+
+bool ScanArchiveReader::open(const std::string& path) {
+    close();
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(ScanArchiveLayout::kFileHeaderBytes)) {
+        ::close(fd);
+        return false;
+    }
+    const size_t size = static_cast<size_t>(info.st_size);
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // The mapping keeps the file contents
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    // Workers read records front to back
+    ::madvise(mapping, size, MADV_SEQUENTIAL);
+
+    const uint8_t* header = static_cast<const uint8_t*>(mapping);
+    const uint64_t recordCount = load<uint32_t>(header, kRecordCountOffset);
+    const uint64_t index = load<uint64_t>(header, kIndexOffsetOffset);
+    const bool valid = load<uint32_t>(header, kMagicOffset) == ScanArchiveLayout::kMagic &&
+                       load<uint32_t>(header, kVersionOffset) == ScanArchiveLayout::kVersion &&
+                       load<uint64_t>(header, kFileBytesOffset) == size &&
+                       index >= ScanArchiveLayout::kFileHeaderBytes && index % sizeof(uint64_t) == 0 &&
+                       index + recordCount * sizeof(uint64_t) == size;
+    if (!valid) {
+        ::munmap(mapping, size);
+        return false;
+    }
+
+    data = header;
+    bytes = size;
+    count = static_cast<size_t>(recordCount);
+    indexOffset = index;
+    return true;
+}
+
+void ScanArchiveReader::close() {
+    if (data != nullptr) {
+        ::munmap(const_cast<uint8_t*>(data), bytes);
+    }
+    data = nullptr;
+    bytes = 0;
+    count = 0;
+    indexOffset = 0;
+}
+
+bool ScanArchiveReader::record(size_t index, ScanRecordView& record) const {
+    if (index >= count) {
+        return false;
+    }
+    const uint64_t offset = load<uint64_t>(data, indexOffset + index * sizeof(uint64_t));
+    if (offset < ScanArchiveLayout::kFileHeaderBytes || offset % 16 != 0 ||
+        offset + ScanArchiveLayout::kMaskOffset > indexOffset) {
+        return false;
+    }
+    const uint8_t* base = data + offset;
+    const size_t recordBytes = load<uint32_t>(base, kRecordBytesOffset);
+    const size_t maskBytes = load<uint32_t>(base, kMaskBytesOffset);
+    const size_t glbBytes = load<uint32_t>(base, kGlbBytesOffset);
+    const size_t glbOffset = align16(ScanArchiveLayout::kMaskOffset + maskBytes);
+    if (recordBytes > indexOffset - offset || glbOffset + glbBytes > recordBytes) {
+        return false;
+    }
+
+    const uint32_t flags = load<uint32_t>(base, kFlagsOffset);
+    record = ScanRecordView();
+    record.scanId = load<uint64_t>(base, kScanIdOffset);
+    record.userHeightCm = load<float>(base, kUserHeightOffset);
+    record.frontWidth = static_cast<int>(load<uint32_t>(base, kFrontSizeOffset));
+    record.frontHeight = static_cast<int>(load<uint32_t>(base, kFrontSizeOffset + 4));
+    record.landmarks = reinterpret_cast<const cv::Point2f*>(base + ScanArchiveLayout::kLandmarksOffset);
+    if ((flags & ScanArchiveLayout::kHasResults) != 0) {
+        record.keypoints3d = reinterpret_cast<const cv::Point3f*>(base + ScanArchiveLayout::kKeypoints3dOffset);
+        record.measurements = reinterpret_cast<const float*>(base + ScanArchiveLayout::kMeasurementsOffset);
+    }
+    if (maskBytes > 0) {
+        record.maskWidth = static_cast<int>(load<uint32_t>(base, kMaskSizeOffset));
+        record.maskHeight = static_cast<int>(load<uint32_t>(base, kMaskSizeOffset + 4));
+        record.mask = base + ScanArchiveLayout::kMaskOffset;
+        record.maskBytes = maskBytes;
+    }
+    if (glbBytes > 0) {
+        record.glb = base + glbOffset;
+        record.glbBytes = glbBytes;
+    }
+    return true;
+}
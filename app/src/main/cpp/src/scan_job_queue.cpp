@@ -0,0 +1,224 @@
+#include "scan_job_queue.h"
+#include "jni_registry.h"
+#include <android/log.h>
+#include <algorithm>
+#include <system_error>
+
+#define LOG_TAG "ScanJobQueue"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+// Defined in mediapipe_pose_detector.cpp
+extern JavaVM* g_jvm;
+
+namespace {
+
+// Local refs a job may hold at once on its worker (freed when it completes)
+constexpr jint kJobLocalRefs = 64;
+
+// A listener that throws must not take the worker down with it
+void clearListenerException(JNIEnv* env, uint64_t handle) {
+    if (env->ExceptionCheck()) {
+        env->ExceptionClear();
+        LOGE("Listener of scan %llu threw", static_cast<unsigned long long>(handle));
+    }
+}
+
+} // namespace
+
+void ScanJob::checkpoint(ScanStage stage) {
+    if (isCancelled()) {
+        throw ScanCancelled();
+    }
+
+    const JniRegistry& registry = JniRegistry::get();
+    if (env != nullptr && registry.scanCallbackProgress != nullptr) {
+        env->CallVoidMethod(callback, registry.scanCallbackProgress,
+                            static_cast<jlong>(jobHandle), static_cast<jint>(stage));
+        clearListenerException(env, jobHandle);
+    }
+
+    // The listener may have cancelled from onProgress
+    if (isCancelled()) {
+        throw ScanCancelled();
+    }
+}
+
+ScanJobQueue::~ScanJobQueue() {
+    stop();
+}
+
+uint64_t ScanJobQueue::submit(JNIEnv* env, jobject listener, Work work) {
+    if (listener == nullptr || !work) {
+        return 0;
+    }
+    jobject callback = env->NewGlobalRef(listener);
+    if (callback == nullptr) {
+        return 0;
+    }
+
+    uint64_t handle = 0;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!stopping && workers.empty()) {
+            try {
+                for (int i = 0; i < kWorkerCount; ++i) {
+                    workers.emplace_back(&ScanJobQueue::run, this);
+                }
+            } catch (const std::system_error&) {
+                LOGE("Started %zu of %d scan workers", workers.size(), kWorkerCount);
+            }
+            // Hand out no handle before a worker is known to be able to run it
+            workerReported.wait(lock, [this] { return reportedWorkers == workers.size(); });
+            if (attachedWorkers == 0) {
+                LOGE("No scan worker could attach");
+            }
+        }
+
+        if (!stopping && attachedWorkers > 0) {
+            auto job = std::make_shared<ScanJob>(++nextHandle, callback);
+            handle = job->handle();
+            jobs.emplace(handle, job);
+            queued.push_back(Entry{job, std::move(work)});
+        }
+    }
+
+    if (handle == 0) {
+        env->DeleteGlobalRef(callback);
+        return 0;
+    }
+    jobReady.notify_one();
+    return handle;
+}
+
+bool ScanJobQueue::cancel(uint64_t handle) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = jobs.find(handle);
+    if (it == jobs.end()) {
+        return false;
+    }
+    it->second->cancel();
+
+    // A queued job only needs its onCancelled call - move it to the front so
+    // the next free worker reports it instead of it waiting its turn
+    auto entry = std::find_if(queued.begin(), queued.end(),
+                              [handle](const Entry& e) { return e.job->handle() == handle; });
+    if (entry != queued.end() && entry != queued.begin()) {
+        std::rotate(queued.begin(), entry, entry + 1);
+    }
+    return true;
+}
+
+size_t ScanJobQueue::pending() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return jobs.size();
+}
+
+void ScanJobQueue::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    jobReady.notify_all();
+    for (std::thread& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers.clear();
+}
+
+void ScanJobQueue::run() {
+    JNIEnv* env = nullptr;
+    JavaVMAttachArgs args{JNI_VERSION_1_6, "BodyScanWorker", nullptr};
+    const bool attached =
+        g_jvm != nullptr && g_jvm->AttachCurrentThreadAsDaemon(&env, &args) == JNI_OK && env != nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        reportedWorkers++;
+        if (attached) {
+            attachedWorkers++;
+        }
+    }
+    workerReported.notify_all();
+    if (!attached) {
+        LOGE("Failed to attach scan worker thread");
+        return;
+    }
+
+    for (;;) {
+        Entry entry;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobReady.wait(lock, [this] { return !queued.empty() || stopping; });
+            if (queued.empty()) {
+                break;
+            }
+            entry = std::move(queued.front());
+            queued.pop_front();
+            // Jobs still queued at shutdown complete as cancelled
+            if (stopping) {
+                entry.job->cancel();
+            }
+        }
+
+        if (env->PushLocalFrame(kJobLocalRefs) == JNI_OK) {
+            execute(env, entry.job, entry.work);
+            env->PopLocalFrame(nullptr);
+        } else {
+            env->ExceptionClear();
+            LOGE("Out of local refs - scan %llu not run", static_cast<unsigned long long>(entry.job->handle()));
+            // Still complete it, so its caller is not left waiting
+            finish(env, *entry.job, nullptr, entry.job->isCancelled());
+        }
+
+        // Release the job's frames before waiting for the next one
+        entry.work = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.erase(entry.job->handle());
+        }
+        env->DeleteGlobalRef(entry.job->callback);
+    }
+
+    g_jvm->DetachCurrentThread();
+}
+
+void ScanJobQueue::execute(JNIEnv* env, const std::shared_ptr<ScanJob>& job, Work& work) {
+    const uint64_t handle = job->handle();
+
+    jobject result = nullptr;
+    bool cancelled = job->isCancelled();
+    if (!cancelled) {
+        job->env = env;
+        try {
+            result = work(env, *job);
+        } catch (const ScanCancelled&) {
+            cancelled = true;
+        } catch (...) {
+            LOGE("Scan %llu failed", static_cast<unsigned long long>(handle));
+            result = nullptr;
+        }
+        job->env = nullptr;
+        if (env->ExceptionCheck()) {
+            env->ExceptionClear();
+        }
+    }
+
+    // A cancel arriving during the last stage is too late: the result is complete
+    finish(env, *job, result, cancelled);
+}
+
+void ScanJobQueue::finish(JNIEnv* env, const ScanJob& job, jobject result, bool cancelled) {
+    const JniRegistry& registry = JniRegistry::get();
+    const uint64_t handle = job.handle();
+    if (cancelled) {
+        LOGI("Scan %llu cancelled", static_cast<unsigned long long>(handle));
+        if (registry.scanCallbackCancelled != nullptr) {
+            env->CallVoidMethod(job.callback, registry.scanCallbackCancelled, static_cast<jlong>(handle));
+        }
+    } else if (registry.scanCallbackComplete != nullptr) {
+        env->CallVoidMethod(job.callback, registry.scanCallbackComplete, static_cast<jlong>(handle), result);
+    }
+    clearListenerException(env, handle);
+}
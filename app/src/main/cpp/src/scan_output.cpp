@@ -0,0 +1,61 @@
+#include "scan_output.h"
+#include <algorithm>
+#include <cstring>
+
+static_assert(sizeof(cv::Point3f) == 3 * sizeof(float), "Point3f must be three packed floats");
+static_assert(sizeof(cv::Point2f) == 2 * sizeof(float), "Point2f must be two packed floats");
+
+ScanOutputWriter::ScanOutputWriter(uint8_t* data, size_t capacity)
+    : data(data), capacity(capacity) {}
+
+void ScanOutputWriter::reset() {
+    std::memset(data, 0, ScanOutputLayout::kMeshOffset);
+    writeU32(ScanOutputLayout::kMagicOffset, ScanOutputLayout::kMagic);
+    writeU32(ScanOutputLayout::kVersionOffset, ScanOutputLayout::kVersion);
+}
+
+ScanOutputStatus ScanOutputWriter::status() const {
+    int32_t status;
+    std::memcpy(&status, data + ScanOutputLayout::kStatusOffset, sizeof(status));
+    return static_cast<ScanOutputStatus>(status);
+}
+
+void ScanOutputWriter::setStatus(ScanOutputStatus status) {
+    writeU32(ScanOutputLayout::kStatusOffset, static_cast<uint32_t>(status));
+}
+
+void ScanOutputWriter::setMaskBytes(size_t bytes) {
+    writeU32(ScanOutputLayout::kMaskBytesOffset, static_cast<uint32_t>(bytes));
+}
+
+void ScanOutputWriter::setMeshBytes(size_t bytes) {
+    writeU32(ScanOutputLayout::kMeshBytesOffset, static_cast<uint32_t>(bytes));
+    if (bytes > meshCapacity()) {
+        setStatus(ScanOutputStatus::MeshTooLarge);
+    }
+}
+
+void ScanOutputWriter::setKeypoints3d(const cv::Point3f* points, size_t count) {
+    count = std::min(count, static_cast<size_t>(WireLayout::kCount));
+    std::memcpy(data + ScanOutputLayout::kKeypoints3dOffset, points, count * sizeof(cv::Point3f));
+}
+
+void ScanOutputWriter::setKeypoints2d(const cv::Point2f* points, size_t count) {
+    count = std::min(count, static_cast<size_t>(WireLayout::kCount));
+    std::memcpy(data + ScanOutputLayout::kKeypoints2dOffset, points, count * sizeof(cv::Point2f));
+}
+
+void ScanOutputWriter::setMeasurements(const float* values, size_t count) {
+    count = std::min(count, static_cast<size_t>(kMeasurementCount));
+    std::memcpy(data + ScanOutputLayout::kMeasurementsOffset, values, count * sizeof(float));
+}
+
+void ScanOutputWriter::setTimings(const ScanTimings& timings) {
+    float stageMs[kScanStageCount];
+    timings.toMillis(stageMs);
+    std::memcpy(data + ScanOutputLayout::kStageMsOffset, stageMs, sizeof(stageMs));
+}
+
+void ScanOutputWriter::writeU32(size_t offset, uint32_t value) {
+    std::memcpy(data + offset, &value, sizeof(value));
+}
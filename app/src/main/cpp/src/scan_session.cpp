@@ -0,0 +1,192 @@
+#include "scan_session.h"
+#include "image_preprocessor.h"
+#include "mediapipe_pose_detector.h"
+#include "pose_estimator.h"
+#include <android/log.h>
+
+#define LOG_TAG "ScanSession"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+// Defined in mediapipe_pose_detector.cpp
+extern JavaVM* g_jvm;
+
+ScanSession::~ScanSession() {
+    stop();
+}
+
+bool ScanSession::begin(JNIEnv* env) {
+    std::lock_guard<std::mutex> lifecycle(lifecycleMutex);
+    if (g_jvm == nullptr || !MediaPipePoseDetector::isReady(env)) {
+        LOGE("MediaPipe not ready - cannot begin scan");
+        return false;
+    }
+
+    bool startWorker;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        generation++;
+        slots = std::array<Slot, kViewCount>();
+        timings = std::make_shared<ScanTimings>();
+        open = true;
+        startWorker = !running;
+        running = true;
+    }
+    viewDone.notify_all();  // A finish() of the dropped scan returns false
+
+    if (startWorker) {
+        // A worker that failed to attach has already exited
+        if (worker.joinable()) {
+            worker.join();
+        }
+        worker = std::thread(&ScanSession::run, this);
+    }
+    return true;
+}
+
+bool ScanSession::addView(int index, cv::Mat frame) {
+    if (index < 0 || index >= kViewCount || frame.empty()) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!open) {
+            return false;
+        }
+        Slot& slot = slots[index];
+        slot.added = true;
+        slot.queued = true;
+        slot.ready = false;
+        slot.take++;
+        slot.frame = std::move(frame);
+        slot.view = View();
+    }
+    viewQueued.notify_one();
+    return true;
+}
+
+bool ScanSession::finish(std::array<View, kViewCount>& views, std::shared_ptr<ScanTimings>& timingsOut) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!open) {
+        return false;
+    }
+    for (const Slot& slot : slots) {
+        if (!slot.added) {
+            open = false;
+            LOGE("Scan finished with a view missing");
+            return false;
+        }
+    }
+
+    const uint64_t scan = generation;
+    viewDone.wait(lock, [this, scan] {
+        if (!running || generation != scan) {
+            return true;
+        }
+        for (const Slot& slot : slots) {
+            if (!slot.ready) {
+                return false;
+            }
+        }
+        return true;
+    });
+    if (!running || generation != scan) {
+        return false;
+    }
+
+    for (int i = 0; i < kViewCount; ++i) {
+        views[i] = std::move(slots[i].view);
+    }
+    timingsOut = std::move(timings);
+    open = false;
+    return true;
+}
+
+void ScanSession::stop() {
+    std::lock_guard<std::mutex> lifecycle(lifecycleMutex);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+        open = false;
+    }
+    viewQueued.notify_all();
+    viewDone.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+bool ScanSession::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return open;
+}
+
+void ScanSession::run() {
+    JNIEnv* env = nullptr;
+    JavaVMAttachArgs args{JNI_VERSION_1_6, "BodyScanSession", nullptr};
+    if (g_jvm->AttachCurrentThreadAsDaemon(&env, &args) != JNI_OK || env == nullptr) {
+        LOGE("Failed to attach scan session worker thread");
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+        open = false;
+        viewDone.notify_all();
+        return;
+    }
+
+    for (;;) {
+        int index = -1;
+        uint64_t scan;
+        uint64_t take;
+        cv::Mat frame;
+        std::shared_ptr<ScanTimings> scanTimings;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            // Views are taken in index order, which is also capture order
+            auto nextQueued = [this] {
+                for (int i = 0; i < kViewCount; ++i) {
+                    if (slots[i].queued) {
+                        return i;
+                    }
+                }
+                return -1;
+            };
+            viewQueued.wait(lock, [&] { return !running || nextQueued() >= 0; });
+            if (!running) {
+                break;
+            }
+            index = nextQueued();
+            Slot& slot = slots[index];
+            slot.queued = false;
+            scan = generation;
+            take = slot.take;
+            frame = std::move(slot.frame);
+            scanTimings = timings;
+        }
+
+        View view;
+        try {
+            ScanTimings::Scope timingScope(scanTimings.get());
+            ImagePreprocessor::run(frame);
+            view.image = std::move(frame);
+            // Only the front view's mask is used (measurements), so the others skip its readback
+            view.keypoints = index == 0 ? PoseEstimator::detect(view.image, view.mask)
+                                        : PoseEstimator::detect(view.image);
+        } catch (...) {
+            // Keep the slot usable: an undetected view triangulates to nothing
+            LOGE("View %d failed", index);
+            view.keypoints.clear();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Slot& slot = slots[index];
+            if (generation == scan && slot.take == take) {
+                slot.view = std::move(view);
+                slot.ready = true;
+            }
+        }
+        viewDone.notify_all();
+    }
+
+    g_jvm->DetachCurrentThread();
+}
@@ -0,0 +1,64 @@
+#include "scan_trace.h"
+
+#ifdef __ANDROID__
+#include <android/trace.h>
+#endif
+
+namespace {
+
+thread_local ScanTimings* activeTimings = nullptr;
+
+const char* const kStageNames[kScanStageCount] = {
+    "bodyscan:Decode",
+    "bodyscan:Preprocess",
+    "bodyscan:Inference",
+    "bodyscan:Triangulation",
+    "bodyscan:MeshBuild",
+    "bodyscan:GlbSerialize",
+    "bodyscan:Measurement",
+    "bodyscan:Pack",
+};
+
+} // namespace
+
+void ScanTimings::toMillis(float* out) const {
+    for (int i = 0; i < kScanStageCount; ++i) {
+        out[i] = static_cast<float>(stageNanos[i].load(std::memory_order_relaxed) / 1.0e6);
+    }
+}
+
+ScanTimings::Scope::Scope(ScanTimings* timings) : previous(activeTimings) {
+    activeTimings = timings;
+}
+
+ScanTimings::Scope::~Scope() {
+    activeTimings = previous;
+}
+
+ScanTimings* ScanTimings::current() {
+    return activeTimings;
+}
+
+ScopedTimer::ScopedTimer(ScanStage stage) : stage(stage), timings(activeTimings) {
+#ifdef __ANDROID__
+    ATrace_beginSection(scanStageName(stage));
+#endif
+    if (timings != nullptr) {
+        start = std::chrono::steady_clock::now();
+    }
+}
+
+ScopedTimer::~ScopedTimer() {
+    if (timings != nullptr) {
+        timings->add(stage, std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+#ifdef __ANDROID__
+    ATrace_endSection();
+#endif
+}
+
+const char* scanStageName(ScanStage stage) {
+    const int index = static_cast<int>(stage);
+    return index >= 0 && index < kScanStageCount ? kStageNames[index] : "bodyscan:Unknown";
+}
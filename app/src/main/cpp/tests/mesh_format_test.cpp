@@ -0,0 +1,393 @@
+/**
+ * Structure of the GLB MeshGenerator writes in each MeshFormat, read back
+ * the way a viewer would: GLB header and chunks, the glTF JSON, and the
+ * BIN chunk through the accessors. The Compact (KHR_mesh_quantization) mesh
+ * must dequantize, through its node transform, to the Float32 mesh.
+ *
+ *   ./mesh_format_test
+ */
+#include "fixtures.h"
+#include "keypoint_schema.h"
+#include "mesh_generator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition)                                                            \
+    do {                                                                            \
+        if (!(condition)) {                                                         \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                             \
+        }                                                                           \
+    } while (0)
+
+// ---- Minimal JSON reader (the subset glTF uses) ----
+
+struct Json {
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<Json> array;
+    std::map<std::string, Json> object;
+
+    const Json& operator[](const std::string& key) const {
+        static const Json kNull;
+        auto it = object.find(key);
+        return it != object.end() ? it->second : kNull;
+    }
+
+    const Json& operator[](size_t index) const {
+        static const Json kNull;
+        return index < array.size() ? array[index] : kNull;
+    }
+
+    bool has(const std::string& key) const { return object.count(key) != 0; }
+};
+
+class JsonParser {
+public:
+    JsonParser(const char* begin, const char* end) : pos(begin), end(end) {}
+
+    bool parse(Json& value) {
+        if (!parseValue(value)) {
+            return false;
+        }
+        skipSpace();
+        return pos == end;
+    }
+
+private:
+    void skipSpace() {
+        while (pos < end && (*pos == ' ' || *pos == '\n' || *pos == '\r' || *pos == '\t')) {
+            ++pos;
+        }
+    }
+
+    bool consume(const char* literal) {
+        const size_t length = std::strlen(literal);
+        if (static_cast<size_t>(end - pos) < length || std::strncmp(pos, literal, length) != 0) {
+            return false;
+        }
+        pos += length;
+        return true;
+    }
+
+    bool parseString(std::string& out) {
+        if (pos >= end || *pos != '"') {
+            return false;
+        }
+        ++pos;
+        out.clear();
+        while (pos < end && *pos != '"') {
+            if (*pos == '\\') {
+                return false;  // MeshGenerator never escapes
+            }
+            out.push_back(*pos++);
+        }
+        if (pos >= end) {
+            return false;
+        }
+        ++pos;
+        return true;
+    }
+
+    bool parseValue(Json& value) {
+        skipSpace();
+        if (pos >= end) {
+            return false;
+        }
+        if (*pos == '{') {
+            ++pos;
+            value.type = Json::Type::Object;
+            skipSpace();
+            if (pos < end && *pos == '}') {
+                ++pos;
+                return true;
+            }
+            for (;;) {
+                skipSpace();
+                std::string key;
+                if (!parseString(key)) {
+                    return false;
+                }
+                skipSpace();
+                if (!consume(":") || !parseValue(value.object[key])) {
+                    return false;
+                }
+                skipSpace();
+                if (consume("}")) {
+                    return true;
+                }
+                if (!consume(",")) {
+                    return false;
+                }
+            }
+        }
+        if (*pos == '[') {
+            ++pos;
+            value.type = Json::Type::Array;
+            skipSpace();
+            if (pos < end && *pos == ']') {
+                ++pos;
+                return true;
+            }
+            for (;;) {
+                value.array.emplace_back();
+                if (!parseValue(value.array.back())) {
+                    return false;
+                }
+                skipSpace();
+                if (consume("]")) {
+                    return true;
+                }
+                if (!consume(",")) {
+                    return false;
+                }
+            }
+        }
+        if (*pos == '"') {
+            value.type = Json::Type::String;
+            return parseString(value.string);
+        }
+        if (consume("true")) {
+            value.type = Json::Type::Bool;
+            value.boolean = true;
+            return true;
+        }
+        if (consume("false")) {
+            value.type = Json::Type::Bool;
+            return true;
+        }
+        if (consume("null")) {
+            return true;
+        }
+        const std::string rest(pos, std::min<size_t>(end - pos, 64));
+        char* numberEnd = nullptr;
+        value.number = std::strtod(rest.c_str(), &numberEnd);
+        if (numberEnd == rest.c_str()) {
+            return false;
+        }
+        value.type = Json::Type::Number;
+        pos += numberEnd - rest.c_str();
+        return true;
+    }
+
+    const char* pos;
+    const char* end;
+};
+
+// ---- GLB container ----
+
+constexpr uint32_t kGlbMagic = 0x46546C67;     // "glTF"
+constexpr uint32_t kChunkJson = 0x4E4F534A;    // "JSON"
+constexpr uint32_t kChunkBin = 0x004E4942;     // "BIN\0"
+
+// glTF componentType values
+constexpr int kByte = 5120;
+constexpr int kShort = 5122;
+constexpr int kUnsignedShort = 5123;
+constexpr int kUnsignedInt = 5125;
+constexpr int kFloat = 5126;
+
+uint32_t readU32(const uint8_t* data) {
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+struct Glb {
+    Json json;
+    const uint8_t* bin = nullptr;
+    size_t binLength = 0;
+};
+
+// Check the header and both chunk headers, then parse the JSON chunk
+bool readGlb(const std::vector<uint8_t>& bytes, Glb& glb) {
+    CHECK(bytes.size() >= 28);
+    if (bytes.size() < 28) {
+        return false;
+    }
+    CHECK(readU32(&bytes[0]) == kGlbMagic);
+    CHECK(readU32(&bytes[4]) == 2);
+    CHECK(readU32(&bytes[8]) == bytes.size());
+
+    const size_t jsonLength = readU32(&bytes[12]);
+    CHECK(readU32(&bytes[16]) == kChunkJson);
+    CHECK(jsonLength % 4 == 0);
+    const size_t binHeader = 20 + jsonLength;
+    CHECK(binHeader + 8 <= bytes.size());
+    if (binHeader + 8 > bytes.size()) {
+        return false;
+    }
+    glb.binLength = readU32(&bytes[binHeader]);
+    CHECK(readU32(&bytes[binHeader + 4]) == kChunkBin);
+    CHECK(glb.binLength % 4 == 0);
+    CHECK(binHeader + 8 + glb.binLength == bytes.size());
+    glb.bin = &bytes[binHeader + 8];
+
+    // The JSON chunk is padded with spaces, which the parser skips
+    const char* json = reinterpret_cast<const char*>(&bytes[20]);
+    const bool parsed = JsonParser(json, json + jsonLength).parse(glb.json);
+    CHECK(parsed);
+    return parsed && failures == 0;
+}
+
+bool listsExtension(const Json& list, const char* name) {
+    for (const Json& entry : list.array) {
+        if (entry.string == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Read the POSITION accessor of a mesh in either format as float cm,
+// applying the node's dequantization transform when the mesh has one
+std::vector<float> readPositions(const Glb& glb) {
+    const Json& accessor = glb.json["accessors"][0];
+    const Json& view = glb.json["bufferViews"][static_cast<size_t>(accessor["bufferView"].number)];
+    const Json& node = glb.json["nodes"][0];
+    const size_t count = static_cast<size_t>(accessor["count"].number);
+    const size_t stride = static_cast<size_t>(view["byteStride"].number);
+    const size_t offset = static_cast<size_t>(view["byteOffset"].number + accessor["byteOffset"].number);
+    const bool quantized = static_cast<int>(accessor["componentType"].number) == kShort;
+
+    std::vector<float> positions;
+    if (offset + count * stride > glb.binLength) {
+        CHECK(offset + count * stride <= glb.binLength);
+        return positions;
+    }
+    positions.reserve(count * 3);
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t* vertex = glb.bin + offset + i * stride;
+        for (int axis = 0; axis < 3; ++axis) {
+            if (quantized) {
+                int16_t stored;
+                std::memcpy(&stored, vertex + axis * sizeof(int16_t), sizeof(stored));
+                positions.push_back(static_cast<float>(stored * node["scale"][axis].number +
+                                                       node["translation"][axis].number));
+            } else {
+                float stored;
+                std::memcpy(&stored, vertex + axis * sizeof(float), sizeof(stored));
+                positions.push_back(stored);
+            }
+        }
+    }
+    return positions;
+}
+
+std::vector<cv::Point3f> body25Keypoints() {
+    const std::vector<cv::Point3f> kpts3d = syntheticScanFixture().keypoints3d;
+    return mapToBody25(KeypointSet<PipelineLayout>::fromPoints(kpts3d.data(), kpts3d.size())).toVector();
+}
+
+// ---- Tests ----
+
+void testFloat32Layout(const Glb& glb) {
+    const Json& json = glb.json;
+    CHECK(!json.has("extensionsUsed"));
+    CHECK(!json.has("extensionsRequired"));
+    CHECK(!json["nodes"][0].has("scale"));
+    CHECK(json["bufferViews"][0]["byteStride"].number == 24);
+    CHECK(json["accessors"][0]["componentType"].number == kFloat);
+    CHECK(json["accessors"][1]["componentType"].number == kFloat);
+    CHECK(json["accessors"][2]["componentType"].number == kUnsignedInt);
+}
+
+void testCompactLayout(const Glb& glb) {
+    const Json& json = glb.json;
+    CHECK(listsExtension(json["extensionsUsed"], "KHR_mesh_quantization"));
+    CHECK(listsExtension(json["extensionsRequired"], "KHR_mesh_quantization"));
+
+    // int16 xyz padded to 8 bytes, then int8 xyz padded to 4
+    CHECK(json["bufferViews"][0]["byteStride"].number == 12);
+
+    const Json& position = json["accessors"][0];
+    const Json& normal = json["accessors"][1];
+    const Json& indices = json["accessors"][2];
+    CHECK(position["componentType"].number == kShort);
+    CHECK(!position["normalized"].boolean);
+    CHECK(normal["componentType"].number == kByte);
+    CHECK(normal["normalized"].boolean);
+    CHECK(normal["byteOffset"].number == 8);
+    const size_t vertexCount = static_cast<size_t>(position["count"].number);
+    CHECK(indices["componentType"].number == (vertexCount < 65535 ? kUnsignedShort : kUnsignedInt));
+
+    // Dequantization: one uniform scale (keeps normals valid) and a translation
+    const Json& node = json["nodes"][0];
+    CHECK(node["scale"].array.size() == 3);
+    CHECK(node["translation"].array.size() == 3);
+    const double scale = node["scale"][0].number;
+    CHECK(scale > 0.0);
+    CHECK(node["scale"][1].number == scale && node["scale"][2].number == scale);
+
+    // The quantized bounds use the whole int16 range on the longest axis
+    bool fullRange = false;
+    for (size_t axis = 0; axis < 3; ++axis) {
+        CHECK(position["min"][axis].number >= -32767 && position["max"][axis].number <= 32767);
+        fullRange = fullRange || (position["min"][axis].number == -32767 && position["max"][axis].number == 32767);
+    }
+    CHECK(fullRange);
+}
+
+void testCompactDequantizesToFloat32(const Glb& compact, const Glb& float32) {
+    const std::vector<float> quantized = readPositions(compact);
+    const std::vector<float> exact = readPositions(float32);
+    CHECK(!exact.empty());
+    CHECK(quantized.size() == exact.size());
+    if (quantized.size() != exact.size()) {
+        return;
+    }
+
+    // Rounding to the nearest step is off by at most half a step (plus the
+    // printed precision of the transform)
+    const double tolerance = compact.json["nodes"][0]["scale"][0].number * 0.5 + 1e-4;
+    size_t outliers = 0;
+    for (size_t i = 0; i < exact.size(); ++i) {
+        if (std::fabs(quantized[i] - exact[i]) > tolerance) {
+            outliers++;
+        }
+    }
+    CHECK(outliers == 0);
+}
+
+} // namespace
+
+int main() {
+    const std::vector<cv::Point3f> body25 = body25Keypoints();
+    const std::vector<uint8_t> compactBytes =
+        MeshGenerator::createFromKeypoints(body25, MeshLod::Standard, MeshFormat::Compact);
+    const std::vector<uint8_t> float32Bytes =
+        MeshGenerator::createFromKeypoints(body25, MeshLod::Standard, MeshFormat::Float32);
+    CHECK(!compactBytes.empty());
+    CHECK(!float32Bytes.empty());
+    CHECK(compactBytes.size() < float32Bytes.size());
+
+    Glb compact;
+    Glb float32;
+    if (readGlb(compactBytes, compact) && readGlb(float32Bytes, float32)) {
+        testFloat32Layout(float32);
+        testCompactLayout(compact);
+        testCompactDequantizesToFloat32(compact, float32);
+    }
+
+    if (failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("mesh_format_test: OK\n");
+    return 0;
+}
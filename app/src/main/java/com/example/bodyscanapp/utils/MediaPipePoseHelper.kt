@@ -23,6 +23,13 @@ object MediaPipePoseHelper {
     private var poseLandmarker: PoseLandmarker? = null
     private var isInitialized = false
     
+    // Second landmarker in VIDEO mode for the streaming preview. It tracks the
+    // pose from the previous frame's landmarks instead of re-running the person
+    // detector on every frame, and produces no segmentation masks.
+    private var videoLandmarker: PoseLandmarker? = null
+    private var appContext: Context? = null
+    private var modelPath: String? = null
+    
     /**
      * Initialize MediaPipe Pose Landmarker with the model from assets.
      * The model file should be placed in assets/pose_landmarker.task
@@ -71,20 +78,12 @@ object MediaPipePoseHelper {
                 return false
             }
             
-            val baseOptions = BaseOptions.builder()
-                .setModelAssetPath(modelPath)
-                .build()
-            
-            val options = PoseLandmarker.PoseLandmarkerOptions.builder()
-                .setBaseOptions(baseOptions)
-                .setRunningMode(RunningMode.IMAGE)
-                .setMinPoseDetectionConfidence(0.5f)
-                .setMinPosePresenceConfidence(0.5f)
-                .setMinTrackingConfidence(0.5f)
-                .setOutputSegmentationMasks(true) // Enable segmentation masks for pixel-level measurements
-                .build()
+            // Enable segmentation masks for pixel-level measurements
+            val options = buildOptions(modelPath, RunningMode.IMAGE, outputMasks = true)
             
             poseLandmarker = PoseLandmarker.createFromOptions(context, options)
+            appContext = context.applicationContext
+            this.modelPath = modelPath
             isInitialized = true
             android.util.Log.i("MediaPipePoseHelper", "MediaPipe Pose Landmarker initialized successfully")
             true
@@ -104,6 +103,82 @@ object MediaPipePoseHelper {
         }
     }
     
+    private fun buildOptions(
+        modelPath: String,
+        runningMode: RunningMode,
+        outputMasks: Boolean
+    ): PoseLandmarker.PoseLandmarkerOptions {
+        val baseOptions = BaseOptions.builder()
+            .setModelAssetPath(modelPath)
+            .build()
+        
+        return PoseLandmarker.PoseLandmarkerOptions.builder()
+            .setBaseOptions(baseOptions)
+            .setRunningMode(runningMode)
+            .setMinPoseDetectionConfidence(0.5f)
+            .setMinPosePresenceConfidence(0.5f)
+            .setMinTrackingConfidence(0.5f)
+            .setOutputSegmentationMasks(outputMasks)
+            .build()
+    }
+    
+    /**
+     * Create the VIDEO-mode landmarker used by detectPoseForVideo.
+     * Requires initialize() to have succeeded; calling it again is a no-op.
+     * 
+     * @return true if the video landmarker is ready
+     */
+    @JvmStatic
+    fun startVideoTracking(): Boolean {
+        if (videoLandmarker != null) {
+            return true
+        }
+        val context = appContext ?: return false
+        val path = modelPath ?: return false
+        
+        return try {
+            videoLandmarker = PoseLandmarker.createFromOptions(
+                context, buildOptions(path, RunningMode.VIDEO, outputMasks = false))
+            true
+        } catch (e: Exception) {
+            android.util.Log.e("MediaPipePoseHelper", "Failed to create video landmarker", e)
+            false
+        }
+    }
+    
+    /**
+     * Detect pose landmarks in one frame of a stream, tracking from the frame before.
+     * 
+     * @param bitmap Input frame bitmap (must be ARGB_8888 format)
+     * @param timestampMs Frame timestamp; must increase from call to call
+     * @return PoseLandmarkerResult (no segmentation masks) or null if detection fails
+     */
+    @JvmStatic
+    fun detectPoseForVideo(bitmap: Bitmap, timestampMs: Long): PoseLandmarkerResult? {
+        val landmarker = videoLandmarker ?: return null
+        
+        return try {
+            val mpImage = BitmapImageBuilder(bitmap).build()
+            landmarker.detectForVideo(mpImage, timestampMs)
+        } catch (e: Exception) {
+            e.printStackTrace()
+            null
+        }
+    }
+    
+    /**
+     * Close the VIDEO-mode landmarker.
+     */
+    @JvmStatic
+    fun stopVideoTracking() {
+        try {
+            videoLandmarker?.close()
+        } catch (e: Exception) {
+            e.printStackTrace()
+        }
+        videoLandmarker = null
+    }
+    
     /**
      * Detect pose landmarks from a bitmap image.
      * 
@@ -161,6 +236,37 @@ object MediaPipePoseHelper {
         return output
     }
     
+    /**
+     * Extract the visibility score of each of the 33 landmarks of the first pose.
+     * Landmarks without a reported visibility are treated as visible (1.0).
+     * 
+     * @param result PoseLandmarkerResult from detection
+     * @return FloatArray of 33 visibility scores (0-1), or null if no pose detected
+     */
+    @JvmStatic
+    fun extractLandmarkVisibility(result: PoseLandmarkerResult?): FloatArray? {
+        if (result == null) {
+            return null
+        }
+        
+        val landmarks = result.landmarks()
+        if (landmarks.isEmpty()) {
+            return null
+        }
+        
+        val pose = landmarks[0]
+        if (pose.size < 33) {
+            return null
+        }
+        
+        val output = FloatArray(33)
+        for (i in 0 until 33) {
+            output[i] = pose[i].visibility().orElse(1.0f)
+        }
+        
+        return output
+    }
+    
     /**
      * Count the number of detected poses in a PoseLandmarkerResult.
      * 
@@ -237,6 +343,35 @@ object MediaPipePoseHelper {
         return maskData
     }
     
+    /**
+     * Get the first segmentation mask's own buffer so native code can wrap it
+     * without copying. The buffer holds width * height native-order floats
+     * starting at position 0 and must be treated as read-only.
+     * 
+     * @param result PoseLandmarkerResult from detection
+     * @return Direct ByteBuffer of mask data, or null if no mask or the buffer
+     *         is not direct (use extractSegmentationMaskData instead)
+     */
+    @JvmStatic
+    fun extractSegmentationMaskBuffer(result: PoseLandmarkerResult?): ByteBuffer? {
+        if (result == null) {
+            return null
+        }
+        
+        val masksOpt = result.segmentationMasks()
+        if (!masksOpt.isPresent || masksOpt.get().isEmpty()) {
+            return null
+        }
+        
+        return try {
+            val byteBuffer = ByteBufferExtractor.extract(masksOpt.get()[0])
+            if (byteBuffer.isDirect && byteBuffer.position() == 0) byteBuffer else null
+        } catch (e: Exception) {
+            android.util.Log.e("MediaPipePoseHelper", "Error extracting segmentation mask buffer: ${e.message}", e)
+            null
+        }
+    }
+    
     /**
      * Get segmentation mask width from PoseLandmarkerResult.
      * 
@@ -288,6 +423,7 @@ object MediaPipePoseHelper {
      */
     @JvmStatic
     fun release() {
+        stopVideoTracking()
         try {
             poseLandmarker?.close()
             poseLandmarker = null
@@ -1,19 +1,28 @@
 package com.example.bodyscanapp.utils
 
+import android.hardware.HardwareBuffer
+import android.os.Build
 import androidx.annotation.Keep
+import androidx.annotation.RequiresApi
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
 
 object NativeBridge {
     init { 
         System.loadLibrary("bodyscan") 
     }
 
+    // @JvmOverloads keeps the shorter constructors for Kotlin/Java callers; native code uses the full one
     @Keep
-    data class ScanResult(
+    data class ScanResult @JvmOverloads constructor(
         val keypoints3d: FloatArray,   // 135*3 (empty for single image)
         val meshGlb: ByteArray,        // GLB binary (empty for single image)
         val measurements: FloatArray,  // e.g. waist, chest, hips, …
-        val keypoints2d: FloatArray? = null  // 135*2 normalized (x, y) coordinates
+        val keypoints2d: FloatArray? = null,  // 135*2 normalized (x, y) coordinates
+        val timings: ScanTimings? = null      // Set by the native scan entry points
     ) {
+        // timings is diagnostics and differs between runs, so it is left out of
+        // equals/hashCode
         override fun equals(other: Any?): Boolean {
             if (this === other) return true
             if (javaClass != other?.javaClass) return false
@@ -39,6 +48,179 @@ object NativeBridge {
         }
     }
 
+    /**
+     * Pipeline stages reported in ScanTimings.stageMs. Ordinals must match the
+     * C++ ScanStage enum.
+     */
+    enum class ScanStage {
+        DECODE,         // Frame ingestion (byte[] copy or pin, buffer wrap, HardwareBuffer lock)
+        PREPROCESS,     // Resize, color conversion and CLAHE
+        INFERENCE,      // MediaPipe pose landmarker, including bitmap upload and readback
+        TRIANGULATION,
+        MESH_BUILD,
+        GLB_SERIALIZE,
+        MEASUREMENT,
+        PACK            // Copying results into Java arrays
+    }
+
+    /**
+     * Where the time of one scan went, for telemetry. Each stage sums every
+     * run of it (e.g. preprocessing of all three views), and stages that run
+     * on worker threads overlap, so the total can exceed the scan's wall time.
+     * Stages also appear as "bodyscan:<Stage>" sections in systrace/Perfetto.
+     */
+    @Keep
+    data class ScanTimings(
+        val stageMs: FloatArray,  // Indexed by ScanStage.ordinal
+        val meshBytes: Int,       // Size of the GLB (0 for single image)
+        val maskBytes: Int        // Size of the segmentation mask read back from MediaPipe
+    ) {
+        operator fun get(stage: ScanStage): Float = stageMs.getOrElse(stage.ordinal) { 0f }
+
+        override fun equals(other: Any?): Boolean {
+            if (this === other) return true
+            if (javaClass != other?.javaClass) return false
+
+            other as ScanTimings
+
+            return stageMs.contentEquals(other.stageMs) &&
+                meshBytes == other.meshBytes &&
+                maskBytes == other.maskBytes
+        }
+
+        override fun hashCode(): Int {
+            var result = stageMs.contentHashCode()
+            result = 31 * result + meshBytes
+            result = 31 * result + maskBytes
+            return result
+        }
+    }
+
+    /**
+     * One scan result filled in place by the native side, for callers that
+     * scan at a high rate: reuse one ScanOutput across scans and no Java
+     * arrays are allocated per scan. The sections hold the same values as the
+     * ScanResult arrays. Layout (native byte order) - must match the C++
+     * ScanOutputLayout in scan_output.h:
+     *
+     *   0     int magic "BSO1", 4 int version, 8 int status, 12 int meshBytes,
+     *         16 int maskBytes, 20-31 reserved
+     *   32    float[8] stage times in ms, indexed by ScanStage.ordinal
+     *   64    float[135 * 3] keypoints3d
+     *   1684  float[135 * 2] keypoints2d
+     *   2764  float[8] measurements
+     *   2800  GLB bytes, up to the end of the buffer
+     *
+     * The accessors read the buffer with absolute gets, so they neither move
+     * its position nor allocate (except mesh(), which returns a view).
+     */
+    class ScanOutput(val buffer: ByteBuffer) {
+        /**
+         * Outcome of the last scan. Ordinals must match the C++
+         * ScanOutputStatus enum.
+         */
+        enum class Status {
+            OK,
+            INVALID_INPUT,   // Frames missing or of the wrong size; all sections zero
+            FAILED,          // Processing failed; all sections zero
+            MESH_TOO_LARGE   // Everything but the mesh was written; meshBytes is the size needed
+        }
+
+        init {
+            require(buffer.isDirect) { "buffer must be a direct ByteBuffer" }
+            require(buffer.capacity() >= MIN_CAPACITY) { "buffer must hold at least $MIN_CAPACITY bytes" }
+            buffer.order(ByteOrder.nativeOrder())
+        }
+
+        // False until a scan has been written into the buffer
+        val isWritten: Boolean
+            get() = buffer.getInt(MAGIC_OFFSET) == MAGIC && buffer.getInt(VERSION_OFFSET) == VERSION
+
+        val status: Status
+            get() = statusOf(buffer.getInt(STATUS_OFFSET))
+
+        // GLB size; larger than meshCapacity with MESH_TOO_LARGE (0 for single image)
+        val meshBytes: Int
+            get() = buffer.getInt(MESH_BYTES_OFFSET)
+
+        val maskBytes: Int
+            get() = buffer.getInt(MASK_BYTES_OFFSET)
+
+        val meshCapacity: Int
+            get() = buffer.capacity() - MESH_OFFSET
+
+        fun stageMs(stage: ScanStage): Float = buffer.getFloat(STAGE_MS_OFFSET + stage.ordinal * 4)
+
+        fun measurement(index: Int): Float {
+            require(index in 0 until MEASUREMENT_COUNT) { "measurement index out of range: $index" }
+            return buffer.getFloat(MEASUREMENTS_OFFSET + index * 4)
+        }
+
+        // Copy the sections into caller-owned arrays (reusable across scans)
+        fun keypoints3d(out: FloatArray = FloatArray(KEYPOINTS_3D_FLOATS)): FloatArray =
+            readFloats(KEYPOINTS_3D_OFFSET, KEYPOINTS_3D_FLOATS, out)
+
+        fun keypoints2d(out: FloatArray = FloatArray(KEYPOINTS_2D_FLOATS)): FloatArray =
+            readFloats(KEYPOINTS_2D_OFFSET, KEYPOINTS_2D_FLOATS, out)
+
+        fun measurements(out: FloatArray = FloatArray(MEASUREMENT_COUNT)): FloatArray =
+            readFloats(MEASUREMENTS_OFFSET, MEASUREMENT_COUNT, out)
+
+        // Read-only view of the GLB bytes; empty unless the mesh was written
+        fun mesh(): ByteBuffer {
+            val size = if (status == Status.OK) meshBytes.coerceIn(0, meshCapacity) else 0
+            val view = buffer.duplicate()
+            view.position(MESH_OFFSET).limit(MESH_OFFSET + size)
+            return view.slice().asReadOnlyBuffer()
+        }
+
+        private fun readFloats(offset: Int, count: Int, out: FloatArray): FloatArray {
+            require(out.size >= count) { "out must hold $count floats" }
+            for (i in 0 until count) {
+                out[i] = buffer.getFloat(offset + i * 4)
+            }
+            return out
+        }
+
+        companion object {
+            const val MAGIC = 0x314F5342  // "BSO1" in little endian
+            const val VERSION = 1
+
+            const val MAGIC_OFFSET = 0
+            const val VERSION_OFFSET = 4
+            const val STATUS_OFFSET = 8
+            const val MESH_BYTES_OFFSET = 12
+            const val MASK_BYTES_OFFSET = 16
+            const val STAGE_MS_OFFSET = 32
+            const val KEYPOINTS_3D_OFFSET = 64
+            const val KEYPOINTS_2D_OFFSET = 1684
+            const val MEASUREMENTS_OFFSET = 2764
+            const val MESH_OFFSET = 2800
+
+            const val KEYPOINTS_3D_FLOATS = 135 * 3
+            const val KEYPOINTS_2D_FLOATS = 135 * 2
+            const val MEASUREMENT_COUNT = 8
+
+            // Holds everything but the mesh (enough for single-image scans)
+            const val MIN_CAPACITY = MESH_OFFSET
+
+            // Mesh room of allocate() - a STANDARD float32 body mesh fits
+            const val DEFAULT_MESH_CAPACITY = 1 shl 20
+
+            private val STATUSES = Status.values()
+
+            internal fun statusOf(code: Int): Status = STATUSES.getOrElse(code) { Status.FAILED }
+
+            // New direct buffer with room for a GLB of meshCapacity bytes
+            @JvmStatic
+            @JvmOverloads
+            fun allocate(meshCapacity: Int = DEFAULT_MESH_CAPACITY): ScanOutput {
+                require(meshCapacity >= 0) { "meshCapacity must not be negative" }
+                return ScanOutput(ByteBuffer.allocateDirect(MESH_OFFSET + meshCapacity))
+            }
+        }
+    }
+
     // Single image processing
     external fun processOneImage(
         image: ByteArray,
@@ -47,6 +229,46 @@ object NativeBridge {
         userHeightCm: Float
     ): ScanResult
 
+    // Single image processing from a direct ByteBuffer holding RGBA pixels
+    // (e.g. a CameraX RGBA_8888 plane). The buffer is wrapped in place, not copied.
+    // rowStride is bytes per row; 0 means tightly packed (width * 4).
+    fun processOneImage(
+        image: ByteBuffer,
+        width: Int,
+        height: Int,
+        rowStride: Int,
+        userHeightCm: Float
+    ): ScanResult {
+        require(image.isDirect) { "image must be a direct ByteBuffer" }
+        return processOneImageBufferNative(image, width, height, rowStride, userHeightCm)
+    }
+
+    // Single image processing from an RGBA_8888 HardwareBuffer, read in place
+    @RequiresApi(Build.VERSION_CODES.O)
+    fun processOneImage(image: HardwareBuffer, userHeightCm: Float): ScanResult =
+        processOneImageHardwareBufferNative(image, userHeightCm)
+
+    // Single image processing from a direct RGBA ByteBuffer into a reusable
+    // ScanOutput (no Java arrays per scan). Returns the status also in out.
+    fun processOneImage(
+        image: ByteBuffer,
+        width: Int,
+        height: Int,
+        rowStride: Int,
+        userHeightCm: Float,
+        out: ScanOutput
+    ): ScanOutput.Status {
+        require(image.isDirect) { "image must be a direct ByteBuffer" }
+        return ScanOutput.statusOf(
+            processOneImageBufferIntoNative(image, width, height, rowStride, userHeightCm, out.buffer)
+        )
+    }
+
+    // Single image processing from an RGBA_8888 HardwareBuffer into a reusable ScanOutput
+    @RequiresApi(Build.VERSION_CODES.O)
+    fun processOneImage(image: HardwareBuffer, userHeightCm: Float, out: ScanOutput): ScanOutput.Status =
+        ScanOutput.statusOf(processOneImageHardwareBufferIntoNative(image, userHeightCm, out.buffer))
+
     // Initialize MediaPipe Pose Detector
     external fun initializeMediaPipe(context: android.content.Context): Boolean
 
@@ -69,6 +291,22 @@ object NativeBridge {
         height: Int
     ): ImageValidationResult
 
+    // Image validation from a direct RGBA ByteBuffer (zero-copy)
+    fun validateImage(
+        image: ByteBuffer,
+        width: Int,
+        height: Int,
+        rowStride: Int
+    ): ImageValidationResult {
+        require(image.isDirect) { "image must be a direct ByteBuffer" }
+        return validateImageBufferNative(image, width, height, rowStride)
+    }
+
+    // Image validation from an RGBA_8888 HardwareBuffer (zero-copy)
+    @RequiresApi(Build.VERSION_CODES.O)
+    fun validateImage(image: HardwareBuffer): ImageValidationResult =
+        validateImageHardwareBufferNative(image)
+
     // Detect keypoints for preview overlay
     // Returns FloatArray of 135*2 = 270 floats (normalized x, y coordinates)
     external fun detectKeypoints(
@@ -77,6 +315,62 @@ object NativeBridge {
         height: Int
     ): FloatArray
 
+    // Preview keypoints from a direct RGBA ByteBuffer (zero-copy)
+    fun detectKeypoints(
+        image: ByteBuffer,
+        width: Int,
+        height: Int,
+        rowStride: Int
+    ): FloatArray {
+        require(image.isDirect) { "image must be a direct ByteBuffer" }
+        return detectKeypointsBufferNative(image, width, height, rowStride)
+    }
+
+    // Preview keypoints from an RGBA_8888 HardwareBuffer (zero-copy)
+    @RequiresApi(Build.VERSION_CODES.O)
+    fun detectKeypoints(image: HardwareBuffer): FloatArray =
+        detectKeypointsHardwareBufferNative(image)
+
+    // Floats written per preview result: 135 keypoints * (x, y)
+    const val PREVIEW_KEYPOINT_FLOATS = 135 * 2
+
+    // Streaming preview overlay: startPreview() once, pushPreviewFrame() for every
+    // camera frame, stopPreview() when the preview goes away. Inference runs on a
+    // native worker on the newest frame (frames arriving while it is busy are
+    // dropped) with tracking and smoothing across frames. Each push copies the
+    // latest smoothed keypoints into out - reuse one array of
+    // PREVIEW_KEYPOINT_FLOATS - and returns the sequence number of the frame they
+    // came from: unchanged if nothing new is ready, 0 before the first result.
+    external fun startPreview(): Boolean
+
+    // Preview frame from an RGBA byte[] (tightly packed)
+    fun pushPreviewFrame(image: ByteArray, width: Int, height: Int, out: FloatArray): Long {
+        require(out.size >= PREVIEW_KEYPOINT_FLOATS) { "out must hold $PREVIEW_KEYPOINT_FLOATS floats" }
+        return pushPreviewFrameNative(image, width, height, out)
+    }
+
+    // Preview frame from a direct RGBA ByteBuffer
+    fun pushPreviewFrame(
+        image: ByteBuffer,
+        width: Int,
+        height: Int,
+        rowStride: Int,
+        out: FloatArray
+    ): Long {
+        require(image.isDirect) { "image must be a direct ByteBuffer" }
+        require(out.size >= PREVIEW_KEYPOINT_FLOATS) { "out must hold $PREVIEW_KEYPOINT_FLOATS floats" }
+        return pushPreviewFrameBufferNative(image, width, height, rowStride, out)
+    }
+
+    // Preview frame from an RGBA_8888 HardwareBuffer
+    @RequiresApi(Build.VERSION_CODES.O)
+    fun pushPreviewFrame(image: HardwareBuffer, out: FloatArray): Long {
+        require(out.size >= PREVIEW_KEYPOINT_FLOATS) { "out must hold $PREVIEW_KEYPOINT_FLOATS floats" }
+        return pushPreviewFrameHardwareBufferNative(image, out)
+    }
+
+    external fun stopPreview()
+
     // Multi-image processing with MediaPipe and 3D reconstruction
     external fun processThreeImages(
         images: Array<ByteArray>,
@@ -84,5 +378,310 @@ object NativeBridge {
         heights: IntArray,
         userHeightCm: Float
     ): ScanResult
-}
 
+    // Multi-image processing from direct RGBA ByteBuffers (zero-copy)
+    // rowStrides may be null when every buffer is tightly packed
+    fun processThreeImages(
+        images: Array<ByteBuffer>,
+        widths: IntArray,
+        heights: IntArray,
+        rowStrides: IntArray?,
+        userHeightCm: Float
+    ): ScanResult {
+        require(images.all { it.isDirect }) { "images must be direct ByteBuffers" }
+        return processThreeImageBuffersNative(images, widths, heights, rowStrides, userHeightCm)
+    }
+
+    // Multi-image processing from direct RGBA ByteBuffers into a reusable
+    // ScanOutput; the GLB is written into its mesh section. On MESH_TOO_LARGE
+    // retry with ScanOutput.allocate(out.meshBytes).
+    fun processThreeImages(
+        images: Array<ByteBuffer>,
+        widths: IntArray,
+        heights: IntArray,
+        rowStrides: IntArray?,
+        userHeightCm: Float,
+        out: ScanOutput
+    ): ScanOutput.Status {
+        require(images.all { it.isDirect }) { "images must be direct ByteBuffers" }
+        return ScanOutput.statusOf(
+            processThreeImageBuffersIntoNative(images, widths, heights, rowStrides, userHeightCm, out.buffer)
+        )
+    }
+
+    // Incremental three-view scan: beginScan(), then addView() as each photo is
+    // taken - its preprocessing and pose detection start right away on a native
+    // worker while the user turns for the next one - and finishScan() once all
+    // three are in. Re-adding a view (a retake) replaces it; beginScan() again
+    // drops an unfinished scan. View 0 is the front view used for measurements.
+    external fun beginScan(): Boolean
+
+    // View from an RGBA byte[] (tightly packed); the pixels are copied
+    fun addView(index: Int, image: ByteArray, width: Int, height: Int): Boolean =
+        addViewNative(index, image, width, height)
+
+    // View from a direct RGBA ByteBuffer; the pixels are copied, so the buffer can be reused
+    fun addView(index: Int, image: ByteBuffer, width: Int, height: Int, rowStride: Int): Boolean {
+        require(image.isDirect) { "image must be a direct ByteBuffer" }
+        return addViewBufferNative(index, image, width, height, rowStride)
+    }
+
+    // View from an RGBA_8888 HardwareBuffer; the pixels are copied
+    @RequiresApi(Build.VERSION_CODES.O)
+    fun addView(index: Int, image: HardwareBuffer): Boolean = addViewHardwareBufferNative(index, image)
+
+    // Wait for the views still being detected, then triangulate, mesh and measure
+    // (blocking, like processThreeImages). Returns the empty result if a view is
+    // missing or no scan was begun.
+    external fun finishScan(userHeightCm: Float): ScanResult
+
+    /**
+     * Outcome of a scan queued with processThreeImagesAsync. Called on a native
+     * worker thread - post to the main thread for UI work. Each scan gets
+     * onProgress for the stages it reaches, then exactly one of onComplete or
+     * onCancelled.
+     */
+    interface ScanListener {
+        // stage is about to run; stages appear in pipeline order (INFERENCE once per view)
+        fun onProgress(handle: Long, stage: ScanStage) {}
+
+        fun onComplete(handle: Long, result: ScanResult)
+
+        // Cancelled with cancelScan before the scan finished
+        fun onCancelled(handle: Long) {}
+    }
+
+    // What the native worker calls: maps stage ordinals and a missing result
+    // before handing over to the ScanListener
+    @Keep
+    internal class ScanCallback(private val listener: ScanListener) {
+        fun onProgress(handle: Long, stage: Int) {
+            STAGES.getOrNull(stage)?.let { listener.onProgress(handle, it) }
+        }
+
+        fun onComplete(handle: Long, result: ScanResult?) {
+            listener.onComplete(handle, result ?: emptyScanResult())
+        }
+
+        fun onCancelled(handle: Long) {
+            listener.onCancelled(handle)
+        }
+
+        private companion object {
+            val STAGES = ScanStage.values()
+
+            fun emptyScanResult() = ScanResult(FloatArray(135 * 3), ByteArray(0), FloatArray(8))
+        }
+    }
+
+    // Queue a three-view scan on the native worker pool and return its handle
+    // at once (0 if it could not be queued). The frames are copied before this
+    // returns. When the user retakes a photo, cancelScan(handle) the stale scan
+    // and queue the new one - it does not wait for the old one to finish.
+    fun processThreeImagesAsync(
+        images: Array<ByteArray>,
+        widths: IntArray,
+        heights: IntArray,
+        userHeightCm: Float,
+        listener: ScanListener
+    ): Long = processThreeImagesAsyncNative(images, widths, heights, userHeightCm, ScanCallback(listener))
+
+    // Same from direct RGBA ByteBuffers; the buffers can be reused once this returns
+    fun processThreeImagesAsync(
+        images: Array<ByteBuffer>,
+        widths: IntArray,
+        heights: IntArray,
+        rowStrides: IntArray?,
+        userHeightCm: Float,
+        listener: ScanListener
+    ): Long {
+        require(images.all { it.isDirect }) { "images must be direct ByteBuffers" }
+        return processThreeImageBuffersAsyncNative(
+            images, widths, heights, rowStrides, userHeightCm, ScanCallback(listener)
+        )
+    }
+
+    // Cancel a queued or running async scan. It stops before its next stage
+    // and completes with onCancelled. Returns false if the scan already completed.
+    fun cancelScan(handle: Long): Boolean = cancelScanNative(handle)
+
+    /**
+     * Mesh level of detail. Ordinals are passed to native code and must match
+     * the C++ MeshLod enum.
+     */
+    enum class MeshLod {
+        THUMBNAIL,  // A few hundred triangles, for history list previews
+        STANDARD,   // Resolution of ScanResult.meshGlb
+        DETAILED    // High-resolution viewer and export
+    }
+
+    /**
+     * GLB encoding. Ordinals are passed to native code and must match the
+     * C++ MeshFormat enum.
+     */
+    enum class MeshFormat {
+        FLOAT32,  // float32 attributes - widest viewer support
+        COMPACT   // KHR_mesh_quantization int16/int8 attributes, uint16 indices - about half the bytes
+    }
+
+    // Rebuild a GLB mesh from ScanResult.keypoints3d at the given level of detail.
+    // Returns an empty array if the keypoints cannot produce a mesh.
+    fun generateMesh(
+        keypoints3d: FloatArray,
+        lod: MeshLod = MeshLod.STANDARD,
+        format: MeshFormat = MeshFormat.FLOAT32
+    ): ByteArray = generateMeshNative(keypoints3d, lod.ordinal, format.ordinal)
+
+    // Same as generateMesh, writing the GLB into a direct ByteBuffer starting at
+    // position 0 (the buffer can be reused across calls). Returns the GLB size in
+    // bytes: 0 if no mesh could be built, and larger than out.capacity() if the
+    // buffer was too small and nothing was written.
+    fun generateMesh(
+        keypoints3d: FloatArray,
+        lod: MeshLod,
+        out: ByteBuffer,
+        format: MeshFormat = MeshFormat.FLOAT32
+    ): Int {
+        require(out.isDirect) { "out must be a direct ByteBuffer" }
+        return generateMeshIntoBufferNative(keypoints3d, lod.ordinal, format.ordinal, out)
+    }
+
+    /**
+     * A cached GLB read in place from native memory (a file mapping when it
+     * comes from the disk cache). [glb] is read-only and must not be used
+     * after [close].
+     */
+    class CachedMesh internal constructor(private val buffer: ByteBuffer) : AutoCloseable {
+        val glb: ByteBuffer = buffer.asReadOnlyBuffer()
+
+        val size: Int get() = buffer.capacity()
+
+        private var closed = false
+
+        override fun close() {
+            if (!closed) {
+                closed = true
+                releaseCachedMeshNative(buffer)
+            }
+        }
+    }
+
+    // Same mesh as generateMesh, without copying it into the Java heap:
+    // identical keypoints, LOD and format reuse the GLB built for the scan.
+    // Returns null if the keypoints cannot produce a mesh.
+    fun openCachedMesh(
+        keypoints3d: FloatArray,
+        lod: MeshLod = MeshLod.STANDARD,
+        format: MeshFormat = MeshFormat.FLOAT32
+    ): CachedMesh? = openCachedMeshNative(keypoints3d, lod.ordinal, format.ordinal)?.let { CachedMesh(it) }
+
+    // Keep built meshes in directory (e.g. File(context.cacheDir, "meshes")) across
+    // app restarts, or only in memory if directory is null. Returns false if the
+    // directory cannot be created.
+    fun configureMeshCache(
+        directory: java.io.File?,
+        maxDiskBytes: Long = DEFAULT_MESH_CACHE_DISK_BYTES,
+        maxMemoryBytes: Long = DEFAULT_MESH_CACHE_MEMORY_BYTES
+    ): Boolean = configureMeshCacheNative(directory?.absolutePath, maxDiskBytes, maxMemoryBytes)
+
+    // Defaults of the C++ MeshCache
+    const val DEFAULT_MESH_CACHE_DISK_BYTES = 64L shl 20
+    const val DEFAULT_MESH_CACHE_MEMORY_BYTES = 8L shl 20
+
+    private external fun generateMeshNative(keypoints3d: FloatArray, lod: Int, format: Int): ByteArray
+
+    private external fun openCachedMeshNative(keypoints3d: FloatArray, lod: Int, format: Int): ByteBuffer?
+
+    private external fun releaseCachedMeshNative(buffer: ByteBuffer)
+
+    private external fun configureMeshCacheNative(
+        directory: String?, maxDiskBytes: Long, maxMemoryBytes: Long
+    ): Boolean
+
+    private external fun generateMeshIntoBufferNative(
+        keypoints3d: FloatArray, lod: Int, format: Int, out: ByteBuffer
+    ): Int
+
+    // Zero-copy entry points - use the public overloads above, which check isDirect
+    private external fun processOneImageBufferNative(
+        image: ByteBuffer, width: Int, height: Int, rowStride: Int, userHeightCm: Float
+    ): ScanResult
+
+    private external fun processOneImageHardwareBufferNative(
+        image: HardwareBuffer, userHeightCm: Float
+    ): ScanResult
+
+    private external fun processOneImageBufferIntoNative(
+        image: ByteBuffer, width: Int, height: Int, rowStride: Int, userHeightCm: Float, out: ByteBuffer
+    ): Int
+
+    private external fun processOneImageHardwareBufferIntoNative(
+        image: HardwareBuffer, userHeightCm: Float, out: ByteBuffer
+    ): Int
+
+    private external fun validateImageBufferNative(
+        image: ByteBuffer, width: Int, height: Int, rowStride: Int
+    ): ImageValidationResult
+
+    private external fun validateImageHardwareBufferNative(image: HardwareBuffer): ImageValidationResult
+
+    private external fun detectKeypointsBufferNative(
+        image: ByteBuffer, width: Int, height: Int, rowStride: Int
+    ): FloatArray
+
+    private external fun detectKeypointsHardwareBufferNative(image: HardwareBuffer): FloatArray
+
+    private external fun pushPreviewFrameNative(
+        image: ByteArray, width: Int, height: Int, out: FloatArray
+    ): Long
+
+    private external fun pushPreviewFrameBufferNative(
+        image: ByteBuffer, width: Int, height: Int, rowStride: Int, out: FloatArray
+    ): Long
+
+    private external fun pushPreviewFrameHardwareBufferNative(image: HardwareBuffer, out: FloatArray): Long
+
+    private external fun processThreeImageBuffersNative(
+        images: Array<ByteBuffer>,
+        widths: IntArray,
+        heights: IntArray,
+        rowStrides: IntArray?,
+        userHeightCm: Float
+    ): ScanResult
+
+    private external fun processThreeImageBuffersIntoNative(
+        images: Array<ByteBuffer>,
+        widths: IntArray,
+        heights: IntArray,
+        rowStrides: IntArray?,
+        userHeightCm: Float,
+        out: ByteBuffer
+    ): Int
+
+    private external fun processThreeImagesAsyncNative(
+        images: Array<ByteArray>,
+        widths: IntArray,
+        heights: IntArray,
+        userHeightCm: Float,
+        callback: ScanCallback
+    ): Long
+
+    private external fun processThreeImageBuffersAsyncNative(
+        images: Array<ByteBuffer>,
+        widths: IntArray,
+        heights: IntArray,
+        rowStrides: IntArray?,
+        userHeightCm: Float,
+        callback: ScanCallback
+    ): Long
+
+    private external fun cancelScanNative(handle: Long): Boolean
+
+    private external fun addViewNative(index: Int, image: ByteArray, width: Int, height: Int): Boolean
+
+    private external fun addViewBufferNative(
+        index: Int, image: ByteBuffer, width: Int, height: Int, rowStride: Int
+    ): Boolean
+
+    private external fun addViewHardwareBufferNative(index: Int, image: HardwareBuffer): Boolean
+}
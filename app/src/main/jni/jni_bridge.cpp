@@ -5,956 +5,1125 @@
 #include "multi_view_3d.h"
 #include "mesh_generator.h"
 #include "mediapipe_pose_detector.h"
+#include "frame_input.h"
+#include "keypoint_schema.h"
+#include "measurements.h"
+#include "preview_session.h"
+#include "scan_trace.h"
+#include "jni_registry.h"
+#include "scan_output.h"
+#include "scan_job_queue.h"
+#include "scan_session.h"
+#include "mesh_cache.h"
+#include "preprocess_pool.h"
 #include <opencv2/opencv.hpp>
+#include <array>
 #include <vector>
 #include <cstring>
 #include <cmath>
 #include <limits>
+#include <string>
+#include <unordered_map>
 #include <algorithm>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 #define LOG_TAG "NativeBridge"
 #define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
-// Helper function to map MediaPipe 3D keypoints to BODY_25 format for mesh generation
-// MediaPipe indices: 0=nose, 11=left_shoulder, 12=right_shoulder, 13=left_elbow, 14=right_elbow,
-//                    15=left_wrist, 16=right_wrist, 23=left_hip, 24=right_hip,
-//                    25=left_knee, 26=right_knee, 27=left_ankle, 28=right_ankle
-// BODY_25 indices:   0=nose, 1=neck, 2=right_shoulder, 3=right_elbow, 4=right_wrist,
-//                    5=left_shoulder, 6=left_elbow, 7=left_wrist, 8=mid_hip,
-//                    9=right_hip, 10=right_knee, 11=right_ankle, 12=left_hip,
-//                    13=left_knee, 14=left_ankle
-static std::vector<cv::Point3f> mapMediaPipeToBODY25(const std::vector<cv::Point3f>& mp3d) {
-    std::vector<cv::Point3f> body25(25, cv::Point3f(0, 0, 0));
-    
-    if (mp3d.size() < 33) {
-        return body25; // Return zeros if insufficient keypoints
-    }
-    
-    // Helper to check if keypoint is valid
-    auto isValid = [](const cv::Point3f& pt) {
-        return !(std::isnan(pt.x) || std::isnan(pt.y) || std::isnan(pt.z) ||
-                 std::isinf(pt.x) || std::isinf(pt.y) || std::isinf(pt.z) ||
-                 (pt.x == 0.0f && pt.y == 0.0f && pt.z == 0.0f));
-    };
-    
-    // Map MediaPipe to BODY_25
-    // 0: nose (same)
-    if (isValid(mp3d[0])) body25[0] = mp3d[0];
-    
-    // 1: neck - interpolate between shoulders
-    if (isValid(mp3d[11]) && isValid(mp3d[12])) {
-        body25[1] = (mp3d[11] + mp3d[12]) * 0.5f;
-    } else if (isValid(mp3d[11])) {
-        body25[1] = mp3d[11];
-    } else if (isValid(mp3d[12])) {
-        body25[1] = mp3d[12];
+// ScanResult keypoint arrays always use the 135-keypoint wire layout; with a
+// slim PipelineLayout the keypoints past the pipeline's count stay zero
+static constexpr jsize kKeypoints3dFloats = WireLayout::kCount * 3;
+static constexpr jsize kKeypoints2dFloats = WireLayout::kCount * 2;
+
+// Build a NativeBridge.ScanTimings from a scan's stage timings and output sizes.
+// Returns null (with the exception cleared) if it cannot be created.
+static jobject newScanTimings(JNIEnv* env, const ScanTimings& timings, size_t meshBytes, size_t maskBytes) {
+    float stageMs[kScanStageCount];
+    timings.toMillis(stageMs);
+    LOGD("Scan stages (ms): decode %.1f, preprocess %.1f, inference %.1f, triangulation %.1f, "
+         "mesh %.1f, glb %.1f, measurement %.1f, pack %.1f; mesh %zu B, mask %zu B",
+         stageMs[0], stageMs[1], stageMs[2], stageMs[3], stageMs[4], stageMs[5], stageMs[6], stageMs[7],
+         meshBytes, maskBytes);
+
+    const JniRegistry& registry = JniRegistry::get();
+    jfloatArray jStageMs = env->NewFloatArray(kScanStageCount);
+    jobject result = nullptr;
+    if (registry.scanTimingsClass != nullptr && jStageMs != nullptr) {
+        env->SetFloatArrayRegion(jStageMs, 0, kScanStageCount, stageMs);
+        result = env->NewObject(registry.scanTimingsClass, registry.scanTimingsInit, jStageMs,
+                                static_cast<jint>(meshBytes), static_cast<jint>(maskBytes));
     }
-    
-    // 2: right_shoulder (MediaPipe index 12)
-    if (isValid(mp3d[12])) body25[2] = mp3d[12];
-    
-    // 3: right_elbow (MediaPipe index 14)
-    if (isValid(mp3d[14])) body25[3] = mp3d[14];
-    
-    // 4: right_wrist (MediaPipe index 16)
-    if (isValid(mp3d[16])) body25[4] = mp3d[16];
-    
-    // 5: left_shoulder (MediaPipe index 11)
-    if (isValid(mp3d[11])) body25[5] = mp3d[11];
-    
-    // 6: left_elbow (MediaPipe index 13)
-    if (isValid(mp3d[13])) body25[6] = mp3d[13];
-    
-    // 7: left_wrist (MediaPipe index 15)
-    if (isValid(mp3d[15])) body25[7] = mp3d[15];
-    
-    // 8: mid_hip - interpolate between hips
-    if (isValid(mp3d[23]) && isValid(mp3d[24])) {
-        body25[8] = (mp3d[23] + mp3d[24]) * 0.5f;
-    } else if (isValid(mp3d[23])) {
-        body25[8] = mp3d[23];
-    } else if (isValid(mp3d[24])) {
-        body25[8] = mp3d[24];
+    if (env->ExceptionCheck()) {
+        env->ExceptionClear();
+        result = nullptr;
     }
-    
-    // 9: right_hip (MediaPipe index 24)
-    if (isValid(mp3d[24])) body25[9] = mp3d[24];
-    
-    // 10: right_knee (MediaPipe index 26)
-    if (isValid(mp3d[26])) body25[10] = mp3d[26];
-    
-    // 11: right_ankle (MediaPipe index 28)
-    if (isValid(mp3d[28])) body25[11] = mp3d[28];
-    
-    // 12: left_hip (MediaPipe index 23)
-    if (isValid(mp3d[23])) body25[12] = mp3d[23];
-    
-    // 13: left_knee (MediaPipe index 25)
-    if (isValid(mp3d[25])) body25[13] = mp3d[25];
-    
-    // 14: left_ankle (MediaPipe index 27)
-    if (isValid(mp3d[27])) body25[14] = mp3d[27];
-    
-    // 15-18: eyes and ears (use MediaPipe face keypoints if available)
-    // For now, leave as zeros - mesh generator may not need these
-    
-    return body25;
+    if (jStageMs != nullptr) env->DeleteLocalRef(jStageMs);
+    return result;
 }
 
-// Forward declaration for computeMeasurementsFrom2D
-std::vector<float> computeMeasurementsFrom2D(
-    const std::vector<cv::Point2f>& kpts2d, 
-    float userHeight, 
-    int imgWidth, 
-    int imgHeight,
-    const cv::Mat& processedImg,
-    const cv::Mat& segmentationMask);
+// keypoints3d array in the wire layout. Point3f is three packed floats, so the
+// points are copied straight from the vector; slots past the pipeline's count,
+// and every slot if the triangulation failed, stay zero (NewFloatArray zero-fills).
+static jfloatArray newKeypoints3dArray(JNIEnv* env, const std::vector<cv::Point3f>& kpts3d) {
+    jfloatArray array = env->NewFloatArray(kKeypoints3dFloats);
+    if (array != nullptr && kpts3d.size() == PipelineLayout::kCount) {
+        env->SetFloatArrayRegion(array, 0, PipelineLayout::kCount * 3,
+                                 reinterpret_cast<const jfloat*>(kpts3d.data()));
+    }
+    return array;
+}
 
-// Multi-image processing with MediaPipe and 3D reconstruction
-extern "C" JNIEXPORT jobject JNICALL
-Java_com_example_bodyscanapp_utils_NativeBridge_processThreeImages(
-        JNIEnv* env, jclass, jobjectArray jImages, jintArray jWidths,
-        jintArray jHeights, jfloat userHeight) {
+// keypoints2d array in the wire layout (normalized x, y), zero where missing
+static jfloatArray newKeypoints2dArray(JNIEnv* env, const std::vector<cv::Point2f>& kpts2d) {
+    jfloatArray array = env->NewFloatArray(kKeypoints2dFloats);
+    if (array != nullptr && kpts2d.size() == PipelineLayout::kCount) {
+        env->SetFloatArrayRegion(array, 0, PipelineLayout::kCount * 2,
+                                 reinterpret_cast<const jfloat*>(kpts2d.data()));
+    }
+    return array;
+}
 
-    // Find the ScanResult class (Kotlin data class)
-    jclass resultClass = env->FindClass("com/example/bodyscanapp/utils/NativeBridge$ScanResult");
-    if (resultClass == nullptr) {
-        return nullptr;
+// Measurements array; kMeasurementCount zeros if none were computed
+static jfloatArray newMeasurementArray(JNIEnv* env, const std::vector<float>& meas) {
+    if (meas.empty()) {
+        return env->NewFloatArray(kMeasurementCount);
     }
-    
-    // Get constructor for Kotlin data class: ScanResult(FloatArray, ByteArray, FloatArray, FloatArray?)
-    // Try 4-parameter constructor first (with keypoints2d)
-    jmethodID constructor = env->GetMethodID(resultClass, "<init>", "([F[B[F[F)V");
-    if (constructor == nullptr) {
-        return nullptr;
+    jfloatArray array = env->NewFloatArray(static_cast<jsize>(meas.size()));
+    if (array != nullptr) {
+        env->SetFloatArrayRegion(array, 0, static_cast<jsize>(meas.size()), meas.data());
     }
+    return array;
+}
 
-    // Initialize result arrays (will be populated or set to empty on error)
-    jfloatArray keypoints3d = nullptr;
-    jbyteArray meshGlb = nullptr;
-    jfloatArray measurements = nullptr;
-    jfloatArray keypoints2d = nullptr; // For multi-image, we don't need 2D keypoints (can pass null)
-
-    try {
-        // 1. Validate input
-        if (jImages == nullptr || jWidths == nullptr || jHeights == nullptr) {
-            // Return empty result
-            keypoints3d = env->NewFloatArray(135 * 3);
-            meshGlb = env->NewByteArray(0);
-            measurements = env->NewFloatArray(8);
-            float zeros[8] = {0};
-            env->SetFloatArrayRegion(measurements, 0, 8, zeros);
-            // Pass null for keypoints2d (4th parameter)
-            jobject result = env->NewObject(resultClass, constructor, keypoints3d, meshGlb, measurements, nullptr);
-            return result;
-        }
+// Process-wide GLB cache shared by scans and stored-scan mesh regeneration.
+// Memory only until configureMeshCache() names a directory. Never destroyed.
+static MeshCache& meshCache() {
+    static MeshCache* cache = new MeshCache();
+    return *cache;
+}
 
-        jsize numImages = env->GetArrayLength(jImages);
-        if (numImages != 3) {
-            // Return empty result
-            keypoints3d = env->NewFloatArray(135 * 3);
-            meshGlb = env->NewByteArray(0);
-            measurements = env->NewFloatArray(8);
-            float zeros[8] = {0};
-            env->SetFloatArrayRegion(measurements, 0, 8, zeros);
-            // Pass null for keypoints2d (4th parameter)
-            jobject result = env->NewObject(resultClass, constructor, keypoints3d, meshGlb, measurements, nullptr);
-            return result;
-        }
+// Build a ScanResult with zeroed keypoints, an empty mesh and 8 zero measurements.
+// NewFloatArray zero-initializes, so no explicit fill is needed.
+static jobject makeEmptyThreeViewResult(JNIEnv* env, jclass resultClass, jmethodID constructor) {
+    jfloatArray keypoints3d = env->NewFloatArray(kKeypoints3dFloats);
+    jbyteArray meshGlb = env->NewByteArray(0);
+    jfloatArray measurements = env->NewFloatArray(kMeasurementCount);
+    // Pass null for keypoints2d and timings
+    jobject result = env->NewObject(resultClass, constructor, keypoints3d, meshGlb, measurements,
+                                    nullptr, nullptr);
+    if (keypoints3d != nullptr) env->DeleteLocalRef(keypoints3d);
+    if (meshGlb != nullptr) env->DeleteLocalRef(meshGlb);
+    if (measurements != nullptr) env->DeleteLocalRef(measurements);
+    return result;
+}
 
-        // Get image dimensions
-        jint widths[3], heights[3];
-        env->GetIntArrayRegion(jWidths, 0, 3, widths);
-        env->GetIntArrayRegion(jHeights, 0, 3, heights);
+// Report the next stage of an async scan job (no-op for blocking calls).
+// Throws ScanCancelled once the job is cancelled.
+static void checkpoint(ScanJob* job, ScanStage stage) {
+    if (job != nullptr) {
+        job->checkpoint(stage);
+    }
+}
 
-        // 2. Convert Java byte[][] → std::vector<cv::Mat>
-        std::vector<cv::Mat> imgs(3);
-        for (int i = 0; i < 3; ++i) {
-            jbyteArray jImg = (jbyteArray)env->GetObjectArrayElement(jImages, i);
-            if (jImg == nullptr) {
-                // Return empty result
-                keypoints3d = env->NewFloatArray(135 * 3);
-                meshGlb = env->NewByteArray(0);
-                measurements = env->NewFloatArray(8);
-                float zeros[8] = {0};
-                env->SetFloatArrayRegion(measurements, 0, 8, zeros);
-                // Pass null for keypoints2d (4th parameter)
-                jobject result = env->NewObject(resultClass, constructor, keypoints3d, meshGlb, measurements, nullptr);
-                return result;
-            }
+// Everything a three-view scan produces before meshing and packing
+struct ThreeViewScan {
+    std::vector<cv::Point3f> keypoints3d;  // PipelineLayout::kCount points, or empty
+    std::vector<cv::Point3f> body25;       // Mesh input
+    std::vector<float> measurements;       // kMeasurementCount values
+    int validKeypoints3d = 0;
+    size_t validBody25 = 0;
+    size_t maskBytes = 0;
+};
 
-            jsize len = env->GetArrayLength(jImg);
-            jint expectedSize = widths[i] * heights[i] * 4; // RGBA = 4 bytes per pixel
-            
-            // Validate buffer size matches expected dimensions
-            if (len < expectedSize) {
-                // Return empty result - invalid image data
-                keypoints3d = env->NewFloatArray(135 * 3);
-                meshGlb = env->NewByteArray(0);
-                measurements = env->NewFloatArray(7);
-                float zeros[7] = {0};
-                env->SetFloatArrayRegion(measurements, 0, 7, zeros);
-                // Pass null for keypoints2d (4th parameter)
-                jobject result = env->NewObject(resultClass, constructor, keypoints3d, meshGlb, measurements, nullptr);
-                env->DeleteLocalRef(jImg);
-                return result;
-            }
-            
-            jbyte* buf = env->GetByteArrayElements(jImg, nullptr);
-            
-            // Create RGBA Mat from buffer (rows=height, cols=width, type=CV_8UC4)
-            // Note: OpenCV Mat constructor is Mat(rows, cols, type, data)
-            cv::Mat rgba(heights[i], widths[i], CV_8UC4, buf);
-            
-            // Convert RGBA to RGB and clone to ensure contiguous memory
-            cv::Mat rgb;
-            cv::cvtColor(rgba, rgb, cv::COLOR_RGBA2RGB);
-            
-            // Clone to ensure the Mat owns its data and is contiguous
-            // This is critical to ensure the full image is processed correctly
-            imgs[i] = rgb.clone();
-            
-            env->ReleaseByteArrayElements(jImg, buf, JNI_ABORT);
-            env->DeleteLocalRef(jImg);
-        }
+// Second half of a three-view scan, once every view is detected: triangulation,
+// mesh input and measurements. front / frontMask are the preprocessed front view
+// and its segmentation mask.
+static void finishThreeViewScan(const std::vector<std::vector<cv::Point2f>>& kpts2d, const cv::Mat& front,
+                                const cv::Mat& frontMask, float userHeight, ThreeViewScan& scan,
+                                ScanJob* job = nullptr) {
+    scan.maskBytes = frontMask.total() * frontMask.elemSize();
 
-        // 3. Pre-process images (CLAHE + resizing)
-        for (auto& img : imgs) {
-            ImagePreprocessor::run(img);
+    // 5. Triangulate to 3D keypoints using multi-view stereo
+    checkpoint(job, ScanStage::Triangulation);
+    scan.keypoints3d = MultiView3D::triangulate(kpts2d, userHeight);
+    
+    // Validate triangulated keypoints
+    for (const auto& pt : scan.keypoints3d) {
+        if (KeypointSet<PipelineLayout>::isValidPoint(pt)) {
+            scan.validKeypoints3d++;
         }
+    }
+    
+    // Log validation results
+    LOGD("Triangulated %d valid 3D keypoints out of %zu", scan.validKeypoints3d, scan.keypoints3d.size());
 
-        // 4. Detect 2D keypoints per view using MediaPipe
-        std::vector<std::vector<cv::Point2f>> kpts2d(3);
-        for (int i = 0; i < 3; ++i) {
-            kpts2d[i] = PoseEstimator::detect(imgs[i]);
-        }
+    // 6. Mesh input: MeshGenerator expects BODY_25 format, mapped from the MediaPipe
+    // landmarks (the first 33 triangulated keypoints) through the constexpr schema
+    const KeypointSet<Body25Layout> body25 = mapToBody25(
+        KeypointSet<MediaPipeLayout>::fromPoints(scan.keypoints3d.data(), scan.keypoints3d.size()));
+    scan.body25 = body25.toVector();
+    scan.validBody25 = body25.validCount();
+    LOGD("Mapped %zu valid BODY_25 keypoints from MediaPipe format", scan.validBody25);
 
-        // 5. Triangulate to 3D keypoints using multi-view stereo
-        std::vector<cv::Point3f> kpts3d = MultiView3D::triangulate(kpts2d, userHeight);
+    // 7. Compute measurements from 2D keypoints of first image (same as processOneImage)
+    // Use the first image (front view) to calculate measurements using 2D approach
+    // This avoids errors from 3D triangulation and uses the proven 2D measurement method
+    checkpoint(job, ScanStage::Measurement);
+    scan.measurements.assign(kMeasurementCount, 0.0f); // matching single-image format
+    
+    if (!kpts2d[0].empty() && kpts2d[0].size() >= MediaPipeLayout::kCount) {
+        // Segmentation mask of the first image is used for pixel-level measurements.
+        // It stays at its native resolution; the measurement maps rows into it.
+        int processedWidth = front.cols;
+        int processedHeight = front.rows;
         
-        // Validate triangulated keypoints
-        int valid3dKeypoints = 0;
-        for (const auto& pt : kpts3d) {
-            if (!(std::isnan(pt.x) || std::isnan(pt.y) || std::isnan(pt.z) ||
-                  std::isinf(pt.x) || std::isinf(pt.y) || std::isinf(pt.z) ||
-                  (pt.x == 0.0f && pt.y == 0.0f && pt.z == 0.0f))) {
-                valid3dKeypoints++;
-            }
-        }
+        // Use the same 2D measurement calculation as processOneImage
+        scan.measurements = computeMeasurementsFrom2D(kpts2d[0], userHeight, processedWidth, processedHeight,
+                                                      front, frontMask);
         
-        // Log validation results
-        LOGD("Triangulated %d valid 3D keypoints out of %zu", valid3dKeypoints, kpts3d.size());
+        // Log measurements
+        LOGD("Computed 8 measurements from 2D keypoints (first image):");
+        for (size_t i = 0; i < scan.measurements.size(); ++i) {
+            LOGD("Measurement[%zu] = %.2f cm", i, scan.measurements[i]);
+        }
+    } else {
+        LOGE("First image keypoints invalid - cannot compute measurements");
+    }
+}
 
-        // 6. Generate 3D mesh from keypoints
-        // MeshGenerator expects BODY_25 format, so we need to map MediaPipe keypoints
-        // Create BODY_25 format keypoints (first 25) from MediaPipe format
-        std::vector<cv::Point3f> body25Keypoints = mapMediaPipeToBODY25(kpts3d);
-        
-        // Count valid BODY_25 keypoints
-        int validBody25 = 0;
-        for (const auto& pt : body25Keypoints) {
-            if (!(std::isnan(pt.x) || std::isnan(pt.y) || std::isnan(pt.z) ||
-                  std::isinf(pt.x) || std::isinf(pt.y) || std::isinf(pt.z) ||
-                  (pt.x == 0.0f && pt.y == 0.0f && pt.z == 0.0f))) {
-                validBody25++;
+// Runs preprocessing, detection, triangulation and measurement on three views
+// (RGB or RGBA). RGBA views are converted by the preprocessing workers, so
+// callers can pass pinned/wrapped memory directly. Meshing is left to the
+// caller, which decides where the GLB goes.
+// Stages record into timings, which must be this thread's current ScanTimings.
+// job, if set, is checkpointed before each stage.
+static void scanThreeFrames(std::vector<cv::Mat>& imgs, float userHeight, ScanTimings& timings,
+                            ThreeViewScan& scan, ScanJob* job = nullptr) {
+    // 3+4. Pre-process (RGB conversion, resizing, CLAHE) and detect 2D keypoints.
+    // Views 1-2 are preprocessed on the persistent PreprocessPool workers while
+    // view 0 goes through MediaPipe. Preprocessing is pure OpenCV and makes no JNI calls; inference
+    // stays on this (attached) thread, which acts as the single inference queue.
+    // The front view's segmentation mask comes from the same inference as its
+    // keypoints (later detections would otherwise replace the stored result)
+    std::vector<std::vector<cv::Point2f>> kpts2d(3);
+    cv::Mat segmentationMask;
+    checkpoint(job, ScanStage::Preprocess);
+    {
+        const bool pipelined = std::thread::hardware_concurrency() > 1;
+        std::future<void> prepared[3];
+        // Pool futures do not block on destruction: wait for pending views
+        // before the frames they touch go away, even on an exception
+        struct WaitPending {
+            std::future<void>* futures;
+            ~WaitPending() {
+                for (int i = 0; i < 3; ++i) {
+                    if (futures[i].valid()) {
+                        futures[i].wait();
+                    }
+                }
             }
-        }
-        LOGD("Mapped %d valid BODY_25 keypoints from MediaPipe format", validBody25);
-        
-        std::vector<uint8_t> mesh = MeshGenerator::createFromKeypoints(body25Keypoints);
-        
-        // Log mesh generation result with detailed info
-        LOGD("Generated mesh size: %zu bytes", mesh.size());
-        if (mesh.empty()) {
-            LOGE("Mesh generation returned empty - check keypoint validation in MeshGenerator");
-            LOGE("Input: %zu BODY_25 keypoints, %d valid", body25Keypoints.size(), validBody25);
-            LOGE("Source: %zu triangulated 3D keypoints, %d valid", kpts3d.size(), valid3dKeypoints);
-        } else {
-            LOGD("Mesh generation SUCCESS: %zu bytes", mesh.size());
-            // Log first few bytes to verify it's a valid GLB
-            if (mesh.size() >= 4) {
-                LOGD("Mesh header (first 4 bytes): %02X %02X %02X %02X", 
-                     mesh[0], mesh[1], mesh[2], mesh[3]);
+        } waitPending{prepared};
+        if (pipelined) {
+            for (int i = 1; i < 3; ++i) {
+                prepared[i] = PreprocessPool::shared().submit(imgs[i], &timings);
             }
         }
 
-        // 7. Compute measurements from 2D keypoints of first image (same as processOneImage)
-        // Use the first image (front view) to calculate measurements using 2D approach
-        // This avoids errors from 3D triangulation and uses the proven 2D measurement method
-        std::vector<float> meas(8, 0.0f); // 8 measurements matching single-image format
-        
-        if (!kpts2d[0].empty() && kpts2d[0].size() >= 33) {
-            // Get segmentation mask for the first image for pixel-level measurements
-            cv::Mat segmentationMask = MediaPipePoseDetector::getSegmentationMask(env, imgs[0]);
-            
-            // Resize segmentation mask to match processed image dimensions if needed
-            int processedWidth = imgs[0].cols;
-            int processedHeight = imgs[0].rows;
-            if (!segmentationMask.empty() && 
-                (segmentationMask.cols != processedWidth || segmentationMask.rows != processedHeight)) {
-                cv::Mat resizedMask;
-                cv::resize(segmentationMask, resizedMask, cv::Size(processedWidth, processedHeight), 0, 0, cv::INTER_LINEAR);
-                segmentationMask = resizedMask;
-            }
-            
-            // Use the same 2D measurement calculation as processOneImage
-            meas = computeMeasurementsFrom2D(kpts2d[0], userHeight, processedWidth, processedHeight, imgs[0], segmentationMask);
-            
-            // Log measurements
-            LOGD("Computed 8 measurements from 2D keypoints (first image):");
-            for (size_t i = 0; i < meas.size(); ++i) {
-                LOGD("Measurement[%zu] = %.2f cm", i, meas[i]);
+        ImagePreprocessor::run(imgs[0]);
+        checkpoint(job, ScanStage::Inference);
+        kpts2d[0] = PoseEstimator::detect(imgs[0], segmentationMask);
+        for (int i = 1; i < 3; ++i) {
+            if (pipelined) {
+                prepared[i].get();  // rethrows a worker exception
+            } else {
+                ImagePreprocessor::run(imgs[i]);
             }
-        } else {
-            LOGE("First image keypoints invalid - cannot compute measurements");
+            checkpoint(job, ScanStage::Inference);
+            kpts2d[i] = PoseEstimator::detect(imgs[i]);
         }
+    }
+    finishThreeViewScan(kpts2d, imgs[0], segmentationMask, userHeight, scan, job);
+}
+
+// Log the outcome of meshing a three-view scan. glb may be null when the mesh did
+// not fit the caller's buffer.
+static void logMeshResult(const ThreeViewScan& scan, const uint8_t* glb, size_t size) {
+    LOGD("Generated mesh size: %zu bytes", size);
+    if (size == 0) {
+        LOGE("Mesh generation returned empty - check keypoint validation in MeshGenerator");
+        LOGE("Input: %zu BODY_25 keypoints, %zu valid", scan.body25.size(), scan.validBody25);
+        LOGE("Source: %zu triangulated 3D keypoints, %d valid", scan.keypoints3d.size(), scan.validKeypoints3d);
+    } else if (glb != nullptr && size >= 4) {
+        // Log first few bytes to verify it's a valid GLB
+        LOGD("Mesh header (first 4 bytes): %02X %02X %02X %02X", glb[0], glb[1], glb[2], glb[3]);
+    }
+}
+
+// Runs a three-view scan through runScan(ThreeViewScan&), meshes it and packs the
+// ScanResult. Failures, in the scan or in packing, produce the empty result.
+// Stages record into timings, which must be this thread's current ScanTimings.
+// ScanCancelled from a job checkpoint propagates; nothing is packed then.
+template <typename RunScan>
+static jobject packThreeViewScan(JNIEnv* env, jclass resultClass, jmethodID constructor,
+                                 const ScanTimings& timings, ScanJob* job, RunScan runScan) {
+    // Initialize result arrays (will be populated or set to empty on error)
+    jfloatArray keypoints3d = nullptr;
+    jbyteArray meshGlb = nullptr;
+    jfloatArray measurements = nullptr;
+    size_t meshBytes = 0;
+    size_t maskBytes = 0;
+
+    try {
+        ThreeViewScan scan;
+        runScan(scan);
+        maskBytes = scan.maskBytes;
+
+        // Through the cache, so reopening the scan (generateMesh on its keypoints)
+        // finds this GLB instead of rebuilding it
+        checkpoint(job, ScanStage::MeshBuild);
+        const std::shared_ptr<const MeshBlob> mesh = meshCache().get(scan.body25);
+        const uint8_t* glb = mesh != nullptr ? mesh->data() : nullptr;
+        meshBytes = mesh != nullptr ? mesh->size() : 0;
+        logMeshResult(scan, glb, meshBytes);
 
         // 8. Pack results into Java arrays
+        checkpoint(job, ScanStage::Pack);
+        ScopedTimer packTimer(ScanStage::Pack);
         
         // Pack keypoints3d: 135 * 3 = 405 floats
-        keypoints3d = env->NewFloatArray(135 * 3);
-        if (keypoints3d != nullptr && kpts3d.size() == 135) {
-            float* kptsArray = new float[135 * 3];
-            for (size_t i = 0; i < 135; ++i) {
-                kptsArray[i * 3 + 0] = kpts3d[i].x;
-                kptsArray[i * 3 + 1] = kpts3d[i].y;
-                kptsArray[i * 3 + 2] = kpts3d[i].z;
-            }
-            env->SetFloatArrayRegion(keypoints3d, 0, 135 * 3, kptsArray);
-            delete[] kptsArray;
-        } else {
-            // Create zero-filled array if conversion failed
-            keypoints3d = env->NewFloatArray(135 * 3);
-            float zeros[135 * 3] = {0};
-            env->SetFloatArrayRegion(keypoints3d, 0, 135 * 3, zeros);
-        }
+        keypoints3d = newKeypoints3dArray(env, scan.keypoints3d);
 
         // Pack meshGlb: GLB binary data
-        meshGlb = env->NewByteArray(mesh.size());
-        if (meshGlb != nullptr && !mesh.empty()) {
-            env->SetByteArrayRegion(meshGlb, 0, mesh.size(), 
-                                   reinterpret_cast<const jbyte*>(mesh.data()));
-            LOGD("Packed mesh into Java ByteArray: %zu bytes", mesh.size());
-        } else {
-            meshGlb = env->NewByteArray(0);
-            LOGE("Failed to pack mesh - meshGlb is null or mesh is empty");
+        meshGlb = env->NewByteArray(static_cast<jsize>(meshBytes));
+        if (meshGlb != nullptr && meshBytes > 0) {
+            env->SetByteArrayRegion(meshGlb, 0, static_cast<jsize>(meshBytes),
+                                   reinterpret_cast<const jbyte*>(glb));
         }
 
         // Pack measurements: float array (8 measurements matching single-image format)
-        measurements = env->NewFloatArray(meas.size());
-        if (measurements != nullptr && !meas.empty()) {
-            env->SetFloatArrayRegion(measurements, 0, meas.size(), meas.data());
-        } else {
-            measurements = env->NewFloatArray(8);
-            float zeros[8] = {0};
-            env->SetFloatArrayRegion(measurements, 0, 8, zeros);
-        }
+        measurements = newMeasurementArray(env, scan.measurements);
 
+    } catch (const ScanCancelled&) {
+        throw;  // Checkpoints come before packing, so no array is held yet
     } catch (...) {
         // Exception occurred - return empty result
-        if (keypoints3d == nullptr) {
-            keypoints3d = env->NewFloatArray(135 * 3);
-            float zeros[135 * 3] = {0};
-            env->SetFloatArrayRegion(keypoints3d, 0, 135 * 3, zeros);
-        }
-        if (meshGlb == nullptr) {
-            meshGlb = env->NewByteArray(0);
-        }
-        if (measurements == nullptr) {
-            measurements = env->NewFloatArray(8);
-            float zeros[8] = {0};
-            env->SetFloatArrayRegion(measurements, 0, 8, zeros);
-        }
+    }
+
+    // Zero-filled arrays for anything that was not packed
+    if (keypoints3d == nullptr) {
+        keypoints3d = env->NewFloatArray(kKeypoints3dFloats);
+    }
+    if (meshGlb == nullptr) {
+        meshGlb = env->NewByteArray(0);
+    }
+    if (measurements == nullptr) {
+        measurements = env->NewFloatArray(kMeasurementCount);
     }
 
     // Create and return ScanResult object
     // Pass null for keypoints2d (4th parameter) - not needed for multi-image processing
-    jobject result = env->NewObject(resultClass, constructor, keypoints3d, meshGlb, measurements, nullptr);
+    jobject jTimings = newScanTimings(env, timings, meshBytes, maskBytes);
+    jobject result = env->NewObject(resultClass, constructor, keypoints3d, meshGlb, measurements,
+                                    nullptr, jTimings);
     
     // Clean up local references
     if (keypoints3d != nullptr) env->DeleteLocalRef(keypoints3d);
     if (meshGlb != nullptr) env->DeleteLocalRef(meshGlb);
     if (measurements != nullptr) env->DeleteLocalRef(measurements);
-    if (keypoints2d != nullptr) env->DeleteLocalRef(keypoints2d);
-    if (resultClass != nullptr) env->DeleteLocalRef(resultClass);
+    if (jTimings != nullptr) env->DeleteLocalRef(jTimings);
     
     return result;
 }
 
-// Helper function to check if a keypoint is valid (detected and within bounds)
-inline bool isValidKeypoint(const cv::Point2f& pt) {
-    return pt.x >= 0.0f && pt.x <= 1.0f && pt.y >= 0.0f && pt.y <= 1.0f;
-}
-
-// Helper function to calculate distance between two keypoints in normalized coordinates
-inline float keypointDistance(const cv::Point2f& p1, const cv::Point2f& p2) {
-    float dx = p2.x - p1.x;
-    float dy = p2.y - p1.y;
-    return std::sqrt(dx * dx + dy * dy);
-}
-
-// Helper function to validate measurement value (sanity check)
-inline float validateMeasurement(float value, float minVal, float maxVal) {
-    if (value < minVal || value > maxVal || std::isnan(value) || std::isinf(value)) {
-        return 0.0f; // Invalid measurement
-    }
-    return value;
-}
-
-// Helper function to compute measurements from 2D keypoints
-// Uses user's known height as scaling factor for accurate measurements
-// If processedImg and segmentationMask are provided, uses pixel-level edge detection for thigh measurements
-// 
-// MediaPipe landmark indices (33 total):
-// 0: nose, 1-6: eyes, 7-8: ears, 9-10: mouth
-// 11-12: shoulders (left, right)
-// 13-14: elbows (left, right)
-// 15-16: wrists (left, right)
-// 17-22: hands (pinky, index, thumb for left/right)
-// 23-24: hips (left, right)
-// 25-26: knees (left, right)
-// 27-28: ankles (left, right)
-// 29-30: heels (left, right)
-// 31-32: foot_index (left, right)
-//
-// Measurement array indices:
-// [0] Shoulder width
-// [1] Arm length (average of left and right)
-// [2] Leg length (average of left and right)
-// [3] Hip width
-// [4] Upper body length (hip midpoint to highest point)
-// [5] Lower body length (hip midpoint to ankle midpoint)
-// [6] Neck width (eye to eye)
-// [7] Thigh width (average of left and right)
-std::vector<float> computeMeasurementsFrom2D(
-    const std::vector<cv::Point2f>& kpts2d, 
-    float userHeight, 
-    int imgWidth, 
-    int imgHeight,
-    const cv::Mat& processedImg = cv::Mat(),
-    const cv::Mat& segmentationMask = cv::Mat()) {
-    std::vector<float> measurements(8, 0.0f); // 8 measurements
-    
-    // Validation: Check input parameters
-    if (kpts2d.empty() || kpts2d.size() < 33 || userHeight <= 0.0f || 
-        userHeight > 300.0f || imgWidth <= 0 || imgHeight <= 0) {
-        return measurements; // Return zeros for invalid input
+// Scans three views (see scanThreeFrames), meshes them and packs the ScanResult
+static jobject processThreeFrames(JNIEnv* env, jclass resultClass, jmethodID constructor,
+                                  std::vector<cv::Mat>& imgs, float userHeight, ScanTimings& timings,
+                                  ScanJob* job = nullptr) {
+    return packThreeViewScan(env, resultClass, constructor, timings, job, [&](ThreeViewScan& scan) {
+        scanThreeFrames(imgs, userHeight, timings, scan, job);
+    });
+}
+
+// Same as processThreeFrames, writing into a ScanOutput buffer: the GLB is
+// copied into its mesh section and no Java object is created.
+static void processThreeFramesInto(ScanOutputWriter& out, std::vector<cv::Mat>& imgs, float userHeight,
+                                   ScanTimings& timings) {
+    ThreeViewScan scan;
+    scanThreeFrames(imgs, userHeight, timings, scan);
+
+    // Through the cache like packThreeViewScan, so reopening the scan finds this GLB
+    const std::shared_ptr<const MeshBlob> mesh = meshCache().get(scan.body25);
+    const size_t meshBytes = mesh != nullptr ? mesh->size() : 0;
+    const bool fits = meshBytes <= out.meshCapacity();
+    if (fits && meshBytes > 0) {
+        std::memcpy(out.meshData(), mesh->data(), meshBytes);
     }
-    
-    // Find head keypoint (nose - index 0)
-    float headY = 1.0f; // Start with max (top of image)
-    bool hasHead = false;
-    if (isValidKeypoint(kpts2d[0])) {
-        headY = kpts2d[0].y;
-        hasHead = true;
+    logMeshResult(scan, fits ? out.meshData() : nullptr, meshBytes);
+
+    ScopedTimer packTimer(ScanStage::Pack);
+    if (scan.keypoints3d.size() == PipelineLayout::kCount) {
+        out.setKeypoints3d(scan.keypoints3d.data(), scan.keypoints3d.size());
     }
-    
-    // Find feet keypoints (ankles, heels, foot_index - indices 27-32)
-    float feetY = 0.0f; // Start with min (bottom of image)
-    bool hasFeet = false;
-    for (int i = 27; i <= 32 && i < static_cast<int>(kpts2d.size()); ++i) {
-        if (isValidKeypoint(kpts2d[i])) {
-            feetY = std::max(feetY, kpts2d[i].y);
-            hasFeet = true;
-        }
+    out.setMeasurements(scan.measurements.data(), scan.measurements.size());
+    out.setMaskBytes(scan.maskBytes);
+    out.setMeshBytes(meshBytes);
+}
+
+// Multi-image processing with MediaPipe and 3D reconstruction
+static jobject JNICALL processThreeImages(
+        JNIEnv* env, jclass, jobjectArray jImages, jintArray jWidths,
+        jintArray jHeights, jfloat userHeight) {
+
+    // ScanResult class and constructor, resolved in JNI_OnLoad
+    const JniRegistry& registry = JniRegistry::get();
+    jclass resultClass = registry.scanResultClass;
+    jmethodID constructor = registry.scanResultInit;
+    if (resultClass == nullptr) {
+        return nullptr;
     }
-    
-    // If feet not found, use bottommost valid keypoint as fallback
-    if (!hasFeet) {
-        for (size_t i = 0; i < kpts2d.size(); ++i) {
-            if (isValidKeypoint(kpts2d[i])) {
-                feetY = std::max(feetY, kpts2d[i].y);
+
+    jobject result = nullptr;
+    try {
+        // 1. Validate input
+        if (jImages == nullptr || jWidths == nullptr || jHeights == nullptr ||
+            env->GetArrayLength(jImages) != 3) {
+            return makeEmptyThreeViewResult(env, resultClass, constructor);
+        }
+
+        // Get image dimensions
+        jint widths[3], heights[3];
+        env->GetIntArrayRegion(jWidths, 0, 3, widths);
+        env->GetIntArrayRegion(jHeights, 0, 3, heights);
+
+        ScanTimings timings;
+        ScanTimings::Scope timingScope(&timings);
+
+        // 2. Pin Java byte[][] as RGBA views - the RGBA→RGB decode happens on the
+        // preprocessing workers. The element local refs must outlive the pins, so
+        // they are left for the JVM to free when this call returns.
+        std::vector<cv::Mat> imgs(3);
+        FrameInput frames[3];
+        {
+            ScopedTimer decodeTimer(ScanStage::Decode);
+            for (int i = 0; i < 3; ++i) {
+                jbyteArray jImg = (jbyteArray)env->GetObjectArrayElement(jImages, i);
+                if (!frames[i].pinByteArray(env, jImg, widths[i], heights[i])) {
+                    // Return empty result - missing or invalid image data
+                    return makeEmptyThreeViewResult(env, resultClass, constructor);
+                }
+                imgs[i] = frames[i].image();
             }
         }
+
+        result = processThreeFrames(env, resultClass, constructor, imgs, userHeight, timings);
+    } catch (...) {
+        result = makeEmptyThreeViewResult(env, resultClass, constructor);
     }
-    
-    // Calculate body height in normalized coordinates
-    float bodyHeightNormalized = feetY - headY;
-    if (bodyHeightNormalized <= 0.0f || !hasHead) {
-        return measurements; // Invalid body height
+
+    return result;
+}
+
+// Wrap three direct ByteBuffers in place as the views of a scan. rowStrides may be
+// null for tightly packed RGBA. The frames must stay alive until processing ends.
+// Returns false if the arrays are malformed or a buffer cannot be wrapped.
+static bool wrapThreeBuffers(JNIEnv* env, jobjectArray jBuffers, jintArray jWidths, jintArray jHeights,
+                             jintArray jRowStrides, FrameInput (&frames)[3], std::vector<cv::Mat>& imgs) {
+    if (jBuffers == nullptr || jWidths == nullptr || jHeights == nullptr ||
+        env->GetArrayLength(jBuffers) != 3) {
+        return false;
     }
-    
-    // Convert normalized height to pixels using processed image height
-    float bodyHeightPixels = bodyHeightNormalized * imgHeight;
-    
-    if (bodyHeightPixels <= 0.0f) {
-        return measurements;
+
+    jint widths[3], heights[3];
+    jint rowStrides[3] = {0, 0, 0};
+    env->GetIntArrayRegion(jWidths, 0, 3, widths);
+    env->GetIntArrayRegion(jHeights, 0, 3, heights);
+    if (jRowStrides != nullptr && env->GetArrayLength(jRowStrides) >= 3) {
+        env->GetIntArrayRegion(jRowStrides, 0, 3, rowStrides);
     }
-    
-    // Calculate scale factor: user's known height / body height in pixels
-    // This gives us cm per pixel for this specific image
-    float cmPerPixel = userHeight / bodyHeightPixels;
-    
-    // [0] Shoulder Width: Distance between landmarks 11 and 12 (left and right shoulders)
-    if (kpts2d.size() > 12 && isValidKeypoint(kpts2d[11]) && isValidKeypoint(kpts2d[12])) {
-        float shoulderWidthNormalized = keypointDistance(kpts2d[11], kpts2d[12]);
-        float shoulderWidthCm = shoulderWidthNormalized * imgWidth * cmPerPixel;
-        measurements[0] = validateMeasurement(shoulderWidthCm, 30.0f, 60.0f);
+
+    ScopedTimer decodeTimer(ScanStage::Decode);
+    imgs.resize(3);
+    for (int i = 0; i < 3; ++i) {
+        jobject jBuf = env->GetObjectArrayElement(jBuffers, i);
+        bool wrapped = frames[i].wrapDirectBuffer(env, jBuf, widths[i], heights[i], rowStrides[i]);
+        if (jBuf != nullptr) env->DeleteLocalRef(jBuf);
+        if (!wrapped) {
+            return false;
+        }
+        imgs[i] = frames[i].image();
     }
-    
-    // [1] Arm Length: Average of left and right arm lengths
-    // Left arm: shoulder (11) → elbow (13) → wrist (15)
-    // Right arm: shoulder (12) → elbow (14) → wrist (16)
-    if (kpts2d.size() > 16 && 
-        isValidKeypoint(kpts2d[11]) && isValidKeypoint(kpts2d[13]) && isValidKeypoint(kpts2d[15]) &&
-        isValidKeypoint(kpts2d[12]) && isValidKeypoint(kpts2d[14]) && isValidKeypoint(kpts2d[16])) {
-        // Calculate left arm length (sum of segments)
-        float leftArmSegment1 = keypointDistance(kpts2d[11], kpts2d[13]);
-        float leftArmSegment2 = keypointDistance(kpts2d[13], kpts2d[15]);
-        float leftArmLengthNormalized = leftArmSegment1 + leftArmSegment2;
-        
-        // Calculate right arm length (sum of segments)
-        float rightArmSegment1 = keypointDistance(kpts2d[12], kpts2d[14]);
-        float rightArmSegment2 = keypointDistance(kpts2d[14], kpts2d[16]);
-        float rightArmLengthNormalized = rightArmSegment1 + rightArmSegment2;
-        
-        // Average the two arms
-        float avgArmLengthNormalized = (leftArmLengthNormalized + rightArmLengthNormalized) / 2.0f;
-        
-        // Convert to centimeters using max dimension for diagonal distances
-        float avgArmLengthCm = avgArmLengthNormalized * std::max(imgWidth, imgHeight) * cmPerPixel;
-        measurements[1] = validateMeasurement(avgArmLengthCm, 50.0f, 80.0f);
+    return true;
+}
+
+// Multi-image processing from direct ByteBuffers (zero-copy ingestion)
+// rowStrides may be null for tightly packed RGBA
+static jobject JNICALL processThreeImageBuffersNative(
+        JNIEnv* env, jclass, jobjectArray jBuffers, jintArray jWidths,
+        jintArray jHeights, jintArray jRowStrides, jfloat userHeight) {
+
+    const JniRegistry& registry = JniRegistry::get();
+    jclass resultClass = registry.scanResultClass;
+    jmethodID constructor = registry.scanResultInit;
+    if (resultClass == nullptr) {
+        return nullptr;
     }
-    
-    // [2] Leg Length: Average of left and right leg lengths
-    // Left leg: hip (23) → knee (25) → ankle (27)
-    // Right leg: hip (24) → knee (26) → ankle (28)
-    if (kpts2d.size() > 28 && 
-        isValidKeypoint(kpts2d[23]) && isValidKeypoint(kpts2d[25]) && isValidKeypoint(kpts2d[27]) &&
-        isValidKeypoint(kpts2d[24]) && isValidKeypoint(kpts2d[26]) && isValidKeypoint(kpts2d[28])) {
-        // Calculate left leg length (sum of segments)
-        float leftLegSegment1 = keypointDistance(kpts2d[23], kpts2d[25]);
-        float leftLegSegment2 = keypointDistance(kpts2d[25], kpts2d[27]);
-        float leftLegLengthNormalized = leftLegSegment1 + leftLegSegment2;
-        
-        // Calculate right leg length (sum of segments)
-        float rightLegSegment1 = keypointDistance(kpts2d[24], kpts2d[26]);
-        float rightLegSegment2 = keypointDistance(kpts2d[26], kpts2d[28]);
-        float rightLegLengthNormalized = rightLegSegment1 + rightLegSegment2;
-        
-        // Average the two legs
-        float avgLegLengthNormalized = (leftLegLengthNormalized + rightLegLengthNormalized) / 2.0f;
-        
-        // Convert to centimeters using max dimension for diagonal distances
-        float avgLegLengthCm = avgLegLengthNormalized * std::max(imgWidth, imgHeight) * cmPerPixel;
-        measurements[2] = validateMeasurement(avgLegLengthCm, 70.0f, 120.0f);
+
+    jobject result = nullptr;
+    try {
+        ScanTimings timings;
+        ScanTimings::Scope timingScope(&timings);
+
+        std::vector<cv::Mat> imgs;
+        FrameInput frames[3];
+        if (!wrapThreeBuffers(env, jBuffers, jWidths, jHeights, jRowStrides, frames, imgs)) {
+            return makeEmptyThreeViewResult(env, resultClass, constructor);
+        }
+
+        result = processThreeFrames(env, resultClass, constructor, imgs, userHeight, timings);
+    } catch (...) {
+        result = makeEmptyThreeViewResult(env, resultClass, constructor);
     }
-    
-    // [3] Hip Width: Distance between landmarks 23 and 24 (left and right hips)
-    if (kpts2d.size() > 24 && isValidKeypoint(kpts2d[23]) && isValidKeypoint(kpts2d[24])) {
-        float hipWidthNormalized = keypointDistance(kpts2d[23], kpts2d[24]);
-        float hipWidthCm = hipWidthNormalized * imgWidth * cmPerPixel;
-        measurements[3] = validateMeasurement(hipWidthCm, 25.0f, 50.0f);
+
+    return result;
+}
+
+// Writer over a direct ByteBuffer in the ScanOutputLayout; invalid (see
+// ScanOutputWriter::valid) if the buffer is not direct or too small
+static ScanOutputWriter scanOutputWriter(JNIEnv* env, jobject jOut) {
+    if (jOut == nullptr) {
+        return ScanOutputWriter(nullptr, 0);
     }
-    
-    // [4] Upper Body Length: Distance from hip midpoint to highest keypoint
-    if (kpts2d.size() > 24 && isValidKeypoint(kpts2d[23]) && isValidKeypoint(kpts2d[24])) {
-        // Calculate hip midpoint manually (do NOT assume landmark 35 exists)
-        cv::Point2f hipMidpoint;
-        hipMidpoint.x = (kpts2d[23].x + kpts2d[24].x) / 2.0f;
-        hipMidpoint.y = (kpts2d[23].y + kpts2d[24].y) / 2.0f;
-        
-        // Find highest keypoint (minimum Y value) from keypoints 0-32
-        float highestY = 1.0f;
-        cv::Point2f highestKeypoint;
-        bool foundHighest = false;
-        for (int i = 0; i <= 32 && i < static_cast<int>(kpts2d.size()); ++i) {
-            if (isValidKeypoint(kpts2d[i])) {
-                if (kpts2d[i].y < highestY) {
-                    highestY = kpts2d[i].y;
-                    highestKeypoint = kpts2d[i];
-                    foundHighest = true;
-                }
+    uint8_t* data = static_cast<uint8_t*>(env->GetDirectBufferAddress(jOut));
+    jlong capacity = env->GetDirectBufferCapacity(jOut);
+    if (data == nullptr || capacity < 0) {
+        return ScanOutputWriter(nullptr, 0);
+    }
+    return ScanOutputWriter(data, static_cast<size_t>(capacity));
+}
+
+// Multi-image processing from direct ByteBuffers into a reusable ScanOutput buffer
+// (no Java allocations). Returns the ScanOutputStatus also stored in the buffer;
+// InvalidInput without writing anything if the output buffer is unusable.
+static jint JNICALL processThreeImageBuffersIntoNative(
+        JNIEnv* env, jclass, jobjectArray jBuffers, jintArray jWidths,
+        jintArray jHeights, jintArray jRowStrides, jfloat userHeight, jobject jOut) {
+
+    ScanOutputWriter out = scanOutputWriter(env, jOut);
+    if (!out.valid()) {
+        return static_cast<jint>(ScanOutputStatus::InvalidInput);
+    }
+    out.reset();
+
+    ScanTimings timings;
+    try {
+        ScanTimings::Scope timingScope(&timings);
+
+        std::vector<cv::Mat> imgs;
+        FrameInput frames[3];
+        if (!wrapThreeBuffers(env, jBuffers, jWidths, jHeights, jRowStrides, frames, imgs)) {
+            out.setStatus(ScanOutputStatus::InvalidInput);
+        } else {
+            processThreeFramesInto(out, imgs, userHeight, timings);
+        }
+    } catch (...) {
+        out.reset();
+        out.setStatus(ScanOutputStatus::Failed);
+    }
+
+    out.setTimings(timings);
+    return static_cast<jint>(out.status());
+}
+
+// Process-wide queue of async scans. Never destroyed: its workers are daemon
+// threads that live as long as the process
+static ScanJobQueue& scanJobQueue() {
+    static ScanJobQueue* queue = new ScanJobQueue();
+    return *queue;
+}
+
+// Queue a three-view scan on frames the job owns. Returns the job handle, or 0.
+// timings already holds the Decode time of copying the frames in.
+static jlong submitThreeViewJob(JNIEnv* env, jobject callback, std::vector<cv::Mat> imgs, bool valid,
+                                float userHeight, std::shared_ptr<ScanTimings> timings) {
+    ScanJobQueue::Work work = [imgs, valid, userHeight, timings](JNIEnv* env, ScanJob& job) mutable {
+        const JniRegistry& registry = JniRegistry::get();
+        if (registry.scanResultClass == nullptr) {
+            return static_cast<jobject>(nullptr);
+        }
+        if (!valid) {
+            return makeEmptyThreeViewResult(env, registry.scanResultClass, registry.scanResultInit);
+        }
+        ScanTimings::Scope timingScope(timings.get());
+        return processThreeFrames(env, registry.scanResultClass, registry.scanResultInit, imgs, userHeight,
+                                  *timings, &job);
+    };
+    return static_cast<jlong>(scanJobQueue().submit(env, callback, std::move(work)));
+}
+
+// Async multi-image processing: copies the RGBA byte[] frames (they cannot be
+// held past this call) and queues the scan. Invalid input still gets a job,
+// completing with the same empty ScanResult processThreeImages returns.
+static jlong JNICALL processThreeImagesAsyncNative(
+        JNIEnv* env, jclass, jobjectArray jImages, jintArray jWidths,
+        jintArray jHeights, jfloat userHeight, jobject callback) {
+    try {
+        auto timings = std::make_shared<ScanTimings>();
+        ScanTimings::Scope timingScope(timings.get());
+
+        std::vector<cv::Mat> imgs(3);
+        bool valid = jImages != nullptr && jWidths != nullptr && jHeights != nullptr &&
+                     env->GetArrayLength(jImages) == 3;
+        if (valid) {
+            jint widths[3], heights[3];
+            env->GetIntArrayRegion(jWidths, 0, 3, widths);
+            env->GetIntArrayRegion(jHeights, 0, 3, heights);
+
+            ScopedTimer decodeTimer(ScanStage::Decode);
+            for (int i = 0; i < 3 && valid; ++i) {
+                jbyteArray jImg = (jbyteArray)env->GetObjectArrayElement(jImages, i);
+                FrameInput frame;
+                valid = frame.loadByteArray(env, jImg, widths[i], heights[i]);
+                if (jImg != nullptr) env->DeleteLocalRef(jImg);
+                imgs[i] = frame.image();  // Owned RGB copy
             }
         }
-        
-        if (foundHighest) {
-            // Calculate vertical distance (Y increases downward, so subtract to get positive length)
-            float upperBodyLengthNormalized = hipMidpoint.y - highestKeypoint.y;
-            float upperBodyLengthCm = upperBodyLengthNormalized * imgHeight * cmPerPixel;
-            measurements[4] = validateMeasurement(upperBodyLengthCm, 40.0f, 80.0f);
+
+        return submitThreeViewJob(env, callback, std::move(imgs), valid, userHeight, timings);
+    } catch (...) {
+        return 0;
+    }
+}
+
+// Async multi-image processing from direct ByteBuffers. The pixels are copied
+// before this returns, so the caller may reuse the buffers right away.
+static jlong JNICALL processThreeImageBuffersAsyncNative(
+        JNIEnv* env, jclass, jobjectArray jBuffers, jintArray jWidths,
+        jintArray jHeights, jintArray jRowStrides, jfloat userHeight, jobject callback) {
+    try {
+        auto timings = std::make_shared<ScanTimings>();
+        ScanTimings::Scope timingScope(timings.get());
+
+        std::vector<cv::Mat> imgs;
+        FrameInput frames[3];
+        const bool valid = wrapThreeBuffers(env, jBuffers, jWidths, jHeights, jRowStrides, frames, imgs);
+        if (valid) {
+            ScopedTimer decodeTimer(ScanStage::Decode);
+            for (cv::Mat& img : imgs) {
+                img = img.clone();  // RGBA; converted by the job's preprocessing
+            }
+        }
+
+        return submitThreeViewJob(env, callback, std::move(imgs), valid, userHeight, timings);
+    } catch (...) {
+        return 0;
+    }
+}
+
+// Cancel an async scan; see ScanJobQueue::cancel
+static jboolean JNICALL cancelScanNative(
+        JNIEnv*, jclass, jlong handle) {
+    if (handle <= 0) {
+        return JNI_FALSE;
+    }
+    return scanJobQueue().cancel(static_cast<uint64_t>(handle)) ? JNI_TRUE : JNI_FALSE;
+}
+
+// Process-wide incremental scan session (one scan in progress at a time).
+// Never destroyed - its worker is a daemon thread
+static ScanSession& scanSession() {
+    static ScanSession* session = new ScanSession();
+    return *session;
+}
+
+// Open an incremental scan, dropping the views of an unfinished one
+static jboolean JNICALL beginScan(
+        JNIEnv* env, jclass) {
+    try {
+        return scanSession().begin(env) ? JNI_TRUE : JNI_FALSE;
+    } catch (...) {
+        return JNI_FALSE;
+    }
+}
+
+// Shared body of the addView entry points: copy the frame (the session keeps
+// it past this call) and queue it for preprocessing and detection
+template <typename LoadFrame>
+static jboolean addViewWith(jint index, LoadFrame loadFrame) {
+    try {
+        FrameInput frame;
+        if (!loadFrame(frame)) {
+            return JNI_FALSE;
+        }
+        return scanSession().addView(index, std::move(frame.image())) ? JNI_TRUE : JNI_FALSE;
+    } catch (...) {
+        return JNI_FALSE;
+    }
+}
+
+// View from an RGBA byte[], converted to an owned RGB frame
+static jboolean JNICALL addViewNative(
+        JNIEnv* env, jclass, jint index, jbyteArray jImage, jint width, jint height) {
+    return addViewWith(index, [&](FrameInput& frame) {
+        return frame.loadByteArray(env, jImage, width, height);
+    });
+}
+
+// View from a direct RGBA ByteBuffer; the pixels are copied so the buffer can be reused
+static jboolean JNICALL addViewBufferNative(
+        JNIEnv* env, jclass, jint index, jobject jBuffer, jint width, jint height, jint rowStride) {
+    return addViewWith(index, [&](FrameInput& frame) {
+        if (!frame.wrapDirectBuffer(env, jBuffer, width, height, rowStride)) {
+            return false;
+        }
+        frame.image() = frame.image().clone();
+        return true;
+    });
+}
+
+// View from an RGBA_8888 HardwareBuffer (API 26+), copied before it is unlocked
+static jboolean JNICALL addViewHardwareBufferNative(
+        JNIEnv* env, jclass, jint index, jobject jHardwareBuffer) {
+    return addViewWith(index, [&](FrameInput& frame) {
+        if (!frame.wrapHardwareBuffer(env, jHardwareBuffer)) {
+            return false;
+        }
+        frame.image() = frame.image().clone();
+        return true;
+    });
+}
+
+// Close the incremental scan: wait for pending view detections, then triangulate,
+// mesh and measure. Returns the empty three-view result if a view is missing.
+static jobject JNICALL finishScan(
+        JNIEnv* env, jclass, jfloat userHeight) {
+    const JniRegistry& registry = JniRegistry::get();
+    jclass resultClass = registry.scanResultClass;
+    jmethodID constructor = registry.scanResultInit;
+    if (resultClass == nullptr) {
+        return nullptr;
+    }
+
+    try {
+        std::array<ScanSession::View, ScanSession::kViewCount> views;
+        std::shared_ptr<ScanTimings> timings;
+        if (!scanSession().finish(views, timings)) {
+            return makeEmptyThreeViewResult(env, resultClass, constructor);
         }
+
+        ScanTimings::Scope timingScope(timings.get());
+        return packThreeViewScan(env, resultClass, constructor, *timings, nullptr, [&](ThreeViewScan& scan) {
+            std::vector<std::vector<cv::Point2f>> kpts2d(ScanSession::kViewCount);
+            for (int i = 0; i < ScanSession::kViewCount; ++i) {
+                kpts2d[i] = std::move(views[i].keypoints);
+            }
+            finishThreeViewScan(kpts2d, views[0].image, views[0].mask, userHeight, scan);
+        });
+    } catch (...) {
+        return makeEmptyThreeViewResult(env, resultClass, constructor);
+    }
+}
+
+// Read stored ScanResult.keypoints3d (135 * 3 floats) as BODY_25 mesh input and
+// clamp the MeshLod / MeshFormat ordinals. Returns false if the array is too short.
+// Only the leading MediaPipe landmarks are copied out of the Java array.
+static bool readMeshInput(JNIEnv* env, jfloatArray jKeypoints3d, jint lod, jint format,
+                          std::vector<cv::Point3f>& body25, MeshLod& meshLod, MeshFormat& meshFormat) {
+    if (jKeypoints3d == nullptr || env->GetArrayLength(jKeypoints3d) < kKeypoints3dFloats) {
+        return false;
+    }
+
+    std::array<cv::Point3f, MediaPipeLayout::kCount> landmarks;
+    env->GetFloatArrayRegion(jKeypoints3d, 0, MediaPipeLayout::kCount * 3,
+                             reinterpret_cast<jfloat*>(landmarks.data()));
+    body25 = mapToBody25(KeypointSet<MediaPipeLayout>::fromPoints(landmarks.data(),
+                                                                  landmarks.size())).toVector();
+
+    meshLod = MeshLod::Standard;
+    if (lod >= static_cast<jint>(MeshLod::Thumbnail) && lod <= static_cast<jint>(MeshLod::Detailed)) {
+        meshLod = static_cast<MeshLod>(lod);
+    }
+    meshFormat = format == static_cast<jint>(MeshFormat::Compact) ? MeshFormat::Compact
+                                                                   : MeshFormat::Float32;
+    return true;
+}
+
+// Cached GLB for stored ScanResult.keypoints3d (built on a miss), or null if
+// the array is too short or cannot produce a mesh
+static std::shared_ptr<const MeshBlob> cachedMesh(JNIEnv* env, jfloatArray jKeypoints3d, jint lod, jint format) {
+    std::vector<cv::Point3f> body25;
+    MeshLod meshLod;
+    MeshFormat meshFormat;
+    if (!readMeshInput(env, jKeypoints3d, lod, format, body25, meshLod, meshFormat)) {
+        return nullptr;
+    }
+    return meshCache().get(body25, meshLod, meshFormat);
+}
+
+// Regenerate a body mesh from stored ScanResult.keypoints3d
+// at the requested level of detail and encoding (MeshLod / MeshFormat ordinals).
+// Served from the mesh cache when the same mesh was built before.
+static jbyteArray JNICALL generateMeshNative(
+        JNIEnv* env, jclass, jfloatArray jKeypoints3d, jint lod, jint format) {
+
+    std::shared_ptr<const MeshBlob> mesh;
+    try {
+        mesh = cachedMesh(env, jKeypoints3d, lod, format);
+    } catch (...) {
+        mesh = nullptr;
     }
-    
-    // [5] Lower Body Length: Distance from hip midpoint to ankle midpoint
-    if (kpts2d.size() > 28 && 
-        isValidKeypoint(kpts2d[23]) && isValidKeypoint(kpts2d[24]) &&
-        isValidKeypoint(kpts2d[27]) && isValidKeypoint(kpts2d[28])) {
-        // Calculate hip midpoint manually (do NOT assume landmark 35 exists)
-        cv::Point2f hipMidpoint;
-        hipMidpoint.x = (kpts2d[23].x + kpts2d[24].x) / 2.0f;
-        hipMidpoint.y = (kpts2d[23].y + kpts2d[24].y) / 2.0f;
-        
-        // Calculate ankle midpoint manually (do NOT assume landmark 134 exists)
-        cv::Point2f ankleMidpoint;
-        ankleMidpoint.x = (kpts2d[27].x + kpts2d[28].x) / 2.0f;
-        ankleMidpoint.y = (kpts2d[27].y + kpts2d[28].y) / 2.0f;
-        
-        // Calculate distance (primarily vertical, so use imgHeight)
-        float lowerBodyLengthNormalized = keypointDistance(hipMidpoint, ankleMidpoint);
-        float lowerBodyLengthCm = lowerBodyLengthNormalized * imgHeight * cmPerPixel;
-        measurements[5] = validateMeasurement(lowerBodyLengthCm, 60.0f, 100.0f);
+
+    const jsize size = mesh != nullptr ? static_cast<jsize>(mesh->size()) : 0;
+    jbyteArray meshGlb = env->NewByteArray(size);
+    if (meshGlb != nullptr && size > 0) {
+        env->SetByteArrayRegion(meshGlb, 0, size, reinterpret_cast<const jbyte*>(mesh->data()));
     }
-    
-    // [6] Neck Width: Distance from left eye (2) to right eye (5)
-    if (kpts2d.size() > 5 && isValidKeypoint(kpts2d[2]) && isValidKeypoint(kpts2d[5])) {
-        float neckWidthNormalized = keypointDistance(kpts2d[2], kpts2d[5]);
-        float neckWidthCm = neckWidthNormalized * imgWidth * cmPerPixel;
-        measurements[6] = validateMeasurement(neckWidthCm, 8.0f, 15.0f);
+    return meshGlb;
+}
+
+// Same as generateMeshNative, copying the GLB into a direct ByteBuffer (no Java
+// array). Returns the GLB size, which is larger than the buffer capacity if
+// nothing was written, or 0 if no mesh could be built.
+static jint JNICALL generateMeshIntoBufferNative(
+        JNIEnv* env, jclass, jfloatArray jKeypoints3d, jint lod, jint format, jobject jBuffer) {
+
+    if (jBuffer == nullptr) {
+        return 0;
     }
-    
-    // [7] Thigh Width: Average of left and right thigh widths
-    // Use pixel-level edge detection if segmentation mask is available
-    float leftThighWidthPixels = 0.0f;
-    float rightThighWidthPixels = 0.0f;
-    bool leftThighValid = false;
-    bool rightThighValid = false;
-    
-    bool usePixelDetection = !segmentationMask.empty() && !processedImg.empty() &&
-                             segmentationMask.cols == processedImg.cols &&
-                             segmentationMask.rows == processedImg.rows;
-    
-    // Left thigh: Calculate midpoint between left hip (23) and left knee (25)
-    if (kpts2d.size() > 25 && isValidKeypoint(kpts2d[23]) && isValidKeypoint(kpts2d[25])) {
-        float midpointYNormalized = (kpts2d[23].y + kpts2d[25].y) / 2.0f;
-        int midpointY = static_cast<int>(midpointYNormalized * imgHeight);
-        
-        if (usePixelDetection && midpointY >= 0 && midpointY < imgHeight) {
-            // Pixel-level edge detection: traverse horizontally at midpoint Y
-            int leftEdge = -1;
-            int rightEdge = -1;
-            float leftHipXNormalized = kpts2d[23].x;
-            int leftHipX = static_cast<int>(leftHipXNormalized * imgWidth);
-            
-            // Search from left edge of image towards right to find leftmost edge
-            for (int x = 0; x < imgWidth; ++x) {
-                if (x >= 0 && x < segmentationMask.cols && midpointY >= 0 && midpointY < segmentationMask.rows) {
-                    float maskValue = segmentationMask.at<float>(midpointY, x);
-                    if (maskValue > 0.5f) {
-                        leftEdge = x;
-                        break;
-                    }
-                }
-            }
-            
-            // Search from body centerline towards left hip to find rightmost edge of left thigh
-            int bodyCenterX = 0;
-            if (kpts2d.size() > 24 && isValidKeypoint(kpts2d[23]) && isValidKeypoint(kpts2d[24])) {
-                bodyCenterX = static_cast<int>((kpts2d[23].x + kpts2d[24].x) / 2.0f * imgWidth);
-            }
-            int searchEnd = std::min(leftHipX + (bodyCenterX - leftHipX) * 2, imgWidth - 1);
-            
-            for (int x = searchEnd; x >= leftHipX; --x) {
-                if (x >= 0 && x < segmentationMask.cols && midpointY >= 0 && midpointY < segmentationMask.rows) {
-                    float maskValue = segmentationMask.at<float>(midpointY, x);
-                    if (maskValue > 0.5f) {
-                        rightEdge = x;
-                        break;
-                    }
-                }
-            }
-            
-            if (leftEdge >= 0 && rightEdge >= 0 && rightEdge > leftEdge) {
-                leftThighWidthPixels = static_cast<float>(rightEdge - leftEdge);
-                leftThighValid = true;
-            }
+    uint8_t* out = static_cast<uint8_t*>(env->GetDirectBufferAddress(jBuffer));
+    jlong capacity = env->GetDirectBufferCapacity(jBuffer);
+    if (out == nullptr || capacity < 0) {
+        return 0;
+    }
+
+    try {
+        const std::shared_ptr<const MeshBlob> mesh = cachedMesh(env, jKeypoints3d, lod, format);
+        if (mesh == nullptr) {
+            return 0;
         }
-        
-        // Fallback to estimation if pixel detection failed
-        if (!leftThighValid) {
-            float bodyCenterX = 0.5f;
-            if (kpts2d.size() > 24 && isValidKeypoint(kpts2d[23]) && isValidKeypoint(kpts2d[24])) {
-                bodyCenterX = (kpts2d[23].x + kpts2d[24].x) / 2.0f;
-            }
-            float hipHalfWidth = std::abs(kpts2d[23].x - bodyCenterX);
-            float thighExpansionFactor = 1.5f;
-            float leftThighHalfWidth = hipHalfWidth * thighExpansionFactor;
-            float leftThighWidthNormalized = leftThighHalfWidth * 2.0f;
-            leftThighWidthPixels = leftThighWidthNormalized * imgWidth;
-            leftThighValid = true;
+        if (mesh->size() <= static_cast<size_t>(capacity)) {
+            std::memcpy(out, mesh->data(), mesh->size());
         }
+        return static_cast<jint>(mesh->size());
+    } catch (...) {
+        return 0;
     }
-    
-    // Right thigh: Calculate midpoint between right hip (24) and right knee (26)
-    if (kpts2d.size() > 26 && isValidKeypoint(kpts2d[24]) && isValidKeypoint(kpts2d[26])) {
-        float midpointYNormalized = (kpts2d[24].y + kpts2d[26].y) / 2.0f;
-        int midpointY = static_cast<int>(midpointYNormalized * imgHeight);
-        
-        if (usePixelDetection && midpointY >= 0 && midpointY < imgHeight) {
-            // Pixel-level edge detection: traverse horizontally at midpoint Y
-            int leftEdge = -1;
-            int rightEdge = -1;
-            float rightHipXNormalized = kpts2d[24].x;
-            int rightHipX = static_cast<int>(rightHipXNormalized * imgWidth);
-            
-            // Search from body centerline towards right to find leftmost edge of right thigh
-            int bodyCenterX = 0;
-            if (kpts2d.size() > 24 && isValidKeypoint(kpts2d[23]) && isValidKeypoint(kpts2d[24])) {
-                bodyCenterX = static_cast<int>((kpts2d[23].x + kpts2d[24].x) / 2.0f * imgWidth);
-            }
-            for (int x = bodyCenterX; x < imgWidth; ++x) {
-                if (x >= 0 && x < segmentationMask.cols && midpointY >= 0 && midpointY < segmentationMask.rows) {
-                    float maskValue = segmentationMask.at<float>(midpointY, x);
-                    if (maskValue > 0.5f) {
-                        leftEdge = x;
-                        break;
-                    }
-                }
-            }
-            
-            // Search from right edge of image towards left to find rightmost edge
-            for (int x = imgWidth - 1; x >= rightHipX; --x) {
-                if (x >= 0 && x < segmentationMask.cols && midpointY >= 0 && midpointY < segmentationMask.rows) {
-                    float maskValue = segmentationMask.at<float>(midpointY, x);
-                    if (maskValue > 0.5f) {
-                        rightEdge = x;
-                        break;
-                    }
-                }
-            }
-            
-            if (leftEdge >= 0 && rightEdge >= 0 && rightEdge > leftEdge) {
-                rightThighWidthPixels = static_cast<float>(rightEdge - leftEdge);
-                rightThighValid = true;
-            }
+}
+
+// Cached meshes handed to Java as direct ByteBuffers over the cache's memory,
+// kept alive until releaseCachedMeshNative. Keyed by the buffer address; the
+// count covers the same mesh being open more than once.
+static std::mutex g_meshLeaseMutex;
+static std::unordered_map<const void*, std::pair<std::shared_ptr<const MeshBlob>, int>> g_meshLeases;
+
+// Open the cached GLB for stored keypoints without copying it into the Java heap.
+// The buffer reads the cache's memory (a file mapping when the disk cache holds
+// the mesh), so Java must not write to it. Returns null if no mesh can be built.
+static jobject JNICALL openCachedMeshNative(
+        JNIEnv* env, jclass, jfloatArray jKeypoints3d, jint lod, jint format) {
+    try {
+        const std::shared_ptr<const MeshBlob> mesh = cachedMesh(env, jKeypoints3d, lod, format);
+        if (mesh == nullptr) {
+            return nullptr;
         }
-        
-        // Fallback to estimation if pixel detection failed
-        if (!rightThighValid) {
-            float bodyCenterX = 0.5f;
-            if (kpts2d.size() > 24 && isValidKeypoint(kpts2d[23]) && isValidKeypoint(kpts2d[24])) {
-                bodyCenterX = (kpts2d[23].x + kpts2d[24].x) / 2.0f;
-            }
-            float hipHalfWidth = std::abs(kpts2d[24].x - bodyCenterX);
-            float thighExpansionFactor = 1.5f;
-            float rightThighHalfWidth = hipHalfWidth * thighExpansionFactor;
-            float rightThighWidthNormalized = rightThighHalfWidth * 2.0f;
-            rightThighWidthPixels = rightThighWidthNormalized * imgWidth;
-            rightThighValid = true;
+        jobject buffer = env->NewDirectByteBuffer(const_cast<uint8_t*>(mesh->data()),
+                                                  static_cast<jlong>(mesh->size()));
+        if (buffer == nullptr) {
+            env->ExceptionClear();
+            return nullptr;
         }
+        std::lock_guard<std::mutex> lock(g_meshLeaseMutex);
+        auto& lease = g_meshLeases[mesh->data()];
+        lease.first = mesh;
+        lease.second++;
+        return buffer;
+    } catch (...) {
+        return nullptr;
     }
-    
-    // Calculate average thigh width in centimeters
-    if (leftThighValid && rightThighValid) {
-        float avgThighWidthPixels = (leftThighWidthPixels + rightThighWidthPixels) / 2.0f;
-        float avgThighWidthCm = avgThighWidthPixels * cmPerPixel;
-        measurements[7] = validateMeasurement(avgThighWidthCm, 15.0f, 40.0f);
-    } else if (leftThighValid) {
-        float leftThighWidthCm = leftThighWidthPixels * cmPerPixel;
-        measurements[7] = validateMeasurement(leftThighWidthCm, 15.0f, 40.0f);
-    } else if (rightThighValid) {
-        float rightThighWidthCm = rightThighWidthPixels * cmPerPixel;
-        measurements[7] = validateMeasurement(rightThighWidthCm, 15.0f, 40.0f);
+}
+
+// Release a buffer from openCachedMeshNative; it must not be read afterwards
+static void JNICALL releaseCachedMeshNative(
+        JNIEnv* env, jclass, jobject jBuffer) {
+    if (jBuffer == nullptr) {
+        return;
+    }
+    const void* address = env->GetDirectBufferAddress(jBuffer);
+    std::lock_guard<std::mutex> lock(g_meshLeaseMutex);
+    auto it = g_meshLeases.find(address);
+    if (it != g_meshLeases.end() && --it->second.second <= 0) {
+        g_meshLeases.erase(it);
     }
-    
-    return measurements;
 }
 
-// Single image processing function
-extern "C" JNIEXPORT jobject JNICALL
-Java_com_example_bodyscanapp_utils_NativeBridge_processOneImage(
-        JNIEnv* env, jclass, jbyteArray jImage, jint width, jint height, jfloat userHeight) {
+// Point the mesh cache at a disk directory (null or empty: memory only) and set
+// both byte budgets. Returns false if the directory cannot be created.
+static jboolean JNICALL configureMeshCacheNative(
+        JNIEnv* env, jclass, jstring jDirectory, jlong maxDiskBytes, jlong maxMemoryBytes) {
+    std::string directory;
+    if (jDirectory != nullptr) {
+        const char* chars = env->GetStringUTFChars(jDirectory, nullptr);
+        if (chars == nullptr) {
+            return JNI_FALSE;
+        }
+        directory = chars;
+        env->ReleaseStringUTFChars(jDirectory, chars);
+    }
 
-    // Find the ScanResult class (Kotlin data class)
-    jclass resultClass = env->FindClass("com/example/bodyscanapp/utils/NativeBridge$ScanResult");
-    if (resultClass == nullptr) {
-        return nullptr;
+    try {
+        MeshCache& cache = meshCache();
+        cache.setMemoryBudget(static_cast<size_t>(std::max<jlong>(0, maxMemoryBytes)));
+        return cache.setDiskCache(directory, static_cast<size_t>(std::max<jlong>(0, maxDiskBytes)))
+            ? JNI_TRUE : JNI_FALSE;
+    } catch (...) {
+        return JNI_FALSE;
     }
+}
+
+// Create a single-image ScanResult and release the array references
+static jobject newSingleImageResult(JNIEnv* env, jclass resultClass, jmethodID constructor,
+                                    jfloatArray keypoints3d, jbyteArray meshGlb,
+                                    jfloatArray measurements, jfloatArray keypoints2d,
+                                    jobject timings = nullptr) {
+    jobject result = env->NewObject(resultClass, constructor, keypoints3d, meshGlb, measurements,
+                                    keypoints2d, timings);
+
+    // Clean up local references
+    if (keypoints3d != nullptr) env->DeleteLocalRef(keypoints3d);
+    if (meshGlb != nullptr) env->DeleteLocalRef(meshGlb);
+    if (measurements != nullptr) env->DeleteLocalRef(measurements);
+    if (keypoints2d != nullptr) env->DeleteLocalRef(keypoints2d);
+    if (timings != nullptr) env->DeleteLocalRef(timings);
+    return result;
+}
+
+// Build a single-image ScanResult with zeroed keypoints and measurements
+// NewFloatArray zero-initializes, so no explicit fill is needed
+static jobject makeEmptySingleImageResult(JNIEnv* env, jclass resultClass, jmethodID constructor) {
+    return newSingleImageResult(env, resultClass, constructor,
+                                env->NewFloatArray(kKeypoints3dFloats), env->NewByteArray(0),
+                                env->NewFloatArray(kMeasurementCount), env->NewFloatArray(kKeypoints2dFloats));
+}
+
+// Everything a single-image scan produces before packing
+struct SingleViewScan {
+    std::vector<cv::Point2f> keypoints2d;  // PipelineLayout::kCount points, or empty
+    std::vector<float> measurements;
+    size_t maskBytes = 0;
+};
+
+// Runs preprocessing, detection and 2D measurement on a decoded frame (RGB or RGBA).
+// Stages record into this thread's current ScanTimings.
+static void scanSingleFrame(cv::Mat& img, float userHeight, SingleViewScan& scan) {
+    // 2. Pre-process image (CLAHE + resizing)
+    ImagePreprocessor::run(img);
+
+    // 3. Detect 2D keypoints and segmentation mask (pixel-level measurements)
+    // using a single MediaPipe inference
+    cv::Mat segmentationMask;
+    scan.keypoints2d = PoseEstimator::detect(img, segmentationMask);
+    scan.maskBytes = segmentationMask.total() * segmentationMask.elemSize();
     
-    // Get constructor for Kotlin data class
-    // Try 4-parameter constructor first (with keypoints2d)
-    jmethodID constructor = env->GetMethodID(resultClass, "<init>", "([F[B[F[F)V");
-    if (constructor == nullptr) {
-        // Fall back to 3-parameter constructor (without keypoints2d, will use default null)
-        constructor = env->GetMethodID(resultClass, "<init>", "([F[B[F)V");
-        if (constructor == nullptr) {
-            return nullptr;
-        }
-    }
+    // The mask stays at its native resolution; the measurement maps rows into it
+    int processedWidth = img.cols;
+    int processedHeight = img.rows;
+
+    // 4. Compute measurements from 2D keypoints
+    // Use processed image dimensions (after preprocessing/resizing)
+    scan.measurements = computeMeasurementsFrom2D(scan.keypoints2d, userHeight, processedWidth, processedHeight,
+                                                  img, segmentationMask);
+}
 
+// Scans a decoded frame (see scanSingleFrame) and packs the ScanResult.
+// Stages record into timings, which must be this thread's current ScanTimings.
+static jobject processSingleFrame(JNIEnv* env, jclass resultClass, jmethodID constructor,
+                                  cv::Mat& img, float userHeight, const ScanTimings& timings) {
     // Initialize result arrays
     jfloatArray keypoints3d = nullptr;
     jbyteArray meshGlb = nullptr;
     jfloatArray measurements = nullptr;
     jfloatArray keypoints2d = nullptr;
+    size_t maskBytes = 0;
 
     try {
-        // 1. Validate input
-        if (jImage == nullptr || width <= 0 || height <= 0) {
-            // Return empty result
-            keypoints3d = env->NewFloatArray(135 * 3);
-            meshGlb = env->NewByteArray(0);
-            measurements = env->NewFloatArray(8);
-            keypoints2d = env->NewFloatArray(135 * 2);
-            float zeros2d[135 * 2] = {0};
-            env->SetFloatArrayRegion(keypoints2d, 0, 135 * 2, zeros2d);
-            
-            // Try 4-parameter constructor first, fall back to 3-parameter
-            jobject result = nullptr;
-            jmethodID newConstructor = env->GetMethodID(resultClass, "<init>", "([F[B[F[F)V");
-            if (newConstructor != nullptr && keypoints2d != nullptr) {
-                result = env->NewObject(resultClass, newConstructor, keypoints3d, meshGlb, measurements, keypoints2d);
-            } else {
-                result = env->NewObject(resultClass, constructor, keypoints3d, meshGlb, measurements);
-            }
-            return result;
-        }
-
-        jsize len = env->GetArrayLength(jImage);
-        jint expectedSize = width * height * 4; // RGBA = 4 bytes per pixel
-        
-        // Validate buffer size
-        if (len < expectedSize) {
-            keypoints3d = env->NewFloatArray(135 * 3);
-            meshGlb = env->NewByteArray(0);
-            measurements = env->NewFloatArray(8);
-            keypoints2d = env->NewFloatArray(135 * 2);
-            float zeros2d[135 * 2] = {0};
-            env->SetFloatArrayRegion(keypoints2d, 0, 135 * 2, zeros2d);
-            
-            jmethodID newConstructor = env->GetMethodID(resultClass, "<init>", "([F[B[F[F)V");
-            if (newConstructor != nullptr && keypoints2d != nullptr) {
-                return env->NewObject(resultClass, newConstructor, keypoints3d, meshGlb, measurements, keypoints2d);
-            } else {
-                return env->NewObject(resultClass, constructor, keypoints3d, meshGlb, measurements);
-            }
-        }
-        
-        jbyte* buf = env->GetByteArrayElements(jImage, nullptr);
-        
-        // Create RGBA Mat from buffer
-        cv::Mat rgba(height, width, CV_8UC4, buf);
-        
-        // Convert RGBA to RGB and clone
-        cv::Mat rgb;
-        cv::cvtColor(rgba, rgb, cv::COLOR_RGBA2RGB);
-        cv::Mat img = rgb.clone();
-        
-        env->ReleaseByteArrayElements(jImage, buf, JNI_ABORT);
-
-        // 2. Pre-process image (CLAHE + resizing)
-        ImagePreprocessor::run(img);
-
-        // 3. Detect 2D keypoints using MediaPipe
-        std::vector<cv::Point2f> kpts2d = PoseEstimator::detect(img);
-        
-        // Get segmentation mask for pixel-level measurements
-        cv::Mat segmentationMask = MediaPipePoseDetector::getSegmentationMask(env, img);
-        
-        // Resize segmentation mask to match processed image dimensions if needed
-        int processedWidth = img.cols;
-        int processedHeight = img.rows;
-        if (!segmentationMask.empty() && 
-            (segmentationMask.cols != processedWidth || segmentationMask.rows != processedHeight)) {
-            cv::Mat resizedMask;
-            cv::resize(segmentationMask, resizedMask, cv::Size(processedWidth, processedHeight), 0, 0, cv::INTER_LINEAR);
-            segmentationMask = resizedMask;
-        }
-
-        // 4. Compute measurements from 2D keypoints
-        // Use processed image dimensions (after preprocessing/resizing)
-        std::vector<float> meas = computeMeasurementsFrom2D(kpts2d, userHeight, processedWidth, processedHeight, img, segmentationMask);
+        SingleViewScan scan;
+        scanSingleFrame(img, userHeight, scan);
+        maskBytes = scan.maskBytes;
 
         // 5. Pack results into Java arrays
+        ScopedTimer packTimer(ScanStage::Pack);
         
         // Pack keypoints3d: 135 * 3 = 405 floats (empty for single image)
-        keypoints3d = env->NewFloatArray(135 * 3);
-        float zeros3d[135 * 3] = {0};
-        env->SetFloatArrayRegion(keypoints3d, 0, 135 * 3, zeros3d);
+        keypoints3d = env->NewFloatArray(kKeypoints3dFloats);
 
         // Pack meshGlb: empty for single image
         meshGlb = env->NewByteArray(0);
 
         // Pack measurements: float array
-        measurements = env->NewFloatArray(meas.size());
-        if (measurements != nullptr && !meas.empty()) {
-            env->SetFloatArrayRegion(measurements, 0, meas.size(), meas.data());
-        } else {
-            measurements = env->NewFloatArray(8);
-            float zeros[8] = {0};
-            env->SetFloatArrayRegion(measurements, 0, 8, zeros);
-        }
+        measurements = newMeasurementArray(env, scan.measurements);
 
         // Pack keypoints2d: 135 * 2 = 270 floats (normalized x, y coordinates)
-        keypoints2d = env->NewFloatArray(135 * 2);
-        if (keypoints2d != nullptr && kpts2d.size() == 135) {
-            float* kpts2dArray = new float[135 * 2];
-            for (size_t i = 0; i < 135; ++i) {
-                kpts2dArray[i * 2 + 0] = kpts2d[i].x; // normalized x (0-1)
-                kpts2dArray[i * 2 + 1] = kpts2d[i].y; // normalized y (0-1)
-            }
-            env->SetFloatArrayRegion(keypoints2d, 0, 135 * 2, kpts2dArray);
-            delete[] kpts2dArray;
-        } else {
-            // Create zero-filled array if conversion failed
-            float zeros2d[135 * 2] = {0};
-            env->SetFloatArrayRegion(keypoints2d, 0, 135 * 2, zeros2d);
-        }
+        keypoints2d = newKeypoints2dArray(env, scan.keypoints2d);
 
     } catch (...) {
         // Exception occurred - return empty result
-        if (keypoints3d == nullptr) {
-            keypoints3d = env->NewFloatArray(135 * 3);
-            float zeros[135 * 3] = {0};
-            env->SetFloatArrayRegion(keypoints3d, 0, 135 * 3, zeros);
-        }
-        if (meshGlb == nullptr) {
-            meshGlb = env->NewByteArray(0);
-        }
-        if (measurements == nullptr) {
-            measurements = env->NewFloatArray(8);
-            float zeros[8] = {0};
-            env->SetFloatArrayRegion(measurements, 0, 8, zeros);
-        }
-        if (keypoints2d == nullptr) {
-            keypoints2d = env->NewFloatArray(135 * 2);
-            float zeros2d[135 * 2] = {0};
-            env->SetFloatArrayRegion(keypoints2d, 0, 135 * 2, zeros2d);
-        }
+    }
+
+    // Zero-filled arrays for anything that was not packed
+    if (keypoints3d == nullptr) {
+        keypoints3d = env->NewFloatArray(kKeypoints3dFloats);
+    }
+    if (meshGlb == nullptr) {
+        meshGlb = env->NewByteArray(0);
+    }
+    if (measurements == nullptr) {
+        measurements = env->NewFloatArray(kMeasurementCount);
+    }
+    if (keypoints2d == nullptr) {
+        keypoints2d = env->NewFloatArray(kKeypoints2dFloats);
     }
 
     // Create and return ScanResult object
+    return newSingleImageResult(env, resultClass, constructor, keypoints3d, meshGlb, measurements,
+                                keypoints2d, newScanTimings(env, timings, 0, maskBytes));
+}
+
+// Shared front half of the single-image entry points: lets the caller load a
+// frame, then runs the pipeline on it
+template <typename LoadFrame>
+static jobject processOneFrameWith(JNIEnv* env, float userHeight, LoadFrame loadFrame) {
+    // ScanResult class and constructor, resolved in JNI_OnLoad
+    const JniRegistry& registry = JniRegistry::get();
+    jclass resultClass = registry.scanResultClass;
+    jmethodID constructor = registry.scanResultInit;
+    if (resultClass == nullptr) {
+        return nullptr;
+    }
+
     jobject result = nullptr;
-    jmethodID newConstructor = env->GetMethodID(resultClass, "<init>", "([F[B[F[F)V");
-    if (newConstructor != nullptr && keypoints2d != nullptr) {
-        result = env->NewObject(resultClass, newConstructor, keypoints3d, meshGlb, measurements, keypoints2d);
-    } else {
-        // Fall back to 3-parameter constructor (keypoints2d will be null/default)
-        result = env->NewObject(resultClass, constructor, keypoints3d, meshGlb, measurements);
+    try {
+        ScanTimings timings;
+        ScanTimings::Scope timingScope(&timings);
+
+        // 1. Validate and load input
+        FrameInput frame;
+        bool loaded;
+        {
+            ScopedTimer decodeTimer(ScanStage::Decode);
+            loaded = loadFrame(frame);
+        }
+        if (!loaded) {
+            result = makeEmptySingleImageResult(env, resultClass, constructor);
+        } else {
+            result = processSingleFrame(env, resultClass, constructor, frame.image(), userHeight, timings);
+        }
+    } catch (...) {
+        result = makeEmptySingleImageResult(env, resultClass, constructor);
     }
-    
-    // Clean up local references
-    if (keypoints3d != nullptr) env->DeleteLocalRef(keypoints3d);
-    if (meshGlb != nullptr) env->DeleteLocalRef(meshGlb);
-    if (measurements != nullptr) env->DeleteLocalRef(measurements);
-    if (keypoints2d != nullptr) env->DeleteLocalRef(keypoints2d);
-    if (resultClass != nullptr) env->DeleteLocalRef(resultClass);
-    
+
     return result;
 }
 
+// Same as processOneFrameWith, writing into a ScanOutput buffer instead of a
+// ScanResult. Returns the ScanOutputStatus also stored in the buffer.
+template <typename LoadFrame>
+static jint processOneFrameIntoWith(JNIEnv* env, jobject jOut, float userHeight, LoadFrame loadFrame) {
+    ScanOutputWriter out = scanOutputWriter(env, jOut);
+    if (!out.valid()) {
+        return static_cast<jint>(ScanOutputStatus::InvalidInput);
+    }
+    out.reset();
+
+    ScanTimings timings;
+    try {
+        ScanTimings::Scope timingScope(&timings);
+
+        FrameInput frame;
+        bool loaded;
+        {
+            ScopedTimer decodeTimer(ScanStage::Decode);
+            loaded = loadFrame(frame);
+        }
+        if (!loaded) {
+            out.setStatus(ScanOutputStatus::InvalidInput);
+        } else {
+            SingleViewScan scan;
+            scanSingleFrame(frame.image(), userHeight, scan);
+
+            ScopedTimer packTimer(ScanStage::Pack);
+            if (scan.keypoints2d.size() == PipelineLayout::kCount) {
+                out.setKeypoints2d(scan.keypoints2d.data(), scan.keypoints2d.size());
+            }
+            out.setMeasurements(scan.measurements.data(), scan.measurements.size());
+            out.setMaskBytes(scan.maskBytes);
+        }
+    } catch (...) {
+        out.reset();
+        out.setStatus(ScanOutputStatus::Failed);
+    }
+
+    out.setTimings(timings);
+    return static_cast<jint>(out.status());
+}
+
+// Single image processing function
+static jobject JNICALL processOneImage(
+        JNIEnv* env, jclass, jbyteArray jImage, jint width, jint height, jfloat userHeight) {
+    return processOneFrameWith(env, userHeight, [&](FrameInput& frame) {
+        return frame.loadByteArray(env, jImage, width, height);
+    });
+}
+
+// Single image processing from a direct ByteBuffer (zero-copy ingestion)
+static jobject JNICALL processOneImageBufferNative(
+        JNIEnv* env, jclass, jobject jBuffer, jint width, jint height, jint rowStride,
+        jfloat userHeight) {
+    return processOneFrameWith(env, userHeight, [&](FrameInput& frame) {
+        return frame.wrapDirectBuffer(env, jBuffer, width, height, rowStride);
+    });
+}
+
+// Single image processing from an android.hardware.HardwareBuffer (API 26+)
+static jobject JNICALL processOneImageHardwareBufferNative(
+        JNIEnv* env, jclass, jobject jHardwareBuffer, jfloat userHeight) {
+    return processOneFrameWith(env, userHeight, [&](FrameInput& frame) {
+        return frame.wrapHardwareBuffer(env, jHardwareBuffer);
+    });
+}
+
+// Single image processing from a direct ByteBuffer into a reusable ScanOutput buffer
+static jint JNICALL processOneImageBufferIntoNative(
+        JNIEnv* env, jclass, jobject jBuffer, jint width, jint height, jint rowStride,
+        jfloat userHeight, jobject jOut) {
+    return processOneFrameIntoWith(env, jOut, userHeight, [&](FrameInput& frame) {
+        return frame.wrapDirectBuffer(env, jBuffer, width, height, rowStride);
+    });
+}
+
+// Single image processing from an android.hardware.HardwareBuffer into a ScanOutput buffer
+static jint JNICALL processOneImageHardwareBufferIntoNative(
+        JNIEnv* env, jclass, jobject jHardwareBuffer, jfloat userHeight, jobject jOut) {
+    return processOneFrameIntoWith(env, jOut, userHeight, [&](FrameInput& frame) {
+        return frame.wrapHardwareBuffer(env, jHardwareBuffer);
+    });
+}
+
 // Initialize MediaPipe Pose Detector with Android context
-extern "C" JNIEXPORT jboolean JNICALL
-Java_com_example_bodyscanapp_utils_NativeBridge_initializeMediaPipe(
+static jboolean JNICALL initializeMediaPipe(
         JNIEnv* env, jclass, jobject context) {
     return MediaPipePoseDetector::initialize(env, context) ? JNI_TRUE : JNI_FALSE;
 }
 
-// TODO: Update to use MediaPipe for validation
-extern "C" JNIEXPORT jobject JNICALL
-Java_com_example_bodyscanapp_utils_NativeBridge_validateImage(
-        JNIEnv* env, jclass, jbyteArray jImage, jint width, jint height) {
-    
-    // Find the ImageValidationResult class
-    jclass resultClass = env->FindClass("com/example/bodyscanapp/utils/NativeBridge$ImageValidationResult");
-    if (resultClass == nullptr) {
-        return nullptr;
-    }
-    
-    // Get constructor
-    jmethodID constructor = env->GetMethodID(resultClass, "<init>", "(ZZZFLjava/lang/String;)V");
-    if (constructor == nullptr) {
+// Shared body of the validation entry points: loadFrame fills the FrameInput,
+// or returns false with a message describing why it could not
+template <typename LoadFrame>
+static jobject validateFrameWith(JNIEnv* env, LoadFrame loadFrame) {
+    // ImageValidationResult class and constructor, resolved in JNI_OnLoad
+    const JniRegistry& registry = JniRegistry::get();
+    if (registry.validationResultClass == nullptr) {
         return nullptr;
     }
     
@@ -966,35 +1135,15 @@ Java_com_example_bodyscanapp_utils_NativeBridge_validateImage(
     std::string message = "";
     
     try {
-        if (jImage == nullptr || width <= 0 || height <= 0) {
-            message = "Invalid input";
-        } else {
-            jsize len = env->GetArrayLength(jImage);
-            jint expectedSize = width * height * 4; // RGBA
-            
-            if (len >= expectedSize * 0.9) {  // Allow some tolerance
-                jbyte* buf = env->GetByteArrayElements(jImage, nullptr);
-                
-                // Create RGBA Mat
-                cv::Mat rgba(height, width, CV_8UC4, buf);
-                
-                // Convert RGBA to RGB
-                cv::Mat rgb;
-                cv::cvtColor(rgba, rgb, cv::COLOR_RGBA2RGB);
-                cv::Mat img = rgb.clone();
-                
-                env->ReleaseByteArrayElements(jImage, buf, JNI_ABORT);
-                
-                // Validate image
-                PoseEstimator::ValidationResult result = PoseEstimator::validateImage(img);
-                hasPerson = result.hasPerson;
-                isFullBody = result.isFullBody;
-                hasMultiplePeople = result.hasMultiplePeople;
-                confidence = result.confidence;
-                message = result.message;
-            } else {
-                message = "Image size mismatch";
-            }
+        FrameInput frame;
+        if (loadFrame(frame, message)) {
+            // Validate image
+            PoseEstimator::ValidationResult result = PoseEstimator::validateImage(frame.image());
+            hasPerson = result.hasPerson;
+            isFullBody = result.isFullBody;
+            hasMultiplePeople = result.hasMultiplePeople;
+            confidence = result.confidence;
+            message = result.message;
         }
     } catch (...) {
         message = "Processing error";
@@ -1004,7 +1153,7 @@ Java_com_example_bodyscanapp_utils_NativeBridge_validateImage(
     jstring jMessage = env->NewStringUTF(message.c_str());
     
     // Create and return result object
-    jobject result = env->NewObject(resultClass, constructor,
+    jobject result = env->NewObject(registry.validationResultClass, registry.validationResultInit,
         (jboolean)hasPerson,
         (jboolean)isFullBody,
         (jboolean)hasMultiplePeople,
@@ -1013,70 +1162,291 @@ Java_com_example_bodyscanapp_utils_NativeBridge_validateImage(
     
     // Clean up
     if (jMessage != nullptr) env->DeleteLocalRef(jMessage);
-    if (resultClass != nullptr) env->DeleteLocalRef(resultClass);
     
     return result;
 }
 
-// Detect keypoints for preview overlay
-extern "C" JNIEXPORT jfloatArray JNICALL
-Java_com_example_bodyscanapp_utils_NativeBridge_detectKeypoints(
+// TODO: Update to use MediaPipe for validation
+static jobject JNICALL validateImage(
         JNIEnv* env, jclass, jbyteArray jImage, jint width, jint height) {
+    return validateFrameWith(env, [&](FrameInput& frame, std::string& message) {
+        if (jImage == nullptr || width <= 0 || height <= 0) {
+            message = "Invalid input";
+            return false;
+        }
+        // Allow some tolerance on the buffer size
+        if (!frame.loadByteArray(env, jImage, width, height, 0.9f)) {
+            message = "Image size mismatch";
+            return false;
+        }
+        return true;
+    });
+}
+
+// Image validation from a direct ByteBuffer (zero-copy ingestion)
+static jobject JNICALL validateImageBufferNative(
+        JNIEnv* env, jclass, jobject jBuffer, jint width, jint height, jint rowStride) {
+    return validateFrameWith(env, [&](FrameInput& frame, std::string& message) {
+        if (jBuffer == nullptr || width <= 0 || height <= 0) {
+            message = "Invalid input";
+            return false;
+        }
+        if (!frame.wrapDirectBuffer(env, jBuffer, width, height, rowStride)) {
+            message = "Image size mismatch";
+            return false;
+        }
+        return true;
+    });
+}
+
+// Image validation from an android.hardware.HardwareBuffer (API 26+)
+static jobject JNICALL validateImageHardwareBufferNative(
+        JNIEnv* env, jclass, jobject jHardwareBuffer) {
+    return validateFrameWith(env, [&](FrameInput& frame, std::string& message) {
+        if (!frame.wrapHardwareBuffer(env, jHardwareBuffer)) {
+            message = "Unsupported hardware buffer";
+            return false;
+        }
+        return true;
+    });
+}
+
+// Shared body of the preview keypoint entry points
+template <typename LoadFrame>
+static jfloatArray detectFrameKeypointsWith(JNIEnv* env, LoadFrame loadFrame) {
     
-    // Initialize result array
-    jfloatArray keypoints2d = env->NewFloatArray(135 * 2);
+    // Initialize result array (zero-filled by NewFloatArray)
+    jfloatArray keypoints2d = env->NewFloatArray(kKeypoints2dFloats);
     if (keypoints2d == nullptr) {
         return nullptr;
     }
     
-    // Fill with zeros as default
-    float zeros2d[135 * 2] = {0};
-    env->SetFloatArrayRegion(keypoints2d, 0, 135 * 2, zeros2d);
-    
     try {
-        if (jImage == nullptr || width <= 0 || height <= 0) {
-            return keypoints2d; // Return zeros
-        }
-        
-        jsize len = env->GetArrayLength(jImage);
-        jint expectedSize = width * height * 4; // RGBA
-        
-        if (len < expectedSize * 0.9) {  // Allow some tolerance
+        FrameInput frame;
+        if (!loadFrame(frame)) {
             return keypoints2d; // Return zeros
         }
         
-        jbyte* buf = env->GetByteArrayElements(jImage, nullptr);
-        
-        // Create RGBA Mat
-        cv::Mat rgba(height, width, CV_8UC4, buf);
-        
-        // Convert RGBA to RGB
-        cv::Mat rgb;
-        cv::cvtColor(rgba, rgb, cv::COLOR_RGBA2RGB);
-        cv::Mat img = rgb.clone();
-        
-        env->ReleaseByteArrayElements(jImage, buf, JNI_ABORT);
-        
         // Detect keypoints using MediaPipe
-        std::vector<cv::Point2f> kpts2d = PoseEstimator::detect(img);
+        std::vector<cv::Point2f> kpts2d = PoseEstimator::detect(frame.image());
         
-        // Pack keypoints2d: 135 * 2 = 270 floats (normalized x, y coordinates)
-        if (kpts2d.size() == 135) {
-            float* kpts2dArray = new float[135 * 2];
-            for (size_t i = 0; i < 135; ++i) {
-                kpts2dArray[i * 2 + 0] = kpts2d[i].x; // normalized x (0-1)
-                kpts2dArray[i * 2 + 1] = kpts2d[i].y; // normalized y (0-1)
-            }
-            env->SetFloatArrayRegion(keypoints2d, 0, 135 * 2, kpts2dArray);
-            delete[] kpts2dArray;
+        // Pack keypoints2d: 135 * 2 = 270 floats (normalized x, y coordinates),
+        // copied straight from the packed Point2f vector
+        if (kpts2d.size() == PipelineLayout::kCount) {
+            env->SetFloatArrayRegion(keypoints2d, 0, PipelineLayout::kCount * 2,
+                                     reinterpret_cast<const jfloat*>(kpts2d.data()));
         }
         
     } catch (...) {
-        // Exception occurred - return zeros
-        float zeros[135 * 2] = {0};
-        env->SetFloatArrayRegion(keypoints2d, 0, 135 * 2, zeros);
+        // Exception occurred - return zeros. The array is only written once
+        // detection succeeded, so it still holds its initial zeros.
     }
     
     return keypoints2d;
 }
 
+// Detect keypoints for preview overlay
+static jfloatArray JNICALL detectKeypoints(
+        JNIEnv* env, jclass, jbyteArray jImage, jint width, jint height) {
+    return detectFrameKeypointsWith(env, [&](FrameInput& frame) {
+        // Allow some tolerance on the buffer size
+        return frame.loadByteArray(env, jImage, width, height, 0.9f);
+    });
+}
+
+// Detect keypoints for preview overlay from a direct ByteBuffer (zero-copy ingestion)
+static jfloatArray JNICALL detectKeypointsBufferNative(
+        JNIEnv* env, jclass, jobject jBuffer, jint width, jint height, jint rowStride) {
+    return detectFrameKeypointsWith(env, [&](FrameInput& frame) {
+        return frame.wrapDirectBuffer(env, jBuffer, width, height, rowStride);
+    });
+}
+
+// Detect keypoints for preview overlay from an android.hardware.HardwareBuffer (API 26+)
+static jfloatArray JNICALL detectKeypointsHardwareBufferNative(
+        JNIEnv* env, jclass, jobject jHardwareBuffer) {
+    return detectFrameKeypointsWith(env, [&](FrameInput& frame) {
+        return frame.wrapHardwareBuffer(env, jHardwareBuffer);
+    });
+}
+
+// Process-wide streaming preview (one camera preview at a time).
+// Never destroyed - stopPreview() joins its worker, not static destruction
+static PreviewSession& previewSession() {
+    static PreviewSession* session = new PreviewSession();
+    return *session;
+}
+
+// Start the streaming preview worker
+static jboolean JNICALL startPreview(
+        JNIEnv* env, jclass) {
+    try {
+        return previewSession().start(env) ? JNI_TRUE : JNI_FALSE;
+    } catch (...) {
+        return JNI_FALSE;
+    }
+}
+
+// Shared body of the preview frame entry points: queue the frame, then copy
+// the newest smoothed keypoints into the caller's reusable array
+template <typename LoadFrame>
+static jlong pushPreviewFrameWith(JNIEnv* env, jfloatArray out, LoadFrame loadFrame) {
+    if (out == nullptr || env->GetArrayLength(out) < static_cast<jsize>(PreviewSession::kKeypointFloats)) {
+        return 0;
+    }
+    
+    try {
+        PreviewSession& session = previewSession();
+        {
+            // The session copies the pixels, so the frame can be released right away
+            FrameInput frame;
+            if (loadFrame(frame)) {
+                session.pushFrame(frame.image());
+            }
+        }
+        
+        float keypoints[PreviewSession::kKeypointFloats];
+        const uint64_t sequence = session.latest(keypoints);
+        if (sequence > 0) {
+            env->SetFloatArrayRegion(out, 0, PreviewSession::kKeypointFloats, keypoints);
+        }
+        return static_cast<jlong>(sequence);
+    } catch (...) {
+        return 0;
+    }
+}
+
+// Preview frame from an RGBA byte[]
+static jlong JNICALL pushPreviewFrameNative(
+        JNIEnv* env, jclass, jbyteArray jImage, jint width, jint height, jfloatArray out) {
+    return pushPreviewFrameWith(env, out, [&](FrameInput& frame) {
+        // Pinned rather than converted: the session's copy is the one pass over the pixels
+        return frame.pinByteArray(env, jImage, width, height);
+    });
+}
+
+// Preview frame from a direct ByteBuffer
+static jlong JNICALL pushPreviewFrameBufferNative(
+        JNIEnv* env, jclass, jobject jBuffer, jint width, jint height, jint rowStride, jfloatArray out) {
+    return pushPreviewFrameWith(env, out, [&](FrameInput& frame) {
+        return frame.wrapDirectBuffer(env, jBuffer, width, height, rowStride);
+    });
+}
+
+// Preview frame from an android.hardware.HardwareBuffer (API 26+)
+static jlong JNICALL pushPreviewFrameHardwareBufferNative(
+        JNIEnv* env, jclass, jobject jHardwareBuffer, jfloatArray out) {
+    return pushPreviewFrameWith(env, out, [&](FrameInput& frame) {
+        return frame.wrapHardwareBuffer(env, jHardwareBuffer);
+    });
+}
+
+// Stop the streaming preview worker
+static void JNICALL stopPreview(
+        JNIEnv* env, jclass) {
+    try {
+        previewSession().stop(env);
+    } catch (...) {
+    }
+}
+
+// Natives of NativeBridge, bound by RegisterNatives in JNI_OnLoad (no symbol lookup per method)
+#define SCAN_RESULT "Lcom/example/bodyscanapp/utils/NativeBridge$ScanResult;"
+#define VALIDATION_RESULT "Lcom/example/bodyscanapp/utils/NativeBridge$ImageValidationResult;"
+#define BYTE_BUFFER "Ljava/nio/ByteBuffer;"
+#define HARDWARE_BUFFER "Landroid/hardware/HardwareBuffer;"
+#define SCAN_CALLBACK "Lcom/example/bodyscanapp/utils/NativeBridge$ScanCallback;"
+
+static const JNINativeMethod kNativeMethods[] = {
+    {"processOneImage", "([BIIF)" SCAN_RESULT, reinterpret_cast<void*>(processOneImage)},
+    {"processOneImageBufferNative", "(" BYTE_BUFFER "IIIF)" SCAN_RESULT,
+     reinterpret_cast<void*>(processOneImageBufferNative)},
+    {"processOneImageHardwareBufferNative", "(" HARDWARE_BUFFER "F)" SCAN_RESULT,
+     reinterpret_cast<void*>(processOneImageHardwareBufferNative)},
+    {"processOneImageBufferIntoNative", "(" BYTE_BUFFER "IIIF" BYTE_BUFFER ")I",
+     reinterpret_cast<void*>(processOneImageBufferIntoNative)},
+    {"processOneImageHardwareBufferIntoNative", "(" HARDWARE_BUFFER "F" BYTE_BUFFER ")I",
+     reinterpret_cast<void*>(processOneImageHardwareBufferIntoNative)},
+    {"processThreeImages", "([[B[I[IF)" SCAN_RESULT, reinterpret_cast<void*>(processThreeImages)},
+    {"processThreeImageBuffersNative", "([" BYTE_BUFFER "[I[I[IF)" SCAN_RESULT,
+     reinterpret_cast<void*>(processThreeImageBuffersNative)},
+    {"processThreeImageBuffersIntoNative", "([" BYTE_BUFFER "[I[I[IF" BYTE_BUFFER ")I",
+     reinterpret_cast<void*>(processThreeImageBuffersIntoNative)},
+    {"processThreeImagesAsyncNative", "([[B[I[IF" SCAN_CALLBACK ")J",
+     reinterpret_cast<void*>(processThreeImagesAsyncNative)},
+    {"processThreeImageBuffersAsyncNative", "([" BYTE_BUFFER "[I[I[IF" SCAN_CALLBACK ")J",
+     reinterpret_cast<void*>(processThreeImageBuffersAsyncNative)},
+    {"cancelScanNative", "(J)Z", reinterpret_cast<void*>(cancelScanNative)},
+    {"beginScan", "()Z", reinterpret_cast<void*>(beginScan)},
+    {"addViewNative", "(I[BII)Z", reinterpret_cast<void*>(addViewNative)},
+    {"addViewBufferNative", "(I" BYTE_BUFFER "III)Z", reinterpret_cast<void*>(addViewBufferNative)},
+    {"addViewHardwareBufferNative", "(I" HARDWARE_BUFFER ")Z",
+     reinterpret_cast<void*>(addViewHardwareBufferNative)},
+    {"finishScan", "(F)" SCAN_RESULT, reinterpret_cast<void*>(finishScan)},
+    {"generateMeshNative", "([FII)[B", reinterpret_cast<void*>(generateMeshNative)},
+    {"generateMeshIntoBufferNative", "([FII" BYTE_BUFFER ")I",
+     reinterpret_cast<void*>(generateMeshIntoBufferNative)},
+    {"openCachedMeshNative", "([FII)" BYTE_BUFFER, reinterpret_cast<void*>(openCachedMeshNative)},
+    {"releaseCachedMeshNative", "(" BYTE_BUFFER ")V", reinterpret_cast<void*>(releaseCachedMeshNative)},
+    {"configureMeshCacheNative", "(Ljava/lang/String;JJ)Z", reinterpret_cast<void*>(configureMeshCacheNative)},
+    {"initializeMediaPipe", "(Landroid/content/Context;)Z", reinterpret_cast<void*>(initializeMediaPipe)},
+    {"validateImage", "([BII)" VALIDATION_RESULT, reinterpret_cast<void*>(validateImage)},
+    {"validateImageBufferNative", "(" BYTE_BUFFER "III)" VALIDATION_RESULT,
+     reinterpret_cast<void*>(validateImageBufferNative)},
+    {"validateImageHardwareBufferNative", "(" HARDWARE_BUFFER ")" VALIDATION_RESULT,
+     reinterpret_cast<void*>(validateImageHardwareBufferNative)},
+    {"detectKeypoints", "([BII)[F", reinterpret_cast<void*>(detectKeypoints)},
+    {"detectKeypointsBufferNative", "(" BYTE_BUFFER "III)[F",
+     reinterpret_cast<void*>(detectKeypointsBufferNative)},
+    {"detectKeypointsHardwareBufferNative", "(" HARDWARE_BUFFER ")[F",
+     reinterpret_cast<void*>(detectKeypointsHardwareBufferNative)},
+    {"startPreview", "()Z", reinterpret_cast<void*>(startPreview)},
+    {"pushPreviewFrameNative", "([BII[F)J", reinterpret_cast<void*>(pushPreviewFrameNative)},
+    {"pushPreviewFrameBufferNative", "(" BYTE_BUFFER "III[F)J",
+     reinterpret_cast<void*>(pushPreviewFrameBufferNative)},
+    {"pushPreviewFrameHardwareBufferNative", "(" HARDWARE_BUFFER "[F)J",
+     reinterpret_cast<void*>(pushPreviewFrameHardwareBufferNative)},
+    {"stopPreview", "()V", reinterpret_cast<void*>(stopPreview)},
+};
+
+#undef SCAN_RESULT
+#undef VALIDATION_RESULT
+#undef BYTE_BUFFER
+#undef HARDWARE_BUFFER
+#undef SCAN_CALLBACK
+
+// Resolve the JNI registry and bind the natives once, while System.loadLibrary runs.
+// Failing here makes loadLibrary throw instead of failing on the first scan.
+extern "C" JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM* vm, void*) {
+    JNIEnv* env = nullptr;
+    if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK || env == nullptr) {
+        return JNI_ERR;
+    }
+
+    if (!JniRegistry::load(env)) {
+        LOGE("Failed to resolve NativeBridge classes");
+        return JNI_ERR;
+    }
+
+    const jint methodCount = static_cast<jint>(sizeof(kNativeMethods) / sizeof(kNativeMethods[0]));
+    if (env->RegisterNatives(JniRegistry::get().nativeBridgeClass, kNativeMethods, methodCount) != JNI_OK) {
+        env->ExceptionClear();
+        LOGE("Failed to register NativeBridge natives");
+        JniRegistry::unload(env);
+        return JNI_ERR;
+    }
+
+    // Not fatal: initializeMediaPipe() retries the MediaPipe helper lookups
+    if (!MediaPipePoseDetector::onLoad(vm, env)) {
+        LOGE("MediaPipe helper not resolved at load time");
+    }
+
+    return JNI_VERSION_1_6;
+}
+
+extern "C" JNIEXPORT void JNICALL JNI_OnUnload(JavaVM* vm, void*) {
+    JNIEnv* env = nullptr;
+    if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) == JNI_OK && env != nullptr) {
+        JniRegistry::unload(env);
+    }
+}
@@ -64,5 +64,101 @@ class NativeBridgeTest {
         assertEquals(100f, result.measurements[1], 0.01f)
         assertEquals(90f, result.measurements[2], 0.01f)
     }
-}
+    
+    @Test
+    fun `test ScanTimings lookup and ScanResult equality`() {
+        val timings = NativeBridge.ScanTimings(
+            stageMs = FloatArray(8) { it.toFloat() },
+            meshBytes = 1024,
+            maskBytes = 4096
+        )
+        assertEquals(2f, timings[NativeBridge.ScanStage.INFERENCE], 0.001f)
+        assertEquals(7f, timings[NativeBridge.ScanStage.PACK], 0.001f)
+        
+        // Timings are diagnostics and do not affect result equality
+        val measurements = floatArrayOf(40f, 60f)
+        val withTimings = NativeBridge.ScanResult(FloatArray(3), ByteArray(0), measurements, null, timings)
+        val withoutTimings = NativeBridge.ScanResult(FloatArray(3), ByteArray(0), measurements)
+        assertEquals(withoutTimings, withTimings)
+        assertEquals(withoutTimings.hashCode(), withTimings.hashCode())
+        assertNull(withoutTimings.timings)
+    }
+    
+    @Test
+    fun `test ScanOutput reads sections at documented offsets`() {
+        val output = NativeBridge.ScanOutput.allocate(meshCapacity = 16)
+        val buffer = output.buffer
+        assertFalse(output.isWritten)
+
+        // Fill the buffer as the native side would
+        buffer.putInt(0, NativeBridge.ScanOutput.MAGIC)
+        buffer.putInt(4, NativeBridge.ScanOutput.VERSION)
+        buffer.putInt(8, 0)
+        buffer.putInt(12, 4)
+        buffer.putInt(16, 1024)
+        buffer.putFloat(32 + NativeBridge.ScanStage.INFERENCE.ordinal * 4, 12.5f)
+        buffer.putFloat(64 + 4, 2f)            // keypoints3d[1]
+        buffer.putFloat(1684 + 269 * 4, 0.5f)  // last keypoints2d value
+        buffer.putFloat(2764 + 7 * 4, 42f)     // last measurement
+        byteArrayOf(0x67, 0x6C, 0x54, 0x46).forEachIndexed { i, b -> buffer.put(2800 + i, b) }
+
+        assertTrue(output.isWritten)
+        assertEquals(NativeBridge.ScanOutput.Status.OK, output.status)
+        assertEquals(1024, output.maskBytes)
+        assertEquals(12.5f, output.stageMs(NativeBridge.ScanStage.INFERENCE), 0f)
+        assertEquals(2f, output.keypoints3d()[1], 0f)
+        assertEquals(0.5f, output.keypoints2d()[269], 0f)
+        assertEquals(42f, output.measurement(7), 0f)
+        assertEquals(42f, output.measurements()[7], 0f)
 
+        val mesh = output.mesh()
+        assertEquals(4, mesh.remaining())
+        assertEquals(0x67.toByte(), mesh.get(0))
+        assertEquals(0, buffer.position())  // Accessors leave the caller's buffer alone
+    }
+
+    @Test
+    fun `test ScanOutput hides the mesh when it did not fit`() {
+        val output = NativeBridge.ScanOutput.allocate(meshCapacity = 0)
+        output.buffer.putInt(8, NativeBridge.ScanOutput.Status.MESH_TOO_LARGE.ordinal)
+        output.buffer.putInt(12, 5000)
+
+        assertEquals(NativeBridge.ScanOutput.Status.MESH_TOO_LARGE, output.status)
+        assertEquals(5000, output.meshBytes)
+        assertEquals(0, output.mesh().remaining())
+    }
+
+    @Test(expected = IllegalArgumentException::class)
+    fun `test ScanOutput rejects a buffer smaller than the fixed sections`() {
+        NativeBridge.ScanOutput(java.nio.ByteBuffer.allocateDirect(NativeBridge.ScanOutput.MIN_CAPACITY - 1))
+    }
+
+    @Test
+    fun `test ScanCallback maps native stages and results to the listener`() {
+        val events = mutableListOf<String>()
+        var completed: NativeBridge.ScanResult? = null
+        val callback = NativeBridge.ScanCallback(object : NativeBridge.ScanListener {
+            override fun onProgress(handle: Long, stage: NativeBridge.ScanStage) {
+                events.add("$handle:$stage")
+            }
+
+            override fun onComplete(handle: Long, result: NativeBridge.ScanResult) {
+                completed = result
+            }
+
+            override fun onCancelled(handle: Long) {
+                events.add("$handle:cancelled")
+            }
+        })
+
+        callback.onProgress(7, NativeBridge.ScanStage.TRIANGULATION.ordinal)
+        callback.onProgress(7, 99)  // Unknown stages are dropped
+        callback.onCancelled(8)
+        callback.onComplete(7, null)
+
+        assertEquals(listOf("7:TRIANGULATION", "8:cancelled"), events)
+        assertEquals(135 * 3, completed!!.keypoints3d.size)
+        assertEquals(0, completed!!.meshGlb.size)
+        assertEquals(8, completed!!.measurements.size)
+    }
+}